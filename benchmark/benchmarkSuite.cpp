@@ -0,0 +1,381 @@
+//
+//  benchmarkSuite.cpp
+//  MNN
+//
+//  Created by MNN on 2020/11/11.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#if defined(_MSC_VER)
+#include <Windows.h>
+#undef min
+#undef max
+#else
+#include <sys/time.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <dirent.h>
+#endif
+
+#include <MNN/Interpreter.hpp>
+#include <MNN/MNNDefine.h>
+#include <MNN/Tensor.hpp>
+#include "revertMNNModel.hpp"
+
+/**
+ Sweep thread number, precision, memory mode and batch for every model in a folder,
+ and write latency percentiles, per-op-type time, memory and create / resize time as json.
+ */
+struct Model {
+    std::string name;
+    std::string model_file;
+};
+
+struct BenchConfig {
+    MNNForwardType forward = MNN_FORWARD_CPU;
+    int thread             = 4;
+    int precision          = 2;
+    int memory             = 0;
+    int batch              = 1;
+};
+
+struct OpTypeStat {
+    float time  = 0.0f;
+    float flops = 0.0f;
+    int count   = 0;
+};
+
+struct BenchResult {
+    float loadTime   = 0.0f;
+    float createTime = 0.0f;
+    float resizeTime = 0.0f;
+    float firstTime  = 0.0f;
+    float memory     = 0.0f;
+    std::vector<float> costs;
+    std::map<std::string, OpTypeStat> opStats;
+};
+
+#if !defined(_MSC_VER)
+static inline bool file_exist(const char* file) {
+    struct stat buffer;
+    return stat(file, &buffer) == 0;
+}
+#endif
+
+static std::vector<Model> findModelFiles(const char* dir) {
+    std::vector<Model> models;
+#if defined(_MSC_VER)
+    WIN32_FIND_DATA ffd;
+    HANDLE hFind = INVALID_HANDLE_VALUE;
+    std::string mnn_model_pattern = std::string(dir) + "\\*.mnn";
+    hFind = FindFirstFile(mnn_model_pattern.c_str(), &ffd);
+    if (INVALID_HANDLE_VALUE == hFind) {
+        std::cout << "open " << dir << " failed: " << strerror(errno) << std::endl;
+        return models;
+    }
+    do {
+        Model m;
+        m.name       = ffd.cFileName;
+        m.model_file = std::string(dir) + "\\" + m.name;
+        if (INVALID_FILE_ATTRIBUTES != GetFileAttributes(m.model_file.c_str()) && GetLastError() != ERROR_FILE_NOT_FOUND) {
+            models.push_back(std::move(m));
+        }
+    } while (FindNextFile(hFind, &ffd) != 0);
+    FindClose(hFind);
+#else
+    DIR* root;
+    if ((root = opendir(dir)) == NULL) {
+        std::cout << "open " << dir << " failed: " << strerror(errno) << std::endl;
+        return models;
+    }
+    struct dirent* ent;
+    while ((ent = readdir(root)) != NULL) {
+        Model m;
+        if (ent->d_name[0] != '.') {
+            m.name       = ent->d_name;
+            m.model_file = std::string(dir) + "/" + m.name;
+            if (file_exist(m.model_file.c_str())) {
+                models.push_back(std::move(m));
+            }
+        }
+    }
+    closedir(root);
+#endif
+    std::sort(models.begin(), models.end(), [](const Model& a, const Model& b) { return a.name < b.name; });
+    return models;
+}
+
+static inline uint64_t getTimeInUs() {
+    uint64_t time;
+#if defined(_MSC_VER)
+    LARGE_INTEGER now, freq;
+    QueryPerformanceCounter(&now);
+    QueryPerformanceFrequency(&freq);
+    uint64_t sec  = now.QuadPart / freq.QuadPart;
+    uint64_t usec = (now.QuadPart % freq.QuadPart) * 1000000 / freq.QuadPart;
+    time          = sec * 1000000 + usec;
+#else
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    time = static_cast<uint64_t>(tv.tv_sec) * 1000000 + tv.tv_usec;
+#endif
+    return time;
+}
+
+static std::vector<int> parseList(const char* str) {
+    std::vector<int> values;
+    std::stringstream ss(str);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) {
+            values.push_back(atoi(item.c_str()));
+        }
+    }
+    return values;
+}
+
+static float percentile(std::vector<float> costs, float p) {
+    if (costs.empty()) {
+        return 0.0f;
+    }
+    std::sort(costs.begin(), costs.end());
+    // Nearest rank
+    int rank = (int)(p * costs.size() + 0.999f) - 1;
+    rank     = std::max(0, std::min(rank, (int)costs.size() - 1));
+    return costs[rank];
+}
+
+static void fillInput(MNN::Interpreter* net, MNN::Session* session) {
+    for (auto& iter : net->getSessionInputAll(session)) {
+        auto input = iter.second;
+        std::shared_ptr<MNN::Tensor> hostTensor(MNN::Tensor::createHostTensorFromDevice(input, false));
+        if (hostTensor->getType() == halide_type_of<float>()) {
+            for (int i = 0; i < hostTensor->elementSize(); ++i) {
+                hostTensor->host<float>()[i] = Revert::getRandValue();
+            }
+        } else {
+            ::memset(hostTensor->host<void>(), 0, hostTensor->size());
+        }
+        input->copyFromHostTensor(hostTensor.get());
+    }
+}
+
+static MNN::Session* createSession(MNN::Interpreter* net, const BenchConfig& bench, MNN::BackendConfig& backendConfig) {
+    MNN::ScheduleConfig config;
+    config.numThread        = bench.thread;
+    config.type             = bench.forward;
+    backendConfig.precision = (MNN::BackendConfig::PrecisionMode)bench.precision;
+    backendConfig.memory    = (MNN::BackendConfig::MemoryMode)bench.memory;
+    backendConfig.power     = MNN::BackendConfig::Power_High;
+    config.backendConfig    = &backendConfig;
+    return net->createSession(config);
+}
+
+static bool resizeBatch(MNN::Interpreter* net, MNN::Session* session, int batch) {
+    bool needResize = false;
+    for (auto& iter : net->getSessionInputAll(session)) {
+        auto input = iter.second;
+        if (input->dimensions() > 0 && input->length(0) != batch) {
+            auto shape = input->shape();
+            shape[0]   = batch;
+            net->resizeTensor(input, shape);
+            needResize = true;
+        }
+    }
+    if (needResize) {
+        net->resizeSession(session);
+    }
+    return needResize;
+}
+
+static bool doBench(const Model& model, const BenchConfig& bench, int loop, int warmup, BenchResult& result) {
+    auto loadBegin = getTimeInUs();
+    auto revertor  = std::unique_ptr<Revert>(new Revert(model.model_file.c_str()));
+    revertor->initialize();
+    auto net = std::shared_ptr<MNN::Interpreter>(
+        MNN::Interpreter::createFromBuffer(revertor->getBuffer(), revertor->getBufferSize()));
+    revertor.reset();
+    if (nullptr == net) {
+        return false;
+    }
+    result.loadTime = (getTimeInUs() - loadBegin) / 1000.0f;
+
+    // Latency and memory are measured on a release session, whose memory can be reused among ops
+    net->setSessionMode(MNN::Interpreter::Session_Release);
+    MNN::BackendConfig backendConfig;
+    auto createBegin  = getTimeInUs();
+    auto session      = createSession(net.get(), bench, backendConfig);
+    result.createTime = (getTimeInUs() - createBegin) / 1000.0f;
+    if (nullptr == session) {
+        return false;
+    }
+    auto resizeBegin  = getTimeInUs();
+    resizeBatch(net.get(), session, bench.batch);
+    result.resizeTime = (getTimeInUs() - resizeBegin) / 1000.0f;
+    net->getSessionInfo(session, MNN::Interpreter::MEMORY, &result.memory);
+
+    fillInput(net.get(), session);
+    auto outputs = net->getSessionOutputAll(session);
+    std::vector<std::pair<MNN::Tensor*, std::shared_ptr<MNN::Tensor>>> outputHosts;
+    for (auto& iter : outputs) {
+        outputHosts.emplace_back(std::make_pair(iter.second, std::shared_ptr<MNN::Tensor>(
+            MNN::Tensor::createHostTensorFromDevice(iter.second, false))));
+    }
+    auto runOnce = [&]() {
+        net->runSession(session);
+        for (auto& iter : outputHosts) {
+            iter.first->copyToHostTensor(iter.second.get());
+        }
+    };
+    auto firstBegin  = getTimeInUs();
+    runOnce();
+    result.firstTime = (getTimeInUs() - firstBegin) / 1000.0f;
+    for (int i = 0; i < warmup; ++i) {
+        runOnce();
+    }
+    result.costs.clear();
+    for (int i = 0; i < loop; ++i) {
+        auto timeBegin = getTimeInUs();
+        runOnce();
+        result.costs.push_back((getTimeInUs() - timeBegin) / 1000.0f);
+    }
+    net->releaseSession(session);
+
+    // Per-op time needs callbacks, which are only called by debug session
+    net->setSessionMode(MNN::Interpreter::Session_Debug);
+    MNN::BackendConfig debugConfig;
+    auto debugSession = createSession(net.get(), bench, debugConfig);
+    if (nullptr == debugSession) {
+        return false;
+    }
+    resizeBatch(net.get(), debugSession, bench.batch);
+    fillInput(net.get(), debugSession);
+    net->runSession(debugSession);
+    result.opStats.clear();
+    const int opLoop = std::max(1, std::min(loop, 10));
+    uint64_t opBegin = 0;
+    MNN::TensorCallBackWithInfo before = [&opBegin](const std::vector<MNN::Tensor*>& tensors,
+                                                    const MNN::OperatorInfo* info) {
+        opBegin = getTimeInUs();
+        return true;
+    };
+    MNN::TensorCallBackWithInfo after = [&opBegin, &result, opLoop](const std::vector<MNN::Tensor*>& tensors,
+                                                                     const MNN::OperatorInfo* info) {
+        auto& stat = result.opStats[info->type()];
+        stat.time += (getTimeInUs() - opBegin) / 1000.0f / opLoop;
+        stat.flops += info->flops() / opLoop;
+        stat.count++;
+        return true;
+    };
+    for (int i = 0; i < opLoop; ++i) {
+        net->runSessionWithCallBackInfo(debugSession, before, after, true);
+    }
+    for (auto& iter : result.opStats) {
+        iter.second.count /= opLoop;
+    }
+    net->releaseSession(debugSession);
+    return true;
+}
+
+static void writeJson(std::ostream& os, const Model& model, const BenchConfig& bench, const BenchResult& result,
+                      bool first) {
+    float sum = 0.0f;
+    for (auto v : result.costs) {
+        sum += v;
+    }
+    float avg = result.costs.empty() ? 0.0f : sum / result.costs.size();
+    os << (first ? "\n" : ",\n");
+    os << "  {\"model\": \"" << model.name << "\", \"forward\": " << bench.forward << ", \"thread\": " << bench.thread
+       << ", \"precision\": " << bench.precision << ", \"memory_mode\": " << bench.memory
+       << ", \"batch\": " << bench.batch << ",\n";
+    os << "   \"load_ms\": " << result.loadTime << ", \"create_session_ms\": " << result.createTime
+       << ", \"resize_ms\": " << result.resizeTime << ", \"first_run_ms\": " << result.firstTime
+       << ", \"memory_mb\": " << result.memory << ",\n";
+    os << "   \"latency_ms\": {\"min\": " << percentile(result.costs, 0.0f) << ", \"avg\": " << avg
+       << ", \"p50\": " << percentile(result.costs, 0.5f) << ", \"p90\": " << percentile(result.costs, 0.9f)
+       << ", \"p99\": " << percentile(result.costs, 0.99f) << ", \"max\": " << percentile(result.costs, 1.0f)
+       << "},\n";
+    os << "   \"ops\": {";
+    bool firstOp = true;
+    for (auto& iter : result.opStats) {
+        os << (firstOp ? "\n" : ",\n");
+        os << "    \"" << iter.first << "\": {\"count\": " << iter.second.count << ", \"time_ms\": " << iter.second.time
+           << ", \"mflops\": " << iter.second.flops << "}";
+        firstOp = false;
+    }
+    os << "}}";
+}
+
+int main(int argc, const char* argv[]) {
+    std::cout << "MNN benchmark suite" << std::endl;
+    if (argc <= 1) {
+        std::cout << "Usage: " << argv[0]
+                  << " models_folder [loop_count] [warmup] [forwardtype] [threads] [precisions] [memory_modes] "
+                     "[batches] [output.json]"
+                  << std::endl;
+        std::cout << "threads, precisions, memory_modes and batches are comma separated lists, such as 1,2,4"
+                  << std::endl;
+        return 1;
+    }
+    int loop               = argc >= 3 ? atoi(argv[2]) : 10;
+    int warmup             = argc >= 4 ? atoi(argv[3]) : 10;
+    MNNForwardType forward = argc >= 5 ? static_cast<MNNForwardType>(atoi(argv[4])) : MNN_FORWARD_CPU;
+    auto threads           = parseList(argc >= 6 ? argv[5] : "4");
+    auto precisions        = parseList(argc >= 7 ? argv[6] : "2");
+    auto memories          = parseList(argc >= 8 ? argv[7] : "0");
+    auto batches           = parseList(argc >= 9 ? argv[8] : "1");
+    const char* jsonFile   = argc >= 10 ? argv[9] : "benchmark.json";
+
+    auto models = findModelFiles(argv[1]);
+    std::stringstream json;
+    json << "[";
+    bool first = true;
+    for (auto& m : models) {
+        for (auto thread : threads) {
+            for (auto precision : precisions) {
+                for (auto memory : memories) {
+                    for (auto batch : batches) {
+                        BenchConfig bench;
+                        bench.forward   = forward;
+                        bench.thread    = thread;
+                        bench.precision = precision;
+                        bench.memory    = memory;
+                        bench.batch     = batch;
+                        BenchResult result;
+                        if (!doBench(m, bench, loop, warmup, result)) {
+                            MNN_ERROR("Benchmark %s failed\n", m.name.c_str());
+                            continue;
+                        }
+                        printf("[ - ] %-24s thread=%d precision=%d memory=%d batch=%d  p50 = %8.3fms  p90 = %8.3fms  "
+                               "p99 = %8.3fms  mem = %.2fMB\n",
+                               m.name.c_str(), thread, precision, memory, batch, percentile(result.costs, 0.5f),
+                               percentile(result.costs, 0.9f), percentile(result.costs, 0.99f), result.memory);
+                        writeJson(json, m, bench, result, first);
+                        first = false;
+                    }
+                }
+            }
+        }
+    }
+    json << "\n]\n";
+    FILE* f = fopen(jsonFile, "w");
+    if (nullptr == f) {
+        MNN_ERROR("Can't open %s\n", jsonFile);
+        return 1;
+    }
+    auto content = json.str();
+    fwrite(content.c_str(), 1, content.size(), f);
+    fclose(f);
+    std::cout << "Result is written to " << jsonFile << std::endl;
+    return 0;
+}
@@ -0,0 +1,320 @@
+//
+//  benchmarkTrainExprModels.cpp
+//  MNN
+//
+//  Created by MNN on 2020/11/12.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#include <iostream>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <cfloat>
+#include <map>
+#include <cstring>
+#include <cstdlib>
+#if defined(_MSC_VER)
+#include <Windows.h>
+#undef min
+#undef max
+#else
+#include <sys/time.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/resource.h>
+#endif
+
+#include "MNN_generated.h"
+#include <MNN/MNNForwardType.h>
+#include <MNN/expr/Expr.hpp>
+#include <MNN/expr/ExprCreator.hpp>
+#include <MNN/expr/Executor.hpp>
+#include "module/PipelineModule.hpp"
+#include "ExprModels.hpp"
+#include "Loss.hpp"
+#include "SGD.hpp"
+
+using namespace MNN;
+using namespace MNN::Express;
+using namespace MNN::Train;
+
+/**
+ Train the expr models with synthetic data and split the time of every step into
+ graph construction, resize, forward, backward and optimizer update.
+ */
+struct StepCost {
+    float graph    = 0.0f;
+    float resize   = 0.0f;
+    float forward  = 0.0f;
+    float backward = 0.0f;
+    float update   = 0.0f;
+    size_t swapBytes = 0;
+};
+
+static inline uint64_t getTimeInUs() {
+    uint64_t time;
+#if defined(_MSC_VER)
+    LARGE_INTEGER now, freq;
+    QueryPerformanceCounter(&now);
+    QueryPerformanceFrequency(&freq);
+    uint64_t sec = now.QuadPart / freq.QuadPart;
+    uint64_t usec = (now.QuadPart % freq.QuadPart) * 1000000 / freq.QuadPart;
+    time = sec * 1000000 + usec;
+#else
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    time = static_cast<uint64_t>(tv.tv_sec) * 1000000 + tv.tv_usec;
+#endif
+    return time;
+}
+
+// Peak resident memory of the process in MB
+static float getPeakMemoryInMB() {
+#if defined(_MSC_VER)
+    return 0.0f;
+#else
+    struct rusage usage;
+    if (0 != getrusage(RUSAGE_SELF, &usage)) {
+        return 0.0f;
+    }
+#if defined(__APPLE__)
+    return usage.ru_maxrss / 1024.0f / 1024.0f;
+#else
+    return usage.ru_maxrss / 1024.0f;
+#endif
+#endif
+}
+
+// Bytes of the feature maps that the optimizer will read back from swap/
+static size_t getSwapBytes(const ParameterOptimizer* solver) {
+    size_t bytes = 0;
+#if !defined(_MSC_VER)
+    for (auto p : solver->swapable()) {
+        auto exprs = p->getInput2Expr();
+        if (exprs.size() != 1 || nullptr == exprs[0].lock()) {
+            continue;
+        }
+        auto outputs = exprs[0].lock()->outputVars();
+        if (outputs.empty() || nullptr == outputs[0].lock()) {
+            continue;
+        }
+        struct stat buffer;
+        auto fileName = "swap/" + outputs[0].lock()->name();
+        if (stat(fileName.c_str(), &buffer) == 0) {
+            bytes += buffer.st_size;
+        }
+    }
+#endif
+    return bytes;
+}
+
+static std::vector<std::string> splitArgs(const std::string& args, const std::string& delimiter) {
+    std::vector<std::string> result;
+    size_t pos = 0, nextPos = args.find(delimiter, 0);
+    while (nextPos != std::string::npos) {
+        result.push_back(args.substr(pos, nextPos - pos));
+        pos = nextPos + delimiter.length();
+        nextPos = args.find(delimiter, pos);
+    }
+    result.push_back(args.substr(pos, args.length() - pos));
+    return result;
+}
+
+static VARP createModel(const std::string& model, int& numClass) {
+    auto modelArgs = splitArgs(model.c_str(), "_");
+    auto modelType = modelArgs[0];
+    if (modelArgs.size() < 2) {
+        return nullptr;
+    }
+    numClass = atoi(modelArgs[1].c_str());
+    if (modelType == "MobileNetV1" && modelArgs.size() >= 4) {
+        auto mobileNetWidthType      = EnumMobileNetWidthTypeByString(modelArgs[2]);
+        auto mobileNetResolutionType = EnumMobileNetResolutionTypeByString(modelArgs[3]);
+        if (mobileNetWidthType < 0 || mobileNetResolutionType < 0) {
+            return nullptr;
+        }
+        return mobileNetV1Expr(mobileNetWidthType, mobileNetResolutionType, numClass);
+    } else if (modelType == "MobileNetV2") {
+        return mobileNetV2Expr(numClass);
+    } else if (modelType == "ResNet" && modelArgs.size() >= 3) {
+        auto resNetType = EnumResNetTypeByString(modelArgs[2]);
+        if (resNetType < 0) {
+            return nullptr;
+        }
+        return resNetExpr(resNetType, numClass);
+    } else if (modelType == "GoogLeNet") {
+        return googLeNetExpr(numClass);
+    } else if (modelType == "SqueezeNet") {
+        return squeezeNetExpr(numClass);
+    } else if (modelType == "ShuffleNet" && modelArgs.size() >= 3) {
+        return shuffleNetExpr(atoi(modelArgs[2].c_str()), numClass);
+    }
+    return nullptr;
+}
+
+static bool trainNet(VARP netOutput, int numClass, int loop, std::vector<StepCost>& costs) {
+    // Turn the constant weights of the model to trainable parameters
+    std::shared_ptr<Module> model;
+    std::vector<int> inputShape;
+    {
+        std::unique_ptr<NetT> netTable(new NetT);
+        Variable::save({netOutput}, netTable.get());
+        flatbuffers::FlatBufferBuilder builder(1024);
+        auto offset = CreateNet(builder, netTable.get());
+        builder.Finish(offset);
+        auto varMap       = Variable::loadMap(builder.GetBufferPointer(), builder.GetSize());
+        auto inputOutputs = Variable::getInputAndOutput(varMap);
+        auto inputs       = Variable::mapToSequence(inputOutputs.first);
+        auto outputs      = Variable::mapToSequence(inputOutputs.second);
+        if (inputs.size() != 1 || outputs.size() != 1) {
+            MNN_ERROR("Only support model with one input and one output\n");
+            return false;
+        }
+        inputShape = inputs[0]->getInfo()->dim;
+        model.reset(PipelineModule::extract(inputs, outputs, true));
+    }
+    std::shared_ptr<SGD> solver(new SGD(model));
+    solver->setLearningRate(0.0001f);
+    solver->setMomentum(0.9f);
+    solver->setWeightDecay(0.00004f);
+    model->setIsTraining(true);
+
+    auto exe = Executor::getGlobalExecutor();
+    for (int i = 0; i < loop; ++i) {
+        StepCost cost;
+        for (auto p : solver->swapable()) {
+            p->clearInput2Expr();
+        }
+        // Synthetic image and label
+        auto timeBegin = getTimeInUs();
+        auto input     = _Input(inputShape, NCHW);
+        auto inputPtr  = input->writeMap<float>();
+        auto inputSize = input->getInfo()->size;
+        for (int j = 0; j < inputSize; ++j) {
+            inputPtr[j] = (float)((j + i) % 255) / 255.0f;
+        }
+        std::vector<float> label(numClass, 0.0f);
+        label[i % numClass] = 1.0f;
+        auto target  = _Const(label.data(), {1, numClass}, NCHW);
+        auto predict = model->forward(_Convert(input, NC4HW4));
+        predict      = _Reshape(_Convert(predict, NCHW), {1, numClass});
+        auto loss    = _CrossEntropy(predict, target);
+        cost.graph   = (getTimeInUs() - timeBegin) / 1000.0f;
+
+        timeBegin = getTimeInUs();
+        Variable::prepareCompute({loss});
+        cost.resize = (getTimeInUs() - timeBegin) / 1000.0f;
+
+        timeBegin = getTimeInUs();
+        if (nullptr == loss->readMap<float>()) {
+            MNN_ERROR("Compute loss error\n");
+            return false;
+        }
+        cost.forward = (getTimeInUs() - timeBegin) / 1000.0f;
+
+        // Same as ParameterOptimizer::step, but time gradient and update separately
+        cost.swapBytes = getSwapBytes(solver.get());
+        timeBegin      = getTimeInUs();
+        auto res       = solver->onGetNextParameter(loss);
+        cost.backward  = (getTimeInUs() - timeBegin) / 1000.0f;
+        if (res.empty()) {
+            MNN_ERROR("Compute gradient error\n");
+            return false;
+        }
+        timeBegin = getTimeInUs();
+        for (auto iter : res) {
+            iter.second.fix(VARP::TRAINABLE);
+        }
+        for (auto iter : res) {
+            iter.first->input(iter.second);
+        }
+        cost.update = (getTimeInUs() - timeBegin) / 1000.0f;
+        solver->setCurrentStep(solver->currentStep() + 1);
+        costs.emplace_back(cost);
+        exe->gc(Executor::PART);
+    }
+    return true;
+}
+
+static void displayStats(const std::string& name, const std::vector<StepCost>& costs) {
+    // The first step includes the creation of the caches, report it separately
+    if (costs.empty()) {
+        return;
+    }
+    auto print = [](const char* tag, const StepCost& c) {
+        printf("[ - ] %-8s graph = %8.3fms  resize = %8.3fms  forward = %8.3fms  backward = %8.3fms  update = %8.3fms  "
+               "total = %8.3fms  swap = %.2fMB\n",
+               tag, c.graph, c.resize, c.forward, c.backward, c.update,
+               c.graph + c.resize + c.forward + c.backward + c.update, c.swapBytes / 1024.0f / 1024.0f);
+    };
+    printf("[ - ] %s\n", name.c_str());
+    print("first", costs[0]);
+    if (costs.size() > 1) {
+        StepCost avg;
+        for (int i = 1; i < costs.size(); ++i) {
+            avg.graph += costs[i].graph;
+            avg.resize += costs[i].resize;
+            avg.forward += costs[i].forward;
+            avg.backward += costs[i].backward;
+            avg.update += costs[i].update;
+            avg.swapBytes += costs[i].swapBytes;
+        }
+        float n = costs.size() - 1;
+        avg.graph /= n;
+        avg.resize /= n;
+        avg.forward /= n;
+        avg.backward /= n;
+        avg.update /= n;
+        avg.swapBytes /= (costs.size() - 1);
+        print("avg", avg);
+    }
+    printf("[ - ] peak memory = %.2fMB\n", getPeakMemoryInMB());
+}
+
+static void _printHelp() {
+    std::cout << "Usage: " << " model_to_benchmark [step_count] [forwardtype] [numberThread]" << std::endl;
+    std::cout << "model_to_benchmark: " << std::endl;
+    std::cout << "\t MobileNetV1_{numClass}_{width}_{resolution}, width: {1.0, 0.75, 0.5, 0.25}, resolution: {224, 192, 160, 128}, e.g: MobileNetV1_100_1.0_224" << std::endl;
+    std::cout << "\t MobileNetV2_{numClass}, e.g: MobileNetV2_100" << std::endl;
+    std::cout << "\t ResNet_{numClass}_{layer}, layer: {18, 34, 50, 101, 152}, e.g: ResNet_100_18" << std::endl;
+    std::cout << "\t GoogLeNet_{numClass}, e.g: GoogLeNet_100" << std::endl;
+    std::cout << "\t SqueezeNet_{numClass}, e.g: SqueezeNet_100" << std::endl;
+    std::cout << "\t ShuffleNet_{numClass}_{group}, group: [1, 2, 3, 4, 8], e.g: ShuffleNet_100_4" << std::endl;
+}
+
+int main(int argc, const char* argv[]) {
+    std::cout << "MNN Expr Models training benchmark" << std::endl;
+    if (argc <= 1 || strcmp(argv[1], "help") == 0 || argc > 5) {
+        _printHelp();
+        return 0;
+    }
+    int loop               = 5;
+    MNNForwardType forward = MNN_FORWARD_CPU;
+    int numThread          = 4;
+    if (argc >= 3) {
+        loop = atoi(argv[2]);
+    }
+    if (argc >= 4) {
+        forward = static_cast<MNNForwardType>(atoi(argv[3]));
+    }
+    if (argc >= 5) {
+        numThread = atoi(argv[4]);
+    }
+    BackendConfig config;
+    config.power = BackendConfig::Power_High;
+    Executor::getGlobalExecutor()->setGlobalExecutorConfig(forward, config, numThread);
+
+    int numClass = 0;
+    auto output  = createModel(argv[1], numClass);
+    if (nullptr == output || numClass <= 0) {
+        std::cout << "Not support Model " << argv[1] << std::endl;
+        return 1;
+    }
+    std::vector<StepCost> costs;
+    if (!trainNet(output, numClass, loop, costs)) {
+        return 1;
+    }
+    displayStats(argv[1], costs);
+    return 0;
+}
@@ -7,6 +7,9 @@
 //
 
 #include <MNN/expr/Executor.hpp>
+#include <algorithm>
+#include <functional>
+#include <map>
 #include "core/Session.hpp"
 #include "core/TensorUtils.hpp"
 #include "Utils.hpp"
@@ -159,6 +162,7 @@ std::shared_ptr<Executor> Executor::newExecutor(MNNForwardType type,
     Backend::Info info;
     info.type = type;
     info.numThread = numberThread;
+    info.user = (BackendConfig*)&config;
     std::shared_ptr<Runtime> bn(creator->onCreate(info));
     return std::shared_ptr<Executor>(new Executor(bn, type));
 }
@@ -271,7 +275,7 @@ void Executor::ComputeCache::setContentDirty() {
     mContentDirty = true;
 }
 
-Executor::ComputeCache::ComputeCache(std::shared_ptr<Backend> backend, std::shared_ptr<Backend> backupBackend) : mContext(backupBackend) {
+Executor::ComputeCache::ComputeCache(std::shared_ptr<Backend> backend, std::shared_ptr<Backend> backupBackend) : mContext(backupBackend, true, backend->type()) {
     mBackend = backend;
     mBackupBackend = backupBackend;
 }
@@ -424,6 +428,10 @@ ErrorCode Executor::ComputeCache::resize() {
         Timer autoTime;
 #endif
         GeometryComputerUtils::makeRaster(buffer, mCmdBuffer, mContext);
+        if (mBackend->type() == MNN_FORWARD_CPU) {
+            // Chains of elementwise ops run as one tiled loop instead of streaming every intermediate tensor
+            GeometryComputerUtils::fuseElementwise(mCmdBuffer);
+        }
 #ifdef MNN_EXPR_ENABLE_PROFILER
         float costTime = (float)autoTime.durationInUs() / (float)1000;
         ExecutorScope::Current()->addOpCostTime((int)OpType_If, costTime);
@@ -546,6 +554,14 @@ ErrorCode Executor::ComputeCache::resize() {
         if (NO_ERROR != code) {
             return code;
         }
+        for (auto t : cmd.outputs) {
+            // Nothing in this cache reads it
+            auto des = TensorUtils::getDescribe(t);
+            if (des->memoryType == Tensor::InsideDescribe::MEMORY_BACKEND && des->usage == Tensor::InsideDescribe::NORMAL &&
+                0 == des->useCount && nullptr != des->backend) {
+                des->backend->onReleaseBuffer(t, Backend::DYNAMIC);
+            }
+        }
         for (auto v = 0; v<cmd.inputs.size(); ++v) {
             if (!SizeComputer::opNeedContent(op->type(), v)) {
                 continue;
@@ -612,6 +628,106 @@ static void _collectExecuteUnit(std::vector<std::shared_ptr<Executor::Unit>>& de
     expr->inside()->mUnit = nullptr;
 }
 
+// Reorder the units, which are in a topological order, so that the next one run is the ready unit that releases the
+// most memory: the inputs it is the last consumer of minus the outputs it allocates. The tensors are released after
+// their last consumer when resizing, so in a backward graph every forward activation goes back to the allocator as
+// soon as the gradient ops using it have run, instead of staying alive until the output visited last needs it.
+static void _scheduleUnits(std::vector<std::shared_ptr<Executor::Unit>>& units) {
+    const int unitNumber = (int)units.size();
+    if (unitNumber <= 2) {
+        return;
+    }
+    std::map<const Tensor*, int> producer;
+    std::map<const Tensor*, int64_t> bytes;
+    for (int i = 0; i < unitNumber; ++i) {
+        auto& unit  = *units[i];
+        auto inside = unit.inside.lock();
+        for (int v = 0; v < unit.outputs.size(); ++v) {
+            producer[unit.outputs[v]] = i;
+            int64_t size = 0;
+            if (nullptr != inside && !inside->mInfoDirty && v < inside->mOutputInfos.size()) {
+                auto& info = inside->mOutputInfos[v];
+                size       = (int64_t)info.size * info.type.bytes();
+            }
+            if (TensorUtils::getDescribe(unit.outputs[v])->usage == Tensor::InsideDescribe::OUTPUT) {
+                // Kept until the cache is released, it never counts as freed
+                size = -size - 1;
+            }
+            bytes[unit.outputs[v]] = size;
+        }
+    }
+    // Distinct inputs produced in this cache, the units using each tensor and pending producers of each unit
+    std::vector<std::vector<const Tensor*>> inputs(unitNumber);
+    std::vector<std::vector<int>> users(unitNumber);
+    std::vector<int> waiting(unitNumber, 0);
+    std::map<const Tensor*, std::vector<int>> consumers;
+    for (int i = 0; i < unitNumber; ++i) {
+        for (auto t : units[i]->inputs) {
+            auto iter = producer.find(t);
+            if (iter == producer.end() || iter->second == i ||
+                std::find(inputs[i].begin(), inputs[i].end(), t) != inputs[i].end()) {
+                continue;
+            }
+            inputs[i].emplace_back(t);
+            users[iter->second].emplace_back(i);
+            waiting[i]++;
+            consumers[t].emplace_back(i);
+        }
+    }
+    // Only changes when the unit becomes the last pending consumer of an input
+    std::vector<int64_t> score(unitNumber, 0);
+    for (int i = 0; i < unitNumber; ++i) {
+        for (auto t : inputs[i]) {
+            if (1 == consumers[t].size() && bytes[t] > 0) {
+                score[i] += bytes[t];
+            }
+        }
+        for (auto t : units[i]->outputs) {
+            auto size = bytes[t];
+            if (size < 0) {
+                score[i] += size + 1;
+            } else if (consumers.find(t) != consumers.end()) {
+                score[i] -= size;
+            }
+        }
+    }
+    std::vector<int> ready;
+    for (int i = 0; i < unitNumber; ++i) {
+        if (0 == waiting[i]) {
+            ready.emplace_back(i);
+        }
+    }
+    std::vector<std::shared_ptr<Executor::Unit>> ordered;
+    ordered.reserve(unitNumber);
+    while (!ready.empty()) {
+        int best = 0;
+        for (int k = 1; k < ready.size(); ++k) {
+            // Keep the original order for the same score
+            auto current = score[ready[k]], bestScore = score[ready[best]];
+            if (current > bestScore || (current == bestScore && ready[k] < ready[best])) {
+                best = k;
+            }
+        }
+        int index = ready[best];
+        ready.erase(ready.begin() + best);
+        ordered.emplace_back(units[index]);
+        for (auto t : inputs[index]) {
+            auto& pending = consumers[t];
+            pending.erase(std::find(pending.begin(), pending.end(), index));
+            if (1 == pending.size() && bytes[t] > 0) {
+                score[pending[0]] += bytes[t];
+            }
+        }
+        for (auto u : users[index]) {
+            if (0 == --waiting[u]) {
+                ready.emplace_back(u);
+            }
+        }
+    }
+    MNN_ASSERT(ordered.size() == units.size());
+    units = std::move(ordered);
+}
+
 void Executor::_create(const std::vector<EXPRP>& outputs, std::set<std::shared_ptr<Executor::ComputeCache>>&& inputCaches, std::set<std::shared_ptr<Expr::Inside>>&& inputNode, bool forceCPU) {
     std::vector<EXPRP> packed;
     for (auto expr : outputs) {
@@ -652,6 +768,7 @@ void Executor::_create(const std::vector<EXPRP>& outputs, std::set<std::shared_p
     for (auto expr : packed) {
         _collectExecuteUnit(packedCache->mUnits, expr);
     }
+    _scheduleUnits(packedCache->mUnits);
     for (auto expr : packed) {
         expr->inside()->mCache = packedCache;
     }
@@ -728,9 +845,124 @@ void Executor::_visit(EXPRP expr, std::set<std::shared_ptr<Executor::ComputeCach
     //MNN_PRINT("Create %p, %s\n", expr.get(), EnumNameOpType(expr->get()->type()));
     expr->inside()->mUnit = unitP;
 }
+// Constants larger than it are not compared by content
+static const int gMaxCompareConstBytes = 1024;
+
+// Key of the value an expr computes, return false if the expr can't be shared
+static bool _exprKey(EXPRP expr, std::string& key) {
+    key.clear();
+    auto op = expr->get();
+    if (nullptr == op) {
+        // Input and trainable can be changed, only constants can be shared
+        if (expr->inputType() != VARP::CONSTANT) {
+            return false;
+        }
+        auto tensor = expr->inside()->mOutputTensors[0];
+        auto& info  = expr->inside()->mOutputInfos[0];
+        auto bytes  = info.size * info.type.bytes();
+        if (nullptr == tensor->host<char>() || bytes > gMaxCompareConstBytes) {
+            return false;
+        }
+        key.append("c");
+        key.append((const char*)&info.type, sizeof(info.type));
+        key.append((const char*)&info.order, sizeof(info.order));
+        key.append((const char*)info.dim.data(), info.dim.size() * sizeof(int));
+        key.append("|");
+        key.append(tensor->host<char>(), bytes);
+        return true;
+    }
+    if (op->type() == OpType_RandomUniform || nullptr == expr->extra().first) {
+        return false;
+    }
+    int outputSize = expr->outputSize();
+    key.append("o");
+    key.append((const char*)&outputSize, sizeof(int));
+    key.append(expr->extra().first.get(), expr->extra().second);
+    for (auto& input : expr->inputs()) {
+        auto inputExpr = input->expr();
+        auto ptr       = inputExpr.first.get();
+        key.append((const char*)&ptr, sizeof(ptr));
+        key.append((const char*)&inputExpr.second, sizeof(int));
+    }
+    return true;
+}
+
+void Executor::_eliminateCommonExpr(const std::vector<EXPRP>& outputs) {
+    // Collect the exprs that are not computed yet, inputs come before the exprs using them
+    std::vector<EXPRP> order;
+    std::function<void(EXPRP)> collect = [&](EXPRP expr) {
+        if (expr->visited()) {
+            return;
+        }
+        expr->setVisited(true);
+        bool compute = nullptr != expr->get() && nullptr == expr->inside()->mCache && nullptr == expr->inside()->mUnit;
+        if (compute) {
+            for (auto& input : expr->inputs()) {
+                collect(input->expr().first);
+            }
+        }
+        order.emplace_back(expr);
+    };
+    for (auto& expr : outputs) {
+        collect(expr);
+    }
+    std::set<Expr*> outputSet;
+    for (auto& expr : outputs) {
+        outputSet.insert(expr.get());
+    }
+    // The first expr of each key is kept, the later ones are replaced in their users' inputs. They're no longer
+    // reachable from the outputs, so no unit is created for them
+    std::map<std::string, EXPRP> exprMap;
+    std::map<Expr*, EXPRP> replaced;
+    std::string key;
+    for (auto& expr : order) {
+        expr->setVisited(false);
+        bool compute = nullptr != expr->get() && nullptr == expr->inside()->mCache && nullptr == expr->inside()->mUnit;
+        if (!compute && nullptr != expr->get()) {
+            continue;
+        }
+        for (int i = 0; i < expr->mInputs.size(); ++i) {
+            auto inputExpr = expr->mInputs[i]->expr();
+            auto iter      = replaced.find(inputExpr.first.get());
+            if (iter == replaced.end()) {
+                continue;
+            }
+            auto newInput = Variable::create(iter->second, inputExpr.second);
+            newInput->addInput2expr(expr);
+            iter->second->mTo.emplace_back(WeakEXPRP(expr));
+            // The replaced expr no longer outputs to expr
+            for (auto& to : inputExpr.first->mTo) {
+                if (to.lock().get() == expr.get()) {
+                    to.reset();
+                }
+            }
+            expr->mInputs[i] = newInput;
+        }
+        if (!_exprKey(expr, key)) {
+            continue;
+        }
+        auto iter = exprMap.find(key);
+        if (iter == exprMap.end()) {
+            exprMap.insert(std::make_pair(key, expr));
+            continue;
+        }
+        if (outputSet.find(expr.get()) != outputSet.end()) {
+            continue;
+        }
+        replaced.insert(std::make_pair(expr.get(), iter->second));
+        if (nullptr != expr->get()) {
+            mEliminatedNumber++;
+            for (auto& info : expr->inside()->mOutputInfos) {
+                mEliminatedBytes += info.size * info.type.bytes();
+            }
+        }
+    }
+}
+
 void Executor::_makeCache(const std::vector<EXPRP>& expr, bool forceCPU) {
     std::set<std::shared_ptr<Executor::ComputeCache>> inputCaches;
     std::set<std::shared_ptr<Expr::Inside>> inputNode;
+    _eliminateCommonExpr(expr);
     for (auto e : expr) {
         // 这里的create感觉像是创建Tensor的参数信息，但是不会分配内存
         _visit(e, inputCaches, inputNode);
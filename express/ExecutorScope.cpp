@@ -15,11 +15,7 @@ namespace MNN {
 namespace Express {
 
 typedef std::shared_ptr<Express::Executor> ExecutorRef;
-#if !defined(__APPLE__)
 thread_local static Scope<ExecutorRef> g_executor_scope;
-#else
-static Scope<ExecutorRef> g_executor_scope;
-#endif
 
 ExecutorScope::ExecutorScope(const std::shared_ptr<Executor>& current) {
     g_executor_scope.EnterScope(current);
@@ -0,0 +1,96 @@
+//
+//  KVCache.cpp
+//  MNN
+//
+//  Created by MNN on 2020/11/27.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#include <MNN/expr/KVCache.hpp>
+#include <MNN/expr/ExprCreator.hpp>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+namespace MNN {
+namespace Express {
+
+KVCache::KVCache(INTS shape, Dimensionformat order) {
+    MNN_ASSERT(shape.size() >= 2);
+    auto dims       = (int)shape.size();
+    shape[dims - 2] = std::max(shape[dims - 2], 1);
+    mCapacity       = shape[dims - 2];
+    mOutside        = 1;
+    for (int i = 0; i < dims - 2; ++i) {
+        mOutside *= shape[i];
+    }
+    mRowBytes = shape[dims - 1] * sizeof(float);
+    mCache    = _Input(shape, order, halide_type_of<float>());
+    ::memset(mCache->writeMap<void>(), 0, (size_t)mOutside * mCapacity * mRowBytes);
+    mLength = _Input({1}, NCHW, halide_type_of<int32_t>());
+    mLength->writeMap<int32_t>()[0] = 0;
+}
+
+bool KVCache::_grow(int capacity) {
+    auto shape              = mCache->getInfo()->dim;
+    shape[shape.size() - 2] = capacity;
+    const size_t oldStride  = (size_t)mCapacity * mRowBytes;
+    const size_t newStride  = (size_t)capacity * mRowBytes;
+    std::vector<uint8_t> origin(mOutside * oldStride);
+    ::memcpy(origin.data(), mCache->readMap<void>(), origin.size());
+    // Keep the variable, so the graphs built on it only need resize
+    if (!mCache->resize(shape)) {
+        return false;
+    }
+    auto dst = mCache->writeMap<uint8_t>();
+    for (int o = 0; o < mOutside; ++o) {
+        ::memcpy(dst + o * newStride, origin.data() + o * oldStride, mSize * mRowBytes);
+        ::memset(dst + o * newStride + mSize * mRowBytes, 0, newStride - mSize * mRowBytes);
+    }
+    mCapacity = capacity;
+    return true;
+}
+
+bool KVCache::append(VARP entries) {
+    auto info = entries->getInfo();
+    if (nullptr == info || info->dim.size() < 2 || info->type != halide_type_of<float>()) {
+        MNN_ERROR("KVCache: invalid entries\n");
+        return false;
+    }
+    auto dims   = (int)info->dim.size();
+    auto number = info->dim[dims - 2];
+    if (info->dim[dims - 1] * (int)sizeof(float) != mRowBytes || info->size != mOutside * number * info->dim[dims - 1]) {
+        MNN_ERROR("KVCache: the shape of entries don't match the cache\n");
+        return false;
+    }
+    auto src = entries->readMap<uint8_t>();
+    if (nullptr == src) {
+        return false;
+    }
+    if (mSize + number > mCapacity) {
+        int capacity = mCapacity > 0 ? mCapacity : 1;
+        while (capacity < mSize + number) {
+            capacity *= 2;
+        }
+        if (!_grow(capacity)) {
+            return false;
+        }
+    }
+    // Only the new rows are copied
+    auto dst = mCache->writeMap<uint8_t>();
+    for (int o = 0; o < mOutside; ++o) {
+        ::memcpy(dst + ((size_t)o * mCapacity + mSize) * mRowBytes, src + (size_t)o * number * mRowBytes,
+                 number * mRowBytes);
+    }
+    mSize += number;
+    mLength->writeMap<int32_t>()[0] = mSize;
+    return true;
+}
+
+void KVCache::reset() {
+    mSize                           = 0;
+    mLength->writeMap<int32_t>()[0] = 0;
+}
+
+} // namespace Express
+} // namespace MNN
@@ -1569,5 +1569,24 @@ VARP _Select(VARP select, VARP input0, VARP input1) {
     return (Variable::create(Expr::create(std::move(selectOp), {select, input0, input1})));
 }
 
+VARP _ScaledDotProductAttention(VARP query, VARP key, VARP value, VARP mask, float scale, bool causal,
+                                VARP kvLength) {
+    std::unique_ptr<OpT> op(new OpT);
+    op->type       = OpType_Attention;
+    op->main.type  = OpParameter_AttentionParam;
+    op->main.value = new AttentionParamT;
+    op->main.AsAttentionParam()->scale    = scale;
+    op->main.AsAttentionParam()->causal   = causal;
+    op->main.AsAttentionParam()->kvLength = nullptr != kvLength;
+    std::vector<VARP> inputs{query, key, value};
+    if (nullptr != mask) {
+        inputs.emplace_back(mask);
+    }
+    if (nullptr != kvLength) {
+        inputs.emplace_back(kvLength);
+    }
+    return Variable::create(Expr::create(std::move(op), inputs));
+}
+
 } // namespace Express
 } // namespace MNN
@@ -150,17 +150,22 @@ public:
         auto dimFormat = x->getInfo()->order;
         VARP outputData = nullptr;
         if (getIsTraining()) {
-            if (dimFormat == NC4HW4 || dimFormat == NHWC) {
-                x = _Convert(x, NCHW);
+            if (dimFormat == NHWC) {
+                x = _Convert(x, NC4HW4);
             }
             MNN_ASSERT(x->getInfo()->dim[1] == mChannels);
-            auto sampleMean     = _ReduceMean(x, mReductionDims, true); // mean for each channel in the batch
-            auto xSub = x - sampleMean;
-            auto sampleVar      = _ReduceMean(_Square(xSub), mReductionDims,
-                                         true); // variance for each channel in the batch
-            auto rSampleStd     = _Reciprocal(_Sqrt(sampleVar + _Const(mEps)));
-            auto normalizedData = xSub * rSampleStd;
-            outputData          = normalizedData * mScale + mBias;
+            // The fused op keeps only the mean and 1 / std of each channel for backward
+            std::unique_ptr<OpT> bnOp(new OpT);
+            bnOp->type                         = OpType_BatchNormTrain;
+            bnOp->main.type                    = OpParameter_BatchNorm;
+            bnOp->main.value                   = new BatchNormT;
+            bnOp->main.AsBatchNorm()->channels = mChannels;
+            bnOp->main.AsBatchNorm()->epsilon  = mEps;
+            auto bnExpr     = Expr::create(std::move(bnOp), {x, mScale, mBias}, 3);
+            outputData      = Variable::create(bnExpr, 0);
+            auto sampleMean = Variable::create(bnExpr, 1);
+            auto rSampleStd = Variable::create(bnExpr, 2);
+            auto sampleVar  = _Reciprocal(_Square(rSampleStd)) - _Const(mEps);
 
             mRunningMean = _Const(mMomentum) * mRunningMean + _Const(1 - mMomentum) * sampleMean;
             mRunningVariance = _Const(mMomentum) * mRunningVariance + _Const(1 - mMomentum) * sampleVar;
@@ -123,6 +123,26 @@ public:
         Session_Input_Inside = 2,
         /** The input tensor is alloced by user, set input data before session resize*/
         Session_Input_User = 3,
+
+        /** About op schedule, Default Session_Schedule_Serial*/
+        /** Ops are run one by one, every op use all threads*/
+        Session_Schedule_Serial = 4,
+        /** Independent ops are run concurrently on CPU, one thread for each op*/
+        Session_Schedule_Parallel = 5,
+
+        /** About layout, Default Session_Layout_Keep*/
+        /** Every op keeps the layout of its own*/
+        Session_Layout_Keep = 6,
+        /** Layouts are propagated through the ops that accept any layout on CPU to remove conversions,
+            see LAYOUT_CONVERT_SAVED*/
+        Session_Layout_Propagate = 7,
+
+        /** About resize, Default Session_Resize_Full*/
+        /** Every resize makes the memory plan and resizes all ops again*/
+        Session_Resize_Full = 8,
+        /** A resize keeps the memory and the resize of the ops whose tensors keep their shapes on CPU, see
+            RESIZE_SKIPPED. The memory of the last full plan is hold besides the memory of the changed ops*/
+        Session_Resize_Incremental = 9,
     };
     /**
      * @brief The API shoud be called before create session.
@@ -135,6 +155,7 @@ public:
      * @brief The API shoud be called before create session.
      * If the cache exist, try to load cache from file.
      * After createSession, try to save cache to file.
+     * The CPU backend caches the packed weights of convolutions, so that they needn't be packed again.
      * @param cacheFile      cache file name
      * @param keySize        the first `keySize` bytes used as the key to check if the `cacheFile` exists.
      * @return void
@@ -243,6 +264,23 @@ public:
     ErrorCode runSessionWithCallBackInfo(const Session* session, const TensorCallBackWithInfo& before,
                                          const TensorCallBackWithInfo& end, bool sync = false) const;
 
+    /**
+     * @brief make a stateful session for streaming. after each run, the value of each state output is copied to its
+     *        state input, such as the hidden state of RNN or the context frames of temporal convolution, so the next
+     *        run only computes the new frames. the state inputs are zero at first and are kept by resizeSession if
+     *        their shape is not changed.
+     * @param session   given session.
+     * @param states    pairs of (input name, output name), the two tensors must have the same element size.
+     * @return false if any name is not an input / output of the session.
+     */
+    bool setSessionStates(Session* session, const std::vector<std::pair<std::string, std::string>>& states);
+
+    /**
+     * @brief set the state inputs of session to zero to begin a new sequence.
+     * @param session   given session.
+     */
+    void resetSessionStates(Session* session);
+
     /**
      * @brief get input tensor for given name.
      * @param session   given session.
@@ -268,6 +306,13 @@ public:
         /** Backends in session in M, int*, length >= the configs when create session */
         BACKENDS = 2,
 
+        /** layout conversion removed by layout propagation in MB, float* */
+        LAYOUT_CONVERT_SAVED = 3,
+
+        /** number of ops whose resize is skipped by the last resize under Session_Resize_Incremental, because their
+            inputs and outputs are not changed, int* */
+        RESIZE_SKIPPED = 4,
+
         ALL
     };
 
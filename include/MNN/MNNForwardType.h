@@ -69,6 +69,20 @@ struct BackendConfig {
         void* sharedContext = nullptr;
         size_t flags; // Valid for CPU Backend
     };
+
+    /** Placement of the threads of CPU backend on the cores, valid for MNN's thread pool on Linux.
+        None: keep the placement of the thread pool shared in the process.
+        Compact: one thread per physical core, fill a NUMA node before the next one.
+        Scatter: one thread per physical core, round robin on the NUMA nodes.
+        Reset: remove the pinning of the shared thread pool.
+        Compact, Scatter and Reset change the shared pool for every runtime using it.
+        Node: the runtime uses a pool of its own on the NUMA node of the thread creating it, and the pages of its
+        buffers are placed on that node. Run the session from a thread on the node, it computes a part of the tasks.
+        The hyper-threads of a core are used after all physical cores.
+        Appended after the other fields to keep the layout of them. */
+    enum AffinityMode { Affinity_None = 0, Affinity_Compact, Affinity_Scatter, Affinity_Node, Affinity_Reset };
+
+    AffinityMode affinity = Affinity_None;
 };
 }; // namespace MNN
 #endif
@@ -0,0 +1,2 @@
+#define MNN_REVISION "28b1531fc720b9e03a469c7cb1d04845d3c64155"
+#define MNN_REPOSITORY "/root/repo"
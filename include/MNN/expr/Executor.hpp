@@ -14,6 +14,7 @@
 #include <vector>
 #include <mutex>
 #include <set>
+#include <atomic>
 #include <MNN/MNNForwardType.h>
 namespace MNN {
 //下面的这些东西可以当作ptr使用，而非obj
@@ -60,6 +61,10 @@ public:
     void addOpCostTime(int op, float costTime);
     void addOpCostTime(const std::string& type, float costTime);
     void addOpFlops(const std::string& type, float flops);
+    // Number of exprs and bytes of their outputs removed by common subexpression elimination in makeCache
+    std::pair<int, size_t> getEliminatedInfo() const {
+        return std::make_pair(mEliminatedNumber.load(), mEliminatedBytes.load());
+    }
     class Profiler;
     static RuntimeInfo getRuntime();
 private:
@@ -67,12 +72,15 @@ private:
     void _create(const std::vector<EXPRP>& outputs, std::set<std::shared_ptr<Executor::ComputeCache>>&& inputCaches, std::set<std::shared_ptr<Expr::Inside>>&& inputNode, bool forceCPU);
 
     void _visit(EXPRP expr, std::set<std::shared_ptr<Executor::ComputeCache>>& inputCaches, std::set<std::shared_ptr<Expr::Inside>>& inputNode);
+    void _eliminateCommonExpr(const std::vector<EXPRP>& outputs);
 
     Executor(std::shared_ptr<Runtime> backend, MNNForwardType type);
     std::pair<std::shared_ptr<Runtime>, MNNForwardType> mRuntime;
     std::pair<std::shared_ptr<Runtime>, MNNForwardType> mBackupRuntime;
     std::mutex mMutex;
     std::shared_ptr<Profiler> mProfiler;
+    std::atomic<int> mEliminatedNumber = {0};
+    std::atomic<size_t> mEliminatedBytes = {0};
 };
 } // namespace Express
 } // namespace MNN
@@ -0,0 +1,63 @@
+//
+//  KVCache.hpp
+//  MNN
+//
+//  Created by MNN on 2020/11/27.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#ifndef MNN_EXPR_KVCACHE_HPP_
+#define MNN_EXPR_KVCACHE_HPP_
+
+#include <MNN/expr/Expr.hpp>
+
+namespace MNN {
+namespace Express {
+
+/* Key or value cache for incremental decoding, cache() is [..., capacity, d] and only the first size() entries are
+   valid. append() copies the new entries in place after the valid ones and updates length(), so the graph built on
+   cache() and length() (such as _ScaledDotProductAttention with kvLength) is recomputed without resize while the
+   capacity holds. When it's full the capacity is doubled, which resizes the graph once.
+ */
+class MNN_PUBLIC KVCache {
+public:
+    // shape: [..., capacity, d]
+    KVCache(INTS shape, Dimensionformat order = NCHW);
+    KVCache(const KVCache&) = delete;
+    KVCache& operator=(const KVCache&) = delete;
+    ~KVCache() = default;
+
+    // entries: [..., n, d] with the same leading dims and d as the cache
+    bool append(VARP entries);
+    // Drop all entries and keep the capacity
+    void reset();
+
+    VARP cache() const {
+        return mCache;
+    }
+    // Number of valid entries, int [1]
+    VARP length() const {
+        return mLength;
+    }
+    int size() const {
+        return mSize;
+    }
+    int capacity() const {
+        return mCapacity;
+    }
+
+private:
+    bool _grow(int capacity);
+    VARP mCache;
+    VARP mLength;
+    int mSize = 0;
+    int mCapacity;
+    // Number of rows before the capacity axis and bytes of a row
+    int mOutside;
+    int mRowBytes;
+};
+
+} // namespace Express
+} // namespace MNN
+
+#endif // MNN_EXPR_KVCACHE_HPP_
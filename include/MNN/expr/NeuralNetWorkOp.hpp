@@ -136,6 +136,14 @@ MNN_PUBLIC VARP _Int8ToFloat(VARP x, VARP scale);
 
 MNN_PUBLIC VARP _Select(VARP select, VARP input0, VARP input1);
 
+/* softmax(scale * query * key^T + mask) * value, fused on CPU without storing the attention matrix
+ query: [..., lq, d], key: [..., lk, d], value: [..., lk, dv], mask: [lq, lk] or [..., lq, lk], additive
+ scale <= 0 means 1 / sqrt(d)
+ kvLength: int [1], only the first kvLength keys / values are read, see KVCache
+ */
+MNN_PUBLIC VARP _ScaledDotProductAttention(VARP query, VARP key, VARP value, VARP mask = nullptr,
+                                           float scale = 0.0f, bool causal = false, VARP kvLength = nullptr);
+
 } // namespace Express
 } // namespace MNN
 
@@ -74,6 +74,8 @@ typedef struct {
     PyObject_HEAD
     Tensor *tensor;
     int owner;
+    // The numpy array whose memory the tensor wraps, kept alive until the tensor is released
+    PyObject *base;
 } PyMNNTensor;
 
 typedef struct {
@@ -306,6 +308,9 @@ static PyObject* PyMNNTensor_getData(PyMNNTensor *self, PyObject *args);
 static PyObject* PyMNNTensor_getHost(PyMNNTensor *self, PyObject *args);
 static PyObject* PyMNNTensor_copyFrom(PyMNNTensor *self, PyObject *args);
 static PyObject* PyMNNTensor_copyToHostTensor(PyMNNTensor *self, PyObject *args);
+#ifndef USE_PRIVATE
+static PyObject* PyMNNTensor_getArrayInterface(PyMNNTensor *self, void *closure);
+#endif
 
 static PyMethodDef PyMNNTensor_methods[] = {
 #ifndef USE_PRIVATE
@@ -323,6 +328,13 @@ static PyMethodDef PyMNNTensor_methods[] = {
     {NULL}  /* Sentinel */
 };
 
+static PyGetSetDef PyMNNTensor_getsetters[] = {
+#ifndef USE_PRIVATE
+    {(char *)"__array_interface__", (getter)PyMNNTensor_getArrayInterface, NULL, (char *)"numpy view of host memory", NULL},
+#endif
+    {NULL}  /* Sentinel */
+};
+
 static PyTypeObject PyMNNTensorType = {
     PyVarObject_HEAD_INIT(NULL, 0)
     "MNN.Tensor",                   /*tp_name*/
@@ -353,7 +365,7 @@ static PyTypeObject PyMNNTensorType = {
     0,                                        /* tp_iternext */
     PyMNNTensor_methods,                                   /* tp_methods */
     0,                      /* tp_members */
-    0,                    /* tp_getset */
+    PyMNNTensor_getsetters,                    /* tp_getset */
     0,                                        /* tp_base */
     0,                                        /* tp_dict */
     0,                                        /* tp_descr_get */
@@ -1198,11 +1210,12 @@ static PyObject* PyMNNTensor_new(struct _typeobject *type, PyObject *args, PyObj
 
 static void PyMNNTensor_dealloc(PyMNNTensor *self) {
     if (self->owner) {
-        if (self->tensor->host<void *>()) {
+        if (NULL == self->base && self->tensor->host<void *>()) {
             free(self->tensor->host<void *>());
         }
         delete self->tensor;
     }
+    Py_XDECREF(self->base);
     Py_TYPE(self)->tp_free((PyObject*)self);
 }
 
@@ -1311,22 +1324,32 @@ static int PyMNNTensor_init(PyMNNTensor *self, PyObject *args, PyObject *kwds) {
         }
     }
 #ifndef USE_PRIVATE
+    else if (PyArray_ISCARRAY((PyArrayObject*)data) && PyArray_TYPE(data) == dtype2npytype(dtype)) {
+        // Share the memory of a contiguous, aligned and writeable numpy array instead of copying it
+        pData = PyArray_DATA((PyArrayObject*)data);
+        Py_INCREF(data);
+        self->base = data;
+    }
     else {
-        int npy_type = PyArray_TYPE(data);
+        int npy_type = dtype2npytype(dtype);
+        if (NPY_NOTYPE == npy_type) {
+            PyErr_SetString(PyExc_Exception,"PyMNNTensor_init: unsupported data type for numpy");
+            return -1;
+        }
+        // Copy the other arrays, converted to the dtype of the tensor and made contiguous
+        PyArrayObject *data_cont = (PyArrayObject*)PyArray_ContiguousFromAny(data, npy_type, 0, 0);
+        if (NULL == data_cont) {
+            return -1;
+        }
         int itemsize = getitemsize(dtype, npy_type);
         pData = malloc(dataSize * itemsize);
         if(NULL == pData) {
+            Py_DECREF(data_cont);
             PyErr_SetString(PyExc_Exception,"PyMNNTensor_init: malloc failed");
             return -1;
         }
-        PyArrayObject *data_cont= PyArray_GETCONTIGUOUS((PyArrayObject*)data);
-        auto tmpBuffer = PyArray_DATA(data_cont);
-        if(NULL == tmpBuffer) {
-             PyErr_SetString(PyExc_Exception,"PyMNNTensor_init: ndarry failed to get buffer data");
-             return -1;
-        }
-        memcpy(pData, tmpBuffer, dataSize * itemsize);
-        Py_XDECREF(data_cont);
+        memcpy(pData, PyArray_DATA(data_cont), dataSize * itemsize);
+        Py_DECREF(data_cont);
      }
  #endif
     Tensor *tensor = Tensor::create(vShape
@@ -1337,6 +1360,10 @@ static int PyMNNTensor_init(PyMNNTensor *self, PyObject *args, PyObject *kwds) {
     if (!tensor) {
         PyErr_SetString(PyExc_Exception,
                         "PyMNNTensor_create: Tensor create failed");
+        if (NULL == self->base) {
+            free(pData);
+        }
+        Py_CLEAR(self->base);
         return -1;
     }
     self->tensor = tensor;
@@ -1351,23 +1378,28 @@ static PyObject* PyMNNTensor_fromNumpy(PyMNNTensor *self, PyObject *args) {
     }
     if (!PyArray_Check(data)) {
         PyErr_SetString(PyExc_Exception,"PyMNNTensor_fromNumpy: input is not a numpy");
+        return NULL;
     }
     if (self->owner){
-        if(self->tensor->size() != PyArray_Size(data)) {
+        if(self->tensor->elementSize() != PyArray_Size(data)) {
             PyErr_SetString(PyExc_Exception,"PyMNNTensor_fromNumpy: tensor/numpy size does not match each other");
             return NULL;
         }
-        DType dtype = htype2dtype(self->tensor->getType());
-        int npy_type = PyArray_TYPE(data);
-        int itemsize = getitemsize(dtype, npy_type);
-        PyArrayObject *data_cont= PyArray_GETCONTIGUOUS((PyArrayObject*)data);
+        int npy_type = dtype2npytype(htype2dtype(self->tensor->getType()));
+        if (NPY_NOTYPE == npy_type) {
+            PyErr_SetString(PyExc_Exception,"PyMNNTensor_fromNumpy: unsupported data type for numpy");
+            return NULL;
+        }
+        PyArrayObject *data_cont = (PyArrayObject*)PyArray_ContiguousFromAny(data, npy_type, 0, 0);
+        if (NULL == data_cont) {
+            return NULL;
+        }
+        // Nothing to copy when the tensor wraps this array
         auto tmpBuffer = PyArray_DATA(data_cont);
-        if(NULL == tmpBuffer) {
-             PyErr_SetString(PyExc_Exception,"PyMNNTensor_fromNumpy: ndarry failed to get buffer data");
-             return NULL;
+        if (tmpBuffer != self->tensor->host<void *>()) {
+            memcpy(self->tensor->host<void *>(), tmpBuffer, self->tensor->size());
         }
-        memcpy(self->tensor->host<void *>(), tmpBuffer, self->tensor->size() * itemsize);
-        Py_XDECREF(data_cont);
+        Py_DECREF(data_cont);
     }
     Py_RETURN_NONE;
 }
@@ -1412,6 +1444,16 @@ static PyObject* PyMNNTensor_getDataType(PyMNNTensor *self, PyObject *args) {
     Py_RETURN_NONE;
 }
 
+#ifndef USE_PRIVATE
+static int tensorNpyType(halide_type_t t) {
+    // htype2dtype treats double as float
+    if (t == *httDouble()) {
+        return NPY_DOUBLE;
+    }
+    return dtype2npytype(htype2dtype(t));
+}
+#endif
+
 static PyObject* PyMNNTensor_getData(PyMNNTensor *self, PyObject *args) {
     if (self->tensor) {
         halide_type_t t = self->tensor->getType();
@@ -1458,21 +1500,16 @@ static PyObject* PyMNNTensor_getData(PyMNNTensor *self, PyObject *args) {
          for(const auto dim : self->tensor->shape()) {
             npy_dims.push_back(dim);
          }
-         if (t == *httInt()) {
-            auto data = self->tensor->host<int32_t>();
-            return PyArray_SimpleNewFromData(npy_dims.size(), npy_dims.data(), NPY_INT32, data);
-         } else if (t == *httUint8()) {
-            auto data = self->tensor->host<uint8_t>();
-            return PyArray_SimpleNewFromData(npy_dims.size(), npy_dims.data(), NPY_UINT8, data);
-         } else if (t == *httInt64()) {
-            auto data = self->tensor->host<int64_t>();
-            return PyArray_SimpleNewFromData(npy_dims.size(), npy_dims.data(), NPY_INT64, data);
-         } else if (t == *httFloat()) {
-            auto data = self->tensor->host<float>();
-            return PyArray_SimpleNewFromData(npy_dims.size(), npy_dims.data(), NPY_FLOAT, data);
-         } else if (t == *httDouble()) {
-            auto data = self->tensor->host<double>();
-            return PyArray_SimpleNewFromData(npy_dims.size(), npy_dims.data(), NPY_DOUBLE, data);
+         int npy_type = tensorNpyType(t);
+         if (t == *httInt() || t == *httUint8() || t == *httInt64() || t == *httFloat() || t == *httDouble()) {
+            // A view of the tensor memory, which holds a reference of the tensor
+            PyObject *outputData = PyArray_SimpleNewFromData(npy_dims.size(), npy_dims.data(), npy_type,
+                                                             self->tensor->host<void>());
+            if (NULL != outputData) {
+                Py_INCREF(self);
+                PyArray_SetBaseObject((PyArrayObject *)outputData, (PyObject *)self);
+            }
+            return outputData;
          } else if (t == *httString()) {
             auto data = self->tensor->host<char *>();
             PyObject *outputData = PyTuple_New(size);
@@ -1532,6 +1569,37 @@ static PyObject* PyMNNTensor_copyToHostTensor(PyMNNTensor *self, PyObject *args)
     Py_RETURN_TRUE;
 }
 
+#ifndef USE_PRIVATE
+static PyObject* PyMNNTensor_getArrayInterface(PyMNNTensor *self, void *closure) {
+    if (NULL == self->tensor || NULL == self->tensor->host<void>() ||
+        self->tensor->getDimensionType() == Tensor::CAFFE_C4) {
+        // Device and NC4HW4 tensors must be copied to a host tensor first
+        PyErr_SetString(PyExc_AttributeError, "__array_interface__ needs a host tensor in NCHW or NHWC");
+        return NULL;
+    }
+    halide_type_t t = self->tensor->getType();
+    if (t == *httString()) {
+        PyErr_SetString(PyExc_AttributeError, "__array_interface__ does not support string tensor");
+        return NULL;
+    }
+    PyArray_Descr *descr = PyArray_DescrFromType(tensorNpyType(t));
+    PyObject *typestr = PyObject_GetAttrString((PyObject *)descr, "str");
+    Py_DECREF(descr);
+    if (NULL == typestr) {
+        return NULL;
+    }
+    auto shape = self->tensor->shape();
+    PyObject *shapeTuple = PyTuple_New(shape.size());
+    for (int i=0; i<shape.size(); i++) {
+        PyTuple_SetItem(shapeTuple, i, PyLong_FromLong(shape[i]));
+    }
+    PyObject *data = Py_BuildValue("(NO)", PyLong_FromVoidPtr(self->tensor->host<void>()), Py_False);
+    PyObject *interface = Py_BuildValue("{sNsNsNsi}", "shape", shapeTuple, "typestr", typestr, "data", data,
+                                        "version", 3);
+    return interface;
+}
+#endif
+
 static PyObject* PyMNNTensor_getShape(PyMNNTensor *self, PyObject *args) {
     if (self->tensor) {
         PyObject *shape = PyTuple_New(self->tensor->shape().size());
@@ -177,6 +177,23 @@ halide_type_t dtype2htype(DType dtype) {
     return halide_type_of<float>();
 }
 #ifndef USE_PRIVATE
+inline int dtype2npytype(int dtype)
+{
+    switch(dtype) {
+      case DType_FLOAT:
+        return NPY_FLOAT;
+      case DType_DOUBLE:
+        return NPY_DOUBLE;
+      case DType_INT32:
+        return NPY_INT;
+      case DType_INT64:
+        return NPY_INT64;
+      case DType_UINT8:
+        return NPY_UINT8;
+      default:
+        return NPY_NOTYPE;
+    }
+}
 inline int getitemsize(int dtype, int npy_type)
 {
     switch(dtype) {
@@ -0,0 +1,83 @@
+# Tests of the numpy memory shared by MNN.Tensor, run after installing the MNN wheel:
+#   python tensor_numpy_test.py
+from __future__ import print_function
+import gc
+import sys
+import unittest
+import numpy as np
+import MNN
+
+def create_tensor(shape, data, halide_type=MNN.Halide_Type_Float):
+    return MNN.Tensor(shape, halide_type, data, MNN.Tensor_DimensionType_Caffe)
+
+class TensorNumpyTest(unittest.TestCase):
+    def test_wrap_contiguous_array(self):
+        data = np.arange(24, dtype=np.float32).reshape(2, 3, 4)
+        refcount = sys.getrefcount(data)
+        tensor = create_tensor((2, 3, 4), data)
+        # The tensor holds a reference of the array and uses its memory
+        self.assertEqual(sys.getrefcount(data), refcount + 1)
+        data[1, 2, 3] = 100.0
+        self.assertEqual(tensor.getData()[1, 2, 3], 100.0)
+        del tensor
+        gc.collect()
+        self.assertEqual(sys.getrefcount(data), refcount)
+
+    def test_copy_non_contiguous_array(self):
+        data = np.arange(48, dtype=np.float32).reshape(4, 12)[:, ::2]
+        self.assertFalse(data.flags['C_CONTIGUOUS'])
+        refcount = sys.getrefcount(data)
+        tensor = create_tensor((4, 6), data)
+        self.assertEqual(sys.getrefcount(data), refcount)
+        expect = data.copy()
+        data[0, 0] = 100.0
+        self.assertTrue(np.array_equal(tensor.getData(), expect))
+
+    def test_copy_mismatched_dtype(self):
+        data = np.arange(24, dtype=np.float64).reshape(2, 3, 4) * 0.5
+        refcount = sys.getrefcount(data)
+        tensor = create_tensor((2, 3, 4), data)
+        self.assertEqual(sys.getrefcount(data), refcount)
+        result = tensor.getData()
+        self.assertEqual(result.dtype, np.float32)
+        self.assertTrue(np.array_equal(result, data.astype(np.float32)))
+        data[0, 0, 0] = 100.0
+        self.assertEqual(tensor.getData()[0, 0, 0], 0.0)
+
+    def test_view_keeps_tensor_alive(self):
+        tensor = create_tensor((2, 3), (1.0, 2.0, 3.0, 4.0, 5.0, 6.0))
+        refcount = sys.getrefcount(tensor)
+        view = tensor.getData()
+        self.assertIs(view.base, tensor)
+        self.assertEqual(sys.getrefcount(tensor), refcount + 1)
+        del tensor
+        gc.collect()
+        self.assertEqual(view.sum(), 21.0)
+        # The view of a tensor wrapping an array keeps both of them
+        data = np.ones((3, 4), dtype=np.float32)
+        view = create_tensor((3, 4), data).getData()
+        del data
+        gc.collect()
+        view[2, 3] = 2.0
+        self.assertEqual(view.sum(), 13.0)
+
+    def test_array_interface(self):
+        data = np.arange(12, dtype=np.int32).reshape(3, 4)
+        tensor = create_tensor((3, 4), data, MNN.Halide_Type_Int)
+        array = np.asarray(tensor)
+        self.assertIs(array.base, tensor)
+        self.assertEqual(array.dtype, np.int32)
+        self.assertEqual(array.shape, (3, 4))
+        self.assertTrue(np.shares_memory(array, data))
+        array[0, 1] = 7
+        self.assertEqual(tensor.getData()[0, 1], 7)
+        del tensor, data
+        gc.collect()
+        self.assertEqual(array.sum(), 66 - 1 + 7)
+        # NC4HW4 tensors must be copied to a host tensor first
+        c4 = MNN.Tensor((1, 4, 2, 2), MNN.Halide_Type_Float, np.zeros(16, dtype=np.float32),
+                        MNN.Tensor_DimensionType_Caffe_C4)
+        self.assertFalse(hasattr(c4, '__array_interface__'))
+
+if __name__ == '__main__':
+    unittest.main()
@@ -30,6 +30,9 @@ struct WhileParamT;
 struct IfParam;
 struct IfParamT;
 
+struct AttentionParam;
+struct AttentionParamT;
+
 struct Op;
 struct OpT;
 
@@ -58,6 +61,8 @@ inline const flatbuffers::TypeTable *WhileParamTypeTable();
 
 inline const flatbuffers::TypeTable *IfParamTypeTable();
 
+inline const flatbuffers::TypeTable *AttentionParamTypeTable();
+
 inline const flatbuffers::TypeTable *OpTypeTable();
 
 inline const flatbuffers::TypeTable *ViewTypeTable();
@@ -221,11 +226,14 @@ enum OpType {
   OpType_While = 600,
   OpType_If = 601,
   OpType_LayerNorm = 603,
+  OpType_Attention = 604,
+  OpType_BatchNormTrain = 605,
+  OpType_BatchNormGrad = 606,
   OpType_MIN = OpType_AbsVal,
-  OpType_MAX = OpType_LayerNorm
+  OpType_MAX = OpType_BatchNormGrad
 };
 
-inline const OpType (&EnumValuesOpType())[150] {
+inline const OpType (&EnumValuesOpType())[153] {
   static const OpType values[] = {
     OpType_AbsVal,
     OpType_QuantizedAdd,
@@ -376,7 +384,10 @@ inline const OpType (&EnumValuesOpType())[150] {
     OpType_EltwiseInt8,
     OpType_While,
     OpType_If,
-    OpType_LayerNorm
+    OpType_LayerNorm,
+    OpType_Attention,
+    OpType_BatchNormTrain,
+    OpType_BatchNormGrad
   };
   return values;
 }
@@ -987,13 +998,16 @@ inline const char * const *EnumNamesOpType() {
     "If",
     "",
     "LayerNorm",
+    "Attention",
+    "BatchNormTrain",
+    "BatchNormGrad",
     nullptr
   };
   return names;
 }
 
 inline const char *EnumNameOpType(OpType e) {
-  if (e < OpType_AbsVal || e > OpType_LayerNorm) return "";
+  if (e < OpType_AbsVal || e > OpType_BatchNormGrad) return "";
   const size_t index = static_cast<int>(e);
   return EnumNamesOpType()[index];
 }
@@ -1088,11 +1102,12 @@ enum OpParameter {
   OpParameter_IfParam = 86,
   OpParameter_RandomUniform = 87,
   OpParameter_LayerNorm = 88,
+  OpParameter_AttentionParam = 89,
   OpParameter_MIN = OpParameter_NONE,
-  OpParameter_MAX = OpParameter_LayerNorm
+  OpParameter_MAX = OpParameter_AttentionParam
 };
 
-inline const OpParameter (&EnumValuesOpParameter())[89] {
+inline const OpParameter (&EnumValuesOpParameter())[90] {
   static const OpParameter values[] = {
     OpParameter_NONE,
     OpParameter_QuantizedAdd,
@@ -1182,7 +1197,8 @@ inline const OpParameter (&EnumValuesOpParameter())[89] {
     OpParameter_WhileParam,
     OpParameter_IfParam,
     OpParameter_RandomUniform,
-    OpParameter_LayerNorm
+    OpParameter_LayerNorm,
+    OpParameter_AttentionParam
   };
   return values;
 }
@@ -1278,13 +1294,14 @@ inline const char * const *EnumNamesOpParameter() {
     "IfParam",
     "RandomUniform",
     "LayerNorm",
+    "AttentionParam",
     nullptr
   };
   return names;
 }
 
 inline const char *EnumNameOpParameter(OpParameter e) {
-  if (e < OpParameter_NONE || e > OpParameter_LayerNorm) return "";
+  if (e < OpParameter_NONE || e > OpParameter_AttentionParam) return "";
   const size_t index = static_cast<int>(e);
   return EnumNamesOpParameter()[index];
 }
@@ -1645,6 +1662,10 @@ template<> struct OpParameterTraits<LayerNorm> {
   static const OpParameter enum_value = OpParameter_LayerNorm;
 };
 
+template<> struct OpParameterTraits<AttentionParam> {
+  static const OpParameter enum_value = OpParameter_AttentionParam;
+};
+
 struct OpParameterUnion {
   OpParameter type;
   void *value;
@@ -2380,6 +2401,14 @@ struct OpParameterUnion {
     return type == OpParameter_LayerNorm ?
       reinterpret_cast<const LayerNormT *>(value) : nullptr;
   }
+  AttentionParamT *AsAttentionParam() {
+    return type == OpParameter_AttentionParam ?
+      reinterpret_cast<AttentionParamT *>(value) : nullptr;
+  }
+  const AttentionParamT *AsAttentionParam() const {
+    return type == OpParameter_AttentionParam ?
+      reinterpret_cast<const AttentionParamT *>(value) : nullptr;
+  }
 };
 
 bool VerifyOpParameter(flatbuffers::Verifier &verifier, const void *obj, OpParameter type);
@@ -2960,6 +2989,87 @@ inline flatbuffers::Offset<IfParam> CreateIfParamDirect(
 
 flatbuffers::Offset<IfParam> CreateIfParam(flatbuffers::FlatBufferBuilder &_fbb, const IfParamT *_o, const flatbuffers::rehasher_function_t *_rehasher = nullptr);
 
+struct AttentionParamT : public flatbuffers::NativeTable {
+  typedef AttentionParam TableType;
+  float scale;
+  bool causal;
+  bool kvLength;
+  AttentionParamT()
+      : scale(0.0f),
+        causal(false),
+        kvLength(false) {
+  }
+};
+
+struct AttentionParam FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  typedef AttentionParamT NativeTableType;
+  static const flatbuffers::TypeTable *MiniReflectTypeTable() {
+    return AttentionParamTypeTable();
+  }
+  enum FlatBuffersVTableOffset FLATBUFFERS_VTABLE_UNDERLYING_TYPE {
+    VT_SCALE = 4,
+    VT_CAUSAL = 6,
+    VT_KVLENGTH = 8
+  };
+  float scale() const {
+    return GetField<float>(VT_SCALE, 0.0f);
+  }
+  bool causal() const {
+    return GetField<uint8_t>(VT_CAUSAL, 0) != 0;
+  }
+  bool kvLength() const {
+    return GetField<uint8_t>(VT_KVLENGTH, 0) != 0;
+  }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<float>(verifier, VT_SCALE) &&
+           VerifyField<uint8_t>(verifier, VT_CAUSAL) &&
+           VerifyField<uint8_t>(verifier, VT_KVLENGTH) &&
+           verifier.EndTable();
+  }
+  AttentionParamT *UnPack(const flatbuffers::resolver_function_t *_resolver = nullptr) const;
+  void UnPackTo(AttentionParamT *_o, const flatbuffers::resolver_function_t *_resolver = nullptr) const;
+  static flatbuffers::Offset<AttentionParam> Pack(flatbuffers::FlatBufferBuilder &_fbb, const AttentionParamT* _o, const flatbuffers::rehasher_function_t *_rehasher = nullptr);
+};
+
+struct AttentionParamBuilder {
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_scale(float scale) {
+    fbb_.AddElement<float>(AttentionParam::VT_SCALE, scale, 0.0f);
+  }
+  void add_causal(bool causal) {
+    fbb_.AddElement<uint8_t>(AttentionParam::VT_CAUSAL, static_cast<uint8_t>(causal), 0);
+  }
+  void add_kvLength(bool kvLength) {
+    fbb_.AddElement<uint8_t>(AttentionParam::VT_KVLENGTH, static_cast<uint8_t>(kvLength), 0);
+  }
+  explicit AttentionParamBuilder(flatbuffers::FlatBufferBuilder &_fbb)
+        : fbb_(_fbb) {
+    start_ = fbb_.StartTable();
+  }
+  AttentionParamBuilder &operator=(const AttentionParamBuilder &);
+  flatbuffers::Offset<AttentionParam> Finish() {
+    const auto end = fbb_.EndTable(start_);
+    auto o = flatbuffers::Offset<AttentionParam>(end);
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<AttentionParam> CreateAttentionParam(
+    flatbuffers::FlatBufferBuilder &_fbb,
+    float scale = 0.0f,
+    bool causal = false,
+    bool kvLength = false) {
+  AttentionParamBuilder builder_(_fbb);
+  builder_.add_scale(scale);
+  builder_.add_kvLength(kvLength);
+  builder_.add_causal(causal);
+  return builder_.Finish();
+}
+
+flatbuffers::Offset<AttentionParam> CreateAttentionParam(flatbuffers::FlatBufferBuilder &_fbb, const AttentionParamT *_o, const flatbuffers::rehasher_function_t *_rehasher = nullptr);
+
 struct OpT : public flatbuffers::NativeTable {
   typedef Op TableType;
   std::vector<int32_t> inputIndexes;
@@ -3262,6 +3372,9 @@ struct Op FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
   const LayerNorm *main_as_LayerNorm() const {
     return main_type() == OpParameter_LayerNorm ? static_cast<const LayerNorm *>(main()) : nullptr;
   }
+  const AttentionParam *main_as_AttentionParam() const {
+    return main_type() == OpParameter_AttentionParam ? static_cast<const AttentionParam *>(main()) : nullptr;
+  }
   const flatbuffers::String *name() const {
     return GetPointer<const flatbuffers::String *>(VT_NAME);
   }
@@ -3646,6 +3759,10 @@ template<> inline const LayerNorm *Op::main_as<LayerNorm>() const {
   return main_as_LayerNorm();
 }
 
+template<> inline const AttentionParam *Op::main_as<AttentionParam>() const {
+  return main_as_AttentionParam();
+}
+
 struct OpBuilder {
   flatbuffers::FlatBufferBuilder &fbb_;
   flatbuffers::uoffset_t start_;
@@ -4532,6 +4649,38 @@ inline flatbuffers::Offset<IfParam> CreateIfParam(flatbuffers::FlatBufferBuilder
       _aliases_outputs);
 }
 
+inline AttentionParamT *AttentionParam::UnPack(const flatbuffers::resolver_function_t *_resolver) const {
+  auto _o = new AttentionParamT();
+  UnPackTo(_o, _resolver);
+  return _o;
+}
+
+inline void AttentionParam::UnPackTo(AttentionParamT *_o, const flatbuffers::resolver_function_t *_resolver) const {
+  (void)_o;
+  (void)_resolver;
+  { auto _e = scale(); _o->scale = _e; };
+  { auto _e = causal(); _o->causal = _e; };
+  { auto _e = kvLength(); _o->kvLength = _e; };
+}
+
+inline flatbuffers::Offset<AttentionParam> AttentionParam::Pack(flatbuffers::FlatBufferBuilder &_fbb, const AttentionParamT* _o, const flatbuffers::rehasher_function_t *_rehasher) {
+  return CreateAttentionParam(_fbb, _o, _rehasher);
+}
+
+inline flatbuffers::Offset<AttentionParam> CreateAttentionParam(flatbuffers::FlatBufferBuilder &_fbb, const AttentionParamT *_o, const flatbuffers::rehasher_function_t *_rehasher) {
+  (void)_rehasher;
+  (void)_o;
+  struct _VectorArgs { flatbuffers::FlatBufferBuilder *__fbb; const AttentionParamT* __o; const flatbuffers::rehasher_function_t *__rehasher; } _va = { &_fbb, _o, _rehasher}; (void)_va;
+  auto _scale = _o->scale;
+  auto _causal = _o->causal;
+  auto _kvLength = _o->kvLength;
+  return MNN::CreateAttentionParam(
+      _fbb,
+      _scale,
+      _causal,
+      _kvLength);
+}
+
 inline OpT *Op::UnPack(const flatbuffers::resolver_function_t *_resolver) const {
   auto _o = new OpT();
   UnPackTo(_o, _resolver);
@@ -5126,6 +5275,10 @@ inline bool VerifyOpParameter(flatbuffers::Verifier &verifier, const void *obj,
       auto ptr = reinterpret_cast<const LayerNorm *>(obj);
       return verifier.VerifyTable(ptr);
     }
+    case OpParameter_AttentionParam: {
+      auto ptr = reinterpret_cast<const AttentionParam *>(obj);
+      return verifier.VerifyTable(ptr);
+    }
     default: return false;
   }
 }
@@ -5496,6 +5649,10 @@ inline void *OpParameterUnion::UnPack(const void *obj, OpParameter type, const f
       auto ptr = reinterpret_cast<const LayerNorm *>(obj);
       return ptr->UnPack(resolver);
     }
+    case OpParameter_AttentionParam: {
+      auto ptr = reinterpret_cast<const AttentionParam *>(obj);
+      return ptr->UnPack(resolver);
+    }
     default: return nullptr;
   }
 }
@@ -5854,6 +6011,10 @@ inline flatbuffers::Offset<void> OpParameterUnion::Pack(flatbuffers::FlatBufferB
       auto ptr = reinterpret_cast<const LayerNormT *>(value);
       return CreateLayerNorm(_fbb, ptr, _rehasher).Union();
     }
+    case OpParameter_AttentionParam: {
+      auto ptr = reinterpret_cast<const AttentionParamT *>(value);
+      return CreateAttentionParam(_fbb, ptr, _rehasher).Union();
+    }
     default: return 0;
   }
 }
@@ -6212,6 +6373,10 @@ inline OpParameterUnion::OpParameterUnion(const OpParameterUnion &u) FLATBUFFERS
       value = new LayerNormT(*reinterpret_cast<LayerNormT *>(u.value));
       break;
     }
+    case OpParameter_AttentionParam: {
+      value = new AttentionParamT(*reinterpret_cast<AttentionParamT *>(u.value));
+      break;
+    }
     default:
       break;
   }
@@ -6659,6 +6824,11 @@ inline void OpParameterUnion::Reset() {
       delete ptr;
       break;
     }
+    case OpParameter_AttentionParam: {
+      auto ptr = reinterpret_cast<AttentionParamT *>(value);
+      delete ptr;
+      break;
+    }
     default: break;
   }
   value = nullptr;
@@ -6816,12 +6986,15 @@ inline const flatbuffers::TypeTable *OpTypeTypeTable() {
     { flatbuffers::ET_INT, 0, 0 },
     { flatbuffers::ET_INT, 0, 0 },
     { flatbuffers::ET_INT, 0, 0 },
+    { flatbuffers::ET_INT, 0, 0 },
+    { flatbuffers::ET_INT, 0, 0 },
+    { flatbuffers::ET_INT, 0, 0 },
     { flatbuffers::ET_INT, 0, 0 }
   };
   static const flatbuffers::TypeFunction type_refs[] = {
     OpTypeTypeTable
   };
-  static const int64_t values[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 62, 63, 64, 65, 66, 67, 68, 69, 70, 71, 72, 73, 74, 75, 76, 77, 78, 79, 80, 81, 82, 83, 84, 85, 86, 87, 88, 89, 90, 91, 92, 93, 94, 95, 96, 97, 98, 99, 100, 101, 102, 103, 104, 105, 106, 107, 108, 109, 110, 111, 112, 113, 114, 115, 116, 117, 118, 119, 120, 121, 128, 129, 130, 131, 132, 256, 257, 258, 259, 260, 261, 262, 263, 264, 265, 266, 267, 268, 512, 513, 514, 515, 516, 517, 518, 600, 601, 603 };
+  static const int64_t values[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 62, 63, 64, 65, 66, 67, 68, 69, 70, 71, 72, 73, 74, 75, 76, 77, 78, 79, 80, 81, 82, 83, 84, 85, 86, 87, 88, 89, 90, 91, 92, 93, 94, 95, 96, 97, 98, 99, 100, 101, 102, 103, 104, 105, 106, 107, 108, 109, 110, 111, 112, 113, 114, 115, 116, 117, 118, 119, 120, 121, 128, 129, 130, 131, 132, 256, 257, 258, 259, 260, 261, 262, 263, 264, 265, 266, 267, 268, 512, 513, 514, 515, 516, 517, 518, 600, 601, 603, 604, 605, 606 };
   static const char * const names[] = {
     "AbsVal",
     "QuantizedAdd",
@@ -6972,10 +7145,13 @@ inline const flatbuffers::TypeTable *OpTypeTypeTable() {
     "EltwiseInt8",
     "While",
     "If",
-    "LayerNorm"
+    "LayerNorm",
+    "Attention",
+    "BatchNormTrain",
+    "BatchNormGrad"
   };
   static const flatbuffers::TypeTable tt = {
-    flatbuffers::ST_ENUM, 150, type_codes, type_refs, values, names
+    flatbuffers::ST_ENUM, 153, type_codes, type_refs, values, names
   };
   return &tt;
 }
@@ -7070,7 +7246,8 @@ inline const flatbuffers::TypeTable *OpParameterTypeTable() {
     { flatbuffers::ET_SEQUENCE, 0, 84 },
     { flatbuffers::ET_SEQUENCE, 0, 85 },
     { flatbuffers::ET_SEQUENCE, 0, 86 },
-    { flatbuffers::ET_SEQUENCE, 0, 87 }
+    { flatbuffers::ET_SEQUENCE, 0, 87 },
+    { flatbuffers::ET_SEQUENCE, 0, 88 }
   };
   static const flatbuffers::TypeFunction type_refs[] = {
     QuantizedAddTypeTable,
@@ -7160,7 +7337,8 @@ inline const flatbuffers::TypeTable *OpParameterTypeTable() {
     WhileParamTypeTable,
     IfParamTypeTable,
     RandomUniformTypeTable,
-    LayerNormTypeTable
+    LayerNormTypeTable,
+    AttentionParamTypeTable
   };
   static const char * const names[] = {
     "NONE",
@@ -7251,10 +7429,11 @@ inline const flatbuffers::TypeTable *OpParameterTypeTable() {
     "WhileParam",
     "IfParam",
     "RandomUniform",
-    "LayerNorm"
+    "LayerNorm",
+    "AttentionParam"
   };
   static const flatbuffers::TypeTable tt = {
-    flatbuffers::ST_UNION, 89, type_codes, type_refs, nullptr, names
+    flatbuffers::ST_UNION, 90, type_codes, type_refs, nullptr, names
   };
   return &tt;
 }
@@ -7402,6 +7581,23 @@ inline const flatbuffers::TypeTable *IfParamTypeTable() {
   return &tt;
 }
 
+inline const flatbuffers::TypeTable *AttentionParamTypeTable() {
+  static const flatbuffers::TypeCode type_codes[] = {
+    { flatbuffers::ET_FLOAT, 0, -1 },
+    { flatbuffers::ET_BOOL, 0, -1 },
+    { flatbuffers::ET_BOOL, 0, -1 }
+  };
+  static const char * const names[] = {
+    "scale",
+    "causal",
+    "kvLength"
+  };
+  static const flatbuffers::TypeTable tt = {
+    flatbuffers::ST_TABLE, 3, type_codes, nullptr, nullptr, names
+  };
+  return &tt;
+}
+
 inline const flatbuffers::TypeTable *OpTypeTable() {
   static const flatbuffers::TypeCode type_codes[] = {
     { flatbuffers::ET_INT, 1, -1 },
@@ -0,0 +1,195 @@
+//
+//  CPUAttention.cpp
+//  MNN
+//
+//  Created by MNN on 2020/11/02.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#include "backend/cpu/CPUAttention.hpp"
+#include <algorithm>
+#include <limits>
+#include <math.h>
+#include "backend/cpu/CPUBackend.hpp"
+#include "backend/cpu/compute/CommonOptFunction.h"
+#include "core/Concurrency.h"
+#include "core/Macro.h"
+#include "math/Vec.hpp"
+using Vec4 = MNN::Math::Vec<float, 4>;
+
+namespace MNN {
+
+static inline float _dot(const float* a, const float* b, int size) {
+    auto sizeC4   = size / 4;
+    Vec4 sumValue = Vec4(0.0f);
+    for (int i = 0; i < sizeC4; ++i) {
+        sumValue = sumValue + Vec4::load(a + 4 * i) * Vec4::load(b + 4 * i);
+    }
+    float sum = sumValue[0] + sumValue[1] + sumValue[2] + sumValue[3];
+    for (int i = sizeC4 * 4; i < size; ++i) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+// dst = dst * alpha + src * beta
+static inline void _axpby(float* dst, const float* src, float alpha, float beta, int size) {
+    auto sizeC4 = size / 4;
+    auto a      = Vec4(alpha);
+    auto b      = Vec4(beta);
+    for (int i = 0; i < sizeC4; ++i) {
+        Vec4::save(dst + 4 * i, Vec4::load(dst + 4 * i) * a + Vec4::load(src + 4 * i) * b);
+    }
+    for (int i = sizeC4 * 4; i < size; ++i) {
+        dst[i] = dst[i] * alpha + src[i] * beta;
+    }
+}
+
+CPUAttention::CPUAttention(Backend* backend, float scale, bool causal, bool kvLength) : Execution(backend) {
+    mScale    = scale;
+    mCausal   = causal;
+    mKVLength = kvLength;
+}
+
+ErrorCode CPUAttention::onResize(const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs) {
+    auto query = inputs[0];
+    auto key   = inputs[1];
+    auto value = inputs[2];
+    auto dims  = query->dimensions();
+    mLq        = query->length(dims - 2);
+    mDim       = query->length(dims - 1);
+    mLk        = key->length(key->dimensions() - 2);
+    mDimV      = value->length(value->dimensions() - 1);
+    mBatch     = mLq * mDim > 0 ? query->elementSize() / (mLq * mDim) : 0;
+    mKVBatch   = mLk * mDim > 0 ? key->elementSize() / (mLk * mDim) : 0;
+    if (mKVBatch != mBatch && mKVBatch != 1) {
+        MNN_ERROR("Attention's key / value batch should be 1 or the same as query\n");
+        return NOT_SUPPORT;
+    }
+    int numberThread = static_cast<CPUBackend*>(backend())->threadNumber();
+    mCache.reset(Tensor::createDevice<float>({numberThread, KEY_BLOCK + mDimV}));
+    auto res = backend()->onAcquireBuffer(mCache.get(), Backend::DYNAMIC);
+    if (!res) {
+        return OUT_OF_MEMORY;
+    }
+    backend()->onReleaseBuffer(mCache.get(), Backend::DYNAMIC);
+    return NO_ERROR;
+}
+
+ErrorCode CPUAttention::onExecute(const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs) {
+    auto output = outputs[0];
+    if (mBatch == 0 || mLq == 0) {
+        return NO_ERROR;
+    }
+    int inputSize = (int)inputs.size();
+    int validLk   = mLk;
+    if (mKVLength) {
+        inputSize--;
+        validLk = std::max(0, std::min(mLk, inputs[inputSize]->host<int32_t>()[0]));
+    }
+    if (validLk == 0) {
+        ::memset(output->host<float>(), 0, output->size());
+        return NO_ERROR;
+    }
+    const auto qPtr    = inputs[0]->host<float>();
+    const auto kPtr    = inputs[1]->host<float>();
+    const auto vPtr    = inputs[2]->host<float>();
+    const float* mask  = nullptr;
+    int maskBatchStride = 0;
+    if (inputSize > 3) {
+        mask = inputs[3]->host<float>();
+        if (inputs[3]->elementSize() > mLq * mLk) {
+            maskBatchStride = mLq * mLk;
+        }
+    }
+    auto oPtr          = output->host<float>();
+    const float scale  = mScale > 0.0f ? mScale : 1.0f / sqrtf((float)mDim);
+    const int total    = mBatch * mLq;
+    const int lq       = mLq;
+    const int lk       = validLk;
+    const int kvSize   = mLk;
+    const int dim      = mDim;
+    const int dimV     = mDimV;
+    const int kvStride = mKVBatch == 1 ? 0 : 1;
+    const bool causal  = mCausal;
+    int numberThread   = std::min(static_cast<CPUBackend*>(backend())->threadNumber(), total);
+    MNN_CONCURRENCY_BEGIN(tId, numberThread) {
+        auto scores = mCache->host<float>() + tId * mCache->stride(0);
+        auto acc    = scores + KEY_BLOCK;
+        for (int index = (int)tId; index < total; index += numberThread) {
+            auto b       = index / lq;
+            auto y       = index % lq;
+            auto q       = qPtr + index * dim;
+            auto k       = kPtr + b * kvStride * kvSize * dim;
+            auto v       = vPtr + b * kvStride * kvSize * dimV;
+            auto maskY   = mask;
+            if (nullptr != mask) {
+                maskY = mask + b * maskBatchStride + y * kvSize;
+            }
+            // Query y can see key [0, kEnd)
+            auto kEnd = lk;
+            if (causal) {
+                kEnd = std::min(lk, std::max(0, y + 1 + lk - lq));
+            }
+            float maxValue = -std::numeric_limits<float>::max();
+            float sumValue = 0.0f;
+            ::memset(acc, 0, dimV * sizeof(float));
+            for (int kStart = 0; kStart < kEnd; kStart += KEY_BLOCK) {
+                auto kCount = std::min(KEY_BLOCK, kEnd - kStart);
+                float blockMax = -std::numeric_limits<float>::max();
+                for (int j = 0; j < kCount; ++j) {
+                    auto s = _dot(q, k + (kStart + j) * dim, dim) * scale;
+                    if (nullptr != maskY) {
+                        s += maskY[kStart + j];
+                    }
+                    scores[j] = s;
+                    blockMax  = std::max(blockMax, s);
+                }
+                if (blockMax > maxValue) {
+                    // Rescale the accumulated result to the new max
+                    float rescale = expf(maxValue - blockMax);
+                    sumValue      = sumValue * rescale;
+                    _axpby(acc, acc, rescale, 0.0f, dimV);
+                    maxValue      = blockMax;
+                }
+                // MNNExp compute exp(-x)
+                for (int j = 0; j < kCount; ++j) {
+                    scores[j] = maxValue - scores[j];
+                }
+                MNNExp(scores, scores, kCount);
+                for (int j = 0; j < kCount; ++j) {
+                    sumValue += scores[j];
+                    _axpby(acc, v + (kStart + j) * dimV, 1.0f, scores[j], dimV);
+                }
+            }
+            auto dst = oPtr + index * dimV;
+            if (sumValue > 0.0f) {
+                _axpby(acc, acc, 1.0f / sumValue, 0.0f, dimV);
+            }
+            ::memcpy(dst, acc, dimV * sizeof(float));
+        }
+    }
+    MNN_CONCURRENCY_END();
+    return NO_ERROR;
+}
+
+class CPUAttentionCreator : public CPUBackend::Creator {
+public:
+    virtual Execution* onCreate(const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs,
+                                const MNN::Op* op, Backend* backend) const override {
+        float scale = 0.0f;
+        bool causal   = false;
+        bool kvLength = false;
+        auto param    = op->main_as_AttentionParam();
+        if (nullptr != param) {
+            scale    = param->scale();
+            causal   = param->causal();
+            kvLength = param->kvLength();
+        }
+        return new CPUAttention(backend, scale, causal, kvLength);
+    }
+};
+
+REGISTER_CPU_OP_CREATOR(CPUAttentionCreator, OpType_Attention);
+
+} // namespace MNN
@@ -0,0 +1,49 @@
+//
+//  CPUAttention.hpp
+//  MNN
+//
+//  Created by MNN on 2020/11/02.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#ifndef CPUAttention_hpp
+#define CPUAttention_hpp
+
+#include <memory>
+#include "core/Execution.hpp"
+
+namespace MNN {
+
+/*
+ Fused scaled dot product attention: softmax(scale * Q * K^T + mask) * V
+ Q: [..., lq, d], K: [..., lk, d], V: [..., lk, dv], mask (optional, additive): [lq, lk] or [..., lq, lk]
+ The keys are visited block by block with an online softmax, the [lq, lk] score matrix is never stored.
+ With kvLength, the last input is the number of valid keys, K / V are a cache whose lk is the capacity reserved.
+ */
+class CPUAttention : public Execution {
+public:
+    CPUAttention(Backend *backend, float scale, bool causal, bool kvLength);
+    virtual ~CPUAttention() = default;
+    virtual ErrorCode onResize(const std::vector<Tensor *> &inputs, const std::vector<Tensor *> &outputs) override;
+    virtual ErrorCode onExecute(const std::vector<Tensor *> &inputs, const std::vector<Tensor *> &outputs) override;
+
+    // Number of keys computed at once for one query
+    static const int KEY_BLOCK = 64;
+
+private:
+    float mScale;
+    bool mCausal;
+    bool mKVLength;
+    int mBatch   = 0;
+    int mKVBatch = 0;
+    int mLq      = 0;
+    int mLk      = 0;
+    int mDim     = 0;
+    int mDimV    = 0;
+    // Per-thread scores and accumulation
+    std::shared_ptr<Tensor> mCache;
+};
+
+} // namespace MNN
+
+#endif /* CPUAttention_hpp */
@@ -7,6 +7,7 @@
 //
 
 #include "backend/cpu/CPUBackend.hpp"
+#include <string.h>
 #include <cmath>
 #include <mutex>
 #include "core/BufferAllocator.hpp"
@@ -68,21 +69,40 @@ CPURuntime::CPURuntime(const Backend::Info& info) {
     }
 #endif
 #ifdef MNN_USE_THREAD_POOL
-    mThreadNumber = ThreadPool::init(mThreadNumber);
+    auto affinity = nullptr != info.user ? info.user->affinity : BackendConfig::Affinity_None;
+    int node      = -1;
+    if (mThreadNumber > 1 && BackendConfig::Affinity_Node == affinity) {
+        node = ThreadPool::currentNode();
+    }
+    int nodeThreadNumber = 0;
+    if (node >= 0) {
+        nodeThreadNumber = ThreadPool::initNode(mThreadNumber, node);
+    }
+    if (nodeThreadNumber > 0) {
+        mThreadNumber = nodeThreadNumber;
+        mDynamicAllocator.reset(new BufferAllocator(MNN_MEMORY_ALIGN_DEFAULT, node));
+        mStaticAllocator.reset(new BufferAllocator(MNN_MEMORY_ALIGN_DEFAULT, node));
+    } else {
+        node          = -1;
+        mThreadNumber = ThreadPool::init(mThreadNumber);
+    }
     if (mThreadNumber > 1) {
-        mTaskIndex = ThreadPool::acquireWorkIndex();
+        mTaskIndex = ThreadPool::acquireWorkIndex(node);
     } else {
         mTaskIndex = -1;
     }
+    if (mThreadNumber > 1 && node < 0) {
+        ThreadPool::setAffinity(affinity);
+    }
     if (mTaskIndex >= 0 && mPower == BackendConfig::Power_High) {
-        ThreadPool::active();
+        ThreadPool::active(mTaskIndex);
     }
 #endif
 }
 CPURuntime:: ~ CPURuntime() {
 #ifdef MNN_USE_THREAD_POOL
     if (mTaskIndex >= 0 && mPower == BackendConfig::Power_High) {
-        ThreadPool::deactive();
+        ThreadPool::deactive(mTaskIndex);
     }
     ThreadPool::releaseWorkIndex(mTaskIndex);
 #endif
@@ -106,8 +126,143 @@ void CPURuntime::onGabageCollect(int level) {
         mDynamicAllocator->release(false);
     }
 }
+
+// Cache layout: number of weights, then for each weight: key size, key, data size, data
+bool CPURuntime::onSetCache(const void* buffer, size_t size) {
+    mPackedWeights.clear();
+    mCacheBuffer.clear();
+    if (nullptr == buffer) {
+        return false;
+    }
+    auto ptr = (const uint8_t*)buffer;
+    auto end = ptr + size;
+    auto read = [&](void* dst, size_t bytes) {
+        if (ptr + bytes > end) {
+            return false;
+        }
+        ::memcpy(dst, ptr, bytes);
+        ptr += bytes;
+        return true;
+    };
+    uint32_t number = 0;
+    if (!read(&number, sizeof(uint32_t))) {
+        return false;
+    }
+    for (uint32_t i = 0; i < number; ++i) {
+        uint32_t keySize = 0;
+        uint64_t dataSize = 0;
+        if (!read(&keySize, sizeof(uint32_t)) || ptr + keySize > end) {
+            mPackedWeights.clear();
+            return false;
+        }
+        std::string key((const char*)ptr, keySize);
+        ptr += keySize;
+        if (!read(&dataSize, sizeof(uint64_t)) || ptr + dataSize > end) {
+            mPackedWeights.clear();
+            return false;
+        }
+        mPackedWeights[key].assign(ptr, ptr + dataSize);
+        ptr += dataSize;
+    }
+    return !mPackedWeights.empty();
+}
+
+std::pair<const void*, size_t> CPURuntime::onGetCache() {
+    mCacheBuffer.clear();
+    if (mPackedWeights.empty()) {
+        return std::make_pair(nullptr, 0);
+    }
+    auto write = [this](const void* src, size_t bytes) {
+        auto ptr = (const uint8_t*)src;
+        mCacheBuffer.insert(mCacheBuffer.end(), ptr, ptr + bytes);
+    };
+    uint32_t number = (uint32_t)mPackedWeights.size();
+    write(&number, sizeof(uint32_t));
+    for (auto& iter : mPackedWeights) {
+        uint32_t keySize  = (uint32_t)iter.first.size();
+        uint64_t dataSize = iter.second.size();
+        write(&keySize, sizeof(uint32_t));
+        write(iter.first.data(), keySize);
+        write(&dataSize, sizeof(uint64_t));
+        write(iter.second.data(), dataSize);
+    }
+    return std::make_pair(mCacheBuffer.data(), mCacheBuffer.size());
+}
+
+void CPURuntime::onRecordCache(bool record) {
+    mRecordCache = record;
+}
 std::map<OpType, CPUBackend::Creator*>* CPUBackend::gCreator = nullptr;
 
+// FNV-1a
+static uint64_t _hashWeight(const void* source, size_t size) {
+    auto ptr      = (const uint8_t*)source;
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ ptr[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+void CPUBackend::packWeight(Tensor* weight, const std::string& layout, const void* source, size_t sourceBytes,
+                            const std::function<void()>& pack) {
+    bool useCache = !mRuntime->mPackedWeights.empty() || mRuntime->mRecordCache;
+    if (!useCache || nullptr == mCreatingOp || nullptr == mCreatingOp->name()) {
+        pack();
+        return;
+    }
+    // The cache file only checks the head of the model, the hash makes sure the weights are the same
+    auto key  = mCreatingOp->name()->str() + "/" + layout + "/" + std::to_string(mCreatingWeightIndex++) + "/" +
+               std::to_string(_hashWeight(source, sourceBytes));
+    auto size = weight->size();
+    auto iter = mRuntime->mPackedWeights.find(key);
+    if (iter != mRuntime->mPackedWeights.end() && iter->second.size() == size) {
+        ::memcpy(weight->host<uint8_t>(), iter->second.data(), size);
+        return;
+    }
+    pack();
+    if (mRuntime->mRecordCache) {
+        auto ptr = weight->host<uint8_t>();
+        mRuntime->mPackedWeights[key].assign(ptr, ptr + size);
+    }
+}
+
+std::shared_ptr<Tensor> CPUBackend::acquireWeight(const Tensor* weight, const std::string& layout, const void* source,
+                                                  size_t sourceBytes, const std::function<void(Tensor*)>& pack) {
+    auto shared = getSharedWeights();
+    std::string key;
+    if (nullptr != shared && nullptr != mCreatingOp) {
+        std::unique_lock<std::mutex> _l(shared->lock);
+        auto start = (const uint8_t*)shared->buffer;
+        auto op    = (const uint8_t*)mCreatingOp;
+        if (op >= start && op < start + shared->size) {
+            // The op is in the model buffer of the Interpreter, its offset identifies it
+            key       = std::to_string(op - start) + "/" + layout + "/" + std::to_string(mCreatingWeightIndex);
+            auto iter = shared->weights.find(key);
+            if (iter != shared->weights.end()) {
+                auto result = iter->second.lock();
+                if (nullptr != result && result->shape() == weight->shape()) {
+                    // Keep the key of the next weight the same as packWeight
+                    mCreatingWeightIndex++;
+                    return result;
+                }
+            }
+        }
+    }
+    std::shared_ptr<Tensor> result(Tensor::create(weight->shape(), weight->getType(), nullptr,
+                                                  weight->getDimensionType()));
+    if (nullptr == result->host<void>()) {
+        return nullptr;
+    }
+    auto ptr = result.get();
+    packWeight(ptr, layout, source, sourceBytes, [&]() { pack(ptr); });
+    if (!key.empty()) {
+        std::unique_lock<std::mutex> _l(shared->lock);
+        shared->weights[key] = result;
+    }
+    return result;
+}
+
 void CPUBackend::initCreatorMap() {
     gCreator = new std::map<OpType, CPUBackend::Creator*>;
 }
@@ -137,6 +292,7 @@ bool CPUBackend::supportDot() const {
 }
 
 CPUBackend::~CPUBackend() {
+    releaseKeptBuffer();
     for (auto p : mDynamic) {
         mDynamicAllocator->free(p);
     }
@@ -145,7 +301,7 @@ CPUBackend::~CPUBackend() {
 void CPUBackend::onExecuteBegin() const {
 #ifdef MNN_USE_THREAD_POOL
     if (mRuntime->mTaskIndex >= 0 && mRuntime->mPower != BackendConfig::Power_High) {
-        ThreadPool::active();
+        ThreadPool::active(mRuntime->mTaskIndex);
     }
 #else
 #ifdef _OPENMP
@@ -157,7 +313,7 @@ void CPUBackend::onExecuteBegin() const {
 void CPUBackend::onExecuteEnd() const {
 #ifdef MNN_USE_THREAD_POOL
     if (mRuntime->mTaskIndex >= 0 && mRuntime->mPower != BackendConfig::Power_High) {
-        ThreadPool::deactive();
+        ThreadPool::deactive(mRuntime->mTaskIndex);
     }
 #endif
 }
@@ -237,6 +393,9 @@ bool CPUBackend::onReleaseBuffer(const MNN::Tensor* nativeTensor, StorageType st
     if (DYNAMIC_SEPERATE == storageType) {
         return true;
     }
+    if (mKeptDynamic.find(nativeTensor->buffer().host) != mKeptDynamic.end()) {
+        return true;
+    }
     mDynamic.erase(nativeTensor->buffer().host);
     mDynamicAllocator->free(nativeTensor->buffer().host);
     return true;
@@ -274,7 +433,10 @@ Execution* CPUBackend::onCreate(const std::vector<Tensor*>& inputs, const std::v
         MNN_PRINT("Don't support type [%s], %s\n", MNN::EnumNameOpType(op->type()), op->name()->c_str());
         return nullptr;
     }
-    auto exe = iter->second->onCreate(inputs, outputs, op, this);
+    mCreatingOp          = op;
+    mCreatingWeightIndex = 0;
+    auto exe             = iter->second->onCreate(inputs, outputs, op, this);
+    mCreatingOp          = nullptr;
     if (nullptr == exe) {
         MNN_PRINT("The Creator Don't support type [%s], %s\n", MNN::EnumNameOpType(op->type()), op->name()->c_str());
         return nullptr;
@@ -345,6 +507,28 @@ bool CPUBackend::onClearBuffer() {
     return true;
 }
 
+void CPUBackend::keepBuffer() {
+    if (mBufferKept) {
+        return;
+    }
+    mDynamicAllocator->freeze();
+    mKeptDynamic = std::move(mDynamic);
+    mDynamic.clear();
+    mBufferKept = true;
+}
+
+void CPUBackend::releaseKeptBuffer() {
+    if (!mBufferKept) {
+        return;
+    }
+    for (auto p : mKeptDynamic) {
+        mDynamicAllocator->free(p);
+    }
+    mKeptDynamic.clear();
+    mDynamicAllocator->unfreeze();
+    mBufferKept = false;
+}
+
 std::pair<int, int> CPUBackend::multiThreadDivide(int size) const {
     int sizeDivide = size / threadNumber();
     sizeDivide = UP_DIV(sizeDivide, 4) * 4;
@@ -10,8 +10,11 @@
 #define CPUBackend_hpp
 
 #include <stdio.h>
+#include <functional>
 #include <map>
 #include <memory>
+#include <string>
+#include <vector>
 #include "core/Backend.hpp"
 #include "core/Execution.hpp"
 #include "MNN_generated.h"
@@ -32,6 +35,9 @@ public:
     virtual Backend* onCreate() const override;
     virtual void onGabageCollect(int level) override;
     virtual float onGetMemoryInMB() override;
+    virtual bool onSetCache(const void* buffer, size_t size) override;
+    virtual std::pair<const void*, size_t> onGetCache() override;
+    virtual void onRecordCache(bool record) override;
 private:
     std::shared_ptr<BufferAllocator> mStaticAllocator;
     std::shared_ptr<BufferAllocator> mDynamicAllocator;
@@ -48,6 +54,11 @@ private:
     bool mIsSupportFp16arith = false;
     float mFlops = 0.0f;
     static Backend*(*gExtraCreate)(const Runtime* runtime);
+
+    // Packed weights loaded from the cache file, or recorded to be saved, the key is made by CPUBackend::packWeight
+    mutable std::map<std::string, std::vector<uint8_t>> mPackedWeights;
+    bool mRecordCache = false;
+    std::vector<uint8_t> mCacheBuffer;
 };
 
 class CPUBackend : public Backend {
@@ -87,15 +98,36 @@ public:
         return mDynamicAllocator.get();
     }
 
+    /* Keep the dynamic memory planned so far for the executions that are not resized again: onClearBuffer doesn't
+       free it and the later acquires don't reuse it, until releaseKeptBuffer */
+    void keepBuffer();
+    void releaseKeptBuffer();
+
     BackendConfig::MemoryMode memoryMode() const {
         return mRuntime->mMemory;
     }
+    BackendConfig::PrecisionMode precisionMode() const {
+        return mRuntime->mPrecision;
+    }
 #ifdef MNN_USE_THREAD_POOL
     inline int taskIndex() const {return mRuntime->mTaskIndex;}
 #endif
     bool supportDot() const;
     static void initCreatorMap();
 
+    /* Fill weight by pack(), weight must be allocated. If the runtime has a cache file (see
+       Interpreter::setCacheFile), weight is copied from the cache instead, or recorded to the cache after pack().
+       layout should describe how weight is packed, it's a part of the key together with the op's name and the hash
+       of the source weight (sourceBytes from source), so a cache of the model with other weights is not used */
+    void packWeight(Tensor* weight, const std::string& layout, const void* source, size_t sourceBytes,
+                    const std::function<void()>& pack);
+
+    /* Allocate weight with the shape of it and fill it by pack(), see packWeight. The sessions created from one
+       Interpreter share the weight of the same op, layout and shape instead of packing their own copy.
+       The returned tensor owns its memory, don't release it to the backend. Returns nullptr if out of memory */
+    std::shared_ptr<Tensor> acquireWeight(const Tensor* weight, const std::string& layout, const void* source,
+                                          size_t sourceBytes, const std::function<void(Tensor*)>& pack);
+
 protected:
     bool allocBuffer(int size, halide_buffer_t& buffer,  StorageType storageType);
 private:
@@ -103,7 +135,12 @@ private:
     std::shared_ptr<BufferAllocator> mDynamicAllocator;
     bool mCheckNAN = false;
     std::set<void*> mDynamic;
+    std::set<void*> mKeptDynamic;
+    bool mBufferKept = false;
     const CPURuntime* mRuntime;
+    // The op whose execution is being created, and the number of weights it has packed
+    const Op* mCreatingOp   = nullptr;
+    int mCreatingWeightIndex = 0;
     static std::map<OpType, CPUBackend::Creator*>* getCreatorMap();
     static std::map<OpType, CPUBackend::Creator*>* gCreator;
 };
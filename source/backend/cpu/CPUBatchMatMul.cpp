@@ -7,112 +7,312 @@
 //
 
 #include "backend/cpu/CPUBatchMatMul.hpp"
+#include <algorithm>
 #include "backend/cpu/CPUBackend.hpp"
-#include "math/Matrix.hpp"
+#include "backend/cpu/compute/CommonOptFunction.h"
 #include "core/TensorUtils.hpp"
-#include "core/BufferAllocator.hpp"
+#include "core/AutoStorage.h"
+#include "core/Macro.h"
 #include "core/Concurrency.h"
+#include "math/Vec.hpp"
+using Vec4 = MNN::Math::Vec<float, 4>;
 
 namespace MNN {
 
 CPUBatchMatMul::CPUBatchMatMul(Backend* backend, bool adjX, bool adjY) : Execution(backend) {
-    auto threadNumber = static_cast<CPUBackend*>(backend)->threadNumber();
-    for (int i = 0; i < threadNumber; ++i) {
-        Unit unit;
-        unit.mMatrixA.reset(new Tensor);
-        unit.mMatrixB.reset(new Tensor);
-        unit.mMatrixC.reset(new Tensor);
-        unit.mMatMul.reset(new CPUMatMul(backend, adjX, adjY, false));
-        unit.mMatrixB->buffer().dimensions = 2;
-        unit.mMatrixA->buffer().dimensions = 2;
-        unit.mMatrixC->buffer().dimensions = 2;
-        unit.mTempInputs = {unit.mMatrixA.get(), unit.mMatrixB.get()};
-        unit.mTempOutputs = {unit.mMatrixC.get()};
-        mUnits.emplace_back(std::move(unit));
+    mTransposeA = adjX;
+    mTransposeB = adjY;
+}
+
+CPUBatchMatMul::~CPUBatchMatMul() {
+    _releaseConstB();
+}
+
+void CPUBatchMatMul::_releaseConstB() {
+    if (mConstB && nullptr != mPackB) {
+        backend()->onReleaseBuffer(mPackB.get(), Backend::STATIC);
+    }
+    mConstB        = false;
+    mLowPrecisionB = false;
+    mPackB         = nullptr;
+}
+
+void CPUBatchMatMul::_packB(float* dest, const float* source, int tId, int numberThread) {
+    auto destStride = mPackB->stride(0);
+    for (int i = tId; i < mBNumber; i += numberThread) {
+        MNNPackForMatMul_B(dest + i * destStride, source + i * mL * mH, mH, mL, mTransposeB);
     }
 }
 
 ErrorCode CPUBatchMatMul::onResize(const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs) {
-    auto input0          = inputs[0];
-    auto input1          = inputs[1];
-    auto output          = outputs[0];
+    auto input0 = inputs[0];
+    auto input1 = inputs[1];
+    auto output = outputs[0];
+    _releaseConstB();
+    mTaskNumber = 0;
     // Fill output by zero if one of inputs is empty.
     if (input0->elementSize() == 0 || input1->elementSize() == 0) {
         return NO_ERROR;
     }
-    auto dimensions = input0->dimensions();
-    int threadNumber = static_cast<CPUBackend*>(backend())->threadNumber();
-    int batch = 1;
-    for (int i = 0; i < dimensions - 2; ++i) {
-        batch *= input0->length(i);
-    }
-    mBatch = batch;
-    if (threadNumber > batch) {
-        threadNumber = batch;
-    }
-    auto memoryPool = static_cast<CPUBackend*>(backend())->getBufferAllocator();
-    memoryPool->barrierBegin();
-    std::shared_ptr<void> __a(nullptr, [memoryPool](void *) { memoryPool->barrierEnd(); });
-    for (int i = 0; i < threadNumber; ++i) {
-        memoryPool->beginGroup();
-        std::shared_ptr<void> __b(nullptr, [memoryPool](void *) { memoryPool->endGroup(); });
-        auto& unit = mUnits[i];
-        unit.mMatrixA->setLength(0, input0->length(input0->dimensions()-2));
-        unit.mMatrixA->setLength(1, input0->length(input0->dimensions()-1));
+    auto i0Dim = input0->dimensions();
+    auto i1Dim = input1->dimensions();
+    auto o0Dim = output->dimensions();
+    MNN_ASSERT(o0Dim >= 2);
+    mE = output->length(o0Dim - 2);
+    mH = output->length(o0Dim - 1);
+    mL = mTransposeA ? input0->length(i0Dim - 2) : input0->length(i0Dim - 1);
 
-        unit.mMatrixB->setLength(0, input1->length(input1->dimensions()-2));
-        unit.mMatrixB->setLength(1, input1->length(input1->dimensions()-1));
-
-        unit.mMatrixC->setLength(0, output->length(output->dimensions()-2));
-        unit.mMatrixC->setLength(1, output->length(output->dimensions()-1));
-        
-        TensorUtils::setLinearLayout(unit.mMatrixA.get());
-        TensorUtils::setLinearLayout(unit.mMatrixB.get());
-        TensorUtils::setLinearLayout(unit.mMatrixC.get());
+    // Compute the matrix index of A and B for each output matrix, support broadcast
+    const int batchDims = o0Dim - 2;
+    int batch           = 1;
+    for (int i = 0; i < batchDims; ++i) {
+        batch *= output->length(i);
+    }
+    auto i0Offset = o0Dim - i0Dim;
+    auto i1Offset = o0Dim - i1Dim;
+    mAIndex.resize(batch);
+    mBIndex.resize(batch);
+    for (int index = 0; index < batch; ++index) {
+        int c       = index;
+        int aIndex  = 0;
+        int bIndex  = 0;
+        int aStride = 1;
+        int bStride = 1;
+        for (int i = batchDims - 1; i >= 0; --i) {
+            auto cord = c % output->length(i);
+            c         = c / output->length(i);
+            if (i >= i0Offset) {
+                auto len = input0->length(i - i0Offset);
+                if (len > 1) {
+                    aIndex += cord * aStride;
+                }
+                aStride *= len;
+            }
+            if (i >= i1Offset) {
+                auto len = input1->length(i - i1Offset);
+                if (len > 1) {
+                    bIndex += cord * bStride;
+                }
+                bStride *= len;
+            }
+        }
+        mAIndex[index] = aIndex;
+        mBIndex[index] = bIndex;
+    }
+    mBNumber = input1->elementSize() / mL / mH;
 
-        auto res = backend()->onAcquireBuffer(unit.mMatrixA.get(), Backend::DYNAMIC);
-        res = res && backend()->onAcquireBuffer(unit.mMatrixB.get(), Backend::DYNAMIC);
-        res = res && backend()->onAcquireBuffer(unit.mMatrixC.get(), Backend::DYNAMIC);
+    // Split work over batch * eTile * hBlock
+    int eP, lP, hP;
+    MNNGetMatMulPackMode(&eP, &lP, &hP);
+    int numberThread = static_cast<CPUBackend*>(backend())->threadNumber();
+    int hAlign       = hP;
+    while (hAlign % 4 != 0) {
+        hAlign += hP;
+    }
+    mETile         = UP_DIV(mE, eP);
+    auto hBlock    = UP_DIV(mH, hAlign);
+    auto outerTask = batch * mETile;
+    int hChunk     = 1;
+    if (outerTask < numberThread) {
+        hChunk = std::min(hBlock, UP_DIV(numberThread, outerTask));
+    }
+    mHUnit      = UP_DIV(hBlock, hChunk) * hAlign;
+    mHChunk     = UP_DIV(mH, mHUnit);
+    mTaskNumber = outerTask * mHChunk;
 
+    // Pack B once, keep it if B is constant
+    auto cpuBackend = static_cast<CPUBackend*>(backend());
+    mConstB         = TensorUtils::getDescribe(input1)->usage == Tensor::InsideDescribe::CONSTANT;
+    // Storing B as bf16 loses precision and expands B in every execution, so it needs both the low precision and the
+    // low memory mode
+    mLowPrecisionB  = mConstB && cpuBackend->precisionMode() == BackendConfig::Precision_Low &&
+                     cpuBackend->memoryMode() == BackendConfig::Memory_Low;
+    bool res        = false;
+    if (mLowPrecisionB) {
+        // Pack to fp32 first and then store as bf16
+        mPackB.reset(Tensor::createDevice<int16_t>({mBNumber, UP_DIV(mH, hP), mL, hP}));
+        AutoStorage<float> packFloat(mPackB->elementSize());
+        if (nullptr == packFloat.get()) {
+            return OUT_OF_MEMORY;
+        }
+        _packB(packFloat.get(), input1->host<float>(), 0, 1);
+        res = backend()->onAcquireBuffer(mPackB.get(), Backend::STATIC);
         if (!res) {
+            mConstB        = false;
+            mLowPrecisionB = false;
             return OUT_OF_MEMORY;
         }
-        auto code = unit.mMatMul->onResize(unit.mTempInputs, unit.mTempOutputs);
-        backend()->onReleaseBuffer(unit.mMatrixA.get(), Backend::DYNAMIC);
-        backend()->onReleaseBuffer(unit.mMatrixB.get(), Backend::DYNAMIC);
-        backend()->onReleaseBuffer(unit.mMatrixC.get(), Backend::DYNAMIC);
+        MNNFp32ToBf16(mPackB->host<int16_t>(), packFloat.get(), mPackB->elementSize());
+        mTempB.reset(Tensor::createDevice<float>({numberThread, mHUnit * mL}));
+        res = backend()->onAcquireBuffer(mTempB.get(), Backend::DYNAMIC);
+        if (!res) {
+            return OUT_OF_MEMORY;
+        }
+    } else {
+        mPackB.reset(Tensor::createDevice<float>({mBNumber, UP_DIV(mH, hP), mL, hP}));
+        res = backend()->onAcquireBuffer(mPackB.get(), mConstB ? Backend::STATIC : Backend::DYNAMIC);
+        if (!res) {
+            mConstB = false;
+            return OUT_OF_MEMORY;
+        }
+        if (mConstB) {
+            _packB(mPackB->host<float>(), input1->host<float>(), 0, 1);
+        }
+    }
+    auto hC4 = UP_DIV(mHUnit, 4);
+    mTempA.reset(Tensor::createDevice<float>({numberThread, UP_DIV(mL, 4), eP, 4}));
+    mTileA.reset(Tensor::createDevice<float>({numberThread, mL, eP}));
+    mTempC.reset(Tensor::createDevice<float>({numberThread, hC4, eP, 4}));
+    res = backend()->onAcquireBuffer(mTempA.get(), Backend::DYNAMIC);
+    res = res && backend()->onAcquireBuffer(mTileA.get(), Backend::DYNAMIC);
+    res = res && backend()->onAcquireBuffer(mTempC.get(), Backend::DYNAMIC);
+    if (!res) {
+        return OUT_OF_MEMORY;
+    }
+    mCache = nullptr;
+    if (hP % 4 != 0) {
+        auto hDiv = MNNGetC4DivNumber(hP);
+        mCache.reset(Tensor::createDevice<float>({numberThread, eP * hDiv * 4 + hC4 * eP * 4}));
+        res = backend()->onAcquireBuffer(mCache.get(), Backend::DYNAMIC);
+        if (!res) {
+            return OUT_OF_MEMORY;
+        }
+        backend()->onReleaseBuffer(mCache.get(), Backend::DYNAMIC);
+    }
+    backend()->onReleaseBuffer(mTempA.get(), Backend::DYNAMIC);
+    backend()->onReleaseBuffer(mTileA.get(), Backend::DYNAMIC);
+    backend()->onReleaseBuffer(mTempC.get(), Backend::DYNAMIC);
+    if (mLowPrecisionB) {
+        // The expanded h-block is kept across the tasks, so it can't share memory with the A / C tiles
+        backend()->onReleaseBuffer(mTempB.get(), Backend::DYNAMIC);
+    }
+    if (!mConstB) {
+        backend()->onReleaseBuffer(mPackB.get(), Backend::DYNAMIC);
     }
     return NO_ERROR;
 }
 
 ErrorCode CPUBatchMatMul::onExecute(const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs) {
-    auto input0          = inputs[0];
-    auto input1          = inputs[1];
-    auto output          = outputs[0];
+    auto input0 = inputs[0];
+    auto input1 = inputs[1];
+    auto output = outputs[0];
     // Fill output by zero if one of inputs is empty.
     if (input0->elementSize() == 0 || input1->elementSize() == 0) {
         ::memset(output->host<float>(), 0, output->size());
         return NO_ERROR;
     }
-    const int dimensions = input0->dimensions();
-    MNN_ASSERT(dimensions >= 3);
-    const int input0Stride = input0->length(dimensions - 1) * input0->length(dimensions - 2);
-    const int input1Stride = input1->length(dimensions - 1) * input1->length(dimensions - 2);
-    const int outputStride = output->length(dimensions - 1) * output->length(dimensions - 2);
-    const auto input0Ptr   = input0->host<float>();
-    const auto input1Ptr   = input1->host<float>();
-    float* const outputPtr = output->host<float>();
-    int threadNumber = static_cast<CPUBackend*>(backend())->threadNumber();
-    if (threadNumber > mBatch) {
-        threadNumber = mBatch;
-    }
-    MNN_CONCURRENCY_BEGIN(tId, threadNumber) {
-        auto& unit = mUnits[tId];
-        for (int i = (int)tId; i < mBatch; i+=threadNumber) {
-            ::memcpy(unit.mMatrixA->host<float>(), input0Ptr + i * input0Stride, input0Stride * sizeof(float));
-            ::memcpy(unit.mMatrixB->host<float>(), input1Ptr + i * input1Stride, input1Stride * sizeof(float));
-            unit.mMatMul->onExecute(unit.mTempInputs, unit.mTempOutputs);
-            ::memcpy(outputPtr + i * outputStride, unit.mMatrixC->host<float>(), outputStride * sizeof(float));
+    int numberThread = static_cast<CPUBackend*>(backend())->threadNumber();
+    if (!mConstB) {
+        auto source = input1->host<float>();
+        int packThread = std::min(numberThread, mBNumber);
+        MNN_CONCURRENCY_BEGIN(tId, packThread) {
+            _packB(mPackB->host<float>(), source, (int)tId, packThread);
+        }
+        MNN_CONCURRENCY_END();
+    }
+    int eP, lP, hP;
+    MNNGetMatMulPackMode(&eP, &lP, &hP);
+    const auto aPtr  = input0->host<float>();
+    const auto bPtr  = mPackB->host<float>();
+    const auto bLowPtr = mPackB->host<int16_t>();
+    const auto cPtr  = output->host<float>();
+    const int e      = mE;
+    const int l      = mL;
+    const int h      = mH;
+    const int aSize  = e * l;
+    const int bSize  = mPackB->stride(0);
+    const int cSize  = e * h;
+    const int lC4    = l / 4;
+    const int lR     = lC4 * 4;
+    int taskThread   = std::min(numberThread, mTaskNumber);
+    MNN_CONCURRENCY_BEGIN(tId, taskThread) {
+        auto tempA = mTempA->host<float>() + tId * mTempA->stride(0);
+        auto tileA = mTileA->host<float>() + tId * mTileA->stride(0);
+        auto tempC = mTempC->host<float>() + tId * mTempC->stride(0);
+        float* cache = nullptr;
+        if (nullptr != mCache) {
+            cache = mCache->host<float>() + tId * mCache->stride(0);
+        }
+        float* tempB = nullptr;
+        if (mLowPrecisionB) {
+            tempB = mTempB->host<float>() + tId * mTempB->stride(0);
+        }
+        size_t parameters[6];
+        parameters[1] = l;
+        parameters[3] = eP * 4 * sizeof(float);
+        parameters[4] = 0;
+        parameters[5] = 0;
+        int lastA = -1;
+        int lastB = -1;
+        for (int index = (int)tId; index < mTaskNumber; index += taskThread) {
+            auto hIndex = index % mHChunk;
+            auto eIndex = (index / mHChunk) % mETile;
+            auto b      = index / mHChunk / mETile;
+            auto eStart = eIndex * eP;
+            auto eCount = std::min(eP, e - eStart);
+            auto hStart = hIndex * mHUnit;
+            auto hCount = std::min(mHUnit, h - hStart);
+            // Pack A tile: (e, l) or (l, e) -> lC4, eCount, 4 -> packed tile
+            auto aKey = mAIndex[b] * mETile + eIndex;
+            if (aKey != lastA) {
+                auto A = aPtr + mAIndex[b] * aSize;
+                if (!mTransposeA) {
+                    for (int y = 0; y < eCount; ++y) {
+                        auto srcY = A + (eStart + y) * l;
+                        auto dstY = tempA + 4 * y;
+                        for (int x = 0; x < lC4; ++x) {
+                            Vec4::save(dstY + x * eCount * 4, Vec4::load(srcY + 4 * x));
+                        }
+                        for (int x = lR; x < l; ++x) {
+                            dstY[lC4 * eCount * 4 + (x - lR)] = srcY[x];
+                        }
+                    }
+                } else {
+                    for (int x = 0; x < l; ++x) {
+                        auto srcX = A + x * e + eStart;
+                        auto dstX = tempA + (x / 4) * eCount * 4 + (x % 4);
+                        for (int y = 0; y < eCount; ++y) {
+                            dstX[4 * y] = srcX[y];
+                        }
+                    }
+                }
+                MNNPackC4ForMatMul_A(tileA, tempA, eCount, l, eCount);
+                lastA = aKey;
+            }
+            parameters[0] = eCount * sizeof(float);
+            parameters[2] = hCount;
+            const float* B = nullptr;
+            if (mLowPrecisionB) {
+                // Expand the bf16 h-block used by this task
+                auto bKey = mBIndex[b] * mHChunk + hIndex;
+                if (bKey != lastB) {
+                    MNNBf16ToFp32(tempB, bLowPtr + mBIndex[b] * bSize + (hStart / hP) * l * hP,
+                                  UP_DIV(hCount, hP) * hP * l);
+                    lastB = bKey;
+                }
+                B = tempB;
+            } else {
+                B = bPtr + mBIndex[b] * bSize + (hStart / hP) * l * hP;
+            }
+            if (eCount == eP) {
+                MNNPackedMatMul(tempC, tileA, B, parameters, cache, nullptr, nullptr);
+            } else {
+                MNNPackedMatMulRemain(tempC, tileA, B, eCount, parameters, cache, nullptr, nullptr);
+            }
+            // hC4, eCount, 4 -> eCount, hCount
+            auto C   = cPtr + b * cSize + eStart * h + hStart;
+            auto hC4 = hCount / 4;
+            auto hR  = hC4 * 4;
+            for (int y = 0; y < eCount; ++y) {
+                auto dstY = C + y * h;
+                auto srcY = tempC + 4 * y;
+                for (int x = 0; x < hC4; ++x) {
+                    Vec4::save(dstY + 4 * x, Vec4::load(srcY + x * eP * 4));
+                }
+                for (int x = hR; x < hCount; ++x) {
+                    dstY[x] = srcY[hC4 * eP * 4 + (x - hR)];
+                }
+            }
         }
     }
     MNN_CONCURRENCY_END();
@@ -9,28 +9,53 @@
 #ifndef CPUBatchMatMul_hpp
 #define CPUBatchMatMul_hpp
 
-#include "backend/cpu/CPUMatMul.hpp"
+#include <memory>
+#include <vector>
+#include "core/Execution.hpp"
 
 namespace MNN {
 
+/*
+ Batched GEMM: C[b] = A[b] * B[b], the leading dimensions of A / B can be broadcast.
+ Every distinct B is packed once per execution (once per resize when B is constant),
+ and the work is split over the combined (batch, e-tile, h-block) space so that
+ all threads are busy even for many small matrices.
+ With Precision_Low and Memory_Low, a constant B is kept as bf16 and expanded per h-block before compute.
+ */
 class CPUBatchMatMul : public Execution {
 public:
     CPUBatchMatMul(Backend *backend, bool adjX, bool adjY);
-    virtual ~CPUBatchMatMul() = default;
+    virtual ~CPUBatchMatMul();
     virtual ErrorCode onExecute(const std::vector<Tensor *> &inputs, const std::vector<Tensor *> &outputs) override;
     virtual ErrorCode onResize(const std::vector<Tensor *> &inputs, const std::vector<Tensor *> &outputs) override;
 
 private:
-    int mBatch;
-    struct Unit {
-        std::shared_ptr<Execution> mMatMul;
-        std::vector<Tensor*> mTempInputs;
-        std::vector<Tensor*> mTempOutputs;
-        std::unique_ptr<Tensor> mMatrixA;
-        std::unique_ptr<Tensor> mMatrixB;
-        std::unique_ptr<Tensor> mMatrixC;
-    };
-    std::vector<Unit> mUnits;
+    void _packB(float* dest, const float* source, int tId, int numberThread);
+    void _releaseConstB();
+    bool mTransposeA;
+    bool mTransposeB;
+    int mE = 0;
+    int mL = 0;
+    int mH = 0;
+    int mHUnit    = 0;
+    int mHChunk   = 0;
+    int mETile    = 0;
+    int mBNumber  = 0;
+    int mTaskNumber = 0;
+    // Matrix index of A and B for each output matrix
+    std::vector<int> mAIndex;
+    std::vector<int> mBIndex;
+    // Packed B: bNumber, UP_DIV(h, hP), l, hP
+    std::shared_ptr<Tensor> mPackB;
+    bool mConstB = false;
+    // Packed B is stored as bf16
+    bool mLowPrecisionB = false;
+    // Per-thread scratch
+    std::shared_ptr<Tensor> mTempA;
+    std::shared_ptr<Tensor> mTileA;
+    std::shared_ptr<Tensor> mTempC;
+    std::shared_ptr<Tensor> mTempB;
+    std::shared_ptr<Tensor> mCache;
 };
 
 } // namespace MNN
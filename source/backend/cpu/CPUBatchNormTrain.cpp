@@ -0,0 +1,273 @@
+//
+//  CPUBatchNormTrain.cpp
+//  MNN
+//
+//  Created by MNN on 2020/12/01.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#include "backend/cpu/CPUBatchNormTrain.hpp"
+#include <math.h>
+#include <algorithm>
+#include "backend/cpu/CPUBackend.hpp"
+#include "core/Concurrency.h"
+#include "core/Macro.h"
+#include "core/TensorUtils.hpp"
+#include "math/Vec.hpp"
+using Vec4 = MNN::Math::Vec<float, 4>;
+
+namespace MNN {
+
+// x is seen as [batch, channel, plane], a unit is 4 channels for NC4HW4 and 1 channel for NCHW
+struct BatchNormView {
+    int batch;
+    int channel;
+    int plane;
+    bool pack;
+    int units() const {
+        return pack ? UP_DIV(channel, 4) : channel;
+    }
+    // Offset of the unit in batch b
+    int offset(int b, int unit) const {
+        return pack ? (b * UP_DIV(channel, 4) + unit) * plane * 4 : (b * channel + unit) * plane;
+    }
+};
+
+static bool _makeView(const Tensor* x, BatchNormView& view) {
+    auto format = TensorUtils::getDescribe(x)->dimensionFormat;
+    if (x->dimensions() < 2 || MNN_DATA_FORMAT_NHWC == format) {
+        return false;
+    }
+    view.batch   = x->length(0);
+    view.channel = x->length(1);
+    view.plane   = 1;
+    for (int i = 2; i < x->dimensions(); ++i) {
+        view.plane *= x->length(i);
+    }
+    view.pack = MNN_DATA_FORMAT_NC4HW4 == format;
+    return true;
+}
+
+// Per-channel values of the unit, zero for the channels out of range
+static void _loadChannel(const float* src, const BatchNormView& view, int unit, float* dst) {
+    if (!view.pack) {
+        dst[0] = src[unit];
+        return;
+    }
+    for (int i = 0; i < 4; ++i) {
+        int c  = unit * 4 + i;
+        dst[i] = c < view.channel ? src[c] : 0.0f;
+    }
+}
+
+static void _saveChannel(float* dst, const BatchNormView& view, int unit, const float* src) {
+    if (!view.pack) {
+        dst[unit] = src[0];
+        return;
+    }
+    for (int i = 0; i < 4 && unit * 4 + i < view.channel; ++i) {
+        dst[unit * 4 + i] = src[i];
+    }
+}
+
+// sum(a - shiftA) and sum((a - shiftA) * (b - shiftB)) of the unit in all batches, 4 lanes for NC4HW4 and 1 lane
+// for NCHW
+static void _sumUnit(const float* a, const float* b, const BatchNormView& view, int unit, Vec4 shiftA, Vec4 shiftB,
+                     float* sum, float* sumProduct) {
+    Vec4 sumValue(0.0f), productValue(0.0f);
+    float sumScalar = 0.0f, productScalar = 0.0f;
+    auto length     = view.pack ? view.plane * 4 : view.plane;
+    auto lengthC4   = length / 4;
+    for (int n = 0; n < view.batch; ++n) {
+        auto srcA = a + view.offset(n, unit);
+        auto srcB = b + view.offset(n, unit);
+        for (int i = 0; i < lengthC4; ++i) {
+            auto va      = Vec4::load(srcA + 4 * i) - shiftA;
+            auto vb      = Vec4::load(srcB + 4 * i) - shiftB;
+            sumValue     = sumValue + va;
+            productValue = productValue + va * vb;
+        }
+        for (int i = lengthC4 * 4; i < length; ++i) {
+            auto va = srcA[i] - shiftA[0];
+            sumScalar += va;
+            productScalar += va * (srcB[i] - shiftB[0]);
+        }
+    }
+    if (view.pack) {
+        for (int i = 0; i < 4; ++i) {
+            sum[i]        = sumValue[i];
+            sumProduct[i] = productValue[i];
+        }
+        return;
+    }
+    sum[0]        = sumScalar + sumValue[0] + sumValue[1] + sumValue[2] + sumValue[3];
+    sumProduct[0] = productScalar + productValue[0] + productValue[1] + productValue[2] + productValue[3];
+}
+
+// dst = a * alpha + b * beta + gamma for the unit of all batches
+static void _axpbyUnit(float* dst, const float* a, const float* b, const BatchNormView& view, int unit,
+                       const float* alpha, const float* beta, const float* gamma) {
+    Vec4 alphaValue, betaValue(0.0f), gammaValue;
+    if (view.pack) {
+        alphaValue = Vec4::load(alpha);
+        gammaValue = Vec4::load(gamma);
+        if (nullptr != b) {
+            betaValue = Vec4::load(beta);
+        }
+    } else {
+        alphaValue = Vec4(alpha[0]);
+        gammaValue = Vec4(gamma[0]);
+        if (nullptr != b) {
+            betaValue = Vec4(beta[0]);
+        }
+    }
+    auto length   = view.pack ? view.plane * 4 : view.plane;
+    auto lengthC4 = length / 4;
+    for (int n = 0; n < view.batch; ++n) {
+        auto offset = view.offset(n, unit);
+        auto d      = dst + offset;
+        auto srcA   = a + offset;
+        auto srcB   = nullptr != b ? b + offset : nullptr;
+        for (int i = 0; i < lengthC4; ++i) {
+            auto value = Vec4::load(srcA + 4 * i) * alphaValue + gammaValue;
+            if (nullptr != srcB) {
+                value = value + Vec4::load(srcB + 4 * i) * betaValue;
+            }
+            Vec4::save(d + 4 * i, value);
+        }
+        for (int i = lengthC4 * 4; i < length; ++i) {
+            auto value = srcA[i] * alpha[0] + gamma[0];
+            if (nullptr != srcB) {
+                value += srcB[i] * beta[0];
+            }
+            d[i] = value;
+        }
+    }
+}
+
+CPUBatchNormTrain::CPUBatchNormTrain(Backend* backend, float eps) : Execution(backend) {
+    mEps = eps;
+}
+
+ErrorCode CPUBatchNormTrain::onExecute(const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs) {
+    BatchNormView view;
+    if (!_makeView(inputs[0], view)) {
+        return NOT_SUPPORT;
+    }
+    auto x      = inputs[0]->host<float>();
+    auto scale  = inputs[1]->host<float>();
+    auto bias   = inputs[2]->host<float>();
+    auto y      = outputs[0]->host<float>();
+    auto mean   = outputs[1]->host<float>();
+    auto invStd = outputs[2]->host<float>();
+    auto units  = view.units();
+    auto lanes  = view.pack ? 4 : 1;
+    float rSize = 1.0f / (float)(view.batch * view.plane);
+    int threadNumber = std::max(1, std::min(static_cast<CPUBackend*>(backend())->threadNumber(), units));
+    MNN_CONCURRENCY_BEGIN(tId, threadNumber) {
+        for (int u = (int)tId; u < units; u += threadNumber) {
+            // var = E[(x - k)^2] - E[x - k]^2, k is the first value of the channel to keep the precision
+            auto shift = view.pack ? Vec4::load(x + view.offset(0, u)) : Vec4(x[view.offset(0, u)]);
+            float sum[4], sumSquare[4], s[4], b[4], m[4], r[4], alpha[4], gamma[4];
+            _sumUnit(x, x, view, u, shift, shift, sum, sumSquare);
+            _loadChannel(scale, view, u, s);
+            _loadChannel(bias, view, u, b);
+            for (int i = 0; i < lanes; ++i) {
+                auto diff = sum[i] * rSize;
+                auto var  = std::max(sumSquare[i] * rSize - diff * diff, 0.0f);
+                m[i]      = diff + shift[i];
+                r[i]      = 1.0f / sqrtf(var + mEps);
+                alpha[i]  = r[i] * s[i];
+                gamma[i]  = b[i] - m[i] * alpha[i];
+            }
+            // Keep the padding channels of NC4HW4 zero
+            for (int i = view.channel - u * lanes; i < lanes; ++i) {
+                alpha[i] = 0.0f;
+                gamma[i] = 0.0f;
+            }
+            _saveChannel(mean, view, u, m);
+            _saveChannel(invStd, view, u, r);
+            _axpbyUnit(y, x, nullptr, view, u, alpha, nullptr, gamma);
+        }
+    }
+    MNN_CONCURRENCY_END();
+    return NO_ERROR;
+}
+
+CPUBatchNormGrad::CPUBatchNormGrad(Backend* backend) : Execution(backend) {
+    // Do nothing
+}
+
+ErrorCode CPUBatchNormGrad::onExecute(const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs) {
+    BatchNormView view;
+    if (!_makeView(inputs[0], view)) {
+        return NOT_SUPPORT;
+    }
+    auto x      = inputs[0]->host<float>();
+    auto dy     = inputs[1]->host<float>();
+    auto scale  = inputs[2]->host<float>();
+    auto mean   = inputs[3]->host<float>();
+    auto invStd = inputs[4]->host<float>();
+    auto dx     = outputs[0]->host<float>();
+    auto dScale = outputs[1]->host<float>();
+    auto dBias  = outputs[2]->host<float>();
+    auto units  = view.units();
+    auto lanes  = view.pack ? 4 : 1;
+    float rSize = 1.0f / (float)(view.batch * view.plane);
+    int threadNumber = std::max(1, std::min(static_cast<CPUBackend*>(backend())->threadNumber(), units));
+    MNN_CONCURRENCY_BEGIN(tId, threadNumber) {
+        for (int u = (int)tId; u < units; u += threadNumber) {
+            float s[4], m[4], r[4], sumDy[4], sumDyX[4], alpha[4], beta[4], gamma[4];
+            _loadChannel(scale, view, u, s);
+            _loadChannel(mean, view, u, m);
+            _loadChannel(invStd, view, u, r);
+            // sum(dy) and sum(dy * (x - mean))
+            _sumUnit(dy, x, view, u, Vec4(0.0f), view.pack ? Vec4::load(m) : Vec4(m[0]), sumDy, sumDyX);
+            // dx = scale * invStd * (dy - mean(dy) - xhat * mean(dy * xhat)), xhat = (x - mean) * invStd
+            for (int i = 0; i < lanes; ++i) {
+                auto dScaleValue = sumDyX[i] * r[i];
+                auto k           = s[i] * r[i];
+                alpha[i]         = k;
+                beta[i]          = -k * r[i] * dScaleValue * rSize;
+                gamma[i]         = -beta[i] * m[i] - k * sumDy[i] * rSize;
+                sumDyX[i]        = dScaleValue;
+            }
+            for (int i = view.channel - u * lanes; i < lanes; ++i) {
+                alpha[i] = 0.0f;
+                beta[i]  = 0.0f;
+                gamma[i] = 0.0f;
+            }
+            _saveChannel(dScale, view, u, sumDyX);
+            _saveChannel(dBias, view, u, sumDy);
+            _axpbyUnit(dx, dy, x, view, u, alpha, beta, gamma);
+        }
+    }
+    MNN_CONCURRENCY_END();
+    return NO_ERROR;
+}
+
+class CPUBatchNormTrainCreator : public CPUBackend::Creator {
+public:
+    virtual Execution* onCreate(const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs,
+                                const MNN::Op* op, Backend* backend) const override {
+        float eps  = 0.001f;
+        auto param = op->main_as_BatchNorm();
+        if (nullptr != param) {
+            eps = param->epsilon();
+        }
+        return new CPUBatchNormTrain(backend, eps);
+    }
+};
+
+class CPUBatchNormGradCreator : public CPUBackend::Creator {
+public:
+    virtual Execution* onCreate(const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs,
+                                const MNN::Op* op, Backend* backend) const override {
+        return new CPUBatchNormGrad(backend);
+    }
+};
+
+REGISTER_CPU_OP_CREATOR(CPUBatchNormTrainCreator, OpType_BatchNormTrain);
+REGISTER_CPU_OP_CREATOR(CPUBatchNormGradCreator, OpType_BatchNormGrad);
+
+} // namespace MNN
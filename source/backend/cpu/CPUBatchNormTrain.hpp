@@ -0,0 +1,46 @@
+//
+//  CPUBatchNormTrain.hpp
+//  MNN
+//
+//  Created by MNN on 2020/12/01.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#ifndef CPUBatchNormTrain_hpp
+#define CPUBatchNormTrain_hpp
+
+#include "core/Execution.hpp"
+
+namespace MNN {
+
+/*
+ BatchNorm of training, the statistics come from the batch.
+ x: [n, c, ...] in NCHW or NC4HW4, scale / bias: c elements
+ -> y: the same as x, mean / invStd: the shape of scale, invStd = 1 / sqrt(var + eps)
+ One pass for mean and variance (shifted by the first value of the channel), one pass for y.
+ */
+class CPUBatchNormTrain : public Execution {
+public:
+    CPUBatchNormTrain(Backend *backend, float eps);
+    virtual ~CPUBatchNormTrain() = default;
+    virtual ErrorCode onExecute(const std::vector<Tensor *> &inputs, const std::vector<Tensor *> &outputs) override;
+
+private:
+    float mEps;
+};
+
+/*
+ Gradient of CPUBatchNormTrain, it only needs the statistics instead of the normalized x.
+ x, dy, scale, mean, invStd -> dx, dScale, dBias
+ One pass for sum(dy) and sum(dy * xhat), one pass for dx.
+ */
+class CPUBatchNormGrad : public Execution {
+public:
+    CPUBatchNormGrad(Backend *backend);
+    virtual ~CPUBatchNormGrad() = default;
+    virtual ErrorCode onExecute(const std::vector<Tensor *> &inputs, const std::vector<Tensor *> &outputs) override;
+};
+
+} // namespace MNN
+
+#endif /* CPUBatchNormTrain_hpp */
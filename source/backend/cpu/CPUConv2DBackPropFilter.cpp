@@ -0,0 +1,221 @@
+//
+//  CPUConv2DBackPropFilter.cpp
+//  MNN
+//
+//  Created by MNN on 2020/11/12.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#include "backend/cpu/CPUConv2DBackPropFilter.hpp"
+#include "backend/cpu/CPUBackend.hpp"
+#include "backend/cpu/compute/CommonOptFunction.h"
+#include "core/Concurrency.h"
+#include "core/ConvolutionCommon.hpp"
+#include "core/Macro.h"
+#include "core/TensorUtils.hpp"
+
+// Output positions packed per tile, the scratch is about (ic * kh * kw + 2 * oc) * tile floats
+#define MNN_BACKPROP_FILTER_TILE 256
+
+namespace MNN {
+// Element (b, c, y, x) of an NCHW / NC4HW4 tensor is at b * batchStride + channelOffset(c) + (y * w + x) * pixelStride
+struct _Layout {
+    int batchStride;
+    int pixelStride;
+    int area;
+    bool c4;
+    int channelOffset(int c) const {
+        if (c4) {
+            return (c / 4) * area * 4 + (c % 4);
+        }
+        return c * area;
+    }
+};
+
+static _Layout _getLayout(const Tensor* t) {
+    _Layout layout;
+    layout.area        = t->width() * t->height();
+    layout.c4          = TensorUtils::getDescribe(t)->dimensionFormat == MNN_DATA_FORMAT_NC4HW4;
+    layout.pixelStride = layout.c4 ? 4 : 1;
+    layout.batchStride = layout.c4 ? ALIGN_UP4(t->channel()) * layout.area : t->channel() * layout.area;
+    return layout;
+}
+
+CPUConv2DBackPropFilter::CPUConv2DBackPropFilter(const Convolution2DCommon* common, Backend* b)
+    : Execution(b), mCommon(common) {
+    // Do nothing
+}
+
+ErrorCode CPUConv2DBackPropFilter::onResize(const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs) {
+    auto input      = inputs[0];
+    auto outputDiff = inputs[1];
+    auto pads       = ConvolutionCommon::convolutionPad(input, outputDiff, mCommon);
+    mPadX           = pads.first;
+    mPadY           = pads.second;
+
+    const int ic          = input->channel();
+    const int oc          = outputDiff->channel();
+    const int kernelCount = mCommon->kernelX() * mCommon->kernelY();
+    const int total       = outputDiff->batch() * outputDiff->width() * outputDiff->height();
+    mTileSize             = ALIMIN(total, MNN_BACKPROP_FILTER_TILE);
+    mPositions.resize(3 * mTileSize);
+
+    int eP, lP, hP;
+    MNNGetMatMulPackMode(&eP, &lP, &hP);
+    const int threadNumber = ((CPUBackend*)backend())->threadNumber();
+    const int ocC4         = UP_DIV(oc, 4);
+    mColBuffer.reset(Tensor::createDevice<float>({UP_DIV(mTileSize, 4), ic * kernelCount, 4}));
+    mDiffBuffer.reset(Tensor::createDevice<float>({oc, mTileSize}));
+    mPackedDiff.reset(Tensor::createDevice<float>({UP_DIV(oc, hP), mTileSize, hP}));
+    mPackedCol.reset(Tensor::createDevice<float>({threadNumber, mTileSize * eP}));
+    mResultBuffer.reset(Tensor::createDevice<float>({threadNumber, ocC4 * eP * 4}));
+    std::vector<Tensor*> buffers = {mColBuffer.get(), mDiffBuffer.get(), mPackedDiff.get(), mPackedCol.get(),
+                                    mResultBuffer.get()};
+    mCache.reset();
+    if (hP % 4 != 0) {
+        auto hDiv = MNNGetC4DivNumber(hP);
+        mCache.reset(Tensor::createDevice<float>({threadNumber, 4 * hDiv * eP + ocC4 * 4 * eP}));
+        buffers.emplace_back(mCache.get());
+    }
+    for (auto t : buffers) {
+        if (!backend()->onAcquireBuffer(t, Backend::DYNAMIC)) {
+            return OUT_OF_MEMORY;
+        }
+    }
+    for (auto t : buffers) {
+        backend()->onReleaseBuffer(t, Backend::DYNAMIC);
+    }
+    return NO_ERROR;
+}
+
+ErrorCode CPUConv2DBackPropFilter::onExecute(const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs) {
+    auto input      = inputs[0];
+    auto outputDiff = inputs[1];
+    auto kernelDiff = outputs[0];
+
+    const int ic = input->channel(), ih = input->height(), iw = input->width();
+    const int oc = outputDiff->channel(), oh = outputDiff->height(), ow = outputDiff->width();
+    const int kh = mCommon->kernelY(), kw = mCommon->kernelX();
+    const int sh = mCommon->strideY(), sw = mCommon->strideX();
+    const int dh = mCommon->dilateY(), dw = mCommon->dilateX();
+    const int padX = mPadX, padY = mPadY, tileSize = mTileSize;
+    const int kernelCount = kh * kw, plane = oh * ow, total = outputDiff->batch() * plane;
+    const int threadNumber = ((CPUBackend*)backend())->threadNumber();
+
+    const int kernelSize   = ic * kernelCount;
+    int eP, lP, hP;
+    MNNGetMatMulPackMode(&eP, &lP, &hP);
+    const int eBlocks = UP_DIV(kernelSize, eP);
+
+    const auto inputLayout = _getLayout(input);
+    const auto diffLayout  = _getLayout(outputDiff);
+    auto inputPtr          = input->host<float>();
+    auto diffPtr           = outputDiff->host<float>();
+    auto colPtr            = mColBuffer->host<float>();
+    auto diffTilePtr       = mDiffBuffer->host<float>();
+    auto packedDiffPtr     = mPackedDiff->host<float>();
+    auto kernelDiffPtr     = kernelDiff->host<float>();
+    auto batchIndex        = mPositions.data();
+    auto yIndex            = batchIndex + tileSize;
+    auto xIndex            = yIndex + tileSize;
+
+    std::vector<size_t> parameters(6);
+    parameters[0] = eP * sizeof(float);
+    parameters[2] = oc;
+    parameters[3] = eP * 4 * sizeof(float);
+    parameters[4] = 0;
+    parameters[5] = 0;
+
+    ::memset(kernelDiffPtr, 0, oc * kernelSize * sizeof(float));
+    for (int tileStart = 0; tileStart < total; tileStart += tileSize) {
+        const int count = ALIMIN(tileSize, total - tileStart);
+        for (int t = 0; t < count; ++t) {
+            auto pos      = tileStart + t;
+            batchIndex[t] = pos / plane;
+            yIndex[t]     = (pos % plane) / ow;
+            xIndex[t]     = pos % ow;
+        }
+        // Pack input im2col as [count / 4, ic * kh * kw, 4] and outputDiff of the tile as [oc, count]
+        MNN_CONCURRENCY_BEGIN(tId, threadNumber) {
+            for (int c = (int)tId; c < ic; c += threadNumber) {
+                auto srcC = inputPtr + inputLayout.channelOffset(c);
+                for (int ky = 0; ky < kh; ++ky) {
+                    for (int kx = 0; kx < kw; ++kx) {
+                        auto dst = colPtr + ((c * kh + ky) * kw + kx) * 4;
+                        for (int t = 0; t < count; ++t) {
+                            auto dstT = dst + (t / 4) * kernelSize * 4 + (t % 4);
+                            int sy    = yIndex[t] * sh - padY + ky * dh;
+                            int sx    = xIndex[t] * sw - padX + kx * dw;
+                            if (sy < 0 || sy >= ih || sx < 0 || sx >= iw) {
+                                *dstT = 0.0f;
+                                continue;
+                            }
+                            *dstT = srcC[batchIndex[t] * inputLayout.batchStride +
+                                         (sy * iw + sx) * inputLayout.pixelStride];
+                        }
+                    }
+                }
+            }
+            for (int o = (int)tId; o < oc; o += threadNumber) {
+                auto srcO = diffPtr + diffLayout.channelOffset(o);
+                auto dst  = diffTilePtr + o * count;
+                for (int t = 0; t < count; ++t) {
+                    dst[t] = srcO[batchIndex[t] * diffLayout.batchStride +
+                                  (yIndex[t] * ow + xIndex[t]) * diffLayout.pixelStride];
+                }
+            }
+        }
+        MNN_CONCURRENCY_END();
+        MNNPackForMatMul_B(packedDiffPtr, diffTilePtr, oc, count, true);
+        parameters[1] = count;
+
+        // kernelDiff[o, j] += col[j, tile] * outputDiff[o, tile], eP kernel positions j each time
+        MNN_CONCURRENCY_BEGIN(tId, threadNumber) {
+            auto packedCol = mPackedCol->host<float>() + tId * mPackedCol->stride(0);
+            auto result    = mResultBuffer->host<float>() + tId * mResultBuffer->stride(0);
+            float* cache   = nullptr;
+            if (nullptr != mCache) {
+                cache = mCache->host<float>() + tId * mCache->stride(0);
+            }
+            for (int block = (int)tId; block < eBlocks; block += threadNumber) {
+                const int start = block * eP;
+                const int eC    = ALIMIN(eP, kernelSize - start);
+                MNNPackC4ForMatMul_A(packedCol, colPtr + start * 4, eC, count, kernelSize);
+                if (eC == eP) {
+                    MNNPackedMatMul(result, packedCol, packedDiffPtr, parameters.data(), cache, nullptr, nullptr);
+                } else {
+                    // The remain block is packed with eC as the stride
+                    auto remainParameters = parameters;
+                    remainParameters[0]   = eC * sizeof(float);
+                    MNNPackedMatMulRemain(result, packedCol, packedDiffPtr, eC, remainParameters.data(), cache,
+                                          nullptr, nullptr);
+                }
+                // result: [oc / 4, eP, 4]
+                for (int o = 0; o < oc; ++o) {
+                    auto src = result + (o / 4) * eP * 4 + (o % 4);
+                    auto dst = kernelDiffPtr + o * kernelSize + start;
+                    for (int e = 0; e < eC; ++e) {
+                        dst[e] += src[e * 4];
+                    }
+                }
+            }
+        }
+        MNN_CONCURRENCY_END();
+    }
+    return NO_ERROR;
+}
+
+class CPUConv2DBackPropFilterCreator : public CPUBackend::Creator {
+public:
+    virtual Execution* onCreate(const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs,
+                                const MNN::Op* op, Backend* backend) const override {
+        auto common = op->main_as_Convolution2D()->common();
+        if (common->group() != 1) {
+            return nullptr;
+        }
+        return new CPUConv2DBackPropFilter(common, backend);
+    }
+};
+
+REGISTER_CPU_OP_CREATOR(CPUConv2DBackPropFilterCreator, OpType_Conv2DBackPropFilter);
+} // namespace MNN
@@ -0,0 +1,46 @@
+//
+//  CPUConv2DBackPropFilter.hpp
+//  MNN
+//
+//  Created by MNN on 2020/11/12.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#ifndef CPUConv2DBackPropFilter_hpp
+#define CPUConv2DBackPropFilter_hpp
+
+#include "core/Execution.hpp"
+#include "MNN_generated.h"
+
+namespace MNN {
+// Weight gradient of a group = 1 convolution: kernelDiff[oc, ic, kh, kw] = sum(outputDiff * im2col(input))
+// The im2col is packed tile by tile instead of for the whole n * oh * ow plane, and multiplied with the outputDiff of
+// the tile by MNNPackedMatMul: e = ic * kh * kw, l = tile, h = oc
+class CPUConv2DBackPropFilter : public Execution {
+public:
+    CPUConv2DBackPropFilter(const Convolution2DCommon *common, Backend *b);
+    virtual ~CPUConv2DBackPropFilter() = default;
+    virtual ErrorCode onResize(const std::vector<Tensor *> &inputs, const std::vector<Tensor *> &outputs) override;
+    virtual ErrorCode onExecute(const std::vector<Tensor *> &inputs, const std::vector<Tensor *> &outputs) override;
+
+private:
+    const Convolution2DCommon *mCommon;
+    int mPadX     = 0;
+    int mPadY     = 0;
+    int mTileSize = 0;
+    // tile / 4, ic * kh * kw, 4
+    std::shared_ptr<Tensor> mColBuffer;
+    // oc, tile
+    std::shared_ptr<Tensor> mDiffBuffer;
+    // outputDiff of the tile packed by MNNPackForMatMul_B
+    std::shared_ptr<Tensor> mPackedDiff;
+    // For each thread: im2col of eP kernel positions packed by MNNPackC4ForMatMul_A, and the result of them
+    std::shared_ptr<Tensor> mPackedCol;
+    std::shared_ptr<Tensor> mResultBuffer;
+    std::shared_ptr<Tensor> mCache;
+    // batch, oy, ox of each position in the tile
+    std::vector<int> mPositions;
+};
+} // namespace MNN
+
+#endif /* CPUConv2DBackPropFilter_hpp */
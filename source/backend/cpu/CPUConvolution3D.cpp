@@ -0,0 +1,277 @@
+//
+//  CPUConvolution3D.cpp
+//  MNN
+//
+//  Created by MNN on 2019/09/03.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#include "backend/cpu/CPUConvolution3D.hpp"
+#include <limits>
+#include "backend/cpu/CPUBackend.hpp"
+#include "backend/cpu/compute/CommonOptFunction.h"
+#include "backend/cpu/compute/ConvOpt.h"
+#include "backend/cpu/compute/ConvolutionWinograd3D.hpp"
+#include "core/Concurrency.h"
+#include "core/Macro.h"
+#include "core/TensorUtils.hpp"
+#include "math/Vec.hpp"
+
+using Vec4 = MNN::Math::Vec<float, 4>;
+namespace MNN {
+// Weight: oc, ic, kd*kh*kw -> oc, kd*kh*kw, ic, then pack for MNNPackedMatMul
+static void _initWeight(float* dest, const float* source, float* cache, int depth, int outputCount, int kernelSize) {
+    int dims[4] = {
+        depth,
+        kernelSize,
+        kernelSize,
+        depth
+    };
+    for (int o = 0; o < outputCount; ++o) {
+        auto dO = cache + o * depth * kernelSize;
+        auto sO = source + o * depth * kernelSize;
+        MNNTranspose32Bit((int32_t*)dO, (const int32_t*)sO, &dims[0]);
+    }
+    MNNPackForMatMul_B(dest, cache, outputCount, kernelSize * depth, true);
+}
+
+CPUConvolution3D::CPUConvolution3D(const Convolution3DCommon* common, Backend* b, const float* originWeight,
+                                   size_t originWeightSize, const float* bias, size_t biasSize)
+    : Execution(b), mCommon(common) {
+    for (int kernel : *(common->kernels())) {
+        mKernels.push_back(kernel);
+    }
+    for (int stride : *(common->strides())) {
+        mStrides.push_back(stride);
+    }
+    for (int dilate : *(common->dilates())) {
+        mDilates.push_back(dilate);
+    }
+    int eP, lP, hP;
+    MNNGetMatMulPackMode(&eP, &lP, &hP);
+    auto outputCount = (int)biasSize;
+    auto kernelSize  = mKernels[0] * mKernels[1] * mKernels[2];
+    auto srcCount    = (int)originWeightSize / outputCount / kernelSize;
+    mWeight.reset(Tensor::createDevice<float>({UP_DIV(outputCount, hP), UP_DIV(srcCount, 4), kernelSize, 4 * hP}));
+    std::shared_ptr<Tensor> cache(Tensor::createDevice<float>({outputCount, srcCount * kernelSize}));
+    mValid = b->onAcquireBuffer(mWeight.get(), Backend::STATIC) && b->onAcquireBuffer(cache.get(), Backend::STATIC);
+    if (!mValid) {
+        return;
+    }
+    static_cast<CPUBackend*>(b)->packWeight(mWeight.get(), "Conv3D_" + std::to_string(hP), originWeight,
+                                            originWeightSize * sizeof(float), [&]() {
+        _initWeight(mWeight->host<float>(), originWeight, cache->host<float>(), srcCount, outputCount, kernelSize);
+    });
+    b->onReleaseBuffer(cache.get(), Backend::STATIC);
+    mBias.reset(Tensor::createDevice<float>({ALIGN_UP4(outputCount)}));
+    mValid = b->onAcquireBuffer(mBias.get(), Backend::STATIC);
+    if (!mValid) {
+        return;
+    }
+    ::memset(mBias->host<float>(), 0, mBias->size());
+    ::memcpy(mBias->host<float>(), bias, biasSize * sizeof(float));
+}
+
+CPUConvolution3D::~CPUConvolution3D() {
+    if (nullptr != mWeight) {
+        backend()->onReleaseBuffer(mWeight.get(), Backend::STATIC);
+    }
+    if (nullptr != mBias) {
+        backend()->onReleaseBuffer(mBias.get(), Backend::STATIC);
+    }
+}
+
+std::vector<int> CPUConvolution3D::computePads(const Convolution3DCommon* common, const Tensor* input,
+                                               const Tensor* output) {
+    std::vector<int> pads(3, 0);
+    if (common->padMode() == PadMode_SAME) {
+        for (int i = 0; i < 3; ++i) {
+            int inputNeeded = (output->length(i + 2) - 1) * (*common->strides())[i] +
+                              ((*common->kernels())[i] - 1) * (*common->dilates())[i] + 1;
+            pads[i] = (inputNeeded - input->length(i + 2)) / 2;
+        }
+    } else if (common->padMode() == PadMode_CAFFE) {
+        for (int i = 0; i < 3; ++i) {
+            pads[i] = (*common->pads())[i];
+        }
+    }
+    return pads;
+}
+
+ErrorCode CPUConvolution3D::onResize(const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs) {
+    if (!mValid) {
+        return OUT_OF_MEMORY;
+    }
+    auto input  = inputs[0];
+    auto output = outputs[0];
+    mPads       = computePads(mCommon, input, output);
+
+    int eP, lP, hP;
+    MNNGetMatMulPackMode(&eP, &lP, &hP);
+    const int threadNumber  = ((CPUBackend*)backend())->threadNumber();
+    const int ic            = input->length(1), icC4 = UP_DIV(ic, 4);
+    const int oc            = output->length(1), ocC4 = UP_DIV(oc, 4);
+    const int id            = input->length(2), ih = input->length(3), iw = input->length(4);
+    const int od            = output->length(2), oh = output->length(3), ow = output->length(4);
+    const int kernelSize    = mKernels[0] * mKernels[1] * mKernels[2];
+    const int plane         = od * oh * ow;
+    const int batch         = input->length(0);
+    const int srcBatchStep  = icC4 * id * ih * iw * 4;
+    const int dstBatchStep  = ocC4 * plane * 4;
+    const int tileCount     = UP_DIV(plane, eP);
+
+    // The scratch only holds one tile: ic * kd * kh * kw * eP for each thread
+    mTempBuffer.reset(Tensor::createDevice<float>({threadNumber, icC4 * kernelSize * eP * 4}));
+    mTempBufferTranspose.reset(Tensor::createDevice<float>({threadNumber, ic * kernelSize * eP}));
+    bool success = backend()->onAcquireBuffer(mTempBuffer.get(), Backend::DYNAMIC) &&
+                   backend()->onAcquireBuffer(mTempBufferTranspose.get(), Backend::DYNAMIC);
+    if (!success) {
+        return OUT_OF_MEMORY;
+    }
+    mCache.reset();
+    if (hP % 4 != 0) {
+        auto hDiv = MNNGetC4DivNumber(hP);
+        mCache.reset(Tensor::createDevice<float>({threadNumber, 4 * hDiv * eP + ocC4 * 4 * eP}));
+        success = backend()->onAcquireBuffer(mCache.get(), Backend::DYNAMIC);
+        if (!success) {
+            return OUT_OF_MEMORY;
+        }
+        backend()->onReleaseBuffer(mCache.get(), Backend::DYNAMIC);
+    }
+    backend()->onReleaseBuffer(mTempBuffer.get(), Backend::DYNAMIC);
+    backend()->onReleaseBuffer(mTempBufferTranspose.get(), Backend::DYNAMIC);
+
+    std::vector<size_t> parameters(6);
+    parameters[0] = eP * sizeof(float);
+    parameters[1] = ic * kernelSize;
+    parameters[2] = oc;
+    parameters[3] = plane * 4 * sizeof(float);
+    parameters[4] = 0;
+    parameters[5] = 0;
+    std::vector<float> postParameters = {
+        1.0f,
+        1.0f,
+        -std::numeric_limits<float>().max(),
+        std::numeric_limits<float>().max(),
+    };
+    if (mCommon->relu()) {
+        postParameters[2] = 0.0f;
+    }
+    if (mCommon->relu6()) {
+        postParameters[2] = 0.0f;
+        postParameters[3] = 6.0f;
+    }
+    const int kd = mKernels[0], kh = mKernels[1], kw = mKernels[2];
+    const int sd = mStrides[0], sh = mStrides[1], sw = mStrides[2];
+    const int dd = mDilates[0], dh = mDilates[1], dw = mDilates[2];
+    const int pd = mPads[0], ph = mPads[1], pw = mPads[2];
+    const int srcZStep = id * ih * iw * 4;
+    auto tempBuffer    = mTempBuffer;
+    auto gemmBuffer    = mTempBufferTranspose;
+    auto cache         = mCache;
+    auto weight        = mWeight;
+    auto bias          = mBias;
+    mFunction.first    = std::min(threadNumber, tileCount);
+    auto threadNumberFirst = mFunction.first;
+    mFunction.second   = [=](int tId) {
+        auto colBuffer = tempBuffer->host<float>() + tempBuffer->stride(0) * tId;
+        auto gemmPtr   = gemmBuffer->host<float>() + gemmBuffer->stride(0) * tId;
+        float* cachePtr = nullptr;
+        if (nullptr != cache) {
+            cachePtr = cache->host<float>() + tId * cache->stride(0);
+        }
+        for (int b = 0; b < batch; ++b) {
+            auto srcOrigin = input->host<float>() + b * srcBatchStep;
+            auto dstOrigin = output->host<float>() + b * dstBatchStep;
+            for (int x = tId; x < tileCount; x += threadNumberFirst) {
+                int start = x * eP;
+                int xC    = std::min(eP, plane - start);
+                // Im2Col for this tile only, layout: icC4, kd*kh*kw, eP, 4
+                ::memset(colBuffer, 0, tempBuffer->stride(0) * sizeof(float));
+                for (int i = 0; i < xC; ++i) {
+                    int index   = start + i;
+                    int ox      = index % ow;
+                    int oy      = (index / ow) % oh;
+                    int oz      = index / (ow * oh);
+                    int szSta   = oz * sd - pd;
+                    int sySta   = oy * sh - ph;
+                    int sxSta   = ox * sw - pw;
+                    int kzStart = std::max(0, UP_DIV(-szSta, dd)), kzEnd = std::min(kd, UP_DIV(id - szSta, dd));
+                    int kyStart = std::max(0, UP_DIV(-sySta, dh)), kyEnd = std::min(kh, UP_DIV(ih - sySta, dh));
+                    int kxStart = std::max(0, UP_DIV(-sxSta, dw)), kxEnd = std::min(kw, UP_DIV(iw - sxSta, dw));
+                    auto srcStart = srcOrigin + ((szSta * ih + sySta) * iw + sxSta) * 4;
+                    auto dstStart = colBuffer + 4 * i;
+                    for (int sz = 0; sz < icC4; ++sz) {
+                        auto srcC = srcStart + sz * srcZStep;
+                        auto dstC = dstStart + sz * kernelSize * eP * 4;
+                        for (int kz = kzStart; kz < kzEnd; ++kz) {
+                            for (int ky = kyStart; ky < kyEnd; ++ky) {
+                                auto srcY = srcC + ((kz * dd * ih) + ky * dh) * iw * 4;
+                                auto dstY = dstC + (kz * kh + ky) * kw * eP * 4;
+                                for (int kx = kxStart; kx < kxEnd; ++kx) {
+                                    Vec4::save(dstY + kx * eP * 4, Vec4::load(srcY + kx * dw * 4));
+                                }
+                            }
+                        }
+                    }
+                }
+                // GEMM
+                MNNPackC4ForMatMul_A(gemmPtr, colBuffer, eP * kernelSize, ic, eP * kernelSize);
+                if (xC == eP) {
+                    MNNPackedMatMul(dstOrigin + start * 4, gemmPtr, weight->host<float>(), parameters.data(), cachePtr,
+                                    postParameters.data(), bias->host<float>());
+                } else {
+                    MNNPackedMatMulRemain(dstOrigin + start * 4, gemmPtr, weight->host<float>(), xC, parameters.data(),
+                                          cachePtr, postParameters.data(), bias->host<float>());
+                }
+            }
+        }
+    };
+    return NO_ERROR;
+}
+
+ErrorCode CPUConvolution3D::onExecute(const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs) {
+    MNN_CONCURRENCY_BEGIN(tId, mFunction.first) {
+        mFunction.second((int)tId);
+    }
+    MNN_CONCURRENCY_END();
+    return NO_ERROR;
+}
+
+CPUConvolution3D::POSTFUNCTION CPUConvolution3D::getPostFunction(const Convolution3DCommon* common) {
+    if (common->relu()) {
+        return MNNAddBiasRelu;
+    }
+    if (common->relu6()) {
+        return MNNAddBiasRelu6;
+    }
+    return MNNAddBias;
+}
+
+class CPUConvolution3DCreator : public CPUBackend::Creator {
+public:
+    virtual Execution* onCreate(const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs,
+                                const MNN::Op* op, Backend* backend) const override {
+        auto conv3d = op->main_as_Convolution3D();
+        if (nullptr == conv3d->weight() || nullptr == conv3d->bias()) {
+            return nullptr;
+        }
+        auto common      = conv3d->common();
+        auto weight      = conv3d->weight()->data();
+        auto weightSize  = conv3d->weight()->size();
+        auto bias        = conv3d->bias()->data();
+        auto biasSize    = conv3d->bias()->size();
+        auto threadNumber = static_cast<CPUBackend*>(backend)->threadNumber();
+        if (ConvolutionWinograd3D::canUseWinograd(common)) {
+            int unit = ConvolutionWinograd3D::bestWinogradUnit(common, inputs[0], outputs[0], threadNumber);
+            if (unit > 1) {
+                return new ConvolutionWinograd3D(common, inputs[0], outputs[0], backend, weight, weightSize, bias,
+                                                 biasSize, unit);
+            }
+        }
+        return new CPUConvolution3D(common, backend, weight, weightSize, bias, biasSize);
+    }
+};
+
+REGISTER_CPU_OP_CREATOR(CPUConvolution3DCreator, OpType_Convolution3D);
+} // namespace MNN
@@ -0,0 +1,48 @@
+//
+//  CPUConvolution3D.hpp
+//  MNN
+//
+//  Created by MNN on 2019/09/03.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#ifndef CPUConvolution3D_hpp
+#define CPUConvolution3D_hpp
+
+#include <functional>
+#include <vector>
+#include "core/Execution.hpp"
+#include "MNN_generated.h"
+
+namespace MNN {
+// Implicit GEMM: im2col is packed per tile of output points, so the scratch memory is bounded by the tile size
+class CPUConvolution3D : public Execution {
+public:
+    CPUConvolution3D(const Convolution3DCommon *common, Backend *b, const float *originWeight, size_t originWeightSize,
+                     const float *bias, size_t biasSize);
+    virtual ~CPUConvolution3D();
+    virtual ErrorCode onResize(const std::vector<Tensor *> &inputs, const std::vector<Tensor *> &outputs) override;
+    virtual ErrorCode onExecute(const std::vector<Tensor *> &inputs, const std::vector<Tensor *> &outputs) override;
+
+    typedef void (*POSTFUNCTION)(float *dst, const float *bias, size_t planeNumber, size_t biasNumber);
+    static POSTFUNCTION getPostFunction(const Convolution3DCommon *common);
+    static std::vector<int> computePads(const Convolution3DCommon *common, const Tensor *input, const Tensor *output);
+
+private:
+    const Convolution3DCommon *mCommon;
+    std::vector<int> mKernels;
+    std::vector<int> mStrides;
+    std::vector<int> mDilates;
+    std::vector<int> mPads;
+    std::shared_ptr<Tensor> mWeight;
+    std::shared_ptr<Tensor> mBias;
+    std::shared_ptr<Tensor> mTempBuffer;
+    std::shared_ptr<Tensor> mTempBufferTranspose;
+    std::shared_ptr<Tensor> mCache;
+    std::pair<int, std::function<void(int)>> mFunction;
+    bool mValid = true;
+};
+
+} // namespace MNN
+
+#endif /* CPUConvolution3D_hpp */
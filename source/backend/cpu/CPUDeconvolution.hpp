@@ -66,5 +66,21 @@ private:
     std::vector<Tensor *> mTempInputs;
     std::shared_ptr<CPUDeconvolutionOrigin> mOrigin;
 };
+
+// Weight (and bias) come from inputs, such as the input gradient of a convolution in training
+class CPUDeconvolutionMultiInput : public CPUDeconvolutionBasic {
+public:
+    CPUDeconvolutionMultiInput(const Tensor *input, const Op *convOp, Backend *b);
+    virtual ~CPUDeconvolutionMultiInput() = default;
+    virtual ErrorCode onExecute(const std::vector<Tensor *> &inputs, const std::vector<Tensor *> &outputs) override;
+    virtual ErrorCode onResize(const std::vector<Tensor *> &inputs, const std::vector<Tensor *> &outputs) override;
+
+private:
+    std::shared_ptr<Tensor> mWeight;
+    std::shared_ptr<Tensor> mCacheWeight;
+    std::shared_ptr<Tensor> mBias;
+    std::vector<Tensor *> mTempInputs;
+    std::shared_ptr<CPUDeconvolutionOrigin> mOrigin;
+};
 } // namespace MNN
 #endif /* CPUDeconvolution_hpp */
@@ -13,11 +13,13 @@
 
 #include "backend/cpu/CPUDetectionOutput.hpp"
 #include <math.h>
+#include <algorithm>
 #include <vector>
 //#define MNN_OPEN_TIME_TRACE
 #include <MNN/AutoTime.hpp>
 #include "backend/cpu/CPUBackend.hpp"
 #include "backend/cpu/compute/CommonOptFunction.h"
+#include "core/Concurrency.h"
 #include "core/TensorUtils.hpp"
 
 namespace MNN {
@@ -194,38 +196,49 @@ ErrorCode CPUDetectionOutput::onExecute(const std::vector<Tensor *> &inputs, con
         decodeBoxs(priorboxPtr, locationPtr);
     }
 
-    // sort and nms for each class
+    // sort and nms for each class, classes are independent
     std::vector<score_box_t> allClassBoxes;
     auto compareFunction = [](const score_box_t &a, const score_box_t &b) { return box_score(a) > box_score(b); };
     {
         AUTOTIME;
-        for (int i = 1; i < mClassCount; i++) { // start from 1 to ignore background class
+        std::vector<std::vector<score_box_t>> pickedBoxes(mClassCount);
+        int threadNumber = static_cast<CPUBackend *>(backend())->threadNumber();
+        threadNumber     = std::max(1, std::min(threadNumber, mClassCount - 1));
+        MNN_CONCURRENCY_BEGIN(tId, threadNumber) {
             std::vector<score_box_t> classBoxes;
             classBoxes.reserve(priorCount);
-            // filter by confidenceThreshold
-            for (int j = 0; j < priorCount; j++) {
-                float score = confidencePtr[j * mClassCount + i];
-                if (refineDet && (armconfidencePtr[j * 2 + 1] < mObjectnessScoreThreshold)) {
-                    score = 0.0;
-                }
-                if (score > mConfidenceThreshold) {
-                    const float *box = boxes.get() + 4 * j;
-                    classBoxes.push_back(box_rect(box[0], box[1], box[2], box[3], i, score));
+            std::vector<int> picked;
+            for (int i = 1 + (int)tId; i < mClassCount; i += threadNumber) { // start from 1 to ignore background class
+                classBoxes.clear();
+                // filter by confidenceThreshold
+                for (int j = 0; j < priorCount; j++) {
+                    float score = confidencePtr[j * mClassCount + i];
+                    if (refineDet && (armconfidencePtr[j * 2 + 1] < mObjectnessScoreThreshold)) {
+                        score = 0.0;
+                    }
+                    if (score > mConfidenceThreshold) {
+                        const float *box = boxes.get() + 4 * j;
+                        classBoxes.push_back(box_rect(box[0], box[1], box[2], box[3], i, score));
+                    }
                 }
-            }
 
-            // sort inplace
-            std::sort(classBoxes.begin(), classBoxes.end(), compareFunction);
+                // sort inplace
+                std::sort(classBoxes.begin(), classBoxes.end(), compareFunction);
 
-            // apply nms
-            std::vector<int> picked;
-            pickBoxes(classBoxes, picked, mNMSThreshold, mKeepTopK);
+                // apply nms
+                picked.clear();
+                pickBoxes(classBoxes, picked, mNMSThreshold, mKeepTopK);
 
-            // select
-            for (auto index : picked) {
-                allClassBoxes.push_back(classBoxes[index]);
+                // select
+                for (auto index : picked) {
+                    pickedBoxes[i].push_back(classBoxes[index]);
+                }
             }
         }
+        MNN_CONCURRENCY_END();
+        for (int i = 1; i < mClassCount; i++) {
+            allClassBoxes.insert(allClassBoxes.end(), pickedBoxes[i].begin(), pickedBoxes[i].end());
+        }
     }
 
     // set width
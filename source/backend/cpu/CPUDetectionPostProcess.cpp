@@ -6,11 +6,13 @@
 //  Copyright © 2018, Alibaba Group Holding Limited
 
 #include <math.h>
+#include <algorithm>
 #include <numeric>
 
 #include "backend/cpu/CPUBackend.hpp"
 #include "backend/cpu/CPUDetectionPostProcess.hpp"
 #include "backend/cpu/CPUNonMaxSuppressionV2.hpp"
+#include "core/Concurrency.h"
 
 namespace MNN {
 
@@ -100,13 +102,63 @@ static void _NonMaxSuppressionMultiClassFastImpl(const DetectionPostProcessParam
     *numDetectionsPtr = outputBoxIndex;
 }
 
+ErrorCode CPUDetectionPostProcess::_regularNonMaxSuppression(const Tensor* classPredictions,
+                                                             const std::vector<Tensor*>& outputs) {
+    const auto decodedBoxes          = mDecodedBoxes.get();
+    const int numBoxes               = decodedBoxes->length(0);
+    const int numClasses             = mParam.numClasses;
+    const int numClassWithBackground = classPredictions->length(2);
+    const int labelOffset            = numClassWithBackground - numClasses;
+    const int maxDetections          = mParam.maxDetections;
+    const auto scoresStartPtr        = classPredictions->host<float>() + labelOffset;
+    const auto boxesPtr              = decodedBoxes->host<float>();
+
+    // NMS of every class is independent
+    std::vector<std::vector<int>> selected(numClasses);
+    int threadNumber = static_cast<CPUBackend*>(backend())->threadNumber();
+    threadNumber     = std::max(1, std::min(threadNumber, numClasses));
+    MNN_CONCURRENCY_BEGIN(tId, threadNumber) {
+        for (int c = (int)tId; c < numClasses; c += threadNumber) {
+            NonMaxSuppressionStridedImpl(boxesPtr, scoresStartPtr + c, numClassWithBackground, numBoxes,
+                                         mParam.detectionsPerClass, mParam.iouThreshold, mParam.nmsScoreThreshold,
+                                         &selected[c]);
+        }
+    }
+    MNN_CONCURRENCY_END();
+
+    // Keep the top maxDetections of all classes
+    struct Detection {
+        int boxIndex;
+        int classIndex;
+        float score;
+    };
+    std::vector<Detection> detections;
+    for (int c = 0; c < numClasses; ++c) {
+        for (auto boxIndex : selected[c]) {
+            detections.emplace_back(
+                Detection({boxIndex, c, scoresStartPtr[boxIndex * numClassWithBackground + c]}));
+        }
+    }
+    const int outputNum = std::min(maxDetections, (int)detections.size());
+    std::partial_sort(detections.begin(), detections.begin() + outputNum, detections.end(),
+                      [](const Detection& a, const Detection& b) { return a.score > b.score; });
+
+    const auto decodedBoxesPtr = reinterpret_cast<const BoxCornerEncoding*>(boxesPtr);
+    auto detectionBoxesPtr     = reinterpret_cast<BoxCornerEncoding*>(outputs[0]->host<float>());
+    auto detectionClassesPtr   = outputs[1]->host<float>();
+    auto detectionScoresPtr    = outputs[2]->host<float>();
+    for (int i = 0; i < outputNum; ++i) {
+        detectionBoxesPtr[i]   = decodedBoxesPtr[detections[i].boxIndex];
+        detectionClassesPtr[i] = detections[i].classIndex;
+        detectionScoresPtr[i]  = detections[i].score;
+    }
+    *outputs[3]->host<float>() = outputNum;
+    return NO_ERROR;
+}
+
 CPUDetectionPostProcess::CPUDetectionPostProcess(Backend* bn, const MNN::Op* op) : Execution(bn) {
     auto param = op->main_as_DetectionPostProcessParam();
     param->UnPackTo(&mParam);
-    if (mParam.useRegularNMS) {
-        MNN_ERROR("TODO, use regular NMS to process decoded boxes!");
-        return;
-    }
 }
 
 ErrorCode CPUDetectionPostProcess::onResize(const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs) {
@@ -132,7 +184,7 @@ ErrorCode CPUDetectionPostProcess::onExecute(const std::vector<Tensor*>& inputs,
     _decodeBoxes(inputs[0], inputs[2], scaleValues, mDecodedBoxes.get());
 
     if (mParam.useRegularNMS) {
-        return NOT_SUPPORT;
+        return _regularNonMaxSuppression(inputs[1], outputs);
     } else {
         // perform NMS on max scores
         _NonMaxSuppressionMultiClassFastImpl(mParam, mDecodedBoxes.get(), inputs[1], outputs[0], outputs[1], outputs[2],
@@ -42,6 +42,9 @@ public:
     virtual ErrorCode onExecute(const std::vector<Tensor *> &inputs, const std::vector<Tensor *> &outputs) override;
 
 private:
+    // Multi-class NMS: NMS on every class, then keep the top maxDetections of all classes
+    ErrorCode _regularNonMaxSuppression(const Tensor *classPredictions, const std::vector<Tensor *> &outputs);
+
     DetectionPostProcessParamT mParam;
 
     std::shared_ptr<Tensor> mDecodedBoxes;
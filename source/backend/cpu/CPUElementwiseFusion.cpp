@@ -0,0 +1,248 @@
+//
+//  CPUElementwiseFusion.cpp
+//  MNN
+//
+//  Created by MNN on 2020/11/13.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#include "backend/cpu/CPUElementwiseFusion.hpp"
+#include <math.h>
+#include <algorithm>
+#include <string.h>
+#include "backend/cpu/CPUBackend.hpp"
+#include "backend/cpu/compute/CommonOptFunction.h"
+#include "core/Concurrency.h"
+#include "core/Macro.h"
+
+// Number of floats of a tile, all stage results of a tile should stay in L1
+#define FUSION_TILE 512
+
+namespace MNN {
+
+template <typename Func>
+static void _binary(float* dst, const float* src0, const float* src1, bool scalar0, bool scalar1, int count, Func f) {
+    if (scalar0) {
+        const float s = src0[0];
+        for (int i = 0; i < count; ++i) {
+            dst[i] = f(s, src1[i]);
+        }
+    } else if (scalar1) {
+        const float s = src1[0];
+        for (int i = 0; i < count; ++i) {
+            dst[i] = f(src0[i], s);
+        }
+    } else {
+        for (int i = 0; i < count; ++i) {
+            dst[i] = f(src0[i], src1[i]);
+        }
+    }
+}
+
+template <typename Func>
+static void _unary(float* dst, const float* src, bool scalar, int count, Func f) {
+    if (scalar) {
+        const float v = f(src[0]);
+        for (int i = 0; i < count; ++i) {
+            dst[i] = v;
+        }
+        return;
+    }
+    for (int i = 0; i < count; ++i) {
+        dst[i] = f(src[i]);
+    }
+}
+
+CPUElementwiseFusion::CPUElementwiseFusion(Backend* backend, std::vector<Stage>&& stages,
+                                           std::vector<int>&& outputStages)
+    : Execution(backend) {
+    mStages       = std::move(stages);
+    mOutputStages = std::move(outputStages);
+}
+
+ErrorCode CPUElementwiseFusion::onResize(const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs) {
+    auto size     = outputs[0]->elementSize();
+    mThreadNumber = std::max(1, std::min(static_cast<CPUBackend*>(backend())->threadNumber(), UP_DIV(size, FUSION_TILE)));
+    mCache.reset(Tensor::createDevice<float>({mThreadNumber, (int)mStages.size(), FUSION_TILE}));
+    auto res = backend()->onAcquireBuffer(mCache.get(), Backend::DYNAMIC);
+    if (!res) {
+        return OUT_OF_MEMORY;
+    }
+    backend()->onReleaseBuffer(mCache.get(), Backend::DYNAMIC);
+    return NO_ERROR;
+}
+
+void CPUElementwiseFusion::_computeStage(const Stage& stage, float* dst, const float* src0, const float* src1,
+                                         bool scalar0, bool scalar1, int count) const {
+    switch (stage.type) {
+        case OpType_UnaryOp:
+            switch (stage.operation) {
+                case UnaryOpOperation_ABS:
+                    _unary(dst, src0, scalar0, count, [](float x) { return fabsf(x); });
+                    break;
+                case UnaryOpOperation_NEG:
+                    _unary(dst, src0, scalar0, count, [](float x) { return -x; });
+                    break;
+                case UnaryOpOperation_SQUARE:
+                    _unary(dst, src0, scalar0, count, [](float x) { return x * x; });
+                    break;
+                case UnaryOpOperation_SQRT:
+                    _unary(dst, src0, scalar0, count, [](float x) { return sqrtf(x); });
+                    break;
+                case UnaryOpOperation_RSQRT:
+                    _unary(dst, src0, scalar0, count, [](float x) { return 1.0f / sqrtf(x); });
+                    break;
+                case UnaryOpOperation_LOG:
+                    _unary(dst, src0, scalar0, count, [](float x) { return logf(x); });
+                    break;
+                case UnaryOpOperation_RECIPROCAL:
+                    _unary(dst, src0, scalar0, count, [](float x) { return 1.0f / x; });
+                    break;
+                case UnaryOpOperation_EXP:
+                    // MNNExp computes exp(-x)
+                    _unary(dst, src0, scalar0, count, [](float x) { return -x; });
+                    MNNExp(dst, dst, count);
+                    break;
+                case UnaryOpOperation_SIGMOID:
+                    _unary(dst, src0, scalar0, count, [](float x) { return x; });
+                    MNNSigmoid(dst, dst, count);
+                    break;
+                case UnaryOpOperation_TANH:
+                    _unary(dst, src0, scalar0, count, [](float x) { return x; });
+                    MNNTanh(dst, dst, count);
+                    break;
+                default:
+                    MNN_ASSERT(false);
+                    break;
+            }
+            break;
+        case OpType_BinaryOp:
+            switch (stage.operation) {
+                case BinaryOpOperation_ADD:
+                    _binary(dst, src0, src1, scalar0, scalar1, count, [](float x, float y) { return x + y; });
+                    break;
+                case BinaryOpOperation_SUB:
+                    _binary(dst, src0, src1, scalar0, scalar1, count, [](float x, float y) { return x - y; });
+                    break;
+                case BinaryOpOperation_MUL:
+                    _binary(dst, src0, src1, scalar0, scalar1, count, [](float x, float y) { return x * y; });
+                    break;
+                case BinaryOpOperation_REALDIV:
+                    _binary(dst, src0, src1, scalar0, scalar1, count, [](float x, float y) { return x / y; });
+                    break;
+                case BinaryOpOperation_MAXIMUM:
+                    _binary(dst, src0, src1, scalar0, scalar1, count,
+                            [](float x, float y) { return std::max(x, y); });
+                    break;
+                case BinaryOpOperation_MINIMUM:
+                    _binary(dst, src0, src1, scalar0, scalar1, count,
+                            [](float x, float y) { return std::min(x, y); });
+                    break;
+                default:
+                    MNN_ASSERT(false);
+                    break;
+            }
+            break;
+        case OpType_ReLU: {
+            auto slope = stage.param[0];
+            _unary(dst, src0, scalar0, count, [slope](float x) { return x < 0.0f ? x * slope : x; });
+            break;
+        }
+        case OpType_ReLU6: {
+            auto minValue = stage.param[0];
+            auto maxValue = stage.param[1];
+            _unary(dst, src0, scalar0, count,
+                   [minValue, maxValue](float x) { return std::min(std::max(x, minValue), maxValue); });
+            break;
+        }
+        default:
+            MNN_ASSERT(false);
+            break;
+    }
+}
+
+ErrorCode CPUElementwiseFusion::onExecute(const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs) {
+    const int size      = outputs[0]->elementSize();
+    const int tileCount = UP_DIV(size, FUSION_TILE);
+    const int stageSize = (int)mStages.size();
+    MNN_CONCURRENCY_BEGIN(tId, mThreadNumber) {
+        auto cache = mCache->host<float>() + tId * stageSize * FUSION_TILE;
+        for (int tile = (int)tId; tile < tileCount; tile += mThreadNumber) {
+            const int start = tile * FUSION_TILE;
+            const int count = std::min(FUSION_TILE, size - start);
+            auto operand    = [&](int index, bool& scalar) -> const float* {
+                if (index < 0) {
+                    scalar = false;
+                    return cache + (-index - 1) * FUSION_TILE;
+                }
+                auto input = inputs[index];
+                scalar     = input->elementSize() == 1;
+                return scalar ? input->host<float>() : input->host<float>() + start;
+            };
+            for (int s = 0; s < stageSize; ++s) {
+                auto& stage         = mStages[s];
+                bool scalar0        = false;
+                bool scalar1        = false;
+                const float* src0   = operand(stage.operand[0], scalar0);
+                const float* src1   = nullptr;
+                if (stage.type == OpType_BinaryOp) {
+                    src1 = operand(stage.operand[1], scalar1);
+                }
+                _computeStage(stage, cache + s * FUSION_TILE, src0, src1, scalar0, scalar1, count);
+            }
+            for (int i = 0; i < mOutputStages.size(); ++i) {
+                ::memcpy(outputs[i]->host<float>() + start, cache + mOutputStages[i] * FUSION_TILE,
+                         count * sizeof(float));
+            }
+        }
+    }
+    MNN_CONCURRENCY_END();
+    return NO_ERROR;
+}
+
+class CPUElementwiseFusionCreator : public CPUBackend::Creator {
+public:
+    virtual Execution* onCreate(const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs,
+                                const MNN::Op* op, Backend* backend) const override {
+        auto extra = op->main_as_Extra();
+        if (nullptr == extra || nullptr == extra->type() || extra->type()->str() != "ElementwiseFusion" ||
+            nullptr == extra->attr()) {
+            return nullptr;
+        }
+        std::vector<CPUElementwiseFusion::Stage> stages;
+        std::vector<int> outputStages;
+        for (int i = 0; i < extra->attr()->size(); ++i) {
+            auto attr = extra->attr()->GetAs<Attribute>(i);
+            if (nullptr == attr->key() || nullptr == attr->list() || nullptr == attr->list()->i()) {
+                return nullptr;
+            }
+            auto list = attr->list()->i();
+            if (attr->key()->str() == "outputs") {
+                for (int j = 0; j < list->size(); ++j) {
+                    outputStages.emplace_back(list->Get(j));
+                }
+                continue;
+            }
+            CPUElementwiseFusion::Stage stage;
+            ::memset(&stage, 0, sizeof(CPUElementwiseFusion::Stage));
+            stage.type      = attr->i();
+            stage.operation = list->Get(0);
+            for (int j = 1; j < list->size() && j <= 2; ++j) {
+                stage.operand[j - 1] = list->Get(j);
+            }
+            if (nullptr != attr->list()->f()) {
+                for (int j = 0; j < attr->list()->f()->size() && j < 2; ++j) {
+                    stage.param[j] = attr->list()->f()->Get(j);
+                }
+            }
+            stages.emplace_back(stage);
+        }
+        if (stages.empty() || outputStages.size() != outputs.size()) {
+            return nullptr;
+        }
+        return new CPUElementwiseFusion(backend, std::move(stages), std::move(outputStages));
+    }
+};
+
+REGISTER_CPU_OP_CREATOR(CPUElementwiseFusionCreator, OpType_Extra);
+} // namespace MNN
@@ -0,0 +1,43 @@
+//
+//  CPUElementwiseFusion.hpp
+//  MNN
+//
+//  Created by MNN on 2020/11/13.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#ifndef CPUElementwiseFusion_hpp
+#define CPUElementwiseFusion_hpp
+
+#include "core/Execution.hpp"
+
+namespace MNN {
+/**
+ Run a chain of elementwise ops made by GeometryComputerUtils::fuseElementwise tile by tile,
+ the intermediate results stay in a small per-thread buffer.
+ */
+class CPUElementwiseFusion : public Execution {
+public:
+    struct Stage {
+        int type;
+        int operation;
+        // >= 0: index of inputs, < 0: result of stage -(v + 1)
+        int operand[2];
+        float param[2];
+    };
+    CPUElementwiseFusion(Backend* backend, std::vector<Stage>&& stages, std::vector<int>&& outputStages);
+    virtual ~CPUElementwiseFusion() = default;
+    virtual ErrorCode onResize(const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs) override;
+    virtual ErrorCode onExecute(const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs) override;
+
+private:
+    void _computeStage(const Stage& stage, float* dst, const float* src0, const float* src1, bool scalar0,
+                       bool scalar1, int count) const;
+    std::vector<Stage> mStages;
+    std::vector<int> mOutputStages;
+    std::unique_ptr<Tensor> mCache;
+    int mThreadNumber = 1;
+};
+} // namespace MNN
+
+#endif /* CPUElementwiseFusion_hpp */
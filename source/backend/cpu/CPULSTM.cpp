@@ -0,0 +1,230 @@
+//
+//  CPULSTM.cpp
+//  MNN
+//
+//  Created by MNN on 2020/11/09.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#include "backend/cpu/CPULSTM.hpp"
+#include <algorithm>
+#include "backend/cpu/CPUBackend.hpp"
+#include "backend/cpu/CPUMatMul.hpp"
+#include "backend/cpu/compute/CommonOptFunction.h"
+#include "core/Concurrency.h"
+#include "core/Macro.h"
+#include "core/TensorUtils.hpp"
+#include "math/Vec.hpp"
+using Vec4 = MNN::Math::Vec<float, 4>;
+
+namespace MNN {
+
+CPULSTM::CPULSTM(Backend* backend) : Execution(backend) {
+    // Do nothing
+}
+
+CPULSTM::~CPULSTM() {
+    _releaseConstR();
+}
+
+void CPULSTM::_releaseConstR() {
+    if (mConstR && nullptr != mPackR) {
+        backend()->onReleaseBuffer(mPackR.get(), Backend::STATIC);
+    }
+    mConstR = false;
+    mPackR  = nullptr;
+}
+
+void CPULSTM::_packR(const float* source) {
+    // R: 4 * hiddenSize, hiddenSize -> hiddenSize (4 gate units per block), hiddenSize, 4
+    auto hidden = mHiddenSize;
+    auto dest   = mPackR->host<float>();
+    for (int d = 0; d < mDirection; ++d) {
+        auto src = source + d * 4 * hidden * hidden;
+        auto dst = dest + d * 4 * hidden * hidden;
+        for (int y = 0; y < 4 * hidden; ++y) {
+            auto yC = y / 4;
+            auto yR = y % 4;
+            for (int x = 0; x < hidden; ++x) {
+                dst[(yC * hidden + x) * 4 + yR] = src[y * hidden + x];
+            }
+        }
+    }
+}
+
+ErrorCode CPULSTM::onResize(const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs) {
+    MNN_ASSERT(inputs.size() >= 4);
+    auto X      = inputs[0];
+    auto W      = inputs[1];
+    auto R      = inputs[2];
+    auto B      = inputs[3];
+    auto Y      = outputs[0];
+    mSeqLength  = X->length(0);
+    mBatch      = X->length(1);
+    mInputSize  = X->length(2);
+    mDirection  = Y->length(1);
+    mHiddenSize = Y->length(3);
+    auto gateSize = 4 * mHiddenSize * mDirection;
+    _releaseConstR();
+    if (mSeqLength * mBatch == 0) {
+        return NO_ERROR;
+    }
+
+    // Pack R once, keep it if R is constant
+    mConstR = TensorUtils::getDescribe(R)->usage == Tensor::InsideDescribe::CONSTANT;
+    mPackR.reset(Tensor::createDevice<float>({mDirection, mHiddenSize, mHiddenSize, 4}));
+    auto res = backend()->onAcquireBuffer(mPackR.get(), mConstR ? Backend::STATIC : Backend::DYNAMIC);
+    if (!res) {
+        mConstR = false;
+        return OUT_OF_MEMORY;
+    }
+    if (mConstR) {
+        _packR(R->host<float>());
+    }
+    mGates.reset(Tensor::createDevice<float>({mSeqLength * mBatch, gateSize}));
+    int numberThread = static_cast<CPUBackend*>(backend())->threadNumber();
+    mCache.reset(Tensor::createDevice<float>({numberThread, 6 * mHiddenSize}));
+    res = backend()->onAcquireBuffer(mGates.get(), Backend::DYNAMIC);
+    res = res && backend()->onAcquireBuffer(mCache.get(), Backend::DYNAMIC);
+    if (!res) {
+        return OUT_OF_MEMORY;
+    }
+
+    // Gates = X * W^T + B for all timesteps and directions
+    mXWrap.reset(Tensor::createDevice<float>({mSeqLength * mBatch, mInputSize}));
+    mWWrap.reset(Tensor::createDevice<float>({gateSize, mInputSize}));
+    mBWrap.reset(Tensor::createDevice<float>({gateSize}));
+    mXWrap->buffer().host = X->host<uint8_t>();
+    mWWrap->buffer().host = W->host<uint8_t>();
+    mBWrap->buffer().host = B->host<uint8_t>();
+    mInputMatMul.reset(new CPUMatMul(backend(), false, true, true));
+    auto code = mInputMatMul->onResize({mXWrap.get(), mWWrap.get(), mBWrap.get()}, {mGates.get()});
+    if (NO_ERROR != code) {
+        return code;
+    }
+    backend()->onReleaseBuffer(mGates.get(), Backend::DYNAMIC);
+    backend()->onReleaseBuffer(mCache.get(), Backend::DYNAMIC);
+    if (!mConstR) {
+        backend()->onReleaseBuffer(mPackR.get(), Backend::DYNAMIC);
+    }
+    return NO_ERROR;
+}
+
+void CPULSTM::_runSequence(int direction, int batchIndex, float* cache, const std::vector<Tensor*>& inputs,
+                           const std::vector<Tensor*>& outputs) {
+    auto hidden     = mHiddenSize;
+    auto gateStride = 4 * hidden * mDirection;
+    auto gate       = cache;
+    auto cell       = cache + 4 * hidden;
+    auto cellTanh   = cache + 5 * hidden;
+    auto offset     = (direction * mBatch + batchIndex) * hidden;
+    const float* lastHidden = nullptr;
+    if (inputs.size() > 4 && nullptr != inputs[4]) {
+        lastHidden = inputs[4]->host<float>() + offset;
+    }
+    if (inputs.size() > 5 && nullptr != inputs[5]) {
+        ::memcpy(cell, inputs[5]->host<float>() + offset, hidden * sizeof(float));
+    } else {
+        ::memset(cell, 0, hidden * sizeof(float));
+    }
+    auto packR  = mPackR->host<float>() + direction * 4 * hidden * hidden;
+    auto output = outputs[0]->host<float>();
+    auto hiddenC4 = hidden / 4;
+    for (int step = 0; step < mSeqLength; ++step) {
+        int pos = step;
+        if (direction > 0) {
+            pos = mSeqLength - step - 1;
+        }
+        ::memcpy(gate, mGates->host<float>() + (pos * mBatch + batchIndex) * gateStride + direction * 4 * hidden,
+                 4 * hidden * sizeof(float));
+        if (nullptr != lastHidden) {
+            // Gate += R * H, each block computes 4 gate units
+            for (int y = 0; y < hidden; ++y) {
+                auto weight = packR + y * hidden * 4;
+                auto sum    = Vec4::load(gate + 4 * y);
+                for (int x = 0; x < hidden; ++x) {
+                    sum = sum + Vec4::load(weight + 4 * x) * lastHidden[x];
+                }
+                Vec4::save(gate + 4 * y, sum);
+            }
+        }
+        // IOF: sigmoid, C: tanh
+        MNNSigmoid(gate, gate, 3 * hidden);
+        MNNTanh(gate + 3 * hidden, gate + 3 * hidden, hidden);
+        auto I = gate;
+        auto O = gate + hidden;
+        auto F = gate + 2 * hidden;
+        auto C = gate + 3 * hidden;
+        // Cell = F * Cell + I * C
+        for (int x = 0; x < hiddenC4; ++x) {
+            auto c = Vec4::load(F + 4 * x) * Vec4::load(cell + 4 * x) + Vec4::load(I + 4 * x) * Vec4::load(C + 4 * x);
+            Vec4::save(cell + 4 * x, c);
+        }
+        for (int x = hiddenC4 * 4; x < hidden; ++x) {
+            cell[x] = F[x] * cell[x] + I[x] * C[x];
+        }
+        // H = O * tanh(Cell)
+        MNNTanh(cellTanh, cell, hidden);
+        auto dst = output + (pos * mDirection + direction) * mBatch * hidden + batchIndex * hidden;
+        for (int x = 0; x < hiddenC4; ++x) {
+            Vec4::save(dst + 4 * x, Vec4::load(O + 4 * x) * Vec4::load(cellTanh + 4 * x));
+        }
+        for (int x = hiddenC4 * 4; x < hidden; ++x) {
+            dst[x] = O[x] * cellTanh[x];
+        }
+        lastHidden = dst;
+    }
+    if (outputs.size() > 1) {
+        auto dst = outputs[1]->host<float>() + offset;
+        if (nullptr != lastHidden) {
+            ::memcpy(dst, lastHidden, hidden * sizeof(float));
+        } else {
+            ::memset(dst, 0, hidden * sizeof(float));
+        }
+    }
+    if (outputs.size() > 2) {
+        ::memcpy(outputs[2]->host<float>() + offset, cell, hidden * sizeof(float));
+    }
+}
+
+ErrorCode CPULSTM::onExecute(const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs) {
+    if (mSeqLength * mBatch == 0) {
+        return NO_ERROR;
+    }
+    if (!mConstR) {
+        _packR(inputs[2]->host<float>());
+    }
+    auto code = mInputMatMul->onExecute({mXWrap.get(), mWWrap.get(), mBWrap.get()}, {mGates.get()});
+    if (NO_ERROR != code) {
+        return code;
+    }
+    // Directions and batches are independent
+    int numberThread = static_cast<CPUBackend*>(backend())->threadNumber();
+    int taskNumber   = mDirection * mBatch;
+    int threadNumber = std::min(numberThread, taskNumber);
+    auto cacheStride = mCache->stride(0);
+    MNN_CONCURRENCY_BEGIN(tId, threadNumber) {
+        auto cache = mCache->host<float>() + tId * cacheStride;
+        for (int index = (int)tId; index < taskNumber; index += threadNumber) {
+            _runSequence(index / mBatch, index % mBatch, cache, inputs, outputs);
+        }
+    }
+    MNN_CONCURRENCY_END();
+    return NO_ERROR;
+}
+
+class CPULSTMCreator : public CPUBackend::Creator {
+public:
+    virtual Execution* onCreate(const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs,
+                                const MNN::Op* op, Backend* backend) const override {
+        if (inputs.size() < 4) {
+            // Old caffe's LSTM is converted to onnx's format in geometry
+            return nullptr;
+        }
+        return new CPULSTM(backend);
+    }
+};
+
+REGISTER_CPU_OP_CREATOR(CPULSTMCreator, OpType_LSTM);
+
+} // namespace MNN
@@ -0,0 +1,59 @@
+//
+//  CPULSTM.hpp
+//  MNN
+//
+//  Created by MNN on 2020/11/09.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#ifndef CPULSTM_hpp
+#define CPULSTM_hpp
+
+#include <memory>
+#include "core/Execution.hpp"
+
+namespace MNN {
+
+/*
+ Onnx's LSTM, gate order is IOFC
+ X: [seqLength, batch, inputSize], W: [numDirections, 4 * hiddenSize, inputSize]
+ R: [numDirections, 4 * hiddenSize, hiddenSize], B: [numDirections, 4 * hiddenSize]
+ h0 / c0 (optional): [numDirections, batch, hiddenSize]
+ Y: [seqLength, numDirections, batch, hiddenSize], Y_h / Y_c (optional): [numDirections, batch, hiddenSize]
+
+ The input projection of all timesteps and directions is computed by one matmul,
+ then every (direction, batch) runs its recurrence on one thread with R packed as [hiddenSize, 4 * hiddenSize].
+ */
+class CPULSTM : public Execution {
+public:
+    CPULSTM(Backend *backend);
+    virtual ~CPULSTM();
+    virtual ErrorCode onResize(const std::vector<Tensor *> &inputs, const std::vector<Tensor *> &outputs) override;
+    virtual ErrorCode onExecute(const std::vector<Tensor *> &inputs, const std::vector<Tensor *> &outputs) override;
+
+private:
+    void _packR(const float* source);
+    void _releaseConstR();
+    void _runSequence(int direction, int batchIndex, float* cache, const std::vector<Tensor *> &inputs,
+                      const std::vector<Tensor *> &outputs);
+    int mSeqLength  = 0;
+    int mBatch      = 0;
+    int mInputSize  = 0;
+    int mHiddenSize = 0;
+    int mDirection  = 0;
+    // seqLength * batch, numDirections * 4 * hiddenSize
+    std::shared_ptr<Tensor> mGates;
+    std::shared_ptr<Execution> mInputMatMul;
+    std::shared_ptr<Tensor> mXWrap;
+    std::shared_ptr<Tensor> mWWrap;
+    std::shared_ptr<Tensor> mBWrap;
+    // numDirections, hiddenSize, 4 * hiddenSize
+    std::shared_ptr<Tensor> mPackR;
+    bool mConstR = false;
+    // Per-thread gates, cell and tanh(cell)
+    std::shared_ptr<Tensor> mCache;
+};
+
+} // namespace MNN
+
+#endif /* CPULSTM_hpp */
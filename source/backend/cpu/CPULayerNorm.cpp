@@ -6,11 +6,13 @@
 //  Copyright © 2018, Alibaba Group Holding Limited
 //
 
+#include <algorithm>
 #include <cmath>
 
 #include "core/Execution.hpp"
 #include "core/Concurrency.h"
 #include "backend/cpu/CPUBackend.hpp"
+#include "backend/cpu/compute/CommonOptFunction.h"
 #include "MNN_generated.h"
 
 
@@ -77,25 +79,15 @@ ErrorCode CPULayerNorm::onExecute(const std::vector<Tensor*> &inputs,
 
     const float* input = inputs.at(0)->host<float>();
     float* output = outputs.at(0)->host<float>();
-    for (int i = 0; i < outter_size_; ++i) {
-        const float* inner_input = input + i * inner_size_;
-        float* inner_output = output + i * inner_size_;
-        float sum = 0.f;
-        for (int j = 0; j < inner_size_; ++j) {
-            sum += inner_input[j];
-        }
-        float mean = sum / inner_size_;
-        float square_sum = 0.f;
-        for (int j = 0; j < inner_size_; ++j) {
-            square_sum += (inner_input[j] - mean) * (inner_input[j] - mean);
-        }
-        float variable = square_sum / inner_size_;
-        variable = 1.f / std::sqrt(variable + epsilon_);
-
-        for (int j = 0; j < inner_size_; ++j) {
-            inner_output[j] = (inner_input[j] - mean) * variable * gamma[j] + beta[j];
+    // Every row is normalized by a single-pass Welford kernel, rows are split among threads
+    int threadNumber = static_cast<CPUBackend*>(backend())->threadNumber();
+    threadNumber = std::max(1, std::min(threadNumber, outter_size_));
+    MNN_CONCURRENCY_BEGIN(tId, threadNumber) {
+        for (int i = (int)tId; i < outter_size_; i += threadNumber) {
+            MNNNorm(output + i * inner_size_, input + i * inner_size_, gamma, beta, epsilon_, inner_size_);
         }
     }
+    MNN_CONCURRENCY_END();
     return NO_ERROR;
 }
 
@@ -14,9 +14,11 @@
 
 #include "backend/cpu/CPUNonMaxSuppressionV2.hpp"
 #include <math.h>
-#include <queue>
+#include <algorithm>
+#include <limits>
 #include "backend/cpu/CPUBackend.hpp"
 #include "core/Macro.h"
+#include "math/Vec.hpp"
 
 namespace MNN {
 
@@ -24,86 +26,119 @@ CPUNonMaxSuppressionV2::CPUNonMaxSuppressionV2(Backend* backend, const Op* op) :
     // nothing to do
 }
 
-// Return intersection-over-union overlap between boxes i and j
-static inline float IOU(const float* boxes, int i, int j) {
-    const float yMinI = std::min<float>(boxes[i * 4 + 0], boxes[i * 4 + 2]);
-    const float xMinI = std::min<float>(boxes[i * 4 + 1], boxes[i * 4 + 3]);
-    const float yMaxI = std::max<float>(boxes[i * 4 + 0], boxes[i * 4 + 2]);
-    const float xMaxI = std::max<float>(boxes[i * 4 + 1], boxes[i * 4 + 3]);
-    const float yMinJ = std::min<float>(boxes[j * 4 + 0], boxes[j * 4 + 2]);
-    const float xMinJ = std::min<float>(boxes[j * 4 + 1], boxes[j * 4 + 3]);
-    const float yMaxJ = std::max<float>(boxes[j * 4 + 0], boxes[j * 4 + 2]);
-    const float xMaxJ = std::max<float>(boxes[j * 4 + 1], boxes[j * 4 + 3]);
-    const float areaI = (yMaxI - yMinI) * (xMaxI - xMinI);
-    const float areaJ = (yMaxJ - yMinJ) * (xMaxJ - xMinJ);
-    if (areaI <= 0 || areaJ <= 0)
-        return 0.0;
-    const float intersectionYMin = std::max<float>(yMinI, yMinJ);
-    const float intersectionXMin = std::max<float>(xMinI, xMinJ);
-    const float intersectionYMax = std::min<float>(yMaxI, yMaxJ);
-    const float intersectionXMax = std::min<float>(xMaxI, xMaxJ);
-    const float intersectionArea = std::max<float>(intersectionYMax - intersectionYMin, 0.0) *
-                                   std::max<float>(intersectionXMax - intersectionXMin, 0.0);
-    return intersectionArea / (areaI + areaJ - intersectionArea);
-}
-
-void NonMaxSuppressionSingleClasssImpl(const Tensor* decodedBoxes, const float* scores, int maxDetections,
-                                       float iouThreshold, float scoreThreshold, std::vector<int32_t>* selected) {
-    MNN_ASSERT(iouThreshold >= 0.0f && iouThreshold <= 1.0f);
-    MNN_ASSERT(decodedBoxes->dimensions() == 2);
-    const int numBoxes = decodedBoxes->length(0);
-    MNN_ASSERT(decodedBoxes->length(1) == 4)
+// Boxes selected so far, stored as SoA so that a candidate is compared with four of them at once
+namespace {
+struct SelectedBoxes {
+    std::vector<float> yMin;
+    std::vector<float> xMin;
+    std::vector<float> yMax;
+    std::vector<float> xMax;
+    std::vector<float> area;
+    int size = 0;
+
+    void reserve(int number) {
+        auto number4 = UP_DIV(number, 4) * 4;
+        yMin.resize(number4);
+        xMin.resize(number4);
+        yMax.resize(number4);
+        xMax.resize(number4);
+        area.resize(number4);
+        size = 0;
+    }
+    void push(const float* box) {
+        yMin[size] = std::min<float>(box[0], box[2]);
+        xMin[size] = std::min<float>(box[1], box[3]);
+        yMax[size] = std::max<float>(box[0], box[2]);
+        xMax[size] = std::max<float>(box[1], box[3]);
+        area[size] = (yMax[size] - yMin[size]) * (xMax[size] - xMin[size]);
+        size++;
+    }
+    // Return true if iou(box, selected[i]) > iouThreshold for any i
+    bool overlap(const float* box, float iouThreshold) const {
+        using Vec4       = Math::Vec<float, 4>;
+        const float yMinI = std::min<float>(box[0], box[2]);
+        const float xMinI = std::min<float>(box[1], box[3]);
+        const float yMaxI = std::max<float>(box[0], box[2]);
+        const float xMaxI = std::max<float>(box[1], box[3]);
+        const float areaI = (yMaxI - yMinI) * (xMaxI - xMinI);
+        if (areaI <= 0) {
+            return false;
+        }
+        // iou > t <=> inter > t * (areaI + areaJ - inter), boxes with areaJ <= 0 have inter == 0
+        Vec4 zero(0.0f);
+        Vec4 threshold(iouThreshold);
+        Vec4 scale(1.0f + iouThreshold);
+        Vec4 yMinV(yMinI), xMinV(xMinI), yMaxV(yMaxI), xMaxV(xMaxI), areaV(areaI);
+        const int sizeC4 = size / 4;
+        for (int i = 0; i < sizeC4; ++i) {
+            auto h     = Vec4::max(Vec4::min(yMaxV, Vec4::load(yMax.data() + 4 * i)) -
+                               Vec4::max(yMinV, Vec4::load(yMin.data() + 4 * i)), zero);
+            auto w     = Vec4::max(Vec4::min(xMaxV, Vec4::load(xMax.data() + 4 * i)) -
+                               Vec4::max(xMinV, Vec4::load(xMin.data() + 4 * i)), zero);
+            auto inter = h * w;
+            auto diff  = inter * scale - threshold * (areaV + Vec4::load(area.data() + 4 * i));
+            if ((inter[0] > 0 && diff[0] > 0) || (inter[1] > 0 && diff[1] > 0) || (inter[2] > 0 && diff[2] > 0) ||
+                (inter[3] > 0 && diff[3] > 0)) {
+                return true;
+            }
+        }
+        for (int i = sizeC4 * 4; i < size; ++i) {
+            float h     = std::max<float>(std::min<float>(yMaxI, yMax[i]) - std::max<float>(yMinI, yMin[i]), 0.0f);
+            float w     = std::max<float>(std::min<float>(xMaxI, xMax[i]) - std::max<float>(xMinI, xMin[i]), 0.0f);
+            float inter = h * w;
+            if (inter > 0 && inter * (1.0f + iouThreshold) > iouThreshold * (areaI + area[i])) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+} // namespace
 
+void NonMaxSuppressionStridedImpl(const float* boxes, const float* scores, int scoreStride, int numBoxes,
+                                  int maxDetections, float iouThreshold, float scoreThreshold,
+                                  std::vector<int32_t>* selected) {
     const int outputNum = std::min(maxDetections, numBoxes);
-    std::vector<float> scoresData(numBoxes);
-    std::copy_n(scores, numBoxes, scoresData.begin());
-
+    if (outputNum <= 0) {
+        return;
+    }
     struct Candidate {
         int boxIndex;
         float score;
     };
-
-    auto cmp = [](const Candidate bsI, const Candidate bsJ) { return bsI.score < bsJ.score; };
-
-    std::priority_queue<Candidate, std::deque<Candidate>, decltype(cmp)> candidatePriorityQueue(cmp);
-
-    for (int i = 0; i < scoresData.size(); ++i) {
-        if (scoresData[i] > scoreThreshold) {
-            candidatePriorityQueue.emplace(Candidate({i, scoresData[i]}));
+    std::vector<Candidate> candidates;
+    candidates.reserve(numBoxes);
+    for (int i = 0; i < numBoxes; ++i) {
+        auto score = scores[i * scoreStride];
+        if (score > scoreThreshold) {
+            candidates.emplace_back(Candidate({i, score}));
         }
     }
-
-    // std::vector<float> selectedScores;
-    Candidate nextCandidate;
-    float iou, originalScore;
-
-    const auto boxesPtr = decodedBoxes->host<float>();
-    while (selected->size() < outputNum && !candidatePriorityQueue.empty()) {
-        nextCandidate = candidatePriorityQueue.top();
-        originalScore = nextCandidate.score;
-        candidatePriorityQueue.pop();
-
-        // Overlapping boxes are likely to have similar scores,
-        // therefore we iterate through the previously selected boxes backwards
-        // in order to see if `next_candidate` should be suppressed.
-        bool shouldSelect = true;
-        for (int j = (int)selected->size() - 1; j >= 0; --j) {
-            iou = IOU(boxesPtr, nextCandidate.boxIndex, selected->at(j));
-            if (iou == 0.0) {
-                continue;
-            }
-            if (iou > iouThreshold) {
-                shouldSelect = false;
-            }
-        }
-
-        if (shouldSelect) {
-            selected->push_back(nextCandidate.boxIndex);
-            // selectedScores.push_back(nextCandidate.score);
+    // Sort once instead of popping from a priority queue
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [](const Candidate& a, const Candidate& b) { return a.score > b.score; });
+
+    SelectedBoxes selectedBoxes;
+    selectedBoxes.reserve(outputNum);
+    for (int i = 0; i < candidates.size() && selected->size() < outputNum; ++i) {
+        auto box = boxes + candidates[i].boxIndex * 4;
+        if (!selectedBoxes.overlap(box, iouThreshold)) {
+            selectedBoxes.push(box);
+            selected->push_back(candidates[i].boxIndex);
         }
     }
 }
 
+void NonMaxSuppressionSingleClasssImpl(const Tensor* decodedBoxes, const float* scores, int maxDetections,
+                                       float iouThreshold, float scoreThreshold, std::vector<int32_t>* selected) {
+    MNN_ASSERT(iouThreshold >= 0.0f && iouThreshold <= 1.0f);
+    MNN_ASSERT(decodedBoxes->dimensions() == 2);
+    const int numBoxes = decodedBoxes->length(0);
+    MNN_ASSERT(decodedBoxes->length(1) == 4)
+    NonMaxSuppressionStridedImpl(decodedBoxes->host<float>(), scores, 1, numBoxes, maxDetections, iouThreshold,
+                                 scoreThreshold, selected);
+}
+
 ErrorCode CPUNonMaxSuppressionV2::onExecute(const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs) {
     std::vector<int> selected;
     const int maxDetections    = inputs[2]->host<int32_t>()[0];
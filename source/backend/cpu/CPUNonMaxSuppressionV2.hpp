@@ -9,6 +9,7 @@
 #ifndef CPUNonMaxSuppressionV2_hpp
 #define CPUNonMaxSuppressionV2_hpp
 
+#include <vector>
 #include "core/Execution.hpp"
 
 namespace MNN {
@@ -24,6 +25,14 @@ namespace MNN {
  */
 void NonMaxSuppressionSingleClasssImpl(const Tensor* decodedBoxes, const float* scores, int maxDetections, float iouThreshold, float scoreThreshold, std::vector<int>* selected);
 
+/**
+ * @brief same as NonMaxSuppressionSingleClasssImpl, but the score of box i is scores[i * scoreStride],
+ * so that one class of a [num_boxes, num_classes] score matrix can be used directly
+ * @param boxes : float*, shape is [num_boxes, 4]
+ */
+void NonMaxSuppressionStridedImpl(const float* boxes, const float* scores, int scoreStride, int numBoxes,
+                                  int maxDetections, float iouThreshold, float scoreThreshold,
+                                  std::vector<int>* selected);
 
 class CPUNonMaxSuppressionV2 : public Execution {
 public:
@@ -72,6 +72,13 @@ extern void ___CPUPriorBoxCreator__OpType_PriorBox__();
 extern void ___CPUEltwiseInt8Creator__OpType_EltwiseInt8__();
 extern void ___CPUBatchMatMulCreator__OpType_BatchMatMul__();
 extern void ___CPULayerNormCreator__OpType_LayerNorm__();
+extern void ___CPUAttentionCreator__OpType_Attention__();
+extern void ___CPULSTMCreator__OpType_LSTM__();
+extern void ___CPUElementwiseFusionCreator__OpType_Extra__();
+extern void ___CPUConvolution3DCreator__OpType_Convolution3D__();
+extern void ___CPUConv2DBackPropFilterCreator__OpType_Conv2DBackPropFilter__();
+extern void ___CPUBatchNormTrainCreator__OpType_BatchNormTrain__();
+extern void ___CPUBatchNormGradCreator__OpType_BatchNormGrad__();
 
 void registerCPUOps() {
 ___CPUCropAndResizeCreator__OpType_CropAndResize__();
@@ -146,5 +153,12 @@ ___CPUPriorBoxCreator__OpType_PriorBox__();
 ___CPUEltwiseInt8Creator__OpType_EltwiseInt8__();
 ___CPUBatchMatMulCreator__OpType_BatchMatMul__();
 ___CPULayerNormCreator__OpType_LayerNorm__();
+___CPUAttentionCreator__OpType_Attention__();
+___CPULSTMCreator__OpType_LSTM__();
+___CPUElementwiseFusionCreator__OpType_Extra__();
+___CPUConvolution3DCreator__OpType_Convolution3D__();
+___CPUConv2DBackPropFilterCreator__OpType_Conv2DBackPropFilter__();
+___CPUBatchNormTrainCreator__OpType_BatchNormTrain__();
+___CPUBatchNormGradCreator__OpType_BatchNormGrad__();
 }
 }
@@ -7,61 +7,27 @@
 //
 
 #include "backend/cpu/CPURNNSequenceGRU.hpp"
-#include <math.h>
+#include <algorithm>
 #include "backend/cpu/CPUBackend.hpp"
-#include "backend/cpu/compute/ConvOpt.h"
-#include "math/Matrix.hpp"
+#include "backend/cpu/CPUMatMul.hpp"
+#include "backend/cpu/compute/CommonOptFunction.h"
+#include "core/Concurrency.h"
+#include "core/Macro.h"
+#include "math/Vec.hpp"
+using Vec4 = MNN::Math::Vec<float, 4>;
 
 namespace MNN {
 
-static inline float sigmoid(float x) {
-    return 1. / (1. + expf(-x));
-}
-
-// implement GRU cell function
-// Ref: tensorflow/python/ops/rnn_cell_impl.py
-static void runRNNStep(const float* input, const int inputLength, std::shared_ptr<Tensor>& hiddenState,
-                       const int numUnits, std::shared_ptr<Tensor>& gateWeight, std::shared_ptr<Tensor>& gateBias,
-                       std::shared_ptr<Tensor>& candidateWeight, std::shared_ptr<Tensor>& candidateBias,
-                       std::shared_ptr<Tensor>& inputAndState, std::shared_ptr<Tensor>& gate) {
-    // gate is (r_t, z_t)
-    auto inputAndStatePtr = inputAndState->host<float>();
-    auto hiddenStatePtr   = hiddenState->host<float>();
-    ::memcpy(inputAndStatePtr, input, inputLength * sizeof(float));
-    ::memcpy(inputAndStatePtr + inputLength, hiddenStatePtr, numUnits * sizeof(float));
-    Math::Matrix::multi(gate.get(), inputAndState.get(), gateWeight.get());
-    Math::Matrix::add(gate.get(), gate.get(), gateBias.get());
-    const int gateSize = gate->elementSize();
-    auto gatePtr       = gate->host<float>();
-    for (int i = 0; i < gateSize; ++i) {
-        gatePtr[i] = sigmoid(gatePtr[i]);
+// dst = dst + src * alpha
+static inline void _axpy(float* dst, const float* src, float alpha, int size) {
+    auto sizeC4 = size / 4;
+    auto a      = Vec4(alpha);
+    for (int i = 0; i < sizeC4; ++i) {
+        Vec4::save(dst + 4 * i, Vec4::load(dst + 4 * i) + Vec4::load(src + 4 * i) * a);
     }
-
-    {
-        // reset gate
-        auto resetGatePtr = inputAndStatePtr + inputLength;
-        int k             = 0;
-        auto numUnitC4    = numUnits / 4;
-        if (numUnitC4 > 0) {
-            MNNMatrixProd(resetGatePtr, gatePtr, hiddenStatePtr, numUnitC4, 0, 0, 0, 1);
-            k = numUnitC4 * 4;
-        }
-        for (; k < numUnits; ++k) {
-            resetGatePtr[k] = gatePtr[k] * hiddenStatePtr[k];
-        }
+    for (int i = sizeC4 * 4; i < size; ++i) {
+        dst[i] = dst[i] + src[i] * alpha;
     }
-
-    // use r_t to apply Matrix multi and add
-    gate->setLength(1, numUnits);
-    Math::Matrix::multi(gate.get(), inputAndState.get(), candidateWeight.get());
-    Math::Matrix::add(gate.get(), gate.get(), candidateBias.get());
-
-    for (int i = 0; i < numUnits; ++i) {
-        hiddenStatePtr[i] =
-            gatePtr[numUnits + i] * hiddenStatePtr[i] + (1.0 - gatePtr[numUnits + i]) * tanhf(gatePtr[i]);
-    }
-    // reset gate shape fot the next iteration
-    gate->setLength(1, 2 * numUnits);
 }
 
 CPURNNSequenceGRU::CPURNNSequenceGRU(const Op* op, Backend* backend) : MNN::Execution(backend) {
@@ -69,111 +35,165 @@ CPURNNSequenceGRU::CPURNNSequenceGRU(const Op* op, Backend* backend) : MNN::Exec
     mKeepAllOutputs     = rnnParam->keepAllOutputs();
     mIsBidirectionalRNN = rnnParam->isBidirectionalRNN();
     mNumUnits           = rnnParam->numUnits();
-
-    auto copyData = [=](std::shared_ptr<Tensor>& tensor, const Blob* src) {
-        std::vector<int> shape;
-        for (int i = 0; i < src->dims()->size(); ++i) {
-            shape.push_back(src->dims()->data()[i]);
+    mDirection          = mIsBidirectionalRNN ? 2 : 1;
+    mInputSize          = rnnParam->fwGateWeight()->dims()->data()[0] - mNumUnits;
+    MNN_ASSERT(rnnParam->fwCandidateBias()->float32s()->size() == mNumUnits);
+
+    // Gate weight: inputSize + numUnits, 2 * numUnits; Candidate weight: inputSize + numUnits, numUnits
+    // Split the rows by input / hidden state, and put gate and candidate together: (r_t, z_t, c_t)
+    auto numUnits = mNumUnits;
+    auto unit3    = 3 * numUnits;
+    mInputWeight.reset(Tensor::createDevice<float>({mInputSize, mDirection * unit3}));
+    mInputBias.reset(Tensor::createDevice<float>({mDirection * unit3}));
+    mRecurrentWeight.reset(Tensor::createDevice<float>({mDirection, numUnits, unit3}));
+    backend->onAcquireBuffer(mInputWeight.get(), Backend::STATIC);
+    backend->onAcquireBuffer(mInputBias.get(), Backend::STATIC);
+    backend->onAcquireBuffer(mRecurrentWeight.get(), Backend::STATIC);
+    auto copyWeight = [=](int direction, const Blob* gateWeight, const Blob* gateBias, const Blob* candidateWeight,
+                          const Blob* candidateBias) {
+        auto gate      = gateWeight->float32s()->data();
+        auto candidate = candidateWeight->float32s()->data();
+        auto inputDst  = mInputWeight->host<float>() + direction * unit3;
+        for (int y = 0; y < mInputSize; ++y) {
+            auto dst = inputDst + y * mDirection * unit3;
+            ::memcpy(dst, gate + y * 2 * numUnits, 2 * numUnits * sizeof(float));
+            ::memcpy(dst + 2 * numUnits, candidate + y * numUnits, numUnits * sizeof(float));
         }
-        tensor.reset(Tensor::createDevice<float>(shape));
-        backend->onAcquireBuffer(tensor.get(), Backend::STATIC);
-        ::memcpy(tensor->host<float>(), src->float32s()->data(), src->float32s()->size() * sizeof(float));
+        auto recurrentDst = mRecurrentWeight->host<float>() + direction * numUnits * unit3;
+        for (int y = 0; y < numUnits; ++y) {
+            auto dst = recurrentDst + y * unit3;
+            ::memcpy(dst, gate + (mInputSize + y) * 2 * numUnits, 2 * numUnits * sizeof(float));
+            ::memcpy(dst + 2 * numUnits, candidate + (mInputSize + y) * numUnits, numUnits * sizeof(float));
+        }
+        auto biasDst = mInputBias->host<float>() + direction * unit3;
+        ::memcpy(biasDst, gateBias->float32s()->data(), 2 * numUnits * sizeof(float));
+        ::memcpy(biasDst + 2 * numUnits, candidateBias->float32s()->data(), numUnits * sizeof(float));
     };
-    copyData(mFwGateWeight, rnnParam->fwGateWeight());
-    copyData(mFwGateBias, rnnParam->fwGateBias());
-    copyData(mFwCandidateWeight, rnnParam->fwCandidateWeight());
-    copyData(mFwCandidateBias, rnnParam->fwCandidateBias());
-    MNN_ASSERT(mFwCandidateBias->length(0) == mNumUnits);
+    copyWeight(0, rnnParam->fwGateWeight(), rnnParam->fwGateBias(), rnnParam->fwCandidateWeight(),
+               rnnParam->fwCandidateBias());
     if (mIsBidirectionalRNN) {
-        copyData(mBwGateWeight, rnnParam->bwGateWeight());
-        copyData(mBwGateBias, rnnParam->bwGateBias());
-        copyData(mBwCandidateWeight, rnnParam->bwCandidateWeight());
-        copyData(mBwCandidateBias, rnnParam->bwCandidateBias());
+        copyWeight(1, rnnParam->bwGateWeight(), rnnParam->bwGateBias(), rnnParam->bwCandidateWeight(),
+                   rnnParam->bwCandidateBias());
     }
 }
 
 CPURNNSequenceGRU::~CPURNNSequenceGRU() {
-    backend()->onReleaseBuffer(mFwGateWeight.get(), Backend::STATIC);
-    backend()->onReleaseBuffer(mFwGateBias.get(), Backend::STATIC);
-    backend()->onReleaseBuffer(mFwCandidateWeight.get(), Backend::STATIC);
-    backend()->onReleaseBuffer(mFwCandidateBias.get(), Backend::STATIC);
-    if (mIsBidirectionalRNN) {
-        backend()->onReleaseBuffer(mBwGateWeight.get(), Backend::STATIC);
-        backend()->onReleaseBuffer(mBwGateBias.get(), Backend::STATIC);
-        backend()->onReleaseBuffer(mBwCandidateWeight.get(), Backend::STATIC);
-        backend()->onReleaseBuffer(mBwCandidateBias.get(), Backend::STATIC);
-    }
+    backend()->onReleaseBuffer(mInputWeight.get(), Backend::STATIC);
+    backend()->onReleaseBuffer(mInputBias.get(), Backend::STATIC);
+    backend()->onReleaseBuffer(mRecurrentWeight.get(), Backend::STATIC);
 }
 
 ErrorCode CPURNNSequenceGRU::onResize(const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs) {
-    auto input                 = inputs[0];
-    const int inputLastDimSize = input->length(2);
-    mHiddenState.reset(Tensor::createDevice<float>(std::vector<int>{1, mNumUnits}));
-    mInputAndState.reset(Tensor::createDevice<float>(std::vector<int>{1, inputLastDimSize + mNumUnits}));
-    mGate.reset(Tensor::createDevice<float>(std::vector<int>{1, 2 * mNumUnits}));
-
-    backend()->onAcquireBuffer(mHiddenState.get(), Backend::DYNAMIC);
-    backend()->onAcquireBuffer(mInputAndState.get(), Backend::DYNAMIC);
-    backend()->onAcquireBuffer(mGate.get(), Backend::DYNAMIC);
-
-    backend()->onReleaseBuffer(mHiddenState.get(), Backend::DYNAMIC);
-    backend()->onReleaseBuffer(mInputAndState.get(), Backend::DYNAMIC);
-    backend()->onReleaseBuffer(mGate.get(), Backend::DYNAMIC);
-
+    auto input = inputs[0];
+    mBatch     = input->length(0);
+    mSeqLength = input->length(1);
+    MNN_ASSERT(mInputSize == input->length(2));
+    if (mBatch * mSeqLength == 0) {
+        return NO_ERROR;
+    }
+    int numberThread = static_cast<CPUBackend*>(backend())->threadNumber();
+    mGates.reset(Tensor::createDevice<float>({mBatch * mSeqLength, mDirection * 3 * mNumUnits}));
+    mCache.reset(Tensor::createDevice<float>({numberThread, 5 * mNumUnits}));
+    auto res = backend()->onAcquireBuffer(mGates.get(), Backend::DYNAMIC);
+    res      = res && backend()->onAcquireBuffer(mCache.get(), Backend::DYNAMIC);
+    if (!res) {
+        return OUT_OF_MEMORY;
+    }
+    // Input part of the gates for all timesteps and directions
+    mInputWrap.reset(Tensor::createDevice<float>({mBatch * mSeqLength, mInputSize}));
+    mInputWrap->buffer().host = input->host<uint8_t>();
+    mInputMatMul.reset(new CPUMatMul(backend(), false, false, true));
+    auto code = mInputMatMul->onResize({mInputWrap.get(), mInputWeight.get(), mInputBias.get()}, {mGates.get()});
+    if (NO_ERROR != code) {
+        return code;
+    }
+    backend()->onReleaseBuffer(mGates.get(), Backend::DYNAMIC);
+    backend()->onReleaseBuffer(mCache.get(), Backend::DYNAMIC);
     return NO_ERROR;
 }
 
-ErrorCode CPURNNSequenceGRU::onExecute(const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs) {
-    // firstly set the hidden state to zero
-    float* const hiddenStatePtr   = mHiddenState->host<float>();
-    const int hiddenStateDataSize = mHiddenState->size();
-    ::memset(hiddenStatePtr, 0, hiddenStateDataSize);
-
-    auto input                    = inputs[0];
-    auto output                   = outputs[0];
-    float* const inputPtr         = input->host<float>();
-    float* const outputPtr        = output->host<float>();
-    const int batchSize           = input->length(0);
-    const int batchStride         = input->stride(0);
-    const int inputSequenceLength = input->length(1);
-    const int inputCodeLength     = input->length(2);
-
-    for (int b = 0; b < batchSize; ++b) {
-        for (int i = 0; i < inputSequenceLength; ++i) {
-            const int inputOffset = b * batchStride + i * inputCodeLength;
-            runRNNStep(inputPtr + inputOffset, inputCodeLength, mHiddenState, mNumUnits, mFwGateWeight, mFwGateBias,
-                       mFwCandidateWeight, mFwCandidateBias, mInputAndState, mGate);
-            if (mKeepAllOutputs) {
-                ::memcpy(outputPtr + b * output->stride(0) + i * mNumUnits, hiddenStatePtr, hiddenStateDataSize);
+// implement GRU cell function
+// Ref: tensorflow/python/ops/rnn_cell_impl.py
+void CPURNNSequenceGRU::_runSequence(int direction, int batchIndex, float* cache, const std::vector<Tensor*>& outputs) {
+    auto numUnits    = mNumUnits;
+    auto gate        = cache;
+    auto resetHidden = cache + 3 * numUnits;
+    auto hidden      = cache + 4 * numUnits;
+    auto recurrent   = mRecurrentWeight->host<float>() + direction * numUnits * 3 * numUnits;
+    auto gateStride  = mDirection * 3 * numUnits;
+    auto output      = outputs[direction];
+    auto numUnitsC4  = numUnits / 4;
+    // the hidden state start from zero
+    ::memset(hidden, 0, numUnits * sizeof(float));
+    for (int step = 0; step < mSeqLength; ++step) {
+        int pos = step;
+        if (direction > 0) {
+            pos = mSeqLength - step - 1;
+        }
+        ::memcpy(gate, mGates->host<float>() + (batchIndex * mSeqLength + pos) * gateStride + direction * 3 * numUnits,
+                 3 * numUnits * sizeof(float));
+        // gate is (r_t, z_t)
+        if (step > 0) {
+            for (int x = 0; x < numUnits; ++x) {
+                _axpy(gate, recurrent + x * 3 * numUnits, hidden[x], 2 * numUnits);
             }
         }
+        MNNSigmoid(gate, gate, 2 * numUnits);
+        auto r = gate;
+        auto z = gate + numUnits;
+        auto c = gate + 2 * numUnits;
+        // use r_t to compute the candidate
+        if (step > 0) {
+            for (int x = 0; x < numUnitsC4; ++x) {
+                Vec4::save(resetHidden + 4 * x, Vec4::load(r + 4 * x) * Vec4::load(hidden + 4 * x));
+            }
+            for (int x = numUnitsC4 * 4; x < numUnits; ++x) {
+                resetHidden[x] = r[x] * hidden[x];
+            }
+            for (int x = 0; x < numUnits; ++x) {
+                _axpy(c, recurrent + x * 3 * numUnits + 2 * numUnits, resetHidden[x], numUnits);
+            }
+        }
+        MNNTanh(c, c, numUnits);
+        // h_t = z_t * h_t-1 + (1 - z_t) * c_t
+        for (int x = 0; x < numUnitsC4; ++x) {
+            auto cv = Vec4::load(c + 4 * x);
+            Vec4::save(hidden + 4 * x, cv + Vec4::load(z + 4 * x) * (Vec4::load(hidden + 4 * x) - cv));
+        }
+        for (int x = numUnitsC4 * 4; x < numUnits; ++x) {
+            hidden[x] = c[x] + z[x] * (hidden[x] - c[x]);
+        }
+        if (mKeepAllOutputs) {
+            // The backward outputs are stored in the order of computing
+            ::memcpy(output->host<float>() + batchIndex * output->stride(0) + step * numUnits, hidden,
+                     numUnits * sizeof(float));
+        }
     }
-
     if (!mKeepAllOutputs) {
-        ::memcpy(outputPtr, hiddenStatePtr, hiddenStateDataSize);
+        ::memcpy(output->host<float>() + batchIndex * numUnits, hidden, numUnits * sizeof(float));
     }
-    // backward rnn
-    if (mIsBidirectionalRNN) {
-        ::memset(hiddenStatePtr, 0, hiddenStateDataSize);
-        auto outputBw            = outputs[1];
-        float* const outputBwPtr = outputBw->host<float>();
-        for (int b = 0; b < batchSize; ++b) {
-            for (int i = inputSequenceLength - 1; i >= 0; i--) {
-                const int inputOffset = b * batchStride + i * inputCodeLength;
-                runRNNStep(inputPtr + inputOffset, inputCodeLength, mHiddenState, mNumUnits, mBwGateWeight, mBwGateBias,
-                           mBwCandidateWeight, mBwCandidateBias, mInputAndState, mGate);
-                if (mKeepAllOutputs) {
-                    ::memcpy(outputBwPtr + b * outputBw->stride(0) + (inputSequenceLength - 1 - i) * mNumUnits,
-                             hiddenStatePtr, hiddenStateDataSize);
-                }
-            }
-        }
+}
 
-        if (!mKeepAllOutputs) {
-            ::memcpy(outputBwPtr, hiddenStatePtr, hiddenStateDataSize);
+ErrorCode CPURNNSequenceGRU::onExecute(const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs) {
+    if (mBatch * mSeqLength == 0) {
+        return NO_ERROR;
+    }
+    auto code = mInputMatMul->onExecute({mInputWrap.get(), mInputWeight.get(), mInputBias.get()}, {mGates.get()});
+    if (NO_ERROR != code) {
+        return code;
+    }
+    // Directions and batches are independent
+    int numberThread = static_cast<CPUBackend*>(backend())->threadNumber();
+    int taskNumber   = mDirection * mBatch;
+    int threadNumber = std::min(numberThread, taskNumber);
+    auto cacheStride = mCache->stride(0);
+    MNN_CONCURRENCY_BEGIN(tId, threadNumber) {
+        auto cache = mCache->host<float>() + tId * cacheStride;
+        for (int index = (int)tId; index < taskNumber; index += threadNumber) {
+            _runSequence(index / mBatch, index % mBatch, cache, outputs);
         }
     }
-
+    MNN_CONCURRENCY_END();
     return NO_ERROR;
 }
 
@@ -13,6 +13,10 @@
 
 namespace MNN {
 
+/*
+ The input part of the gates is computed for all timesteps and directions by one matmul,
+ then every (direction, batch) runs its recurrence on one thread.
+ */
 class CPURNNSequenceGRU : public Execution {
 public:
     CPURNNSequenceGRU(const Op *op, Backend *backend);
@@ -21,23 +25,27 @@ public:
     virtual ErrorCode onResize(const std::vector<Tensor *> &inputs, const std::vector<Tensor *> &outputs) override;
 
 private:
+    void _runSequence(int direction, int batchIndex, float* cache, const std::vector<Tensor *> &outputs);
     bool mKeepAllOutputs;
     bool mIsBidirectionalRNN;
     int mNumUnits;
-
-    std::shared_ptr<Tensor> mHiddenState;
-    std::shared_ptr<Tensor> mInputAndState;
-    std::shared_ptr<Tensor> mGate;
-    // forward weight and bias
-    std::shared_ptr<Tensor> mFwGateWeight;
-    std::shared_ptr<Tensor> mFwGateBias;
-    std::shared_ptr<Tensor> mFwCandidateWeight;
-    std::shared_ptr<Tensor> mFwCandidateBias;
-    // backward weight and bias
-    std::shared_ptr<Tensor> mBwGateWeight;
-    std::shared_ptr<Tensor> mBwGateBias;
-    std::shared_ptr<Tensor> mBwCandidateWeight;
-    std::shared_ptr<Tensor> mBwCandidateBias;
+    int mDirection;
+    int mInputSize;
+    int mBatch     = 0;
+    int mSeqLength = 0;
+
+    // Input part of the gate and candidate weight for all directions: inputSize, direction * 3 * numUnits
+    std::shared_ptr<Tensor> mInputWeight;
+    std::shared_ptr<Tensor> mInputBias;
+    // Hidden state part of the gate and candidate weight: direction, numUnits, 3 * numUnits
+    std::shared_ptr<Tensor> mRecurrentWeight;
+
+    std::shared_ptr<Execution> mInputMatMul;
+    std::shared_ptr<Tensor> mInputWrap;
+    // batch * seqLength, direction * 3 * numUnits
+    std::shared_ptr<Tensor> mGates;
+    // Per-thread gate, reset state and hidden state
+    std::shared_ptr<Tensor> mCache;
 };
 
 } // namespace MNN
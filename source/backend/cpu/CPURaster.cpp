@@ -27,7 +27,13 @@ static void getBatchChannelArea(const Tensor* t, int& batch, int& channel, int&
         area = t->width() * t->height();
     } else {
         auto format = TensorUtils::getDescribe(t)->dimensionFormat;
-        if (format == MNN_DATA_FORMAT_NHWC) {
+        if (format == MNN_DATA_FORMAT_NC4HW4 && t->dimensions() > 1) {
+            // The channel of NC4HW4 is always packed, even if it is 1, such as N, C, D, H, W
+            channel = t->length(1);
+            for (int i = 2; i < t->dimensions(); i++) {
+                area *= t->length(i);
+            }
+        } else if (format == MNN_DATA_FORMAT_NHWC) {
             for (int i = t->dimensions() - 1; i > 0; i--) {
                 int len = t->length(i);
                 if (len > 1) {
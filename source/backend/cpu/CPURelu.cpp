@@ -13,11 +13,37 @@
 #include "core/Concurrency.h"
 #include "CPUBackend.hpp"
 #include <string.h>
+#include <algorithm>
 namespace MNN {
 ErrorCode CPURelu::onExecute(const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs) {
     auto& ib = inputs[0]->buffer();
     auto& ob = outputs[0]->buffer();
 
+    if (inputs[0]->getType() == halide_type_of<int8_t>()) {
+        // Quantized activations keep their scale through relu
+        const int8_t* src = (const int8_t*)ib.host;
+        int8_t* dst       = (int8_t*)ob.host;
+        int size          = inputs[0]->size();
+        int numberThread  = ((CPUBackend*)backend())->threadNumber();
+        // The arm kernels only handle multiples of 4 bytes, split by 16 bytes and compute the remain here
+        int sizeC16       = size / 16;
+        int remain        = sizeC16 * 16;
+        int sizeDivide    = UP_DIV(sizeC16, numberThread);
+        if (sizeC16 > 0) {
+            MNN_CONCURRENCY_BEGIN(tId, numberThread) {
+                int start = (int)tId * sizeDivide;
+                int end   = std::min(start + sizeDivide, sizeC16);
+                if (end > start) {
+                    MNNReluInt8(dst + 16 * start, src + 16 * start, 16 * (end - start));
+                }
+            }
+            MNN_CONCURRENCY_END();
+        }
+        for (int i = remain; i < size; ++i) {
+            dst[i] = src[i] < 0 ? 0 : src[i];
+        }
+        return NO_ERROR;
+    }
     const float* srcO = (const float*)ib.host;
     float* dstO       = (float*)ob.host;
     auto size         = inputs[0]->size() / sizeof(float);
@@ -109,6 +135,10 @@ public:
             if (nullptr != op->main() && OpParameter_Relu == op->main_type()) {
                 slope = op->main_as_Relu()->slope();
             }
+            if (inputs[0]->getType() == halide_type_of<int8_t>() && slope != 0.0f) {
+                // Leaky relu of int8 is not supported
+                return nullptr;
+            }
             return new CPURelu(backend, slope);
         }
         MNN_ASSERT(op->type() == OpType_PReLU);
@@ -20,10 +20,7 @@ ErrorCode CPUSigmoid::onExecute(const std::vector<Tensor*>& inputs, const std::v
     auto outputData = outputs[0]->host<float>();
 
     const int dataSize = outputs[0]->elementSize();
-    MNNExp(outputData, inputData, dataSize);
-    for (int i = 0; i < dataSize; ++i) {
-        outputData[i] = 1.0f / (1.0f + outputData[i]);
-    }
+    MNNSigmoid(outputData, inputData, dataSize);
     return NO_ERROR;
 }
 
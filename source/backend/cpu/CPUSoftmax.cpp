@@ -7,111 +7,70 @@
 //
 
 #include "backend/cpu/CPUSoftmax.hpp"
+#include <float.h>
 #include <math.h>
 #include "backend/cpu/CPUBackend.hpp"
 #include "backend/cpu/compute/CommonOptFunction.h"
 #include "core/Concurrency.h"
 #include "core/Macro.h"
 #include "core/TensorUtils.hpp"
-#ifdef MNN_USE_NEON
-#include <arm_neon.h>
-#endif
 
 namespace MNN {
 
 int CPUSoftmax::_softmax1(const float *srcData, float *dstData, int outside, int channel, int threadNum) {
-    // Max and sub
-    MNN_CONCURRENCY_BEGIN(tId, threadNum)
-    {
-        const float *srcY = srcData + tId * channel;
-        float *dstY       = dstData + tId * channel;
-        for (int y = (int)tId; y < outside; y += threadNum, srcY += channel * threadNum, dstY += channel * threadNum) {
-            float maxValue = srcY[0];
-            {
-                int c = 1;
-#ifdef MNN_USE_NEON
-#if !(defined(__ARM_FEATURE_FMA) && defined(__aarch64__))
-#define vmaxvq_f32(v)                 \
-    ({                                \
-        float __m = v[0];             \
-        for (int i = 1; i < 4; i++) { \
-            if (v[i] > __m)           \
-                __m = v[i];           \
-        }                             \
-        __m;                          \
-    })
-#endif
-                if (c + 3 < channel) {
-                    float32x4_t maxx4 = vld1q_f32(srcY + c);
-                    c += 4;
-                    for (; c + 3 < channel; c += 4) {
-                        maxx4 = vmaxq_f32(maxx4, vld1q_f32(srcY + c));
-                    }
-                    float value = vmaxvq_f32(maxx4);
-                    if (value > maxValue)
-                        maxValue = value;
-                }
-#endif
-                for (; c < channel; ++c) {
-                    float value = srcY[c];
-                    if (value > maxValue)
-                        maxValue = value;
-                }
-            }
-
-            for (int c = 0; c < channel; ++c) {
-                dstY[c] = -srcY[c] + maxValue;
+    if (outside >= threadNum || channel < threadNum * 256) {
+        MNN_CONCURRENCY_BEGIN(tId, threadNum) {
+            for (int y = (int)tId; y < outside; y += threadNum) {
+                MNNSoftmax(dstData + y * channel, srcData + y * channel, channel);
             }
         }
+        MNN_CONCURRENCY_END();
+        return 0;
     }
-    MNN_CONCURRENCY_END();
-    
-    //Exp
-    auto schedule = ((CPUBackend*)backend())->multiThreadDivide(channel * outside);
-    int sizeDivide = schedule.first;
-    int scheduleNumber = schedule.second;
-
-    MNN_CONCURRENCY_BEGIN(tId, scheduleNumber) {
-        int start = sizeDivide * (int)tId;
-        int realSize = sizeDivide;
-        if (tId == scheduleNumber -1 ) {
-            realSize = channel * outside - start;
+    // Few rows with a large axis: split every row among the threads,
+    // each part is normalized by its own max, then rescaled by exp(partMax - max) / sum
+    auto partMax  = mMaxValue.host<float>();
+    auto partSum  = mSumValue.host<float>();
+    int partSize  = UP_DIV(channel, threadNum);
+    for (int y = 0; y < outside; ++y) {
+        auto srcY = srcData + y * channel;
+        auto dstY = dstData + y * channel;
+        MNN_CONCURRENCY_BEGIN(tId, threadNum) {
+            int start = (int)tId * partSize;
+            int count = ALIMIN(partSize, channel - start);
+            partMax[tId] = -FLT_MAX;
+            partSum[tId] = 0.0f;
+            if (count > 0) {
+                auto src       = srcY + start;
+                float maxValue = src[0];
+                for (int c = 1; c < count; ++c) {
+                    maxValue = ALIMAX(maxValue, src[c]);
+                }
+                partMax[tId] = maxValue;
+                partSum[tId] = MNNExpSum(dstY + start, src, maxValue, count);
+            }
         }
-        if (realSize > 0) {
-            MNNExp(dstData + start, dstData + start, realSize);
+        MNN_CONCURRENCY_END();
+        float maxValue = -FLT_MAX;
+        for (int t = 0; t < threadNum; ++t) {
+            maxValue = ALIMAX(maxValue, partMax[t]);
         }
-    }
-    MNN_CONCURRENCY_END();
-
-    // Sum and div
-    MNN_CONCURRENCY_BEGIN(tId, threadNum);
-    {
-        float *dstY       = dstData + tId * channel;
-        for (int y = (int)tId; y < outside; y += threadNum, dstY += channel * threadNum) {
-            // sum
-            float sumValue = 0;
-
-            for (int c = 0; c < channel; ++c) {
-                sumValue += dstY[c];
+        float sumValue = 0.0f;
+        for (int t = 0; t < threadNum; ++t) {
+            if (partSum[t] > 0.0f) {
+                sumValue += partSum[t] * expf(partMax[t] - maxValue);
             }
-
-            // div
-            {
-                int c = 0;
-#ifdef MNN_USE_NEON
-                float div = 1.f / sumValue;
-                for (; c + 3 < channel; c += 4) {
-                    vst1q_f32(dstY + c, vmulq_n_f32(vld1q_f32(dstY + c), div));
-                }
-#endif
-                for (; c < channel; ++c) {
-                    dstY[c] /= sumValue;
-                }
+        }
+        MNN_CONCURRENCY_BEGIN(tId, threadNum) {
+            int start = (int)tId * partSize;
+            int count = ALIMIN(partSize, channel - start);
+            if (count > 0) {
+                MNNScaleAndAddBiasScalar(dstY + start, dstY + start, 0.0f, expf(partMax[tId] - maxValue) / sumValue,
+                                         count);
             }
         }
+        MNN_CONCURRENCY_END();
     }
-    MNN_CONCURRENCY_END();
-
     return 0;
 }
 int CPUSoftmax::_softmaxCommon(const float *srcData, float *dstData, int inside, int outside, int channel,
@@ -119,68 +78,52 @@ int CPUSoftmax::_softmaxCommon(const float *srcData, float *dstData, int inside,
     if (inside == 1)
         return _softmax1(srcData, dstData, outside, channel, threadNum);
 
-    const int stepY = inside * channel;
+    // Split inside too when outside can't feed all threads, every task runs max, exp and div on its part
+    const int stepY  = inside * channel;
+    int insidePart   = 1;
+    if (outside < threadNum) {
+        insidePart = UP_DIV(threadNum, outside);
+    }
+    int partSize     = ALIMIN(inside, UP_DIV(UP_DIV(inside, insidePart), 4) * 4);
+    insidePart       = UP_DIV(inside, partSize);
+    int taskNumber   = outside * insidePart;
     MNN_CONCURRENCY_BEGIN(tId, threadNum);
     {
-        const float *srcY  = srcData + tId * stepY;
-        float *dstY        = dstData + tId * stepY;
         float *maxValueSub = maxValue + tId * inside;
-
-        for (int y = (int)tId; y < outside; y += threadNum, srcY += stepY * threadNum, dstY += stepY * threadNum) {
-            memcpy(maxValueSub, srcY, sizeof(float) * inside);
-            const float *src = srcY + inside;
-            for (int c = 1; c < channel; ++c, src += inside) {
-                for (int x = 0; x < inside; ++x) {
-                    if (src[x] > maxValueSub[x])
-                        maxValueSub[x] = src[x];
+        float *sumValueSub = sumValue + tId * inside;
+        for (int task = (int)tId; task < taskNumber; task += threadNum) {
+            int y            = task / insidePart;
+            int xStart       = (task % insidePart) * partSize;
+            int count        = ALIMIN(partSize, inside - xStart);
+            const float *src = srcData + y * stepY + xStart;
+            float *dst       = dstData + y * stepY + xStart;
+            ::memcpy(maxValueSub, src, sizeof(float) * count);
+            for (int c = 1; c < channel; ++c) {
+                auto srcC = src + c * inside;
+                for (int x = 0; x < count; ++x) {
+                    maxValueSub[x] = ALIMAX(maxValueSub[x], srcC[x]);
                 }
             }
-            src        = srcY;
-            float *dst = dstY;
-            for (int c = 0; c < channel; ++c, src += inside, dst += inside) {
-                for (int x = 0; x < inside; ++x) {
-                    dst[x] = -src[x] + maxValueSub[x];
+            ::memset(sumValueSub, 0, sizeof(float) * count);
+            for (int c = 0; c < channel; ++c) {
+                auto srcC = src + c * inside;
+                auto dstC = dst + c * inside;
+                for (int x = 0; x < count; ++x) {
+                    dstC[x] = maxValueSub[x] - srcC[x];
                 }
-            }
-        }
-    }
-    MNN_CONCURRENCY_END();
-
-    auto totalSize = channel * inside * outside;
-    //Exp
-    auto schedule = ((CPUBackend*)backend())->multiThreadDivide(totalSize);
-    int sizeDivide = schedule.first;
-    int scheduleNumber = schedule.second;
-
-    MNN_CONCURRENCY_BEGIN(tId, scheduleNumber) {
-        int start = sizeDivide * (int)tId;
-        int realSize = sizeDivide;
-        if (tId == scheduleNumber -1 ) {
-            realSize = totalSize - start;
-        }
-        if (realSize > 0) {
-            MNNExp(dstData + start, dstData + start, realSize);
-        }
-    }
-    MNN_CONCURRENCY_END();
-    
-    MNN_CONCURRENCY_BEGIN(tId, threadNum);
-    {
-        const float *srcY  = srcData + tId * stepY;
-        float *dstY        = dstData + tId * stepY;
-        float *sumValueSub = sumValue + tId * inside;
-        for (int y = (int)tId; y < outside; y += threadNum, srcY += stepY * threadNum, dstY += stepY * threadNum) {
-            memset(sumValueSub, 0, sizeof(float) * inside);
-            float *dst = dstY;
-            for (int c = 0; c < channel; ++c, dst += inside) {
-                for (int x = 0; x < inside; ++x) {
-                    sumValueSub[x] += dst[x];
+                // MNNExp computes exp(-x)
+                MNNExp(dstC, dstC, count);
+                for (int x = 0; x < count; ++x) {
+                    sumValueSub[x] += dstC[x];
                 }
             }
-            dst = dstY;
-            for (int c = 0; c < channel; ++c, dst += inside) {
-                for (int x = 0; x < inside; ++x) {
-                    dst[x] /= sumValueSub[x];
+            for (int x = 0; x < count; ++x) {
+                sumValueSub[x] = 1.0f / sumValueSub[x];
+            }
+            for (int c = 0; c < channel; ++c) {
+                auto dstC = dst + c * inside;
+                for (int x = 0; x < count; ++x) {
+                    dstC[x] *= sumValueSub[x];
                 }
             }
         }
@@ -219,7 +162,8 @@ ErrorCode CPUSoftmax::onResize(const std::vector<Tensor *> &inputs, const std::v
         inside *= input->length(i);
     }
 
-    if (inside != 1) { // not run _softmax1, we need maxValue Tensor and sumValue Tensor.
+    {
+        // inside != 1: max and sum of every thread, inside == 1: max and sum of every part of a row
         int threadNum = ((CPUBackend *)backend())->threadNumber();
 
         mMaxValue.buffer().dim[0].extent = inside * threadNum;
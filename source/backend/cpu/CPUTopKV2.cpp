@@ -7,7 +7,9 @@
 //
 
 #include "backend/cpu/CPUTopKV2.hpp"
+#include <algorithm>
 #include "backend/cpu/CPUBackend.hpp"
+#include "core/Concurrency.h"
 #include "core/Macro.h"
 
 namespace MNN {
@@ -66,22 +68,50 @@ private:
     }
 };
 
+// Find top k of rows [rowStart, rowEnd)
 template <typename T>
-void findTopK(int32_t rowSize, int32_t numRows, const T* data, int32_t k, int32_t* outputIndexes, T* outputValues) {
-    TopContainer<T> topc(k, rowSize);
-    for (int row = 0; row < numRows; row++) {
+void findTopK(int32_t rowSize, int32_t rowStart, int32_t rowEnd, const T* data, int32_t k, int32_t* outputIndexes,
+              T* outputValues) {
+    if (k * 16 < rowSize) {
+        // Small k: most values are rejected by comparing with the heap's top
+        TopContainer<T> topc(k, rowSize);
+        for (int row = rowStart; row < rowEnd; row++) {
+            const T* valuesRow = data + row * rowSize;
+            topc.startCollecting(valuesRow);
+            for (int c = 0; c < rowSize; c++) {
+                topc.push(c);
+            }
+
+            int32_t* indexesRow = outputIndexes + row * k;
+            T* ouputRow         = outputValues + row * k;
+
+            const auto& topK = topc.sortedResult();
+            std::copy(topK.begin(), topK.end(), indexesRow);
+            std::transform(topK.begin(), topK.end(), ouputRow, [valuesRow](const int32_t loc) { return valuesRow[loc]; });
+        }
+        return;
+    }
+    // Large k: partial selection by nth_element, then sort the first k
+    std::vector<int32_t> indexes(rowSize);
+    for (int row = rowStart; row < rowEnd; row++) {
         const T* valuesRow = data + row * rowSize;
-        topc.startCollecting(valuesRow);
+        auto comparator    = [valuesRow](int32_t a, int32_t b) {
+            return valuesRow[b] < valuesRow[a] || (valuesRow[b] == valuesRow[a] && a < b);
+        };
         for (int c = 0; c < rowSize; c++) {
-            topc.push(c);
+            indexes[c] = c;
         }
+        if (k < rowSize) {
+            std::nth_element(indexes.begin(), indexes.begin() + k, indexes.end(), comparator);
+        }
+        std::sort(indexes.begin(), indexes.begin() + k, comparator);
 
         int32_t* indexesRow = outputIndexes + row * k;
         T* ouputRow         = outputValues + row * k;
-
-        const auto& topK = topc.sortedResult();
-        std::copy(topK.begin(), topK.end(), indexesRow);
-        std::transform(topK.begin(), topK.end(), ouputRow, [valuesRow](const int32_t loc) { return valuesRow[loc]; });
+        for (int i = 0; i < k; i++) {
+            indexesRow[i] = indexes[i];
+            ouputRow[i]   = valuesRow[indexes[i]];
+        }
     }
 }
 
@@ -100,16 +130,30 @@ ErrorCode CPUTopKV2::onExecute(const std::vector<Tensor*>& inputs, const std::ve
     const int rowSize = inputTensor->buffer().dim[inputDimension - 1].extent;
     MNN_ASSERT(k <= rowSize);
     const int numRows = inputTensor->elementSize() / rowSize;
+    // Rows are independent
+    int threadNumber = static_cast<CPUBackend*>(backend())->threadNumber();
+    threadNumber     = std::max(1, std::min(threadNumber, numRows));
+    const int rowStep = UP_DIV(numRows, threadNumber);
     if (halide_type_float == inputTensor->getType().code) {
         auto inputData   = inputTensor->host<float>();
         auto topkData    = outputData->host<float>();
         int* indicesData = outputIndices->host<int32_t>();
-        findTopK<float>(rowSize, numRows, inputData, k, indicesData, topkData);
+        MNN_CONCURRENCY_BEGIN(tId, threadNumber) {
+            int rowStart = (int)tId * rowStep;
+            int rowEnd   = std::min(rowStart + rowStep, numRows);
+            findTopK<float>(rowSize, rowStart, rowEnd, inputData, k, indicesData, topkData);
+        }
+        MNN_CONCURRENCY_END();
     } else if(halide_type_int == inputTensor->getType().code && 32 == inputTensor->getType().bits) {
         auto inputData   = inputTensor->host<int32_t>();
         auto topkData    = outputData->host<int32_t>();
         int* indicesData = outputIndices->host<int32_t>();
-        findTopK<int32_t>(rowSize, numRows, inputData, k, indicesData, topkData);
+        MNN_CONCURRENCY_BEGIN(tId, threadNumber) {
+            int rowStart = (int)tId * rowStep;
+            int rowEnd   = std::min(rowStart + rowStep, numRows);
+            findTopK<int32_t>(rowSize, rowStart, rowEnd, inputData, k, indicesData, topkData);
+        }
+        MNN_CONCURRENCY_END();
     } else {
         MNN_PRINT("TODO\n");
         MNN_ASSERT(false);
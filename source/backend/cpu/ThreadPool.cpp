@@ -8,7 +8,17 @@
 #ifdef MNN_USE_THREAD_POOL
 #include "backend/cpu/ThreadPool.hpp"
 #include <string.h>
+#include <algorithm>
 #include <MNN/MNNDefine.h>
+#include <MNN/MNNForwardType.h>
+#if defined(__linux__) && !defined(__ANDROID__)
+#define MNN_THREAD_PLACEMENT
+#include <dirent.h>
+#include <sched.h>
+#include <stdio.h>
+#include <algorithm>
+#include <map>
+#endif
 #ifdef __ANDROID__
 #include <stdint.h>
 #include <sys/syscall.h>
@@ -18,9 +28,22 @@
 //#define MNN_THREAD_LOCK_CPU
 
 #define MNN_THREAD_POOL_MAX_TASKS 2
+// The work index of the pool of node is (node + 1) * MNN_THREAD_POOL_MAX_TASKS + slot
+#define MNN_THREAD_POOL_MAX_NODES 64
 namespace MNN {
 ThreadPool* ThreadPool::gInstance = nullptr;
+static ThreadPool* gNodeInstances[MNN_THREAD_POOL_MAX_NODES] = {nullptr};
 static std::mutex gInitMutex;
+// Task enqueued by a thread that is running a task is computed in that thread, unless the thread leads a group of
+// enqueueBranches
+static thread_local bool gInTask = false;
+struct ThreadGroup {
+    ThreadPool* pool = nullptr;
+    int slot         = 0;
+    int begin        = 0;
+    int number       = 0;
+};
+static thread_local ThreadGroup gGroup;
 int ThreadPool::init(int number) {
     if (1 >= number) {
         return 1;
@@ -36,12 +59,46 @@ int ThreadPool::init(int number) {
     }
     return number;
 }
+int ThreadPool::initNode(int number, int node) {
+    if (1 >= number) {
+        return 1;
+    }
+    if (node < 0 || node >= MNN_THREAD_POOL_MAX_NODES) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> _l(gInitMutex);
+    auto& pool = gNodeInstances[node];
+    if (nullptr != pool) {
+        if (pool->number() < number) {
+            return pool->number();
+        }
+        return number;
+    }
+    pool = new ThreadPool(number, node);
+    return number;
+}
 void ThreadPool::destroy() {
     std::lock_guard<std::mutex> _l(gInitMutex);
     if (nullptr != gInstance) {
         delete gInstance;
         gInstance = nullptr;
     }
+    for (int i = 0; i < MNN_THREAD_POOL_MAX_NODES; ++i) {
+        if (nullptr != gNodeInstances[i]) {
+            delete gNodeInstances[i];
+            gNodeInstances[i] = nullptr;
+        }
+    }
+}
+ThreadPool* ThreadPool::_getPool(int index) {
+    int pool = index / MNN_THREAD_POOL_MAX_TASKS;
+    if (index < 0 || pool > MNN_THREAD_POOL_MAX_NODES) {
+        return nullptr;
+    }
+    if (0 == pool) {
+        return gInstance;
+    }
+    return gNodeInstances[pool - 1];
 }
 #ifdef MNN_THREAD_LOCK_CPU
 static int getNumberOfCPU() {
@@ -149,11 +206,233 @@ static int setSchedAffinity(const std::vector<int>& cpuIDs) {
 }
 
 #endif // arch
-ThreadPool::ThreadPool(int numberThread) {
+
+#ifdef MNN_THREAD_PLACEMENT
+struct CPUTopology {
+    int id;
+    int node;
+    int package;
+    int core;
+    // 0 for the first hyper-thread of a physical core, 1 for the second one ...
+    int sibling;
+};
+
+// The cpus the process can use, it's taken when the first pool is made as the threads of MNN are not pinned then
+static cpu_set_t gProcessMask;
+static bool gHasProcessMask = false;
+
+static void _initProcessMask() {
+    if (gHasProcessMask) {
+        return;
+    }
+    CPU_ZERO(&gProcessMask);
+    gHasProcessMask = 0 == sched_getaffinity(0, sizeof(gProcessMask), &gProcessMask);
+}
+
+static int _readInt(const char* path, int defaultValue) {
+    FILE* fp = fopen(path, "rb");
+    if (nullptr == fp) {
+        return defaultValue;
+    }
+    int value = defaultValue;
+    if (1 != fscanf(fp, "%d", &value)) {
+        value = defaultValue;
+    }
+    fclose(fp);
+    return value;
+}
+
+// Parse the cpu list of sysfs, such as "0-3,8,10-11"
+static std::vector<int> _readList(const char* path) {
+    std::vector<int> result;
+    FILE* fp = fopen(path, "rb");
+    if (nullptr == fp) {
+        return result;
+    }
+    int first = 0;
+    while (1 == fscanf(fp, "%d", &first)) {
+        int last = first;
+        int c    = fgetc(fp);
+        if ('-' == c) {
+            if (1 != fscanf(fp, "%d", &last)) {
+                break;
+            }
+            c = fgetc(fp);
+        }
+        for (int i = first; i <= last; ++i) {
+            result.emplace_back(i);
+        }
+        if (',' != c) {
+            break;
+        }
+    }
+    fclose(fp);
+    return result;
+}
+
+// The cpus this process can use, with their NUMA node, package and core from sysfs
+static std::vector<CPUTopology> _getTopology() {
+    std::vector<CPUTopology> cpus;
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (gHasProcessMask) {
+        allowed = gProcessMask;
+    } else if (0 != sched_getaffinity(0, sizeof(allowed), &allowed)) {
+        return cpus;
+    }
+    std::vector<int> nodeOfCPU(CPU_SETSIZE, 0);
+    DIR* dir = opendir("/sys/devices/system/node");
+    if (nullptr != dir) {
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != nullptr) {
+            int node = 0;
+            if (1 != sscanf(entry->d_name, "node%d", &node)) {
+                continue;
+            }
+            char path[256];
+            snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+            for (auto cpu : _readList(path)) {
+                if (cpu >= 0 && cpu < CPU_SETSIZE) {
+                    nodeOfCPU[cpu] = node;
+                }
+            }
+        }
+        closedir(dir);
+    }
+    for (int i = 0; i < CPU_SETSIZE; ++i) {
+        if (!CPU_ISSET(i, &allowed)) {
+            continue;
+        }
+        char path[256];
+        CPUTopology cpu;
+        cpu.id   = i;
+        cpu.node = nodeOfCPU[i];
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", i);
+        cpu.package = _readInt(path, 0);
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/core_id", i);
+        cpu.core    = _readInt(path, i);
+        cpu.sibling = 0;
+        for (auto& c : cpus) {
+            if (c.package == cpu.package && c.core == cpu.core) {
+                cpu.sibling++;
+            }
+        }
+        cpus.emplace_back(cpu);
+    }
+    return cpus;
+}
+
+// The cpu for each of the number threads, only the cpus of the node if node >= 0
+static std::vector<int> _placeThreads(int mode, int number, int node) {
+    auto cpus = _getTopology();
+    if (node >= 0) {
+        cpus.erase(std::remove_if(cpus.begin(), cpus.end(), [node](const CPUTopology& c) { return c.node != node; }),
+                   cpus.end());
+    }
+    if (cpus.empty()) {
+        return std::vector<int>(number, -1);
+    }
+    auto compact = [](const CPUTopology& a, const CPUTopology& b) {
+        if (a.sibling != b.sibling) {
+            return a.sibling < b.sibling;
+        }
+        if (a.node != b.node) {
+            return a.node < b.node;
+        }
+        if (a.package != b.package) {
+            return a.package < b.package;
+        }
+        if (a.core != b.core) {
+            return a.core < b.core;
+        }
+        return a.id < b.id;
+    };
+    std::sort(cpus.begin(), cpus.end(), compact);
+    if (BackendConfig::Affinity_Scatter == mode) {
+        // Take the k-th cpu of every node in turn
+        std::map<std::pair<int, int>, int> counter;
+        std::vector<std::pair<std::pair<int, int>, CPUTopology>> ranked;
+        for (auto& c : cpus) {
+            auto key = std::make_pair(c.sibling, c.node);
+            ranked.emplace_back(std::make_pair(std::make_pair(c.sibling, counter[key]++), c));
+        }
+        std::stable_sort(ranked.begin(), ranked.end(),
+                         [](const std::pair<std::pair<int, int>, CPUTopology>& a,
+                            const std::pair<std::pair<int, int>, CPUTopology>& b) { return a.first < b.first; });
+        for (int i = 0; i < ranked.size(); ++i) {
+            cpus[i] = ranked[i].second;
+        }
+    }
+    std::vector<int> result(number);
+    for (int i = 0; i < number; ++i) {
+        result[i] = cpus[i % cpus.size()].id;
+    }
+    return result;
+}
+
+static void _pinThread(int cpu) {
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    if (cpu < 0) {
+        // Not pinned, use all cpus of the process
+        auto cpus = _getTopology();
+        for (auto& c : cpus) {
+            CPU_SET(c.id, &mask);
+        }
+    } else {
+        CPU_SET(cpu, &mask);
+    }
+    if (0 != sched_setaffinity(0, sizeof(mask), &mask)) {
+        MNN_PRINT("Set thread affinity to cpu %d failed\n", cpu);
+    }
+}
+#endif
+
+int ThreadPool::currentNode() {
+#ifdef MNN_THREAD_PLACEMENT
+    int current = sched_getcpu();
+    for (auto& c : _getTopology()) {
+        if (c.id == current) {
+            return c.node;
+        }
+    }
+#endif
+    return -1;
+}
+
+void ThreadPool::setAffinity(int mode) {
+    if (nullptr == gInstance || BackendConfig::Affinity_None == mode || BackendConfig::Affinity_Node == mode) {
+        return;
+    }
+#ifdef MNN_THREAD_PLACEMENT
+    std::vector<int> cpus(gInstance->mNumberThread, -1);
+    if (BackendConfig::Affinity_Reset != mode) {
+        cpus = _placeThreads(mode, gInstance->mNumberThread, -1);
+    }
+    std::lock_guard<std::mutex> _l(gInstance->mQueueMutex);
+    if (cpus == gInstance->mCPUs) {
+        return;
+    }
+    gInstance->mCPUs = cpus;
+    gInstance->mPlacement++;
+#endif
+}
+
+ThreadPool::ThreadPool(int numberThread, int node) {
     mNumberThread = numberThread;
     mActiveCount  = 0;
+    mCPUs.resize(mNumberThread, -1);
+#ifdef MNN_THREAD_PLACEMENT
+    _initProcessMask();
+    if (node >= 0) {
+        // The threads pin themselves when they start
+        mCPUs      = _placeThreads(BackendConfig::Affinity_Compact, mNumberThread, node);
+        mPlacement = 1;
+    }
+#endif
     mTaskAvailable.resize(MNN_THREAD_POOL_MAX_TASKS);
-    mTasks.resize(MNN_THREAD_POOL_MAX_TASKS);
+    // The slots of the work indexes, then the slots of the groups led by each thread for each work index
+    mTasks.resize(MNN_THREAD_POOL_MAX_TASKS * (1 + mNumberThread));
     for (int t = 0; t < mTasks.size(); ++t) {
         mTaskAvailable[t] = true;
         for (int i = 0; i < mNumberThread; ++i) {
@@ -173,9 +452,22 @@ ThreadPool::ThreadPool(int numberThread) {
 #ifdef MNN_THREAD_LOCK_CPU
             int res = setSchedAffinity(sortedCPUIDs);
 #endif
+            gInTask = true;
+            int placement = 0;
             while (!mStop) {
+#ifdef MNN_THREAD_PLACEMENT
+                if (placement != mPlacement) {
+                    int cpu = -1;
+                    {
+                        std::lock_guard<std::mutex> _l(mQueueMutex);
+                        placement = mPlacement;
+                        cpu       = mCPUs[threadIndex];
+                    }
+                    _pinThread(cpu);
+                }
+#endif
                 while (mActiveCount > 0) {
-                    for (int i = 0; i < MNN_THREAD_POOL_MAX_TASKS; ++i) {
+                    for (int i = 0; i < mTasks.size(); ++i) {
                         if (*mTasks[i].second[threadIndex]) {
                             mTasks[i].first.first(threadIndex);
                             { *mTasks[i].second[threadIndex] = false; }
@@ -203,54 +495,64 @@ ThreadPool::~ThreadPool() {
     }
 }
 
-int ThreadPool::acquireWorkIndex() {
-    if (nullptr == gInstance) {
+int ThreadPool::acquireWorkIndex(int node) {
+    if (node >= MNN_THREAD_POOL_MAX_NODES) {
         return -1;
     }
-    std::lock_guard<std::mutex> _l(gInstance->mQueueMutex);
+    auto pool = node < 0 ? gInstance : gNodeInstances[node];
+    int base  = (node + 1) * MNN_THREAD_POOL_MAX_TASKS;
+    if (nullptr == pool) {
+        return -1;
+    }
+    std::lock_guard<std::mutex> _l(pool->mQueueMutex);
     for (int i = 0; i < MNN_THREAD_POOL_MAX_TASKS; ++i) {
-        if (gInstance->mTaskAvailable[i]) {
-            gInstance->mTaskAvailable[i] = false;
-            return i;
+        if (pool->mTaskAvailable[i]) {
+            pool->mTaskAvailable[i] = false;
+            return base + i;
         }
     }
     return -1;
 }
 void ThreadPool::releaseWorkIndex(int index) {
-    if (nullptr == gInstance) {
-        return;
-    }
-    if (index < 0 || index >= MNN_THREAD_POOL_MAX_TASKS) {
+    auto pool = _getPool(index);
+    if (nullptr == pool) {
         return;
     }
-    std::lock_guard<std::mutex> _l(gInstance->mQueueMutex);
-    gInstance->mTaskAvailable[index] = true;
+    std::lock_guard<std::mutex> _l(pool->mQueueMutex);
+    pool->mTaskAvailable[index % MNN_THREAD_POOL_MAX_TASKS] = true;
 }
 
-void ThreadPool::active() {
-    if (nullptr == gInstance) {
+void ThreadPool::active(int index) {
+    auto pool = _getPool(index);
+    if (nullptr == pool) {
         return;
     }
-    gInstance->mActiveCount++;
-    std::lock_guard<std::mutex> _l(gInstance->mQueueMutex);
-    gInstance->mCondition.notify_all();
+    pool->mActiveCount++;
+    std::lock_guard<std::mutex> _l(pool->mQueueMutex);
+    pool->mCondition.notify_all();
 }
-void ThreadPool::deactive() {
-    if (nullptr == gInstance) {
+void ThreadPool::deactive(int index) {
+    auto pool = _getPool(index);
+    if (nullptr == pool) {
         return;
     }
-    gInstance->mActiveCount--;
+    pool->mActiveCount--;
 }
 
 void ThreadPool::enqueue(TASK&& task, int index) {
-    if (1 >= task.second || 0 > index) {
+    if (gInTask && gGroup.number > 1 && task.second > 1) {
+        gGroup.pool->enqueueGroup(std::move(task), gGroup.slot, gGroup.begin, gGroup.number);
+        return;
+    }
+    if (1 >= task.second || 0 > index || gInTask) {
         for (int i = 0; i < task.second; ++i) {
             task.first(i);
         }
         return;
     }
-    MNN_ASSERT(nullptr != gInstance);
-    gInstance->enqueueInternal(std::move(task), index);
+    auto pool = _getPool(index);
+    MNN_ASSERT(nullptr != pool);
+    pool->enqueueInternal(std::move(task), index % MNN_THREAD_POOL_MAX_TASKS);
 }
 void ThreadPool::enqueueInternal(TASK&& task, int index) {
     if (mActiveCount == 0) {
@@ -277,7 +579,9 @@ void ThreadPool::enqueueInternal(TASK&& task, int index) {
             *mTasks[index].second[i] = true;
         }
     }
+    gInTask = true;
     mTasks[index].first.first(0);
+    gInTask = false;
     bool complete = true;
     do {
         std::this_thread::yield();
@@ -291,5 +595,66 @@ void ThreadPool::enqueueInternal(TASK&& task, int index) {
         // FUNC_PRINT(notComplete);
     } while (!complete);
 }
+
+void ThreadPool::enqueueBranches(TASK&& task, int index, int number) {
+    auto pool = _getPool(index);
+    if (1 >= task.second || 0 > index || gInTask || nullptr == pool || 0 == pool->mActiveCount) {
+        for (int i = 0; i < task.second; ++i) {
+            task.first(i);
+        }
+        return;
+    }
+    // Thread k * budget leads the group of branch k, the other threads of the group only run the tasks it enqueues
+    number          = std::min(number, pool->mNumberThread);
+    int groupNumber = std::min(task.second, number);
+    int budget      = number / groupNumber;
+    int slot        = index % MNN_THREAD_POOL_MAX_TASKS;
+    TASK groupTask;
+    groupTask.second = groupNumber * budget;
+    groupTask.first  = [&task, pool, slot, groupNumber, budget](int tId) {
+        if (0 != tId % budget) {
+            return;
+        }
+        gGroup.pool   = pool;
+        gGroup.slot   = slot;
+        gGroup.begin  = tId;
+        gGroup.number = budget;
+        for (int v = tId / budget; v < task.second; v += groupNumber) {
+            task.first(v);
+        }
+        gGroup.number = 0;
+    };
+    pool->enqueueInternal(std::move(groupTask), slot);
+}
+void ThreadPool::enqueueGroup(TASK&& task, int slot, int begin, int number) {
+    auto& groupTask = mTasks[MNN_THREAD_POOL_MAX_TASKS * (1 + mNumberThread * slot) + begin];
+    int workSize    = std::min(task.second, number);
+    int total       = task.second;
+    groupTask.first = std::make_pair(
+        [&task, begin, workSize, total](int tId) {
+            for (int v = tId - begin; v < total; v += workSize) {
+                task.first(v);
+            }
+        },
+        workSize);
+    for (int i = 1; i < workSize; ++i) {
+        *groupTask.second[begin + i] = true;
+    }
+    // The tasks enqueued by these are computed in this thread
+    gGroup.number = 1;
+    groupTask.first.first(begin);
+    gGroup.number = number;
+    bool complete = true;
+    do {
+        std::this_thread::yield();
+        complete = true;
+        for (int i = 1; i < workSize; ++i) {
+            if (*groupTask.second[begin + i]) {
+                complete = false;
+                break;
+            }
+        }
+    } while (!complete);
+}
 } // namespace MNN
 #endif
@@ -26,21 +26,37 @@ public:
         return mNumberThread;
     }
     static void enqueue(TASK&& task, int index);
+    // Compute the branches of task concurrently on number threads of the pool, each branch gets number / branches
+    // threads for the tasks enqueued by it
+    static void enqueueBranches(TASK&& task, int index, int number);
 
-    static void active();
-    static void deactive();
+    // The index of acquireWorkIndex tells which pool to wake up, 0 is the shared pool
+    static void active(int index = 0);
+    static void deactive(int index = 0);
 
-    static int acquireWorkIndex();
+    // node < 0 for the shared pool, otherwise the pool of the node made by initNode
+    static int acquireWorkIndex(int node = -1);
     static void releaseWorkIndex(int index);
 
     static int init(int number);
+    // The pool whose threads are pinned on the cpus of the NUMA node, return the number of threads, 0 if failed
+    static int initNode(int number, int node);
+    // NUMA node of the cpu running the calling thread, -1 if unknown
+    static int currentNode();
     static void destroy();
 
+    // Pin the threads of the shared pool by BackendConfig::AffinityMode, it's applied when the threads wake up for
+    // the next task. Affinity_None keeps the placement, Affinity_Node is done by the pools of initNode
+    static void setAffinity(int mode);
+
 private:
     void enqueueInternal(TASK&& task, int index);
+    // Compute task on the threads [begin, begin + number) of the group, the calling thread is the thread begin
+    void enqueueGroup(TASK&& task, int slot, int begin, int number);
+    static ThreadPool* _getPool(int index);
 
     static ThreadPool* gInstance;
-    ThreadPool(int number = 0);
+    ThreadPool(int number = 0, int node = -1);
     ~ThreadPool();
 
     std::vector<std::thread> mWorkers;
@@ -53,6 +69,10 @@ private:
 
     int mNumberThread            = 0;
     std::atomic_int mActiveCount = {0};
+
+    // CPU for each thread, -1 means not pinned. mPlacement is increased when it's changed
+    std::vector<int> mCPUs;
+    std::atomic_int mPlacement = {0};
 };
 } // namespace MNN
 #endif
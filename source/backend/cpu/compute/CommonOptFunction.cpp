@@ -9,6 +9,7 @@
 #include "CommonOptFunction.h"
 #include <string.h>
 #include <algorithm>
+#include <float.h>
 #include <math.h>
 #include "math/Vec.hpp"
 #include <vector>
@@ -48,6 +49,20 @@ bool MNNReorder4x4ByPlatform(float* dst, size_t size) {
 void MNNFunctionInit() {
     // Do nothing
 }
+void MNNFp32ToBf16(int16_t* dst, const float* src, size_t size) {
+    auto srcU = (const uint32_t*)src;
+    for (size_t i = 0; i < size; ++i) {
+        auto u = srcU[i];
+        u      = u + 0x7FFF + ((u >> 16) & 1);
+        dst[i] = (int16_t)(u >> 16);
+    }
+}
+void MNNBf16ToFp32(float* dst, const int16_t* src, size_t size) {
+    auto dstU = (uint32_t*)dst;
+    for (size_t i = 0; i < size; ++i) {
+        dstU[i] = ((uint32_t)(uint16_t)src[i]) << 16;
+    }
+}
 #endif
 
 #ifdef MNN_USE_NEON
@@ -320,6 +335,7 @@ void MNNExpC8(float* dest, const float* source, const float* parameters, size_t
         dest[i] = expBasic * expRemain;
     }
 }
+
 #endif // no MNN_USE_SSE
 
 void MNNMaxFloat(float* input, float* maxBuffer, int32_t inputCountUnit) {
@@ -412,6 +428,102 @@ void MNNPowC8(float* dest, const float* source, const float* powfParam, size_t b
 
 #endif // no MNN_USE_NEON
 
+// No NEON kernel for them yet, the C version is used on ARM as well
+#ifndef MNN_USE_SSE
+float MNNExpSum(float* dest, const float* source, float offset, size_t size) {
+    // MNNExp computes exp(-x)
+    for (int i = 0; i < size; ++i) {
+        dest[i] = offset - source[i];
+    }
+    MNNExp(dest, dest, size);
+    float sum = 0.0f;
+    for (int i = 0; i < size; ++i) {
+        sum += dest[i];
+    }
+    return sum;
+}
+
+void MNNNorm(float* dest, const float* source, const float* gamma, const float* beta, float epsilon, size_t size) {
+    // Welford on four lanes, then merge the lanes and the remain
+    using Vec4 = MNN::Math::Vec<float, 4>;
+    Vec4 meanV(0.0f);
+    Vec4 m2V(0.0f);
+    int sizeC4 = (int)size / 4;
+    for (int i = 0; i < sizeC4; ++i) {
+        auto x     = Vec4::load(source + 4 * i);
+        auto delta = x - meanV;
+        meanV      = meanV + delta * (1.0f / (i + 1));
+        m2V        = m2V + delta * (x - meanV);
+    }
+    float count = 0.0f, mean = 0.0f, m2 = 0.0f;
+    if (sizeC4 > 0) {
+        float n = (float)sizeC4;
+        for (int i = 0; i < 4; ++i) {
+            float total = count + n;
+            float delta = meanV[i] - mean;
+            mean += delta * n / total;
+            m2 += m2V[i] + delta * delta * count * n / total;
+            count = total;
+        }
+    }
+    for (int i = sizeC4 * 4; i < size; ++i) {
+        count += 1.0f;
+        float delta = source[i] - mean;
+        mean += delta / count;
+        m2 += delta * (source[i] - mean);
+    }
+    float invStd = 1.0f / sqrtf(m2 / size + epsilon);
+    for (int i = 0; i < size; ++i) {
+        auto value = (source[i] - mean) * invStd;
+        if (nullptr != gamma) {
+            value = value * gamma[i] + beta[i];
+        }
+        dest[i] = value;
+    }
+}
+#endif // no MNN_USE_SSE
+
+void MNNSoftmax(float* dest, const float* source, size_t size) {
+    // Two passes over the row: a block gets max and exp(x - blockMax) while it is in cache,
+    // then every block is rescaled by exp(blockMax - max) / sum
+    const int maxBlockNumber = 64;
+    int blockSize            = ALIMAX(UP_DIV((int)size, maxBlockNumber), 256);
+    int blockNumber          = UP_DIV((int)size, blockSize);
+    float blockMax[maxBlockNumber];
+    float blockSum[maxBlockNumber];
+    float maxValue = -FLT_MAX;
+    for (int b = 0; b < blockNumber; ++b) {
+        auto start = b * blockSize;
+        auto count = ALIMIN(blockSize, (int)size - start);
+        auto src   = source + start;
+        float bMax = src[0];
+        int i      = 0;
+        if (count >= 4) {
+            auto maxV = MNN::Math::Vec<float, 4>::load(src);
+            for (i = 4; i + 3 < count; i += 4) {
+                maxV = MNN::Math::Vec<float, 4>::max(maxV, MNN::Math::Vec<float, 4>::load(src + i));
+            }
+            bMax = ALIMAX(ALIMAX(maxV[0], maxV[1]), ALIMAX(maxV[2], maxV[3]));
+        }
+        for (; i < count; ++i) {
+            bMax = ALIMAX(bMax, src[i]);
+        }
+        blockMax[b] = bMax;
+        blockSum[b] = MNNExpSum(dest + start, src, bMax, count);
+        maxValue    = ALIMAX(maxValue, bMax);
+    }
+    float sum = 0.0f;
+    for (int b = 0; b < blockNumber; ++b) {
+        blockSum[b] *= expf(blockMax[b] - maxValue);
+        sum += blockSum[b];
+    }
+    for (int b = 0; b < blockNumber; ++b) {
+        auto start = b * blockSize;
+        auto count = ALIMIN(blockSize, (int)size - start);
+        MNNScaleAndAddBiasScalar(dest + start, dest + start, 0.0f, expf(blockMax[b] - maxValue) / sum, count);
+    }
+}
+
 
 void MNNPackC4Uint8(uint8_t* dst, const uint8_t* src, size_t area, size_t depth) {
     int z, x;
@@ -755,6 +867,14 @@ void MNNTanh(float* dst, const float* src, size_t dataSize) {
     }
 }
 
+void MNNSigmoid(float* dst, const float* src, size_t dataSize) {
+    // exp(-x) use MNNExpC8, the division can be auto vectorized
+    MNNExp(dst, src, dataSize);
+    for (int i = 0; i < dataSize; ++i) {
+        dst[i] = 1.0f / (1.0f + dst[i]);
+    }
+}
+
 void MNNReluWithSlope(float* dst, const float* src, size_t sizeQuad, float slope) {
     float slopeValue[4];
     for (int i=0; i<4; ++i) {
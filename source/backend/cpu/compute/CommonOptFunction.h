@@ -69,6 +69,13 @@ void MNNPowC8(float* dest, const float* source, const float* powfParam, size_t b
 
 void MNNExp(float* dst, const float* src, size_t dataSize);
 void MNNTanh(float* dst, const float* src, size_t dataSize);
+void MNNSigmoid(float* dst, const float* src, size_t dataSize);
+// dest = exp(source - offset), return the sum of dest
+float MNNExpSum(float* dest, const float* source, float offset, size_t size);
+// Softmax of one row, dest can be the same as source
+void MNNSoftmax(float* dest, const float* source, size_t size);
+// dest = (source - mean) / sqrt(variance + epsilon) * gamma + beta, gamma and beta can be nullptr
+void MNNNorm(float* dest, const float* source, const float* gamma, const float* beta, float epsilon, size_t size);
 void MNNReluWithSlopeCommon(float* dst, const float* src, size_t size, float slope);
 bool MNNReorder4x4ByPlatform(float* dst, size_t size);
 
@@ -91,6 +98,10 @@ void MNNAxByClampBroadcastC4(float* C, const float* A, const float* B, size_t wi
 
 // dim: 4-element, sizeDW, sizeDH, strideSW, strideDH
 void MNNTranspose32Bit(int32_t* dstO, const int32_t* srcO, int32_t* dim); // not C4
+
+// bfloat16 storage: the high 16 bits of fp32, rounded to nearest even
+void MNNFp32ToBf16(int16_t* dst, const float* src, size_t size);
+void MNNBf16ToFp32(float* dst, const int16_t* src, size_t size);
 #ifdef __cplusplus
 }
 #endif
@@ -22,13 +22,17 @@ Convolution1x1Strassen::Convolution1x1Strassen(const Convolution2DCommon *common
     auto mSrcCount   = (int)originWeightSize / outputCount;
     int ePack, lPack, hPack;
     MNNGetMatMulPackMode(&ePack, &lPack, &hPack);
-    mWeight.reset(Tensor::createDevice<float>(std::vector<int>{UP_DIV(outputCount, hPack), mSrcCount, hPack}));
-    mValid = b->onAcquireBuffer(mWeight.get(), Backend::STATIC);
+    std::shared_ptr<Tensor> weight(
+        Tensor::createDevice<float>(std::vector<int>{UP_DIV(outputCount, hPack), mSrcCount, hPack}));
+    mWeight = static_cast<CPUBackend*>(b)->acquireWeight(weight.get(), "Conv1x1_" + std::to_string(hPack), originWeight,
+                                                         originWeightSize * sizeof(float), [&](Tensor* dst) {
+        MNNPackForMatMul_B(dst->host<float>(), originWeight, outputCount, mSrcCount, true);
+    });
+    mValid = nullptr != mWeight;
     if (!mValid) {
         MNN_ERROR("Not Enough Memory\n");
         return;
     }
-    MNNPackForMatMul_B(mWeight->host<float>(), originWeight, outputCount, mSrcCount, true);
 
     mBias.reset(Tensor::createDevice<float>(std::vector<int>{UP_DIV(outputCount, 4), 4}));
     mValid = b->onAcquireBuffer(mBias.get(), Backend::STATIC);
@@ -44,9 +48,6 @@ Convolution1x1Strassen::Convolution1x1Strassen(const Convolution2DCommon *common
 }
 
 Convolution1x1Strassen::~Convolution1x1Strassen() {
-    if (nullptr != mWeight) {
-        backend()->onReleaseBuffer(mWeight.get(), Backend::STATIC);
-    }
     backend()->onReleaseBuffer(mBias.get(), Backend::STATIC);
 }
 
@@ -89,15 +89,20 @@ ConvolutionTiledExecutor::ConvolutionTiledExecutor(const Convolution2DCommon* co
 
     // Don't use common->inputCount for old model common->inputCount is zero
     auto srcCount    = (int)originWeightSize / outputCount / common->kernelX() / common->kernelY();
-    mWeight.reset(Tensor::createDevice<float>(
+    std::shared_ptr<Tensor> weight(Tensor::createDevice<float>(
         {UP_DIV(outputCount, hP), UP_DIV(srcCount, 4), (int)common->kernelX(), common->kernelY(), 4 * hP}));
-    std::shared_ptr<Tensor> cache(Tensor::createDevice<float>({outputCount, srcCount * common->kernelX() * common->kernelY()}));
-    mValid = backend()->onAcquireBuffer(mWeight.get(), Backend::STATIC) && backend()->onAcquireBuffer(cache.get(), Backend::STATIC);
+    mWeight = static_cast<CPUBackend*>(b)->acquireWeight(weight.get(), "Tiled_" + std::to_string(hP), originWeight,
+                                                      originWeightSize * sizeof(float), [&](Tensor* dst) {
+        // The temp buffer is only needed when the weight is packed
+        std::shared_ptr<Tensor> cache(
+            Tensor::create<float>({outputCount, srcCount * common->kernelX() * common->kernelY()}));
+        _initWeight(dst->host<float>(), originWeight, cache->host<float>(), srcCount, outputCount,
+                    common->kernelX() * common->kernelY());
+    });
+    mValid = nullptr != mWeight;
     if (!mValid) {
         return;
     }
-    _initWeight(mWeight->host<float>(), originWeight, cache->host<float>(), srcCount, outputCount, common->kernelX() * common->kernelY());
-    backend()->onReleaseBuffer(cache.get(), Backend::STATIC);
     mBias.reset(Tensor::createDevice<float>({ALIGN_UP4((int)biasSize)}));
     mValid = backend()->onAcquireBuffer(mBias.get(), Backend::STATIC);
     if (!mValid) {
@@ -111,9 +116,6 @@ ConvolutionTiledExecutor::~ConvolutionTiledExecutor() {
     if (nullptr != mBias) {
         backend()->onReleaseBuffer(mBias.get(), Backend::STATIC);
     }
-    if (nullptr != mWeight) {
-        backend()->onReleaseBuffer(mWeight.get(), Backend::STATIC);
-    }
 }
 ErrorCode ConvolutionTiledExecutorBasic::onResize(const std::vector<Tensor*>& inputs,
                                                   const std::vector<Tensor*>& outputs) {
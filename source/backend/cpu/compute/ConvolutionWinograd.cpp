@@ -90,20 +90,18 @@ ConvolutionWinograd::ConvolutionWinograd(const Convolution2DCommon *convOp, cons
     auto G = generator.G();
     std::shared_ptr<Tensor> sourceWeight(Tensor::create<float>(
         std::vector<int>{outputCount, srcCount, kernelSize, kernelSize}, (void *)originWeight, Tensor::CAFFE));
-    mWeight = generator.allocTransformWeight(sourceWeight.get(), 1, hPack, false);
-    mValid  = backend()->onAcquireBuffer(mWeight.get(), Backend::STATIC);
-    if (!mValid) {
-        return;
-    }
-    generator.transformWeight(mWeight.get(), sourceWeight.get());
+    auto weight = generator.allocTransformWeight(sourceWeight.get(), 1, hPack, false);
+    auto layout = "Winograd" + std::to_string(unit) + "_" + std::to_string(hPack);
+    mWeight     = static_cast<CPUBackend*>(b)->acquireWeight(weight.get(), layout, originWeight, originWeightSize * sizeof(float),
+                                                              [&](Tensor* dst) {
+        generator.transformWeight(dst, sourceWeight.get());
+    });
+    mValid = nullptr != mWeight;
 }
 ConvolutionWinograd::~ConvolutionWinograd() {
     if (nullptr != mBias) {
         backend()->onReleaseBuffer(mBias.get(), Backend::STATIC);
     }
-    if (nullptr != mWeight) {
-        backend()->onReleaseBuffer(mWeight.get(), Backend::STATIC);
-    }
 }
 ErrorCode ConvolutionWinograd::onExecute(const std::vector<Tensor *> &inputs, const std::vector<Tensor *> &outputs) {
     auto input   = inputs[0];
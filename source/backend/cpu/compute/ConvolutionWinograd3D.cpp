@@ -9,6 +9,7 @@
 #include "backend/cpu/compute/ConvolutionWinograd3D.hpp"
 #include "backend/cpu/CPUBackend.hpp"
 #include <math.h>
+#include <set>
 #include "backend/cpu/compute/CommonOptFunction.h"
 #include "core/Concurrency.h"
 #include "backend/cpu/compute/ConvOpt.h"
@@ -27,48 +28,57 @@ using namespace MNN::Math;
 namespace MNN {
 ConvolutionWinograd3D::ConvolutionWinograd3D(const Convolution3DCommon *convOp, const Tensor *input, const Tensor *output,
                                              Backend *b, const float *originWeight, size_t originWeightSize,
-                                             const float *bias, size_t biasSize, int unit) : Execution(b), mUnit(unit) {
+                                             const float *bias, size_t biasSize, int unit) : Execution(b), mCommon(convOp), mUnit(unit) {
     for (int32_t kernel: *(convOp->kernels())) {
         mKernels.push_back(kernel);
     }
     MNN_ASSERT(mKernels[1] == mKernels[2]);
-    mPadMode = convOp->padMode();
-    if (mPadMode != PadMode_SAME) {
-        for (int32_t pad: *(convOp->pads())) {
-            mPads.push_back(pad);
-        }
-    }
     mPostFunction = CPUConvolution3D::getPostFunction(convOp);
 
-    const int inputChannel = convOp->inputCount(), outputChannel = convOp->outputCount();
+    const int outputChannel = (int)biasSize;
+    const int inputChannel  = (int)originWeightSize / outputChannel / (mKernels[0] * mKernels[1] * mKernels[2]);
     const int kernelDepth = mKernels[0], kernelSize = mKernels[1], alpha = unit + kernelSize - 1, alpha2 = alpha * alpha;
     mAlpha = alpha;
 
     mSourceTransform = WinogradFunction::chooseSourceTransform(alpha, alpha);
     mDestTransform   = WinogradFunction::chooseDestTransform(alpha, unit);
 
-    mWeight.reset(Tensor::createDevice<float>({ALIGN_UP4(inputChannel) * ALIGN_UP4(outputChannel) * kernelDepth * alpha2}));
+    int ePack, lPack, hPack;
+    MNNGetMatMulPackMode(&ePack, &lPack, &hPack);
+    // kd, alpha2, UP_DIV(oc, hP), ic, hP: one packed winograd weight per kernel depth
+    mWeight.reset(Tensor::createDevice<float>({kernelDepth, alpha2, UP_DIV(outputChannel, hPack), inputChannel, hPack}));
     mBias.reset(Tensor::createDevice<float>({ALIGN_UP4((int)biasSize)}));
-    bool valid = b->onAcquireBuffer(mWeight.get(), Backend::STATIC);
-    valid = valid && b->onAcquireBuffer(mBias.get(), Backend::STATIC);
-    if (!valid) {
+    mValid = b->onAcquireBuffer(mWeight.get(), Backend::STATIC);
+    mValid = mValid && b->onAcquireBuffer(mBias.get(), Backend::STATIC);
+    if (!mValid) {
         return;
     }
 
     memset(mBias->host<float>(), 0, mBias->size());
     memcpy(mBias->host<float>(), bias, biasSize * sizeof(float));
 
-    WinogradGenerater generator(unit, kernelSize);
-
-    const int srcDepthStep = inputChannel * outputChannel * kernelSize * kernelSize;
-    const int dstDepthStep = ALIGN_UP4(inputChannel) * ALIGN_UP4(outputChannel) * alpha2;
-    std::shared_ptr<Tensor> srcWeight, transWeight;
-    for (int d = 0; d < kernelDepth; ++d) {
-        srcWeight.reset(Tensor::create<float>({outputChannel, inputChannel, kernelSize, kernelSize}, (void*)(originWeight + d * srcDepthStep)));
-        transWeight.reset(Tensor::create<float>({alpha2, UP_DIV(outputChannel, 4), UP_DIV(inputChannel, 4), 4, 4},
-                                                (void*)(mWeight->host<float>() + d * dstDepthStep)));
-        generator.transformWeight(transWeight.get(), srcWeight.get());
-    }
+    auto layout = "Winograd3D" + std::to_string(unit) + "_" + std::to_string(hPack);
+    static_cast<CPUBackend*>(b)->packWeight(mWeight.get(), layout, originWeight, originWeightSize * sizeof(float), [&]() {
+        WinogradGenerater generator(unit, kernelSize, 1, true);
+        // oc, ic, kd, kh, kw -> kd, oc, ic, kh, kw
+        const int planeSize    = kernelSize * kernelSize;
+        const int srcDepthStep = inputChannel * outputChannel * planeSize;
+        std::vector<float> depthMajorWeight(kernelDepth * srcDepthStep);
+        for (int d = 0; d < kernelDepth; ++d) {
+            for (int o = 0; o < inputChannel * outputChannel; ++o) {
+                ::memcpy(depthMajorWeight.data() + d * srcDepthStep + o * planeSize,
+                         originWeight + (o * kernelDepth + d) * planeSize, planeSize * sizeof(float));
+            }
+        }
+        std::shared_ptr<Tensor> srcWeight, transWeight;
+        for (int d = 0; d < kernelDepth; ++d) {
+            srcWeight.reset(Tensor::create<float>({outputChannel, inputChannel, kernelSize, kernelSize},
+                                                  (void*)(depthMajorWeight.data() + d * srcDepthStep)));
+            transWeight.reset(Tensor::create<float>({alpha2, UP_DIV(outputChannel, hPack), inputChannel, 1, hPack},
+                                                    (void*)(mWeight->host<float>() + d * mWeight->stride(0))));
+            generator.transformWeight(transWeight.get(), srcWeight.get());
+        }
+    });
 }
 ConvolutionWinograd3D::~ConvolutionWinograd3D() {
     if (nullptr != mBias) {
@@ -80,42 +90,55 @@ ConvolutionWinograd3D::~ConvolutionWinograd3D() {
 }
 
 ErrorCode ConvolutionWinograd3D::onResize(const std::vector<Tensor *> &inputs, const std::vector<Tensor *> &outputs) {
+    if (!mValid) {
+        return OUT_OF_MEMORY;
+    }
     auto input = inputs[0];
     auto output = outputs[0];
     const int oc = output->length(1), od = output->length(2);
     const int ic = input->length(1), id = input->length(2);
     const int threadNumber = ((CPUBackend*)backend())->threadNumber();
     const int alpha2 = mAlpha * mAlpha;
-    auto CONVOLUTION_TILED_NUMBER = MNNGetConvolutionTileNumber();
+    int ePack, lPack, hPack;
+    MNNGetMatMulPackMode(&ePack, &lPack, &hPack);
 
-    if (mPadMode == PadMode_SAME) {
-        mPads.clear();
-        for (int i = 0; i < 3; ++i) {
-            int inputNeeded = output->length(i + 2) - 1 + mKernels[i];
-            mPads.push_back((inputNeeded - input->length(i + 2)) / 2);
-        }
-    }
+    mPads = CPUConvolution3D::computePads(mCommon, input, output);
 
-    mSourceBuffer.reset(Tensor::createDevice<float>({threadNumber, id, alpha2, UP_DIV(ic, 4), CONVOLUTION_TILED_NUMBER, 4}));
-    mDestBuffer.reset(Tensor::createDevice<float>({threadNumber, od + 1, alpha2, UP_DIV(oc, 4), CONVOLUTION_TILED_NUMBER, 4}));
+    mSourceBuffer.reset(Tensor::createDevice<float>({threadNumber, id, alpha2, UP_DIV(ic, 4), ePack, 4}));
+    mDestBuffer.reset(Tensor::createDevice<float>({threadNumber, od + 1, alpha2, UP_DIV(oc, 4), ePack, 4}));
     mTempBuffer.reset(Tensor::createDevice<float>({threadNumber, 2, alpha2, 4}));
+    mGemmBuffer.reset(Tensor::createDevice<float>({threadNumber, ePack * UP_DIV(ic, 4) * 4}));
+    mCacheBuffer = nullptr;
+    if (hPack % 4 != 0) {
+        auto hDiv = MNNGetC4DivNumber(hPack);
+        mCacheBuffer.reset(Tensor::createDevice<float>({threadNumber, hDiv * ePack * 4 + ePack * 4 * UP_DIV(oc, 4)}));
+    }
 
     bool succ = backend()->onAcquireBuffer(mSourceBuffer.get(), Backend::DYNAMIC);
     succ = succ && backend()->onAcquireBuffer(mDestBuffer.get(), Backend::DYNAMIC);
     succ = succ && backend()->onAcquireBuffer(mTempBuffer.get(), Backend::DYNAMIC);
+    succ = succ && backend()->onAcquireBuffer(mGemmBuffer.get(), Backend::DYNAMIC);
+    if (nullptr != mCacheBuffer) {
+        succ = succ && backend()->onAcquireBuffer(mCacheBuffer.get(), Backend::DYNAMIC);
+    }
     if (!succ) {
         return OUT_OF_MEMORY;
     }
     backend()->onReleaseBuffer(mSourceBuffer.get(), Backend::DYNAMIC);
     backend()->onReleaseBuffer(mDestBuffer.get(), Backend::DYNAMIC);
     backend()->onReleaseBuffer(mTempBuffer.get(), Backend::DYNAMIC);
+    backend()->onReleaseBuffer(mGemmBuffer.get(), Backend::DYNAMIC);
+    if (nullptr != mCacheBuffer) {
+        backend()->onReleaseBuffer(mCacheBuffer.get(), Backend::DYNAMIC);
+    }
     return NO_ERROR;
 }
 
 ErrorCode ConvolutionWinograd3D::onExecute(const std::vector<Tensor *> &inputs, const std::vector<Tensor *> &outputs) {
     auto input   = inputs[0];
     auto output  = outputs[0];
-    auto CONVOLUTION_TILED_NUMBER = MNNGetConvolutionTileNumber();
+    int ePack, lPack, hPack;
+    MNNGetMatMulPackMode(&ePack, &lPack, &hPack);
 
     const int dstUnit = mUnit, srcUnit = mAlpha, srcUnit2 = srcUnit * srcUnit;
     const int outputWidth = output->length(4), outputHeight = output->length(3), outputDepth = output->length(2);
@@ -123,7 +146,7 @@ ErrorCode ConvolutionWinograd3D::onExecute(const std::vector<Tensor *> &inputs,
     const int wUnit = UP_DIV(outputWidth, dstUnit), hUnit = UP_DIV(outputHeight, dstUnit);
     const int ic_4 = UP_DIV(input->length(1), 4), dc_4 = UP_DIV(output->length(1), 4);
     const int padY = mPads[1], padX = mPads[2], padDepth = mPads[0], kernelDepth = mKernels[0];
-    const int totalCount = wUnit * hUnit, tileCount = UP_DIV(totalCount, CONVOLUTION_TILED_NUMBER);
+    const int totalCount = wUnit * hUnit, tileCount = UP_DIV(totalCount, ePack);
 
     auto postFunction = mPostFunction;
     const int threadNumber = std::max(((CPUBackend *)backend())->threadNumber(), 1);
@@ -250,23 +273,39 @@ ErrorCode ConvolutionWinograd3D::onExecute(const std::vector<Tensor *> &inputs,
         }
     };
 
-    auto gemmFunc = [=](int xC, int start, int end, const float* srcOrigin, const float* weight, float* dstOrigin) {
+    std::vector<size_t> parameters(6, 0);
+    parameters[1] = input->length(1);
+    parameters[2] = output->length(1);
+
+    auto gemmFunc = [=](int tId, int xC, int start, int end, const float* srcOrigin, float* dstOrigin) {
+        auto gemmBuffer = mGemmBuffer->host<float>() + tId * mGemmBuffer->stride(0);
+        auto cache      = nullptr == mCacheBuffer ? nullptr : mCacheBuffer->host<float>() + tId * mCacheBuffer->stride(0);
+        auto weight     = mWeight->host<float>();
+        auto matmulParameters = parameters;
+        matmulParameters[3]   = xC * 4 * sizeof(float);
+
         float* tempDst = dstOrigin + outputDepth * srcUnit2 * dc_4 * xC * 4;
         const int element = (end - start) * dc_4 * xC * 4, offset = start * dc_4 * xC * 4;
         for (int od = 0; od < outputDepth; ++od) {
             bool add = false;
             float* _dstOrigin = dstOrigin + (od * srcUnit2 + start) * dc_4 * xC * 4;
             const int srcD = od - padDepth, kdStart = -ALIMIN(srcD, 0), kdEnd = kernelDepth - ALIMAX(srcD + kernelDepth - inputDepth, 0);
+            if (kdStart >= kdEnd) {
+                // The whole depth window is padding
+                ::memset(_dstOrigin, 0, element * sizeof(float));
+                continue;
+            }
             for (int kd = kdStart; kd < kdEnd; ++kd) {
                 const float* _srcOrigin = srcOrigin + (kd + srcD) * srcUnit2 * ic_4 * xC * 4;
-                const float* _weight = weight + kd * srcUnit2 * dc_4 * ic_4 * 16;
+                const float* _weight = weight + kd * mWeight->stride(0);
                 for (int i = start; i < end; ++i) {
-                    if (xC == CONVOLUTION_TILED_NUMBER) {
-                        MNNGemmFloatUnit_4(tempDst + i * dc_4 * xC * 4, _srcOrigin + i * ic_4 * 4 * xC,
-                                           _weight + i * 16 * ic_4 * dc_4, ic_4, xC * 4, dc_4, 0);
+                    MNNPackC4ForMatMul_A(gemmBuffer, _srcOrigin + i * ic_4 * 4 * xC, xC, ic_4 * 4, xC);
+                    if (xC == ePack) {
+                        MNNPackedMatMul(tempDst + i * dc_4 * xC * 4, gemmBuffer, _weight + i * mWeight->stride(1),
+                                        matmulParameters.data(), cache, nullptr, nullptr);
                     } else {
-                        MNNGemmFloatCommon_4(tempDst + i * dc_4 * xC * 4, _srcOrigin + i * ic_4 * 4 * xC,
-                                             _weight + (i * dc_4) * ic_4 * 16, ic_4, xC * 4, dc_4, xC, 0);
+                        MNNPackedMatMulRemain(tempDst + i * dc_4 * xC * 4, gemmBuffer, _weight + i * mWeight->stride(1),
+                                              xC, matmulParameters.data(), cache, nullptr, nullptr);
                     }
                 }
                 if (add) {
@@ -279,10 +318,10 @@ ErrorCode ConvolutionWinograd3D::onExecute(const std::vector<Tensor *> &inputs,
         }
     };
 
-    auto gemmConcurrencyFunc = [=, &gemmFunc](int xC, const float* _srcOrigin, const float* weight, float* _dstOrigin) {
+    auto gemmConcurrencyFunc = [=, &gemmFunc](int xC, const float* _srcOrigin, float* _dstOrigin) {
         MNN_CONCURRENCY_BEGIN(tId, threadNumber) {
             const int step = UP_DIV(srcUnit2, threadNumber);
-            gemmFunc(xC, tId * step, ALIMIN((tId + 1) * step, srcUnit2), _srcOrigin, weight, _dstOrigin);
+            gemmFunc((int)tId, xC, tId * step, ALIMIN((tId + 1) * step, srcUnit2), _srcOrigin, _dstOrigin);
         }
         MNN_CONCURRENCY_END()
     };
@@ -292,26 +331,26 @@ ErrorCode ConvolutionWinograd3D::onExecute(const std::vector<Tensor *> &inputs,
         auto _dstOrigin = mDestBuffer->host<float>() + tId * mDestBuffer->stride(0);
         auto midBuffer0 = mTempBuffer->host<float>() + tId * mTempBuffer->stride(0);
         auto midBuffer1 = midBuffer0 + mTempBuffer->stride(1);
-        for (int tIndex = (int)tId; tIndex < tileCount; tIndex += threadNumber) {
-            int xIndex  = (int)tIndex * CONVOLUTION_TILED_NUMBER;
+        for (int tIndex = tileStart; tIndex < tileEnd; tIndex += tileStep) {
+            int xIndex  = (int)tIndex * ePack;
             int xReamin = totalCount - xIndex;
-            int xC      = xReamin > CONVOLUTION_TILED_NUMBER ? CONVOLUTION_TILED_NUMBER : xReamin;
+            int xC      = xReamin > ePack ? ePack : xReamin;
 
             sourceTransformFunc(xIndex, xC, srcOrigin, _srcOrigin, midBuffer0, midBuffer1);
 
             if (threadNumber != tileStep) {
-                gemmConcurrencyFunc(xC, _srcOrigin, mWeight->host<float>(), _dstOrigin);
+                gemmConcurrencyFunc(xC, _srcOrigin, _dstOrigin);
             } else {
-                gemmFunc(xC, 0, srcUnit2, _srcOrigin, mWeight->host<float>(), _dstOrigin);
+                gemmFunc(tId, xC, 0, srcUnit2, _srcOrigin, _dstOrigin);
             }
 
             destTransformFunc(xIndex, xC, _dstOrigin, dstOrigin, midBuffer0, midBuffer1);
         }
     };
 
-    for (int batchIndex = 0; batchIndex < input->batch(); ++batchIndex) {
-        auto srcOrigin = input->host<float>() + batchIndex * input->stride(0);
-        auto dstOrigin = output->host<float>() + batchIndex * output->stride(0);
+    for (int batchIndex = 0; batchIndex < input->length(0); ++batchIndex) {
+        auto srcOrigin = input->host<float>() + batchIndex * ic_4 * inputDepth * inputHeight * inputWidth * 4;
+        auto dstOrigin = output->host<float>() + batchIndex * dc_4 * outputDepth * outputHeight * outputWidth * 4;
 
         if (tileCount >= threadNumber) {
             MNN_CONCURRENCY_BEGIN(tId, threadNumber) {
@@ -340,9 +379,10 @@ ErrorCode ConvolutionWinograd3D::onExecute(const std::vector<Tensor *> &inputs,
 int ConvolutionWinograd3D::bestWinogradUnit(const Convolution3DCommon *common, const Tensor *inputTensor,
                                           const Tensor *outputTensor, int threadNumber) {
     const int ow = outputTensor->length(4), oh = outputTensor->length(3), oc = outputTensor->length(1);
-    auto CONVOLUTION_TILED_NUMBER = MNNGetConvolutionTileNumber();
+    int ePack, hPack, lPack;
+    MNNGetMatMulPackMode(&ePack, &lPack, &hPack);
 
-    int unit2   = UP_DIV(ow * oh, CONVOLUTION_TILED_NUMBER * threadNumber);
+    int unit2   = UP_DIV(ow * oh, ePack * threadNumber);
     int maxUnit = (int)::sqrtf((float)unit2);
     maxUnit     = std::min(maxUnit, CONVOLUTION_WINOGRAD_MAX_UNIT);
     maxUnit     = std::max(maxUnit, CONVOLUTION_WINOGRAD_MIN_UNIT);
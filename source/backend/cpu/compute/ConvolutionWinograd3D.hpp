@@ -27,9 +27,9 @@ public:
                                 int threadnumber);
 
 private:
+    const Convolution3DCommon *mCommon;
     int mUnit;
     int mAlpha;
-    PadMode mPadMode;
     std::vector<int> mKernels;
     std::vector<int> mPads;
     CPUConvolution3D::POSTFUNCTION mPostFunction;
@@ -38,6 +38,9 @@ private:
     std::shared_ptr<Tensor> mSourceBuffer;
     std::shared_ptr<Tensor> mDestBuffer;
     std::shared_ptr<Tensor> mTempBuffer;
+    std::shared_ptr<Tensor> mGemmBuffer;
+    std::shared_ptr<Tensor> mCacheBuffer;
+    bool mValid = false;
 
     WinogradFunction::TransformFunc mSourceTransform;
     WinogradFunction::TransformFunc mDestTransform;
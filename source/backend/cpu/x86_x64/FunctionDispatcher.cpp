@@ -71,6 +71,9 @@ struct FunctionGroup {
     void (*MNNGemmInt8AddBiasScale_16x4_Unit)(int8_t* dst, const int8_t* src, const int8_t* weight, size_t src_depth_quad, size_t dst_step,
                                               size_t dst_depth_quad, const QuanPostTreatParameters* post) = _SSE_MNNGemmInt8AddBiasScale_16x4_Unit;
     void (*MNNExpC8)(float* dest, const float* source, const float* parameters, size_t countC8) = _SSE_MNNExpC8;
+    float (*MNNExpSum)(float* dest, const float* source, float offset, size_t size)           = _SSE_MNNExpSum;
+    void (*MNNNorm)(float* dest, const float* source, const float* gamma, const float* beta, float epsilon,
+                    size_t size)                                                               = _SSE_MNNNorm;
 };
 
 static FunctionGroup gFunc;
@@ -90,6 +93,8 @@ void MNNFunctionInit() {
         gFunc.MNNPackC4ForMatMul_A  = _AVX_MNNPackC4ForMatMul_A;
         gFunc.MNNConvRunForLineDepthwise = _AVX_MNNConvRunForLineDepthwise;
         gFunc.MNNGemmInt8AddBiasScale_16x4_Unit = _AVX_MNNGemmInt8AddBiasScale_16x4_Unit;
+        gFunc.MNNExpSum             = _AVX_MNNExpSum;
+        gFunc.MNNNorm               = _AVX_MNNNorm;
         if (cpuFlags & libyuv::kCpuHasFMA3) {
             gFunc.MNNGemmFloatUnit_4    = _AVX_MNNGemmFloatUnitFMA_4;
             gFunc.MNNGemmFloatCommon_4  = _AVX_MNNGemmFloatCommonFMA_4;
@@ -120,6 +125,14 @@ void MNNAddC4WithStride(const float* source, float* dest, size_t srcStride, size
     _SSE_MNNAddC4WithStride(source, dest, srcStride, dstStride, count);
 }
 
+void MNNFp32ToBf16(int16_t* dst, const float* src, size_t size) {
+    _SSE_MNNFp32ToBf16(dst, src, size);
+}
+
+void MNNBf16ToFp32(float* dst, const int16_t* src, size_t size) {
+    _SSE_MNNBf16ToFp32(dst, src, size);
+}
+
 void MNNGemmFloatUnit_4(float* dstOrigin, const float* src, const float* weight, size_t src_depth_quad, size_t dst_step,
                         size_t dst_depth_quad, size_t weight_depth_offset) {
     gFunc.MNNGemmFloatUnit_4(dstOrigin, src, weight, src_depth_quad, dst_step, dst_depth_quad, weight_depth_offset);
@@ -348,6 +361,12 @@ void MNNPackedMatMulRemain(float* C, const float* A, const float* B, size_t eSiz
 void MNNExpC8(float* dest, const float* source, const float* parameters, size_t countC8) {
     gFunc.MNNExpC8(dest, source, parameters, countC8);
 }
+float MNNExpSum(float* dest, const float* source, float offset, size_t size) {
+    return gFunc.MNNExpSum(dest, source, offset, size);
+}
+void MNNNorm(float* dest, const float* source, const float* gamma, const float* beta, float epsilon, size_t size) {
+    gFunc.MNNNorm(dest, source, gamma, beta, epsilon, size);
+}
 void MNNConvRunForLineDepthwise(float* dst, const float* src, const float* weight, size_t width, size_t src_w_setup,
                                 size_t fw, size_t fh, size_t dilateX_step, size_t dilateY_step, size_t height,
                                 size_t srcHStep, size_t dstHStep) {
@@ -7,6 +7,7 @@
 //
 
 #include <float.h>
+#include <math.h>
 #include <string.h>
 #include <algorithm>
 #include <limits>
@@ -286,3 +287,97 @@ void _AVX_MNNConvRunForLineDepthwise(float* dst, const float* src, const float*
         }
     }
 }
+
+static inline __m256 _AVX_Exp(__m256 x) {
+    // exp(x) = 2^n * exp(t), t in [-ln2 / 2, ln2 / 2]
+    x          = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(-87.0f)), _mm256_set1_ps(87.0f));
+    auto nInt  = _mm256_cvtps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(1.0f / 0.6931471805599453f)));
+    auto t     = _mm256_sub_ps(x, _mm256_mul_ps(_mm256_cvtepi32_ps(nInt), _mm256_set1_ps(0.6931471805599453f)));
+    auto basic = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(nInt, _mm256_set1_epi32(127)), 23));
+    auto p     = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(1.0f / 120.0f), t), _mm256_set1_ps(1.0f / 24.0f));
+    p          = _mm256_add_ps(_mm256_mul_ps(p, t), _mm256_set1_ps(1.0f / 6.0f));
+    p          = _mm256_add_ps(_mm256_mul_ps(p, t), _mm256_set1_ps(0.5f));
+    p          = _mm256_add_ps(_mm256_mul_ps(p, t), _mm256_set1_ps(1.0f));
+    p          = _mm256_add_ps(_mm256_mul_ps(p, t), _mm256_set1_ps(1.0f));
+    return _mm256_mul_ps(basic, p);
+}
+
+static inline float _AVX_ReduceSum(__m256 v) {
+    auto sum4 = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    float temp[4];
+    _mm_storeu_ps(temp, sum4);
+    return (temp[0] + temp[1]) + (temp[2] + temp[3]);
+}
+
+float _AVX_MNNExpSum(float* dest, const float* source, float offset, size_t size) {
+    auto offsetV = _mm256_set1_ps(offset);
+    auto sumV    = _mm256_set1_ps(0.0f);
+    int sizeC8   = (int)size / 8;
+    for (int i = 0; i < sizeC8; ++i) {
+        auto value = _AVX_Exp(_mm256_sub_ps(_mm256_loadu_ps(source + 8 * i), offsetV));
+        _mm256_storeu_ps(dest + 8 * i, value);
+        sumV = _mm256_add_ps(sumV, value);
+    }
+    auto sum    = _AVX_ReduceSum(sumV);
+    auto remain = size - sizeC8 * 8;
+    if (remain > 0) {
+        float temp[8] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+        ::memcpy(temp, source + sizeC8 * 8, remain * sizeof(float));
+        _mm256_storeu_ps(temp, _AVX_Exp(_mm256_sub_ps(_mm256_loadu_ps(temp), offsetV)));
+        for (int i = 0; i < remain; ++i) {
+            dest[sizeC8 * 8 + i] = temp[i];
+            sum += temp[i];
+        }
+    }
+    return sum;
+}
+
+void _AVX_MNNNorm(float* dest, const float* source, const float* gamma, const float* beta, float epsilon, size_t size) {
+    // Welford on every lane, then merge the lanes and the remain
+    auto meanV = _mm256_set1_ps(0.0f);
+    auto m2V   = _mm256_set1_ps(0.0f);
+    int sizeC8 = (int)size / 8;
+    for (int i = 0; i < sizeC8; ++i) {
+        auto x     = _mm256_loadu_ps(source + 8 * i);
+        auto delta = _mm256_sub_ps(x, meanV);
+        meanV      = _mm256_add_ps(meanV, _mm256_mul_ps(delta, _mm256_set1_ps(1.0f / (i + 1))));
+        m2V        = _mm256_add_ps(m2V, _mm256_mul_ps(delta, _mm256_sub_ps(x, meanV)));
+    }
+    float means[8], m2s[8];
+    _mm256_storeu_ps(means, meanV);
+    _mm256_storeu_ps(m2s, m2V);
+    float count = 0.0f, mean = 0.0f, m2 = 0.0f;
+    if (sizeC8 > 0) {
+        float n = (float)sizeC8;
+        for (int i = 0; i < 8; ++i) {
+            float total = count + n;
+            float delta = means[i] - mean;
+            mean += delta * n / total;
+            m2 += m2s[i] + delta * delta * count * n / total;
+            count = total;
+        }
+    }
+    for (int i = sizeC8 * 8; i < size; ++i) {
+        count += 1.0f;
+        float delta = source[i] - mean;
+        mean += delta / count;
+        m2 += delta * (source[i] - mean);
+    }
+    float invStd = 1.0f / sqrtf(m2 / size + epsilon);
+    auto meanAll = _mm256_set1_ps(mean);
+    auto scale   = _mm256_set1_ps(invStd);
+    for (int i = 0; i < sizeC8; ++i) {
+        auto value = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(source + 8 * i), meanAll), scale);
+        if (nullptr != gamma) {
+            value = _mm256_add_ps(_mm256_mul_ps(value, _mm256_loadu_ps(gamma + 8 * i)), _mm256_loadu_ps(beta + 8 * i));
+        }
+        _mm256_storeu_ps(dest + 8 * i, value);
+    }
+    for (int i = sizeC8 * 8; i < size; ++i) {
+        auto value = (source[i] - mean) * invStd;
+        if (nullptr != gamma) {
+            value = value * gamma[i] + beta[i];
+        }
+        dest[i] = value;
+    }
+}
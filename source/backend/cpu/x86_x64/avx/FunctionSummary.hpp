@@ -89,5 +89,7 @@ void _AVX_MNNConvRunForLineDepthwise(float* dst, const float* src, const float*
                                 size_t fw, size_t fh, size_t dilateX_step, size_t dilateY_step, size_t height,
                                      size_t srcHStep, size_t dstHStep);
 void _AVX_MNNGemmInt8AddBiasScale_16x4_Unit(int8_t* dst, const int8_t* src, const int8_t* weight, size_t src_depth_quad, size_t dst_step, size_t dst_depth_quad, const QuanPostTreatParameters* post);
+float _AVX_MNNExpSum(float* dest, const float* source, float offset, size_t size);
+void _AVX_MNNNorm(float* dest, const float* source, const float* gamma, const float* beta, float epsilon, size_t size);
 
 }
@@ -7,6 +7,7 @@
 //
 
 #include <emmintrin.h>
+#include <math.h>
 #include <string.h>
 #include <algorithm>
 #include "core/Macro.h"
@@ -59,6 +60,41 @@ void _SSE_MNNCopyC4WithStride(const float* source, float* dest, size_t srcStride
     }
 }
 
+void _SSE_MNNFp32ToBf16(int16_t* dst, const float* src, size_t size) {
+    auto sizeC8    = size / 8;
+    auto one       = _mm_set1_epi32(1);
+    auto roundBias = _mm_set1_epi32(0x7FFF);
+    for (int i = 0; i < sizeC8; ++i) {
+        auto s0 = _mm_castps_si128(_mm_loadu_ps(src + 8 * i));
+        auto s1 = _mm_castps_si128(_mm_loadu_ps(src + 8 * i + 4));
+        s0      = _mm_add_epi32(s0, _mm_add_epi32(roundBias, _mm_and_si128(_mm_srli_epi32(s0, 16), one)));
+        s1      = _mm_add_epi32(s1, _mm_add_epi32(roundBias, _mm_and_si128(_mm_srli_epi32(s1, 16), one)));
+        s0      = _mm_srli_epi32(s0, 16);
+        s1      = _mm_srli_epi32(s1, 16);
+        _mm_storeu_si128((__m128i*)(dst + 8 * i), _mm_packus_epi32(s0, s1));
+    }
+    auto srcU = (const uint32_t*)src;
+    for (int i = sizeC8 * 8; i < size; ++i) {
+        auto u = srcU[i];
+        u      = u + 0x7FFF + ((u >> 16) & 1);
+        dst[i] = (int16_t)(u >> 16);
+    }
+}
+
+void _SSE_MNNBf16ToFp32(float* dst, const int16_t* src, size_t size) {
+    auto sizeC8 = size / 8;
+    auto zero   = _mm_setzero_si128();
+    for (int i = 0; i < sizeC8; ++i) {
+        auto s = _mm_loadu_si128((const __m128i*)(src + 8 * i));
+        _mm_storeu_ps(dst + 8 * i, _mm_castsi128_ps(_mm_unpacklo_epi16(zero, s)));
+        _mm_storeu_ps(dst + 8 * i + 4, _mm_castsi128_ps(_mm_unpackhi_epi16(zero, s)));
+    }
+    auto dstU = (uint32_t*)dst;
+    for (int i = sizeC8 * 8; i < size; ++i) {
+        dstU[i] = ((uint32_t)(uint16_t)src[i]) << 16;
+    }
+}
+
 void _SSE_MNNAddC4WithStride(const float* source, float* dest, size_t srcStride, size_t dstStride, size_t count) {
     for (int i = 0; i < count; ++i) {
         auto s = source + i * srcStride;
@@ -215,6 +251,100 @@ void _SSE_MNNExpC8(float* dest, const float* source, const float* parameters, si
         auto c8        = _mm_mul_ps(c7, t);
         auto c9        = _mm_add_ps(c8, p2);
         auto expRemain = c9;
-        _mm_store_ps(dest + 4 * i, _mm_mul_ps(expBasic, expRemain));
+        // dest is not aligned for the blocks of MNNSoftmax and the inside parts of CPUSoftmax
+        _mm_storeu_ps(dest + 4 * i, _mm_mul_ps(expBasic, expRemain));
+    }
+}
+
+static inline __m128 _SSE_Exp(__m128 x) {
+    // exp(x) = 2^n * exp(t), t in [-ln2 / 2, ln2 / 2]
+    x          = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-87.0f)), _mm_set1_ps(87.0f));
+    auto nInt  = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(1.0f / 0.6931471805599453f)));
+    auto t     = _mm_sub_ps(x, _mm_mul_ps(_mm_cvtepi32_ps(nInt), _mm_set1_ps(0.6931471805599453f)));
+    auto basic = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(nInt, _mm_set1_epi32(127)), 23));
+    auto p     = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(1.0f / 120.0f), t), _mm_set1_ps(1.0f / 24.0f));
+    p          = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(1.0f / 6.0f));
+    p          = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(0.5f));
+    p          = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(1.0f));
+    p          = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(1.0f));
+    return _mm_mul_ps(basic, p);
+}
+
+static inline float _SSE_ReduceSum(__m128 v) {
+    float temp[4];
+    _mm_storeu_ps(temp, v);
+    return (temp[0] + temp[1]) + (temp[2] + temp[3]);
+}
+
+float _SSE_MNNExpSum(float* dest, const float* source, float offset, size_t size) {
+    auto offsetV = _mm_set1_ps(offset);
+    auto sumV    = _mm_set1_ps(0.0f);
+    int sizeC4   = (int)size / 4;
+    for (int i = 0; i < sizeC4; ++i) {
+        auto value = _SSE_Exp(_mm_sub_ps(_mm_loadu_ps(source + 4 * i), offsetV));
+        _mm_storeu_ps(dest + 4 * i, value);
+        sumV = _mm_add_ps(sumV, value);
+    }
+    auto sum    = _SSE_ReduceSum(sumV);
+    auto remain = size - sizeC4 * 4;
+    if (remain > 0) {
+        float temp[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+        ::memcpy(temp, source + sizeC4 * 4, remain * sizeof(float));
+        _mm_storeu_ps(temp, _SSE_Exp(_mm_sub_ps(_mm_loadu_ps(temp), offsetV)));
+        for (int i = 0; i < remain; ++i) {
+            dest[sizeC4 * 4 + i] = temp[i];
+            sum += temp[i];
+        }
+    }
+    return sum;
+}
+
+void _SSE_MNNNorm(float* dest, const float* source, const float* gamma, const float* beta, float epsilon, size_t size) {
+    // Welford on every lane, then merge the lanes and the remain
+    auto meanV = _mm_set1_ps(0.0f);
+    auto m2V   = _mm_set1_ps(0.0f);
+    int sizeC4 = (int)size / 4;
+    for (int i = 0; i < sizeC4; ++i) {
+        auto x     = _mm_loadu_ps(source + 4 * i);
+        auto delta = _mm_sub_ps(x, meanV);
+        meanV      = _mm_add_ps(meanV, _mm_mul_ps(delta, _mm_set1_ps(1.0f / (i + 1))));
+        m2V        = _mm_add_ps(m2V, _mm_mul_ps(delta, _mm_sub_ps(x, meanV)));
+    }
+    float means[4], m2s[4];
+    _mm_storeu_ps(means, meanV);
+    _mm_storeu_ps(m2s, m2V);
+    float count = 0.0f, mean = 0.0f, m2 = 0.0f;
+    if (sizeC4 > 0) {
+        float n = (float)sizeC4;
+        for (int i = 0; i < 4; ++i) {
+            float total = count + n;
+            float delta = means[i] - mean;
+            mean += delta * n / total;
+            m2 += m2s[i] + delta * delta * count * n / total;
+            count = total;
+        }
+    }
+    for (int i = sizeC4 * 4; i < size; ++i) {
+        count += 1.0f;
+        float delta = source[i] - mean;
+        mean += delta / count;
+        m2 += delta * (source[i] - mean);
+    }
+    float invStd = 1.0f / sqrtf(m2 / size + epsilon);
+    auto meanAll = _mm_set1_ps(mean);
+    auto scale   = _mm_set1_ps(invStd);
+    for (int i = 0; i < sizeC4; ++i) {
+        auto value = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(source + 4 * i), meanAll), scale);
+        if (nullptr != gamma) {
+            value = _mm_add_ps(_mm_mul_ps(value, _mm_loadu_ps(gamma + 4 * i)), _mm_loadu_ps(beta + 4 * i));
+        }
+        _mm_storeu_ps(dest + 4 * i, value);
+    }
+    for (int i = sizeC4 * 4; i < size; ++i) {
+        auto value = (source[i] - mean) * invStd;
+        if (nullptr != gamma) {
+            value = value * gamma[i] + beta[i];
+        }
+        dest[i] = value;
     }
 }
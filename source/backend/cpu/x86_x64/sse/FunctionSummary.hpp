@@ -75,3 +75,7 @@ void _SSE_MNNConvRunForLineDepthwise(float* dst, const float* src, const float*
 void _SSE_MNNGemmInt8AddBiasScale_16x4_Unit(int8_t* dst, const int8_t* src, const int8_t* weight, size_t src_depth_quad, size_t dst_step,
                                             size_t dst_depth_quad, const QuanPostTreatParameters* post);
 void _SSE_MNNExpC8(float* dest, const float* source, const float* parameters, size_t countC8);
+void _SSE_MNNFp32ToBf16(int16_t* dst, const float* src, size_t size);
+void _SSE_MNNBf16ToFp32(float* dst, const int16_t* src, size_t size);
+float _SSE_MNNExpSum(float* dest, const float* source, float offset, size_t size);
+void _SSE_MNNNorm(float* dest, const float* source, const float* gamma, const float* beta, float epsilon, size_t size);
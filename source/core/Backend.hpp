@@ -15,6 +15,8 @@
 #include <MNN/Tensor.hpp>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <string>
 #include <vector>
 #include "Command.hpp"
 #include "NonCopyable.hpp"
@@ -170,8 +172,26 @@ public:
         return mType;
     }
 
+    /** Packed weights shared by the sessions of one Interpreter, the key is made by the backend. A weight is freed
+        when no execution holds it. The session sets it to the backends it creates, so the Interpreters sharing
+        a RuntimeInfo don't share their weights */
+    struct SharedWeights {
+        std::mutex lock;
+        std::map<std::string, std::weak_ptr<Tensor>> weights;
+        // Only the ops in the model buffer are shared, it's empty after the buffer is released
+        const void* buffer = nullptr;
+        size_t size        = 0;
+    };
+    void setSharedWeights(std::shared_ptr<SharedWeights> weights) {
+        mSharedWeights = weights;
+    }
+    std::shared_ptr<SharedWeights> getSharedWeights() const {
+        return mSharedWeights;
+    }
+
 private:
     const MNNForwardType mType;
+    std::shared_ptr<SharedWeights> mSharedWeights;
 };
 
 /** Each backend belong to a runtime*/
@@ -219,6 +239,11 @@ public:
     virtual std::pair<const void*, size_t> onGetCache() {
         return std::make_pair(nullptr, 0);
     }
+
+    // Collect the data for onGetCache while the next sessions are created
+    virtual void onRecordCache(bool record) {
+        // Do nothing
+    }
 };
 
 /** abstract Runtime register */
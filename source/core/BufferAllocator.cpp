@@ -8,10 +8,35 @@
 
 #include "core/BufferAllocator.hpp"
 #include "core/Macro.h"
+#if defined(__linux__) && !defined(__ANDROID__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 //#define DUMP_USAGE
 //#define MNN_DEBUG_MEMORY
 namespace MNN {
+// Prefer the pages of [pointer, pointer + size) on the node, they are placed there when touched first
+static void _bindNode(void* pointer, size_t size, int node) {
+#if defined(__linux__) && !defined(__ANDROID__) && defined(SYS_mbind)
+    const int MPOL_PREFERRED_MODE = 1;
+    const int MPOL_MF_MOVE_FLAG   = 1 << 1;
+    const size_t bits             = 8 * sizeof(unsigned long);
+    if (node < 0 || node >= (int)(64 * bits)) {
+        return;
+    }
+    auto page  = (size_t)sysconf(_SC_PAGESIZE);
+    auto begin = ((size_t)pointer + page - 1) / page * page;
+    auto end   = ((size_t)pointer + size) / page * page;
+    if (end <= begin) {
+        return;
+    }
+    unsigned long mask[64] = {0};
+    mask[node / bits]      = 1UL << (node % bits);
+    syscall(SYS_mbind, (void*)begin, end - begin, MPOL_PREFERRED_MODE, mask, 64 * bits, MPOL_MF_MOVE_FLAG);
+#endif
+}
+
 BufferAllocator::Node::~Node() {
     if (nullptr == parent) {
         MNNMemoryFreeAlign(pointer);
@@ -23,6 +48,7 @@ void* BufferAllocator::alloc(size_t size, bool seperate) {
     MNN_PRINT("Alloc: %f\n", memoryUsed);
 #endif
     void* pointer = nullptr;
+    mAllocCount++;
     // reuse if possible
     if (!seperate) {
         if (nullptr != mCurrentFreeList) {
@@ -42,6 +68,9 @@ void* BufferAllocator::alloc(size_t size, bool seperate) {
     if (nullptr == pointer) {
         return nullptr;
     }
+    if (mNode >= 0) {
+        _bindNode(pointer, size, mNode);
+    }
     mTotalSize += size;
 
     // save node
@@ -120,10 +149,12 @@ bool BufferAllocator::free(void* pointer, bool needRelease) {
 }
 
 void BufferAllocator::release(bool allRelease) {
-    MNN_ASSERT(mGroups.empty());
+    MNN_ASSERT(mBarriers.empty());
     if (allRelease) {
         mUsedList.clear();
         mFreeList.clear();
+        mFrozenList.clear();
+        mFrozenCount = 0;
         mTotalSize = 0;
         return;
     }
@@ -136,28 +167,65 @@ void BufferAllocator::release(bool allRelease) {
     mFreeList.clear();
 }
 
+void BufferAllocator::freeze() {
+    MNN_ASSERT(mBarriers.empty());
+    for (auto& iter : mFreeList) {
+        // Count the frozen node as used, so the parent isn't merged back by the free of its other parts
+        if (nullptr != iter.second->parent) {
+            iter.second->parent->useCount += 1;
+        }
+        mFrozenList.insert(iter);
+    }
+    mFreeList.clear();
+    mFrozenCount++;
+}
+
+void BufferAllocator::unfreeze() {
+    MNN_ASSERT(mFrozenCount > 0);
+    mFrozenCount--;
+    if (mFrozenCount > 0) {
+        return;
+    }
+    auto frozenList = std::move(mFrozenList);
+    mFrozenList.clear();
+    for (auto& iter : frozenList) {
+        returnMemory(&mFreeList, iter.second);
+    }
+}
+
 void BufferAllocator::barrierBegin() {
-    MNN_ASSERT(mGroups.empty());
+    Barrier barrier;
+    barrier.parent = mCurrentFreeList;
+    mBarriers.emplace_back(std::move(barrier));
 }
 
 void BufferAllocator::barrierEnd() {
-    for (auto& freeGroup : mGroups) {
+    MNN_ASSERT(!mBarriers.empty());
+    auto& barrier = mBarriers.back();
+    for (auto& freeGroup : barrier.groups) {
         auto freeList = *freeGroup;
         for (auto& iter : freeList) {
-            returnMemory(&mFreeList, iter.second);
+            if (nullptr != barrier.parent) {
+                returnMemory(barrier.parent, iter.second, false);
+            } else {
+                returnMemory(&mFreeList, iter.second);
+            }
         }
     }
-    mGroups.clear();
+    mCurrentFreeList = barrier.parent;
+    mBarriers.pop_back();
 }
 
 void BufferAllocator::beginGroup() {
+    MNN_ASSERT(!mBarriers.empty());
     std::shared_ptr<FREELIST> newFreeList(new FREELIST);
     mCurrentFreeList = newFreeList.get();
-    mGroups.emplace_back(newFreeList);
+    mBarriers.back().groups.emplace_back(newFreeList);
 }
 
 void BufferAllocator::endGroup() {
-    mCurrentFreeList = nullptr;
+    MNN_ASSERT(!mBarriers.empty());
+    mCurrentFreeList = mBarriers.back().parent;
 }
 
 void* BufferAllocator::getFromFreeList(FREELIST* list, size_t size, bool permiteSplit) {
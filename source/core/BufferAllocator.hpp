@@ -23,8 +23,9 @@ public:
     /**
      * @brief init buffer allocator with pointer alignment.
      * @param align given pointer alignment.
+     * @param node  NUMA node the pages of the new memories are placed on, -1 for the default policy.
      */
-    BufferAllocator(int align = MNN_MEMORY_ALIGN_DEFAULT) : mAlign(align) {
+    BufferAllocator(int align = MNN_MEMORY_ALIGN_DEFAULT, int node = -1) : mAlign(align), mNode(node) {
         // nothing to do
     }
     /**
@@ -70,6 +71,14 @@ public:
         return mTotalSize;
     }
 
+    /**
+     * @brief query how many times alloc has been called.
+     * @return alloc count.
+     */
+    size_t allocCount() const {
+        return mAllocCount;
+    }
+
     /*
      For multi thread case,
      we must assume that the memory use by different thread don't conflict
@@ -77,12 +86,21 @@ public:
      begin group / end group means the memory allocated belong to one thread
      different group must use different memory,
      but the origin freelist can be used by every group
+     barrier can be nested inside a group, the memory of the inner groups
+     is given back to the outer group at the end of the inner barrier
      */
     void barrierBegin();
     void barrierEnd();
     void beginGroup();
     void endGroup();
 
+    /**
+     * @brief take the free memories out of alloc and release until unfreeze, so the memory planned before stays
+     * valid while a new plan is made aside. can be nested, the memories come back at the last unfreeze.
+     */
+    void freeze();
+    void unfreeze();
+
 private:
     class Node {
     public:
@@ -102,10 +120,19 @@ private:
     std::map<void*, std::shared_ptr<Node>> mUsedList;
     FREELIST mFreeList;
     size_t mTotalSize   = 0;
+    size_t mAllocCount  = 0;
     const size_t mAlign = 0;
+    const int mNode     = -1;
 
+    struct Barrier {
+        // The freelist of the group that contains this barrier, nullptr for top level
+        FREELIST* parent = nullptr;
+        std::vector<std::shared_ptr<FREELIST>> groups;
+    };
     FREELIST* mCurrentFreeList = nullptr;
-    std::vector<std::shared_ptr<FREELIST>> mGroups;
+    std::vector<Barrier> mBarriers;
+    FREELIST mFrozenList;
+    int mFrozenCount = 0;
 };
 } // namespace MNN
 #endif
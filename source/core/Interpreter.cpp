@@ -27,10 +27,15 @@ struct Content {
     std::map<const Tensor*, const Session*> tensorMap;
     Interpreter::SessionMode callBackMode = Interpreter::Session_Debug;
     Interpreter::SessionMode inputMode    = Interpreter::Session_Input_Inside;
+    Interpreter::SessionMode scheduleMode = Interpreter::Session_Schedule_Serial;
+    Interpreter::SessionMode layoutMode   = Interpreter::Session_Layout_Keep;
+    Interpreter::SessionMode resizeMode   = Interpreter::Session_Resize_Full;
     AutoStorage<uint8_t> cacheBuffer;
     size_t cacheOffset = 0;
     std::string cacheFile;
     std::mutex lock;
+    // Packed weights shared by the sessions
+    std::shared_ptr<Backend::SharedWeights> sharedWeights{new Backend::SharedWeights};
 };
 
 Interpreter* Interpreter::createFromFile(const char* file) {
@@ -108,6 +113,12 @@ Interpreter* Interpreter::createFromBufferInternal(Content* net) {
 void Interpreter::setSessionMode(SessionMode mode) {
     if (mode == Session_Input_Inside || mode == Session_Input_User) {
         mNet->inputMode = mode;
+    } else if (mode == Session_Schedule_Serial || mode == Session_Schedule_Parallel) {
+        mNet->scheduleMode = mode;
+    } else if (mode == Session_Layout_Keep || mode == Session_Layout_Propagate) {
+        mNet->layoutMode = mode;
+    } else if (mode == Session_Resize_Full || mode == Session_Resize_Incremental) {
+        mNet->resizeMode = mode;
     } else {
         mNet->callBackMode = mode;
     }
@@ -182,9 +193,16 @@ Session* Interpreter::createMultiPathSession(const std::vector<ScheduleConfig>&
     std::unique_lock<std::mutex> _l(mNet->lock);
     auto info           = Schedule::schedule(mNet->net, configs);
     auto validForResize = info.validForResize;
+    {
+        std::unique_lock<std::mutex> _sl(mNet->sharedWeights->lock);
+        mNet->sharedWeights->buffer = mNet->buffer.get();
+        mNet->sharedWeights->size   = mNet->buffer.size();
+    }
     RuntimeInfo rt = runtime;
     auto newSession =
-        std::unique_ptr<Session>(new Session(std::move(info), mNet->callBackMode, mNet->inputMode, std::move(rt)));
+        std::unique_ptr<Session>(new Session(std::move(info), mNet->callBackMode, mNet->inputMode, std::move(rt),
+                                             mNet->scheduleMode, mNet->layoutMode, mNet->sharedWeights,
+                                             mNet->resizeMode));
     if (!newSession->valid()) {
         MNN_PRINT("Invalide Session!!\n");
         return nullptr;
@@ -195,6 +213,9 @@ Session* Interpreter::createMultiPathSession(const std::vector<ScheduleConfig>&
         valid = result->loadCache(mNet->cacheBuffer.get() + mNet->cacheOffset,
                                   mNet->cacheBuffer.size() - mNet->cacheOffset);
     }
+    if ((!mNet->cacheFile.empty()) && (!valid)) {
+        result->recordCache(true);
+    }
     if (validForResize && mNet->inputMode == Session_Input_Inside) {
         result->resize(mNet->net->usage() == Usage_INFERENCE_STATIC);
     }
@@ -235,6 +256,7 @@ Session* Interpreter::createMultiPathSession(const std::vector<ScheduleConfig>&
         }
     }
     // Reset cache
+    result->recordCache(false);
     result->loadCache(nullptr, 0);
 
     mNet->sessions.emplace_back(std::move(newSession));
@@ -340,6 +362,29 @@ ErrorCode Interpreter::runSessionWithCallBackInfo(const Session* session, const
     return session->runWithCallBack(before, callBack, sync);
 }
 
+bool Interpreter::setSessionStates(Session* session, const std::vector<std::pair<std::string, std::string>>& states) {
+    std::unique_lock<std::mutex> _l(mNet->lock);
+    auto& inputs  = session->getInputAll();
+    auto& outputs = session->getOutputAll();
+    std::vector<std::pair<Tensor*, Tensor*>> tensors;
+    for (auto& s : states) {
+        auto inputIter  = inputs.find(s.first);
+        auto outputIter = outputs.find(s.second);
+        if (inputIter == inputs.end() || outputIter == outputs.end()) {
+            MNN_ERROR("Can't find state pair: %s -> %s\n", s.first.c_str(), s.second.c_str());
+            return false;
+        }
+        tensors.emplace_back(std::make_pair(inputIter->second, outputIter->second));
+    }
+    session->setStates(std::move(tensors));
+    return true;
+}
+
+void Interpreter::resetSessionStates(Session* session) {
+    std::unique_lock<std::mutex> _l(mNet->lock);
+    session->resetStates();
+}
+
 const Backend* Interpreter::getBackend(const Session* session, const Tensor* tensor) const {
     return session->getBackEnd(tensor);
 }
@@ -348,6 +393,11 @@ void Interpreter::releaseModel() {
     std::unique_lock<std::mutex> _l(mNet->lock);
     mNet->buffer.release();
     mNet->cacheBuffer.release();
+    {
+        std::unique_lock<std::mutex> _sl(mNet->sharedWeights->lock);
+        mNet->sharedWeights->buffer = nullptr;
+        mNet->sharedWeights->size   = 0;
+    }
     for (auto& iter : mNet->sessions) {
         iter->releaseCache();
     }
@@ -8,10 +8,19 @@
 
 #include "core/Pipeline.hpp"
 #include <string.h>
+#include <algorithm>
+#include <functional>
+#include <set>
+#include "backend/cpu/CPUBackend.hpp"
 #include "core/Backend.hpp"
+#include "core/BufferAllocator.hpp"
+#include "core/DirectedAcyclicGraph.hpp"
 #include "core/Macro.h"
 #include "core/TensorUtils.hpp"
 #include "core/WrapExecution.hpp"
+#ifdef MNN_USE_THREAD_POOL
+#include "backend/cpu/ThreadPool.hpp"
+#endif
 #include "geometry/GeometryComputerUtils.hpp"
 #include "shape/SizeComputer.hpp"
 //#define MNN_OPEN_TIME_TRACE
@@ -20,6 +29,8 @@
 //#define MNN_DEBUG_PREPARE
 
 #define MNN_FAST_RESIZE
+// Commands below this flops (M) are computed by one thread when run concurrently
+#define MNN_PARALLEL_SMALL_OP_FLOPS 1.0f
 namespace MNN {
 
 OperatorInfo::OperatorInfo() {
@@ -85,7 +96,7 @@ void Pipeline::UnitInfo::setUp(const Command& command, int index) {
 Pipeline::Pipeline(std::vector<Schedule::PipelineInfo>&& infos, std::shared_ptr<Backend> backend,
                    std::shared_ptr<Backend> cpuBackend, bool allocInput, bool geometry)
 #ifndef MNN_BUILD_MINI
-    : mContext(cpuBackend, true), mUseGeometry(geometry) {
+    : mContext(cpuBackend, true, backend->type()), mUseGeometry(geometry) {
 #else
 {
 #endif
@@ -136,16 +147,269 @@ ErrorCode Pipeline::encode(bool isStatic) {
         }
         mInit = true;
         GeometryComputerUtils::shapeComputeAndGeometryTransform(mInfo, mBuffer, mContext, mBackupBackend, mUseGeometry);
+        mLayoutSavedBytes = 0;
+        if (mPropagateLayout && mUseGeometry && mBackend->type() == MNN_FORWARD_CPU) {
+            mLayoutSavedBytes = GeometryComputerUtils::propagateLayout(mBuffer);
+        }
+#endif
+    }
+    return NO_ERROR;
+}
+
+class CommandNodeDef : public NodeDef<int> {
+public:
+    CommandNodeDef(int index) {
+        mIndex = index;
+    }
+    virtual shared_ptr<Node<int>> makeNode() override {
+        shared_ptr<Node<int>> ptr = make_shared<Node<int>>();
+        ptr->setData(mIndex);
+        return ptr;
+    }
+
+private:
+    int mIndex;
+};
+
+void Pipeline::_buildStages() {
+    mStages.clear();
+    auto& commands = mBuffer.command;
+    const int size = (int)commands.size();
+    if (0 == size) {
+        return;
+    }
+    int numberThread = 1;
+#ifdef MNN_USE_THREAD_POOL
+    if (mParallelSchedule && mBackend->type() == MNN_FORWARD_CPU) {
+        numberThread = static_cast<CPUBackend*>(mBackend.get())->threadNumber();
+    }
 #endif
+    Stage serial;
+    serial.begin    = 0;
+    serial.end      = size;
+    serial.parallel = false;
+    if (numberThread <= 1 || size < 2) {
+        mStages.emplace_back(serial);
+        return;
+    }
+    // Build dependency from command's inputs / outputs, each tensor should have only one producer
+    std::map<const Tensor*, int> producers;
+    for (int i = 0; i < size; ++i) {
+        for (auto t : commands[i].outputs) {
+            if (producers.find(t) != producers.end()) {
+                mStages.emplace_back(serial);
+                return;
+            }
+            producers.insert(std::make_pair(t, i));
+        }
+    }
+    DirectedAcyclicGraph<int> graph;
+    std::vector<shared_ptr<Node<int>>> nodes(size);
+    for (int i = 0; i < size; ++i) {
+        CommandNodeDef def(i);
+        nodes[i] = graph.AddNode(def);
+    }
+    for (int i = 0; i < size; ++i) {
+        std::set<int> depends;
+        // The origin of a region can be virtual too
+        std::function<void(const Tensor*)> addDepend = [&](const Tensor* t) {
+            auto des = TensorUtils::getDescribe(t);
+            if (des->memoryType == Tensor::InsideDescribe::MEMORY_VIRTUAL) {
+                for (auto& r : des->regions) {
+                    if (nullptr != r.origin) {
+                        addDepend(r.origin);
+                    }
+                }
+                return;
+            }
+            auto iter = producers.find(t);
+            if (iter != producers.end() && iter->second != i) {
+                depends.insert(iter->second);
+            }
+        };
+        for (auto t : commands[i].inputs) {
+            addDepend(t);
+        }
+        for (auto d : depends) {
+            graph.AddEdge(nodes[d], nodes[i]);
+        }
+    }
+    std::vector<shared_ptr<Node<int>>> order;
+    if (!graph.GetPostOrder(order)) {
+        mStages.emplace_back(serial);
+        return;
+    }
+    // The level of a command is the length of the longest path reaching it
+    std::vector<int> levels(size, 0);
+    for (auto& node : order) {
+        auto index = node->getData();
+        for (auto& edge : node->getInEdges()) {
+            auto src = edge->getSrc().lock();
+            if (nullptr != src) {
+                levels[index] = std::max(levels[index], levels[src->getData()] + 1);
+            }
+        }
+    }
+    std::vector<int> sortIndexes(size);
+    for (int i = 0; i < size; ++i) {
+        sortIndexes[i] = i;
+    }
+    std::stable_sort(sortIndexes.begin(), sortIndexes.end(),
+                     [&levels](int a, int b) { return levels[a] < levels[b]; });
+    std::vector<Command> sortedCommands(size);
+    for (int i = 0; i < size; ++i) {
+        sortedCommands[i] = std::move(commands[sortIndexes[i]]);
+    }
+    commands = std::move(sortedCommands);
+    // Split to stages, run a stage concurrently if the commands can share the threads evenly or all of them are small
+    for (int i = 0; i < size;) {
+        Stage stage;
+        stage.begin    = i;
+        stage.end      = i + 1;
+        auto level     = levels[sortIndexes[i]];
+        while (stage.end < size && levels[sortIndexes[stage.end]] == level) {
+            stage.end++;
+        }
+        auto number    = stage.end - stage.begin;
+        stage.parallel = number > 1;
+        if (stage.parallel && number < numberThread && 0 != numberThread % number) {
+            for (int j = stage.begin; j < stage.end; ++j) {
+                auto& cmd  = commands[j];
+                auto flops = SizeComputer::computeFlops(cmd.op, cmd.inputs, cmd.outputs);
+                if (flops > MNN_PARALLEL_SMALL_OP_FLOPS) {
+                    stage.parallel = false;
+                    break;
+                }
+            }
+        }
+        // Merge serial stages
+        if ((!stage.parallel) && (!mStages.empty()) && (!mStages.back().parallel)) {
+            mStages.back().end = stage.end;
+        } else {
+            mStages.emplace_back(stage);
+        }
+        i = stage.end;
+    }
+}
+
+ErrorCode Pipeline::_executeStage(const Stage& stage) {
+    if (!stage.parallel) {
+        for (int i = stage.begin; i < stage.end; ++i) {
+            auto& cmd = mBuffer.command[i];
+            auto code = mExecutions[i]->onExecute(cmd.inputs, cmd.outputs);
+            if (NO_ERROR != code) {
+                return code;
+            }
+        }
+        return NO_ERROR;
+    }
+#ifdef MNN_USE_THREAD_POOL
+    // The commands share the threads of the session, each of them computes with threadNumber / commands threads
+    std::vector<ErrorCode> codes(stage.end - stage.begin, NO_ERROR);
+    std::pair<std::function<void(int)>, int> task;
+    task.second = (int)codes.size();
+    task.first  = [&](int index) {
+        auto& cmd    = mBuffer.command[stage.begin + index];
+        codes[index] = mExecutions[stage.begin + index]->onExecute(cmd.inputs, cmd.outputs);
+    };
+    auto cpuBackend = static_cast<CPUBackend*>(mBackend.get());
+    ThreadPool::enqueueBranches(std::move(task), cpuBackend->taskIndex(), cpuBackend->threadNumber());
+    for (auto code : codes) {
+        if (NO_ERROR != code) {
+            return code;
+        }
     }
+#endif
     return NO_ERROR;
 }
 
+static std::vector<size_t> _shapeKey(const Tensor* t) {
+    std::vector<size_t> key;
+    key.emplace_back((size_t)TensorUtils::getDescribe(t)->dimensionFormat);
+    key.emplace_back((size_t)t->getType().code);
+    key.emplace_back((size_t)t->getType().bits);
+    key.emplace_back((size_t)t->dimensions());
+    for (int i = 0; i < t->dimensions(); ++i) {
+        key.emplace_back((size_t)t->length(i));
+    }
+    return key;
+}
+
+// Index of the tensors read by the command, -1, then the tensors it writes. The tensors are numbered by their first use
+// as the tensors made by geometry are new in every encode
+static std::vector<int> _commandTensors(const Command& cmd, std::vector<const Tensor*>& tensors,
+                                        std::map<const Tensor*, int>& indexes) {
+    std::vector<int> result;
+    auto addTensor = [&](const Tensor* t) {
+        auto iter = indexes.find(t);
+        if (iter == indexes.end()) {
+            iter = indexes.insert(std::make_pair(t, (int)tensors.size())).first;
+            tensors.emplace_back(t);
+        }
+        result.emplace_back(iter->second);
+    };
+    for (auto t : cmd.inputs) {
+        auto des = TensorUtils::getDescribe(t);
+        if (des->memoryType == Tensor::InsideDescribe::MEMORY_VIRTUAL) {
+            for (auto& r : des->regions) {
+                addTensor(r.origin);
+            }
+        } else {
+            addTensor(t);
+        }
+    }
+    result.emplace_back(-1);
+    for (auto t : cmd.outputs) {
+        addTensor(t);
+    }
+    return result;
+}
+
+std::vector<size_t> Pipeline::_resizeKey(const Command& cmd) const {
+    std::vector<size_t> key;
+    // The commands made by geometry are made again by every encode, only the executions of the model's ops are kept
+    if ((!cmd.buffer.empty()) || cmd.op->type() == OpType_Raster) {
+        return key;
+    }
+    key.emplace_back((size_t)cmd.op);
+    auto addTensors = [&key](const std::vector<Tensor*>& tensors) {
+        key.emplace_back(tensors.size());
+        for (auto t : tensors) {
+            if (TensorUtils::getDescribe(t)->memoryType == Tensor::InsideDescribe::MEMORY_VIRTUAL) {
+                return false;
+            }
+            key.emplace_back((size_t)t);
+            key.emplace_back((size_t)t->host<void>());
+            auto shape = _shapeKey(t);
+            key.insert(key.end(), shape.begin(), shape.end());
+        }
+        return true;
+    };
+    if (!addTensors(cmd.inputs) || !addTensors(cmd.outputs)) {
+        key.clear();
+    }
+    return key;
+}
+
+bool Pipeline::_keepShape(const std::vector<int>& indexes, const std::vector<const Tensor*>& tensors) const {
+    for (auto index : indexes) {
+        if (index < 0) {
+            continue;
+        }
+        auto iter = mPlanHosts.find(index);
+        if (iter != mPlanHosts.end() && iter->second.second != _shapeKey(tensors[index])) {
+            return false;
+        }
+    }
+    return true;
+}
+
 ErrorCode Pipeline::allocMemory(bool supportDebug) {
+    // The commands that don't change reuse the executions of the last resize
+    auto lastExecutions = std::move(mExecutions);
     mExecutions.clear();
     mDebugInfos.clear();
-    mBackend->onClearBuffer();
-    mBackupBackend->onClearBuffer();
+    mResizeSkipped = 0;
 
     /** Prepare Execution And Alloc*/
     // Compute refCount
@@ -164,11 +428,100 @@ ErrorCode Pipeline::allocMemory(bool supportDebug) {
             }
         }
     }
+    _buildStages();
+    const int size = (int)mBuffer.command.size();
+
+    /* Keep the memory plan of the last full resize if the commands read and write the same tensors as it and some
+       of them keep the shapes. The commands keeping their tensors skip onResize, the others are resized with memory
+       apart from the kept plan. A tensor keeping its shape keeps its memory, as the order of the commands using it is
+       the same. The memory of the plan is hold from the full resize until the next one */
+    std::vector<const Tensor*> tensors;
+    std::map<const Tensor*, int> tensorIndexes;
+    std::vector<std::vector<int>> planTensors(size);
+    for (int i = 0; i < size; ++i) {
+        planTensors[i] = _commandTensors(mBuffer.command[i], tensors, tensorIndexes);
+    }
+    bool canKeep  = mKeepPlan && mBackend->type() == MNN_FORWARD_CPU && mBackend == mBackupBackend;
+    bool keepPlan = canKeep && mPlanKept && lastExecutions.size() == size && planTensors == mPlanTensors;
+    if (keepPlan) {
+        keepPlan = false;
+        for (int i = 0; i < size && !keepPlan; ++i) {
+            keepPlan = mPlanResized[i] && _keepShape(planTensors[i], tensors);
+        }
+    }
+    // Set back at the end, a failed resize makes a full plan next time
+    mPlanTensors.clear();
+    if (keepPlan) {
+        mBackend->onClearBuffer();
+    } else {
+        if (mPlanKept) {
+            static_cast<CPUBackend*>(mBackend.get())->releaseKeptBuffer();
+            mPlanKept = false;
+        }
+        mBackend->onClearBuffer();
+        mBackupBackend->onClearBuffer();
+        mPlanHosts.clear();
+        mPlanResized.assign(size, true);
+        mResizeKeys.clear();
+    }
+    mResizeKeys.resize(size);
+    std::set<const Tensor*> keptTensors;
+    auto keepTensor = [&](Tensor* t) {
+        if (!keepPlan) {
+            return false;
+        }
+        auto iter = mPlanHosts.find(tensorIndexes[t]);
+        if (iter == mPlanHosts.end() || iter->second.second != _shapeKey(t)) {
+            return false;
+        }
+        t->buffer().host = (uint8_t*)iter->second.first;
+        keptTensors.insert(t);
+        return true;
+    };
+    auto acquireTensor = [&](Backend* bn, Tensor* t, Backend::StorageType memoryType) {
+        TensorUtils::getDescribe(t)->backend = bn;
+        TensorUtils::setLinearLayout(t);
+        if (keepTensor(t)) {
+            return true;
+        }
+        if (!bn->onAcquireBuffer(t, memoryType)) {
+            return false;
+        }
+        if (canKeep && (!keepPlan)) {
+            mPlanHosts[tensorIndexes[t]] = std::make_pair((void*)t->host<void>(), _shapeKey(t));
+        }
+        return true;
+    };
+    // Commands in a parallel stage compute at the same time, so their memory can't be reused by each other
+    BufferAllocator* allocator = nullptr;
+    for (auto& stage : mStages) {
+        if (stage.parallel) {
+            allocator = static_cast<CPUBackend*>(mBackend.get())->getBufferAllocator();
+        }
+    }
+    int stageIndex = 0;
+    bool inBarrier = false;
+    std::shared_ptr<void> __a(nullptr, [&inBarrier, allocator](void*) {
+        if (inBarrier) {
+            allocator->barrierEnd();
+        }
+    });
     // Create Execution and Alloc
     mBackend->onResizeBegin();
-    mExecutions.resize(mBuffer.command.size());
-    for (int i = 0; i < mBuffer.command.size(); ++i) {
+    mExecutions.resize(size);
+    for (int i = 0; i < size; ++i) {
         auto& iter = mBuffer.command[i];
+        while (mStages[stageIndex].end <= i) {
+            stageIndex++;
+        }
+        auto& stage = mStages[stageIndex];
+        if (stage.parallel) {
+            if (stage.begin == i) {
+                allocator->barrierBegin();
+                inBarrier = true;
+            }
+            allocator->beginGroup();
+        }
         // MNN_PRINT("%d - %s\n", i, EnumNameOpType(iter.op->type()));
         mExecutions[i] = nullptr;
         bool cached    = false;
@@ -202,10 +555,7 @@ ErrorCode Pipeline::allocMemory(bool supportDebug) {
                         auto memoryType = _getTensorStorageType(origin);
                         auto bn         = TensorUtils::getDescribe(origin)->backend;
                         if (nullptr == bn) {
-                            TensorUtils::getDescribe(origin)->backend = curBackend;
-                            TensorUtils::setLinearLayout(origin);
-                            auto res = curBackend->onAcquireBuffer(origin, memoryType);
-                            if (!res) {
+                            if (!acquireTensor(curBackend, origin, memoryType)) {
                                 return OUT_OF_MEMORY;
                             }
                         } else {
@@ -218,10 +568,7 @@ ErrorCode Pipeline::allocMemory(bool supportDebug) {
                     auto memoryType = _getTensorStorageType(t);
                     auto bn         = TensorUtils::getDescribe(t)->backend;
                     if (nullptr == bn) {
-                        TensorUtils::setLinearLayout(t);
-                        des->backend = curBackend;
-                        auto res     = curBackend->onAcquireBuffer(t, memoryType);
-                        if (!res) {
+                        if (!acquireTensor(curBackend, t, memoryType)) {
                             return OUT_OF_MEMORY;
                         }
                     } else {
@@ -253,11 +600,21 @@ ErrorCode Pipeline::allocMemory(bool supportDebug) {
         if ((!cached) && iter.buffer.empty() && (iter.op->type() != OpType_Raster)) {
             mOriginExecution.insert(std::make_pair(iter.op, mExecutions[i]));
         }
-        auto code = mExecutions[i]->onResize(iter.inputs, iter.outputs);
-        if (NO_ERROR != code) {
-            return code;
+        // The execution resized by the kept plan with the same tensors, hosts and shapes skips onResize
+        auto resizeKey = _resizeKey(iter);
+        bool skip      = keepPlan && mPlanResized[i] && (!resizeKey.empty()) && mExecutions[i] == lastExecutions[i] &&
+                    resizeKey == mResizeKeys[i];
+        if (skip) {
+            mResizeSkipped++;
+        } else {
+            auto code = mExecutions[i]->onResize(iter.inputs, iter.outputs);
+            if (NO_ERROR != code) {
+                return code;
+            }
+            mPlanResized[i] = !keepPlan;
         }
-        // Free mid tensor
+        mResizeKeys[i] = std::move(resizeKey);
+        // Free mid tensor, the kept memory is not given back to the new plan
         for (auto t : iter.inputs) {
             auto des = TensorUtils::getDescribe(t);
             if (des->memoryType == Tensor::InsideDescribe::MEMORY_VIRTUAL) {
@@ -269,7 +626,7 @@ ErrorCode Pipeline::allocMemory(bool supportDebug) {
                         TensorUtils::getDescribe(origin)->memoryType == Tensor::InsideDescribe::MEMORY_BACKEND) {
                         auto needRelease = _needRelease(origin, !mAllocInput);
                         auto bn          = TensorUtils::getDescribe(origin)->backend;
-                        if (nullptr != bn && needRelease) {
+                        if (nullptr != bn && needRelease && keptTensors.find(origin) == keptTensors.end()) {
                             // For zeroshape may not has bn
                             bn->onReleaseBuffer(origin, Backend::DYNAMIC);
                         }
@@ -281,15 +638,28 @@ ErrorCode Pipeline::allocMemory(bool supportDebug) {
                     TensorUtils::getDescribe(t)->memoryType == Tensor::InsideDescribe::MEMORY_BACKEND) {
                     auto needRelease = _needRelease(t, !mAllocInput);
                     auto bn          = TensorUtils::getDescribe(t)->backend;
-                    if (nullptr != bn && needRelease) {
+                    if (nullptr != bn && needRelease && keptTensors.find(t) == keptTensors.end()) {
                         // For zeroshape may not has bn
                         bn->onReleaseBuffer(t, Backend::DYNAMIC);
                     }
                 }
             }
         }
+        if (stage.parallel) {
+            allocator->endGroup();
+            if (stage.end == i + 1) {
+                allocator->barrierEnd();
+                inBarrier = false;
+            }
+        }
     }
     mBackend->onResizeEnd();
+    if (canKeep && (!keepPlan)) {
+        // Before the garbage collect of the next resize releases the free memory of the plan
+        static_cast<CPUBackend*>(mBackend.get())->keepBuffer();
+        mPlanKept = true;
+    }
+    mPlanTensors = std::move(planTensors);
 
     /** Prepare DebugInfo*/
     if (supportDebug) {
@@ -303,9 +673,8 @@ ErrorCode Pipeline::allocMemory(bool supportDebug) {
 
 ErrorCode Pipeline::execute() {
     mBackend->onExecuteBegin();
-    for (int i = 0; i < mBuffer.command.size(); ++i) {
-        auto& cmd = mBuffer.command[i];
-        auto code = mExecutions[i]->onExecute(cmd.inputs, cmd.outputs);
+    for (auto& stage : mStages) {
+        auto code = _executeStage(stage);
         if (NO_ERROR != code) {
             mBackend->onExecuteEnd();
             return code;
@@ -47,8 +47,42 @@ public:
     ErrorCode execute();
     ErrorCode executeCallBack(const TensorCallBackWithInfo& before, const TensorCallBackWithInfo& after);
     std::vector<Schedule::PipelineInfo>& getPipelineInfo();
+    /** run independent commands concurrently, only valid for CPU backend with thread pool */
+    void setParallelSchedule(bool parallel) {
+        mParallelSchedule = parallel;
+    }
+    /** assign NC4HW4 to layout-free commands when it saves conversion, only valid for CPU backend with geometry */
+    void setPropagateLayout(bool propagate) {
+        mPropagateLayout = propagate;
+    }
+    /** bytes of layout conversion removed by the last encode */
+    size_t getLayoutSavedBytes() const {
+        return mLayoutSavedBytes;
+    }
+    /** keep the memory plan and the executions of the commands whose tensors keep their shapes in the next resizes,
+        only valid for CPU backend */
+    void setKeepPlan(bool keep) {
+        mKeepPlan = keep;
+    }
+    /** number of executions whose onResize is skipped by the last allocMemory */
+    int getResizeSkipped() const {
+        return mResizeSkipped;
+    }
 
 private:
+    /** Commands in [begin, end) don't depend on each other */
+    struct Stage {
+        int begin;
+        int end;
+        bool parallel;
+    };
+    /** reorder commands by dependency level and split them into stages */
+    void _buildStages();
+    ErrorCode _executeStage(const Stage& stage);
+    /** op, tensors, hosts and shapes of the command, empty if its execution can't be kept */
+    std::vector<size_t> _resizeKey(const Command& cmd) const;
+    /** the tensors of the kept plan have the same shapes as in it */
+    bool _keepShape(const std::vector<int>& indexes, const std::vector<const Tensor*>& tensors) const;
     std::shared_ptr<Backend> mBackend;
     std::shared_ptr<Backend> mBackupBackend;
     std::vector<std::shared_ptr<Execution>> mExecutions;
@@ -60,6 +94,20 @@ private:
     bool mAllocInput;
     bool mInit = false;
     std::map<const Op*, std::shared_ptr<Execution>> mOriginExecution;
+    bool mParallelSchedule = false;
+    bool mPropagateLayout = false;
+    size_t mLayoutSavedBytes = 0;
+    std::vector<Stage> mStages;
+    /** The memory plan of the last full resize: index of the tensors of each command, host and shape of the tensors
+        allocated by it, and whether the execution of the command is not resized since it */
+    std::vector<std::vector<int>> mPlanTensors;
+    std::map<int, std::pair<void*, std::vector<size_t>>> mPlanHosts;
+    std::vector<bool> mPlanResized;
+    bool mKeepPlan = false;
+    bool mPlanKept = false;
+    /** _resizeKey of each command in the last resize */
+    std::vector<std::vector<size_t>> mResizeKeys;
+    int mResizeSkipped = 0;
 #ifndef MNN_BUILD_MINI
     GeometryComputer::Context mContext;
     bool mUseGeometry = true;
@@ -21,7 +21,9 @@ using namespace std;
 
 namespace MNN {
 Session::Session(Schedule::ScheduleInfo&& info, Interpreter::SessionMode callBackMode,
-                 Interpreter::SessionMode inputMode, RuntimeInfo&& runtime) {
+                 Interpreter::SessionMode inputMode, RuntimeInfo&& runtime, Interpreter::SessionMode scheduleMode,
+                 Interpreter::SessionMode layoutMode, std::shared_ptr<Backend::SharedWeights> sharedWeights,
+                 Interpreter::SessionMode resizeMode) {
     mRuntime = std::move(runtime);
     if (info.pipelineInfo.empty()) {
         mValid = false;
@@ -40,10 +42,18 @@ Session::Session(Schedule::ScheduleInfo&& info, Interpreter::SessionMode callBac
             second = first;
         } else {
             second.reset(cpuRuntime->onCreate());
+            second->setSharedWeights(sharedWeights);
         }
+        first->setSharedWeights(sharedWeights);
         std::shared_ptr<Pipeline> newPipeline(new Pipeline(std::move(iter.second), first, second, inputMode == Interpreter::Session_Input_Inside, runtime->onGetCompilerType() == Runtime::Compiler_Geometry));
+        newPipeline->setParallelSchedule(scheduleMode == Interpreter::Session_Schedule_Parallel);
+        newPipeline->setKeepPlan(resizeMode == Interpreter::Session_Resize_Incremental);
         mPipelines.emplace_back(std::move(newPipeline));
     }
+    // Tensors shared between pipelines must keep the layout the other pipeline expects
+    if (layoutMode == Interpreter::Session_Layout_Propagate && mPipelines.size() == 1) {
+        mPipelines[0]->setPropagateLayout(true);
+    }
     mInputs       = std::move(info.inputTensors);
     mOutputs      = std::move(info.outputTensor);
     mCallBackMode = callBackMode;
@@ -69,6 +79,12 @@ bool Session::loadCache(const void* buffer, size_t size) {
     return false;
 }
 
+void Session::recordCache(bool record) {
+    for (auto iter : mRuntime.first) {
+        iter.second->onRecordCache(record);
+    }
+}
+
 std::pair<const void*, size_t> Session::getCache() {
     for (auto iter : mRuntime.first) {
         auto res = iter.second->onGetCache();
@@ -79,6 +95,54 @@ std::pair<const void*, size_t> Session::getCache() {
     return std::make_pair(nullptr, 0);
 }
 
+static void _zeroTensor(Tensor* tensor) {
+    if (nullptr == TensorUtils::getDescribe(tensor)->backend) {
+        return;
+    }
+    std::shared_ptr<Tensor> zero(new Tensor(tensor, tensor->getDimensionType()));
+    ::memset(zero->host<void>(), 0, zero->size());
+    tensor->copyFromHostTensor(zero.get());
+}
+
+void Session::setStates(std::vector<std::pair<Tensor*, Tensor*>>&& states) {
+    mStates = std::move(states);
+    mStateShapes.clear();
+    for (auto& s : mStates) {
+        mStateShapes.emplace_back(s.first->shape());
+    }
+    resetStates();
+}
+
+void Session::resetStates() {
+    for (auto& s : mStates) {
+        _zeroTensor(s.first);
+    }
+}
+
+ErrorCode Session::_updateStates() const {
+    for (auto& s : mStates) {
+        auto input  = s.first;
+        auto output = s.second;
+        if (input->elementSize() != output->elementSize()) {
+            MNN_ERROR("The state output has %d elements, but the input has %d\n", output->elementSize(),
+                      input->elementSize());
+            return INPUT_DATA_ERROR;
+        }
+        auto inputBackend  = TensorUtils::getDescribe(input)->backend;
+        auto outputBackend = TensorUtils::getDescribe(output)->backend;
+        if (nullptr == inputBackend || nullptr == outputBackend) {
+            return INVALID_VALUE;
+        }
+        // The copy may convert layout, it is done by the device backend if one of them is not on cpu
+        if (outputBackend->type() != MNN_FORWARD_CPU) {
+            outputBackend->onCopyBuffer(output, input);
+        } else {
+            inputBackend->onCopyBuffer(output, input);
+        }
+    }
+    return NO_ERROR;
+}
+
 ErrorCode Session::run() const {
     if (mNeedResize) {
         MNN_ERROR("Can't run session because not resized\n");
@@ -90,7 +154,7 @@ ErrorCode Session::run() const {
             return error;
         }
     }
-    return NO_ERROR;
+    return _updateStates();
 }
 
 ErrorCode Session::runWithCallBack(const TensorCallBackWithInfo& before, const TensorCallBackWithInfo& end,
@@ -105,7 +169,7 @@ ErrorCode Session::runWithCallBack(const TensorCallBackWithInfo& before, const T
             return error;
         }
     }
-    return NO_ERROR;
+    return _updateStates();
 }
 
 void Session::_clearCache() {
@@ -122,6 +186,15 @@ ErrorCode Session::resize(bool isStatic) {
     for (auto& iter : mRuntime.first) {
         iter.second->onGabageCollect(100);
     }
+    // The memory of the states is released by resize, keep their value for the next run
+    std::vector<std::shared_ptr<Tensor>> stateValues(mStates.size());
+    for (int i = 0; i < mStates.size(); ++i) {
+        auto input = mStates[i].first;
+        if (nullptr != TensorUtils::getDescribe(input)->backend && mStateShapes[i] == input->shape()) {
+            stateValues[i].reset(new Tensor(input, input->getDimensionType()));
+            input->copyToHostTensor(stateValues[i].get());
+        }
+    }
     if (!isStatic) {
         _clearCache();
     }
@@ -139,6 +212,16 @@ ErrorCode Session::resize(bool isStatic) {
         }
     }
     mNeedResize = false;
+    for (int i = 0; i < mStates.size(); ++i) {
+        auto input = mStates[i].first;
+        if (nullptr != stateValues[i].get()) {
+            input->copyFromHostTensor(stateValues[i].get());
+        } else {
+            // The shape of the state is changed, begin a new sequence
+            _zeroTensor(input);
+        }
+        mStateShapes[i] = input->shape();
+    }
     for (auto& iter : mRuntime.first) {
         iter.second->onGabageCollect(0);
     }
@@ -155,6 +238,22 @@ bool Session::getInfo(Interpreter::SessionInfoCode code, void* ptr) const {
             *dst = summer;
             return true;
         } break;
+        case Interpreter::LAYOUT_CONVERT_SAVED: {
+            size_t summer = 0;
+            for (auto& iter : mPipelines) {
+                summer += iter->getLayoutSavedBytes();
+            }
+            *(float*)ptr = summer / 1024.0f / 1024.0f;
+            return true;
+        } break;
+        case Interpreter::RESIZE_SKIPPED: {
+            int summer = 0;
+            for (auto& iter : mPipelines) {
+                summer += iter->getResizeSkipped();
+            }
+            *(int*)ptr = summer;
+            return true;
+        } break;
         // TODO: Support other debug info
         default:
             break;
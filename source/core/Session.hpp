@@ -25,7 +25,11 @@ struct Net;
 class MNN_PUBLIC Session {
 public:
     Session(Schedule::ScheduleInfo&& info, Interpreter::SessionMode callBackMode, Interpreter::SessionMode inputMode,
-            RuntimeInfo&& runtime);
+            RuntimeInfo&& runtime,
+            Interpreter::SessionMode scheduleMode = Interpreter::Session_Schedule_Serial,
+            Interpreter::SessionMode layoutMode   = Interpreter::Session_Layout_Keep,
+            std::shared_ptr<Backend::SharedWeights> sharedWeights = nullptr,
+            Interpreter::SessionMode resizeMode = Interpreter::Session_Resize_Full);
     ~Session();
 
 public:
@@ -116,8 +120,19 @@ public:
      */
     ErrorCode updateToModel(Net* net) const;
 
+    /**
+     * @brief after each run, copy the value of each output to its input, the inputs start from zero.
+     * @param states    pairs of (input, output) tensors of the session.
+     */
+    void setStates(std::vector<std::pair<Tensor*, Tensor*>>&& states);
+    /**
+     * @brief set the state inputs to zero to begin a new sequence.
+     */
+    void resetStates();
+
     bool loadCache(const void* buffer, size_t size);
     std::pair<const void*, size_t> getCache();
+    void recordCache(bool record);
 
 protected:
     const std::vector<std::shared_ptr<Pipeline>>& getPipelines() const {
@@ -127,6 +142,7 @@ protected:
 private:
     void _clearCache();
     void _setUpTensorInfo(const Schedule::ScheduleInfo& info);
+    ErrorCode _updateStates() const;
 
 private:
     RuntimeInfo mRuntime;
@@ -134,6 +150,10 @@ private:
     std::vector<std::pair<int, std::shared_ptr<Tensor>>> mTensors;
     std::map<std::string, Tensor*> mInputs;
     std::map<std::string, Tensor*> mOutputs;
+    // (input, output) pairs carried between runs
+    std::vector<std::pair<Tensor*, Tensor*>> mStates;
+    // Shape of the state inputs when their memory is allocated
+    std::vector<std::vector<int>> mStateShapes;
     bool mNeedResize = true;
     bool mValid      = true;
     Interpreter::SessionMode mCallBackMode;
@@ -14,11 +14,12 @@ namespace MNN {
 class GeometryBatchMatMul : public GeometryComputer {
 public:
     virtual std::vector<bool> onGetOutputVirtual(const Op* op, const std::vector<Tensor*>& inputs,
-                                                 const std::vector<Tensor*>& outputs) const override {
-        if (outputs[0]->dimensions() > 2) {
+                                                 const std::vector<Tensor*>& outputs,
+                                                 const Context& context) const override {
+        if (inputs[0]->elementSize() == 0 || inputs[1]->elementSize() == 0) {
             return {true};
         }
-        if (inputs[0]->elementSize() == 0 || inputs[1]->elementSize() == 0) {
+        if (outputs[0]->dimensions() > 2 && context.forwardType() != MNN_FORWARD_CPU) {
             return {true};
         }
         return {false};
@@ -61,6 +62,17 @@ public:
             transposeA = param->transposeA();
             transposeB = param->transposeB();
         }
+        if (context.forwardType() == MNN_FORWARD_CPU) {
+            // CPU has a batched GEMM that supports broadcast, use one command instead of one matmul per batch
+            std::unique_ptr<OpT> batchMatMul(new OpT);
+            batchMatMul->type                            = OpType_BatchMatMul;
+            batchMatMul->main.type                       = OpParameter_BatchMatMulParam;
+            batchMatMul->main.value                      = new BatchMatMulParamT;
+            batchMatMul->main.AsBatchMatMulParam()->adjX = transposeA;
+            batchMatMul->main.AsBatchMatMulParam()->adjY = transposeB;
+            res.command.emplace_back(GeometryComputerUtils::makeCommand(batchMatMul.get(), {input0, input1}, {output}));
+            return true;
+        }
         outputDes->memoryType = Tensor::InsideDescribe::MEMORY_VIRTUAL;
         auto i0Dim = input0->dimensions();
         auto i1Dim = input1->dimensions();
@@ -23,8 +23,9 @@ GeometryComputer::Context::~Context() {
     }
 }
 
-GeometryComputer::Context::Context(std::shared_ptr<Backend> allocBackend, bool permitVirtual) {
+GeometryComputer::Context::Context(std::shared_ptr<Backend> allocBackend, bool permitVirtual, MNNForwardType type) {
     mPermitVirtual = permitVirtual;
+    mForwardType   = type;
     mBackend       = allocBackend;
     flatbuffers::FlatBufferBuilder builder;
     OpBuilder opBuilder(builder);
@@ -149,7 +150,7 @@ Tensor* GeometryComputer::Context::getRasterCacheCreate(Tensor* src, CommandBuff
 bool GeometryComputer::compute(const Op* op, const std::vector<Tensor*>& inputs,
                                const std::vector<Tensor*>& originOutputs, GeometryComputer::Context& context,
                                CommandBuffer& cmdBuffer) const {
-    auto outputRes = this->onGetOutputVirtual(op, inputs, originOutputs);
+    auto outputRes = this->onGetOutputVirtual(op, inputs, originOutputs, context);
     std::map<std::shared_ptr<Tensor>, Tensor*> rasterMap;
     auto outputs = originOutputs;
     for (int i = 0; i < outputs.size(); ++i) {
@@ -182,13 +183,15 @@ bool GeometryComputer::compute(const Op* op, const std::vector<Tensor*>& inputs,
 }
 
 std::vector<bool> GeometryComputer::onGetOutputVirtual(const Op* op, const std::vector<Tensor*>& inputs,
-                                                       const std::vector<Tensor*>& outputs) const {
+                                                       const std::vector<Tensor*>& outputs,
+                                                       const Context& context) const {
     std::vector<bool> res(outputs.size(), true);
     return res;
 }
 
 std::vector<bool> DefaultGeometryComputer::onGetOutputVirtual(const Op* op, const std::vector<Tensor*>& inputs,
-                                                              const std::vector<Tensor*>& outputs) const {
+                                                              const std::vector<Tensor*>& outputs,
+                                                              const Context& context) const {
     std::vector<bool> res(outputs.size(), false);
     return res;
 }
@@ -10,6 +10,7 @@
 #define GeometryComputer_hpp
 #include <map>
 #include <vector>
+#include <MNN/MNNForwardType.h>
 #include "MNN_generated.h"
 #include "core/Command.hpp"
 #include "core/TensorUtils.hpp"
@@ -22,7 +23,7 @@ public:
     }
     class MNN_PUBLIC Context {
     public:
-        Context(std::shared_ptr<Backend> allocBackend, bool permitVirtual = true);
+        Context(std::shared_ptr<Backend> allocBackend, bool permitVirtual = true, MNNForwardType type = MNN_FORWARD_CPU);
         ~Context();
 
         void clear();
@@ -30,6 +31,10 @@ public:
         bool supportVirtual() const {
             return mPermitVirtual;
         }
+        // The forward type of the backend that runs the commands
+        MNNForwardType forwardType() const {
+            return mForwardType;
+        }
         Tensor* getRasterCacheCreateRecurrse(Tensor* src, CommandBuffer& cmd);
         const std::vector<std::shared_ptr<Tensor>>& searchConst(const Op* op) const;
         std::shared_ptr<Tensor> allocConst(const Op* key, const std::vector<int>& shape, halide_type_t type,
@@ -42,6 +47,7 @@ public:
         std::map<const Op*, std::vector<std::shared_ptr<Tensor>>> mConstTensors;
         std::vector<std::shared_ptr<Tensor>> mEmpty;
         bool mPermitVirtual;
+        MNNForwardType mForwardType;
         std::shared_ptr<Backend> mBackend;
         std::vector<uint8_t> mRasterOp;
     };
@@ -55,9 +61,10 @@ public:
 protected:
     virtual bool onCompute(const Op* op, const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs,
                            Context& context, CommandBuffer& cmd) const = 0;
-    // Return the outputs tensor is virtual or not
+    // Return the outputs tensor is virtual or not, the context tells which backend runs the commands
     virtual std::vector<bool> onGetOutputVirtual(const Op* op, const std::vector<Tensor*>& inputs,
-                                                 const std::vector<Tensor*>& outputs) const;
+                                                 const std::vector<Tensor*>& outputs,
+                                                 const Context& context) const;
 };
 
 class DefaultGeometryComputer : public GeometryComputer {
@@ -68,7 +75,8 @@ public:
     virtual bool onCompute(const Op* op, const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs,
                            Context& context, CommandBuffer& cmd) const override;
     virtual std::vector<bool> onGetOutputVirtual(const Op* op, const std::vector<Tensor*>& inputs,
-                                                 const std::vector<Tensor*>& outputs) const override;
+                                                 const std::vector<Tensor*>& outputs,
+                                                 const Context& context) const override;
 };
 void registerGeometryOps();
 
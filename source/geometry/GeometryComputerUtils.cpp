@@ -10,6 +10,9 @@
 #include "core/OpCommonUtils.hpp"
 #include "core/RuntimeFactory.hpp"
 #include "shape/SizeComputer.hpp"
+#include <algorithm>
+#include <map>
+#include <set>
 namespace MNN {
 static bool _hasZeroShapeOutput(const Schedule::PipelineInfo& info) {
     for (auto t : info.outputs) {
@@ -424,4 +427,431 @@ void GeometryComputerUtils::makeSliceRef(Tensor* dst, Tensor* src, const std::ve
     reg.dst.stride[2] = 1;
     describe->regions = {reg};
 }
+static bool _isLayoutFree(const Command& cmd) {
+    // Elementwise ops whose result doesn't depend on the memory order when C % 4 == 0
+    switch (cmd.op->type()) {
+        case OpType_UnaryOp:
+        case OpType_Sigmoid:
+        case OpType_TanH:
+        case OpType_ReLU:
+        case OpType_ReLU6:
+        case OpType_BinaryOp:
+            break;
+        default:
+            return false;
+    }
+    if (cmd.outputs.size() != 1 || cmd.inputs.empty()) {
+        return false;
+    }
+    auto output = cmd.outputs[0];
+    if (output->dimensions() != 4 || output->getType() != halide_type_of<float>() || output->length(1) % 4 != 0) {
+        return false;
+    }
+    auto check = [output](const Tensor* t) {
+        auto des = TensorUtils::getDescribe(t);
+        if (des->memoryType == Tensor::InsideDescribe::MEMORY_VIRTUAL ||
+            des->dimensionFormat != MNN_DATA_FORMAT_NCHW || t->getType() != output->getType() ||
+            t->dimensions() != output->dimensions()) {
+            return false;
+        }
+        for (int i = 0; i < t->dimensions(); ++i) {
+            if (t->length(i) != output->length(i)) {
+                return false;
+            }
+        }
+        return true;
+    };
+    for (auto t : cmd.inputs) {
+        if (!check(t)) {
+            return false;
+        }
+    }
+    return check(output);
+}
+
+static bool _isIdentityRaster(const Command& cmd) {
+    if (cmd.op->type() != OpType_Raster || cmd.inputs.size() != 1 || cmd.outputs.size() != 1) {
+        return false;
+    }
+    auto& regions = TensorUtils::getDescribe(cmd.inputs[0])->regions;
+    if (regions.size() != 1) {
+        return false;
+    }
+    auto& reg = regions[0];
+    auto src  = reg.origin;
+    auto dst  = cmd.outputs[0];
+    if (nullptr == src || src->dimensions() != dst->dimensions() || src->getType() != dst->getType()) {
+        return false;
+    }
+    for (int i = 0; i < dst->dimensions(); ++i) {
+        if (src->length(i) != dst->length(i)) {
+            return false;
+        }
+    }
+    if (reg.src.offset != 0 || reg.dst.offset != 0) {
+        return false;
+    }
+    // The region must be one dense copy of the whole tensor in logical order
+    int total  = dst->elementSize();
+    int count  = 1;
+    int extent = 1;
+    for (int i = 0; i < 3; ++i) {
+        if (reg.size[i] <= 1) {
+            continue;
+        }
+        if (reg.src.stride[i] != reg.dst.stride[i] || reg.src.stride[i] <= 0) {
+            return false;
+        }
+        count *= reg.size[i];
+        extent += (reg.size[i] - 1) * reg.src.stride[i];
+    }
+    return count == total && extent == total;
+}
+
+size_t GeometryComputerUtils::propagateLayout(CommandBuffer& buffer) {
+    auto& commands = buffer.command;
+    // Union the tensors of layout-free commands, every group must share one layout
+    std::map<Tensor*, Tensor*> parent;
+    auto find = [&parent](Tensor* t) {
+        while (parent[t] != t) {
+            parent[t] = parent[parent[t]];
+            t         = parent[t];
+        }
+        return t;
+    };
+    for (auto& cmd : commands) {
+        if (!_isLayoutFree(cmd)) {
+            continue;
+        }
+        auto output = cmd.outputs[0];
+        parent.insert(std::make_pair(output, output));
+        for (auto t : cmd.inputs) {
+            parent.insert(std::make_pair(t, t));
+            parent[find(t)] = find(output);
+        }
+    }
+    if (parent.empty()) {
+        return 0;
+    }
+    std::map<Tensor*, int> producers;
+    std::map<Tensor*, std::set<int>> readers;
+    for (int i = 0; i < commands.size(); ++i) {
+        auto& cmd = commands[i];
+        for (auto t : cmd.outputs) {
+            producers[t] = i;
+        }
+        if (cmd.op->type() == OpType_Raster) {
+            for (auto& reg : TensorUtils::getDescribe(cmd.inputs[0])->regions) {
+                readers[reg.origin].insert(i);
+            }
+            continue;
+        }
+        for (auto t : cmd.inputs) {
+            readers[t].insert(i);
+        }
+    }
+    std::map<Tensor*, std::vector<Tensor*>> groups;
+    for (auto& iter : parent) {
+        groups[find(iter.first)].push_back(iter.first);
+    }
+
+    // Compare the conversion bytes of the group in NCHW and in NC4HW4
+    size_t saved = 0;
+    std::set<Tensor*> changed;
+    for (auto& iter : groups) {
+        auto root    = iter.first;
+        bool valid   = true;
+        size_t costOrigin = 0;
+        size_t costC4     = 0;
+        auto addCost = [&](Tensor* other, size_t bytes) {
+            if (parent.find(other) != parent.end() && find(other) == root) {
+                return;
+            }
+            auto format = TensorUtils::getDescribe(other)->dimensionFormat;
+            costOrigin += format != MNN_DATA_FORMAT_NCHW ? bytes : 0;
+            costC4 += format != MNN_DATA_FORMAT_NC4HW4 ? bytes : 0;
+        };
+        for (auto t : iter.second) {
+            auto bytes       = (size_t)t->elementSize() * t->getType().bytes();
+            auto producer    = producers.find(t);
+            auto readerIter  = readers.find(t);
+            if (TensorUtils::getDescribe(t)->usage != Tensor::InsideDescribe::NORMAL || producer == producers.end() ||
+                readerIter == readers.end()) {
+                valid = false;
+                break;
+            }
+            auto& pCmd = commands[producer->second];
+            if (_isIdentityRaster(pCmd)) {
+                addCost(TensorUtils::getDescribe(pCmd.inputs[0])->regions[0].origin, bytes);
+            } else if (pCmd.op->type() == OpType_Raster) {
+                costC4 += bytes;
+            } else if (!_isLayoutFree(pCmd)) {
+                valid = false;
+                break;
+            }
+            for (auto index : readerIter->second) {
+                auto& rCmd = commands[index];
+                if (_isIdentityRaster(rCmd)) {
+                    addCost(rCmd.outputs[0], bytes);
+                } else if (rCmd.op->type() == OpType_Raster) {
+                    costC4 += bytes;
+                } else if (!_isLayoutFree(rCmd)) {
+                    valid = false;
+                    break;
+                }
+            }
+            if (!valid) {
+                break;
+            }
+        }
+        if (!valid || costC4 >= costOrigin) {
+            continue;
+        }
+        for (auto t : iter.second) {
+            TensorUtils::getDescribe(t)->dimensionFormat = MNN_DATA_FORMAT_NC4HW4;
+            changed.insert(t);
+        }
+        saved += costOrigin - costC4;
+    }
+    if (changed.empty()) {
+        return 0;
+    }
+
+    // Identity rasters between tensors of the same layout are plain copies now, remove them
+    std::map<Tensor*, Tensor*> replace;
+    std::vector<Command> newCommands;
+    newCommands.reserve(commands.size());
+    for (auto& cmd : commands) {
+        if (_isIdentityRaster(cmd)) {
+            auto origin = TensorUtils::getDescribe(cmd.inputs[0])->regions[0].origin;
+            auto output = cmd.outputs[0];
+            auto oDes   = TensorUtils::getDescribe(origin);
+            auto dDes   = TensorUtils::getDescribe(output);
+            if ((changed.find(origin) != changed.end() || changed.find(output) != changed.end()) &&
+                oDes->dimensionFormat == dDes->dimensionFormat && dDes->usage == Tensor::InsideDescribe::NORMAL &&
+                oDes->memoryType != Tensor::InsideDescribe::MEMORY_VIRTUAL) {
+                replace[output] = origin;
+                continue;
+            }
+        }
+        // Moving keeps the op pointer into cmd.buffer valid
+        newCommands.emplace_back(std::move(cmd));
+    }
+    auto resolve = [&replace](Tensor* t) {
+        auto iter = replace.find(t);
+        while (iter != replace.end()) {
+            t    = iter->second;
+            iter = replace.find(t);
+        }
+        return t;
+    };
+    for (auto& cmd : newCommands) {
+        if (cmd.op->type() == OpType_Raster) {
+            for (auto& reg : TensorUtils::getDescribe(cmd.inputs[0])->regions) {
+                reg.origin = resolve(reg.origin);
+            }
+            continue;
+        }
+        for (auto& t : cmd.inputs) {
+            t = resolve(t);
+        }
+    }
+    commands = std::move(newCommands);
+    return saved;
+}
+
+// Elementwise commands that can run tile by tile in one fused kernel
+static bool _isFusableElementwise(const Command& cmd) {
+    switch (cmd.op->type()) {
+        case OpType_UnaryOp:
+            switch (cmd.op->main_as_UnaryOp()->opType()) {
+                case UnaryOpOperation_ABS:
+                case UnaryOpOperation_NEG:
+                case UnaryOpOperation_SQUARE:
+                case UnaryOpOperation_SQRT:
+                case UnaryOpOperation_RSQRT:
+                case UnaryOpOperation_EXP:
+                case UnaryOpOperation_LOG:
+                case UnaryOpOperation_RECIPROCAL:
+                case UnaryOpOperation_SIGMOID:
+                case UnaryOpOperation_TANH:
+                    break;
+                default:
+                    return false;
+            }
+            if (cmd.inputs.size() != 1) {
+                return false;
+            }
+            break;
+        case OpType_BinaryOp:
+            switch (cmd.op->main_as_BinaryOp()->opType()) {
+                case BinaryOpOperation_ADD:
+                case BinaryOpOperation_SUB:
+                case BinaryOpOperation_MUL:
+                case BinaryOpOperation_REALDIV:
+                case BinaryOpOperation_MAXIMUM:
+                case BinaryOpOperation_MINIMUM:
+                    break;
+                default:
+                    return false;
+            }
+            if (cmd.inputs.size() != 2) {
+                return false;
+            }
+            break;
+        case OpType_ReLU:
+        case OpType_ReLU6:
+            if (cmd.inputs.size() != 1) {
+                return false;
+            }
+            break;
+        default:
+            return false;
+    }
+    if (cmd.outputs.size() != 1) {
+        return false;
+    }
+    auto output = cmd.outputs[0];
+    auto size   = output->elementSize();
+    auto check  = [size](const Tensor* t, bool allowScalar) {
+        auto des = TensorUtils::getDescribe(t);
+        if (des->memoryType == Tensor::InsideDescribe::MEMORY_VIRTUAL || t->getType() != halide_type_of<float>()) {
+            return false;
+        }
+        if (allowScalar && t->elementSize() == 1) {
+            return true;
+        }
+        return des->dimensionFormat != MNN_DATA_FORMAT_NC4HW4 && t->elementSize() == size;
+    };
+    for (auto t : cmd.inputs) {
+        if (!check(t, true)) {
+            return false;
+        }
+    }
+    return size > 1 && check(output, false);
+}
+
+size_t GeometryComputerUtils::fuseElementwise(CommandBuffer& buffer) {
+    auto& commands = buffer.command;
+    std::map<Tensor*, int> readerNumber;
+    for (auto& cmd : commands) {
+        if (cmd.op->type() == OpType_Raster) {
+            for (auto& reg : TensorUtils::getDescribe(cmd.inputs[0])->regions) {
+                readerNumber[reg.origin]++;
+            }
+            continue;
+        }
+        for (auto t : cmd.inputs) {
+            readerNumber[t]++;
+        }
+    }
+    size_t removed = 0;
+    std::vector<Command> newCommands;
+    newCommands.reserve(commands.size());
+    // Group of consecutive fusable commands, each one reads the result of an earlier one
+    std::vector<Command> group;
+    auto flush = [&]() {
+        if (group.size() <= 1) {
+            for (auto& cmd : group) {
+                newCommands.emplace_back(std::move(cmd));
+            }
+            group.clear();
+            return;
+        }
+        std::unique_ptr<OpT> fuseOp(new OpT);
+        fuseOp->type       = OpType_Extra;
+        fuseOp->main.type  = OpParameter_Extra;
+        fuseOp->main.value = new ExtraT;
+        auto extra         = fuseOp->main.AsExtra();
+        extra->type        = "ElementwiseFusion";
+        extra->engine      = "MNN";
+        std::vector<Tensor*> inputs;
+        std::vector<Tensor*> outputs;
+        std::map<Tensor*, int> stageIndex;
+        std::unique_ptr<AttributeT> outputAttr(new AttributeT);
+        outputAttr->key = "outputs";
+        outputAttr->list.reset(new ListValueT);
+        // Stage operand: >= 0 for the input of fused command, < 0 for the result of stage -(v + 1)
+        for (int i = 0; i < group.size(); ++i) {
+            auto& cmd = group[i];
+            std::unique_ptr<AttributeT> stage(new AttributeT);
+            stage->key = "stage";
+            stage->i   = cmd.op->type();
+            stage->list.reset(new ListValueT);
+            auto& params = stage->list->i;
+            switch (cmd.op->type()) {
+                case OpType_UnaryOp:
+                    params.emplace_back(cmd.op->main_as_UnaryOp()->opType());
+                    break;
+                case OpType_BinaryOp:
+                    params.emplace_back(cmd.op->main_as_BinaryOp()->opType());
+                    break;
+                case OpType_ReLU:
+                    params.emplace_back(0);
+                    stage->list->f = {nullptr == cmd.op->main_as_Relu() ? 0.0f : cmd.op->main_as_Relu()->slope()};
+                    break;
+                case OpType_ReLU6: {
+                    params.emplace_back(0);
+                    auto relu6     = cmd.op->main_as_Relu6();
+                    stage->list->f = {nullptr == relu6 ? 0.0f : relu6->minValue(),
+                                      nullptr == relu6 ? 6.0f : relu6->maxValue()};
+                    break;
+                }
+                default:
+                    break;
+            }
+            for (auto t : cmd.inputs) {
+                auto iter = stageIndex.find(t);
+                if (iter != stageIndex.end()) {
+                    params.emplace_back(-(iter->second + 1));
+                    continue;
+                }
+                auto pos = std::find(inputs.begin(), inputs.end(), t);
+                params.emplace_back((int)(pos - inputs.begin()));
+                if (pos == inputs.end()) {
+                    inputs.emplace_back(t);
+                }
+            }
+            auto output = cmd.outputs[0];
+            stageIndex.insert(std::make_pair(output, i));
+            // Results read outside the group or held by user must be written
+            int innerReader = 0;
+            for (int j = i + 1; j < group.size(); ++j) {
+                innerReader += (int)std::count(group[j].inputs.begin(), group[j].inputs.end(), output);
+            }
+            if (i == group.size() - 1 || innerReader != readerNumber[output] ||
+                TensorUtils::getDescribe(output)->usage != Tensor::InsideDescribe::NORMAL) {
+                outputs.emplace_back(output);
+                outputAttr->list->i.emplace_back(i);
+            }
+            extra->attr.emplace_back(std::move(stage));
+        }
+        extra->attr.emplace_back(std::move(outputAttr));
+        removed += group.size() - 1;
+        group.clear();
+        newCommands.emplace_back(makeCommand(fuseOp.get(), inputs, outputs));
+    };
+    for (auto& cmd : commands) {
+        if (!_isFusableElementwise(cmd)) {
+            flush();
+            newCommands.emplace_back(std::move(cmd));
+            continue;
+        }
+        bool connected = false;
+        for (auto t : cmd.inputs) {
+            for (auto& g : group) {
+                if (g.outputs[0] == t && g.outputs[0]->elementSize() == cmd.outputs[0]->elementSize()) {
+                    connected = true;
+                }
+            }
+        }
+        if (!connected) {
+            flush();
+        }
+        group.emplace_back(std::move(cmd));
+    }
+    flush();
+    commands = std::move(newCommands);
+    return removed;
+}
 }; // namespace MNN
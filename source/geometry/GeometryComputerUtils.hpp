@@ -34,6 +34,10 @@ public:
     static ErrorCode shapeComputeAndGeometryTransform(std::vector<Schedule::PipelineInfo>& infos, CommandBuffer& buffer,
                                                       GeometryComputer::Context& geoContext,
                                                       std::shared_ptr<Backend> backupBackend, bool geometry = true);
+    /** Turn groups of layout-free commands to NC4HW4 when it needs less conversion, return the saved bytes */
+    static size_t propagateLayout(CommandBuffer& buffer);
+    /** Merge chains of elementwise commands into one ElementwiseFusion Extra command, return the removed number */
+    static size_t fuseElementwise(CommandBuffer& buffer);
 };
 }; // namespace MNN
 
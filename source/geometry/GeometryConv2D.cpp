@@ -141,7 +141,8 @@ public:
         return computeIm2Col_GEMM(op, inputs, outputs, context, res);
     }
     virtual std::vector<bool> onGetOutputVirtual(const Op* op, const std::vector<Tensor*>& inputs,
-                                                 const std::vector<Tensor*>& outputs) const override {
+                                                 const std::vector<Tensor*>& outputs,
+                                                 const Context& context) const override {
         std::vector<bool> res(outputs.size(), true);
         auto outputDes = TensorUtils::getDescribe(outputs[0]);
         if (MNN_DATA_FORMAT_NC4HW4 == outputDes->dimensionFormat) {
@@ -156,6 +157,40 @@ public:
 
 class GeometryConvTranspose2D : public GeometryConv2D {
 public:
+    // CPU runs the multi-input deconvolution in one execution, avoiding the oc*kh*kw x n*ih*iw matmul result
+    bool computeFused(const Op* op, const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs,
+                      CommandBuffer& res) const {
+        auto newInputs = inputs;
+        if (MNN_DATA_FORMAT_NC4HW4 != TensorUtils::getDescribe(inputs[0])->dimensionFormat) {
+            std::shared_ptr<Tensor> newInput(new Tensor(inputs[0], Tensor::CAFFE_C4, false));
+            ConvertUtils::compute(inputs[0], newInput.get(), res);
+            newInputs[0] = newInput.get();
+            res.extras.emplace_back(std::move(newInput));
+        }
+        Command cmd;
+        cmd.op     = op;
+        cmd.inputs = std::move(newInputs);
+        if (MNN_DATA_FORMAT_NC4HW4 == TensorUtils::getDescribe(outputs[0])->dimensionFormat) {
+            cmd.outputs = outputs;
+            res.command.emplace_back(std::move(cmd));
+            return true;
+        }
+        std::shared_ptr<Tensor> newOutput(new Tensor(outputs[0], Tensor::CAFFE_C4, false));
+        cmd.outputs = {newOutput.get()};
+        res.command.emplace_back(std::move(cmd));
+        ConvertUtils::compute(newOutput.get(), outputs[0], res);
+        res.extras.emplace_back(std::move(newOutput));
+        return true;
+    }
+    virtual std::vector<bool> onGetOutputVirtual(const Op* op, const std::vector<Tensor*>& inputs,
+                                                 const std::vector<Tensor*>& outputs,
+                                                 const Context& context) const override {
+        if (inputs.size() > 1 && _fuseOnCPU(op, context) &&
+            MNN_DATA_FORMAT_NC4HW4 == TensorUtils::getDescribe(outputs[0])->dimensionFormat) {
+            return {false};
+        }
+        return GeometryConv2D::onGetOutputVirtual(op, inputs, outputs, context);
+    }
     // Im2Col + GEMM
     bool computeGEMM_Col2Im(const Op* op, const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs,
                             Context& context, CommandBuffer& res) const {
@@ -311,8 +346,16 @@ public:
             // Origin convolution with format converter
             return GeometryConvUtils::computeSingle(op, inputs, outputs, context, res);
         }
+        if (_fuseOnCPU(op, context)) {
+            return computeFused(op, inputs, outputs, res);
+        }
         return computeGEMM_Col2Im(op, inputs, outputs, context, res);
     }
+
+private:
+    static bool _fuseOnCPU(const Op* op, const Context& context) {
+        return context.forwardType() == MNN_FORWARD_CPU && 1 == op->main_as_Convolution2D()->common()->group();
+    }
 };
 static void _create() {
     std::shared_ptr<GeometryComputer> comp(new GeometryConv2D);
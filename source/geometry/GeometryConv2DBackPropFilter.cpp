@@ -167,14 +167,17 @@ public:
         }
         return true;
     }
+    virtual std::vector<bool> onGetOutputVirtual(const Op* op, const std::vector<Tensor*>& inputs,
+                                                 const std::vector<Tensor*>& outputs,
+                                                 const Context& context) const override {
+        return {!_fuseOnCPU(op->main_as_Convolution2D()->common(), inputs, context)};
+    }
     virtual bool onCompute(const Op* op, const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs,
                            Context& context, CommandBuffer& res) const override {
         auto common     = op->main_as_Convolution2D()->common();
         auto input      = inputs[0];
         auto outputDiff = inputs[1];
-        bool depthWise  = false;
-        if (inputs[0]->channel() == inputs[1]->channel() && inputs[1]->channel() == common->group()) {
-            depthWise = true;
+        if (_isDepthWise(common, inputs)) {
             return computeForDepthWise(common, input, outputDiff, outputs[0], context, res);
         }
         auto kw    = common->kernelX();
@@ -193,6 +196,15 @@ public:
         auto pads  = ConvolutionCommon::convolutionPad(input, outputDiff, common);
         MNN_ASSERT(TensorUtils::getDescribe(input)->dimensionFormat != MNN_DATA_FORMAT_NHWC);
         MNN_ASSERT(TensorUtils::getDescribe(outputDiff)->dimensionFormat != MNN_DATA_FORMAT_NHWC);
+        if (_fuseOnCPU(common, inputs, context)) {
+            // CPU accumulates the gradient tile by tile, so the ic*kh*kw x n*oh*ow im2col is never materialized
+            Command cmd;
+            cmd.op      = op;
+            cmd.inputs  = {input, outputDiff};
+            cmd.outputs = {outputs[0]};
+            res.command.emplace_back(std::move(cmd));
+            return true;
+        }
         Tensor* A = nullptr;
         Tensor* B = nullptr;
         {
@@ -275,6 +287,15 @@ public:
         }
         return true;
     }
+
+private:
+    static bool _isDepthWise(const Convolution2DCommon* common, const std::vector<Tensor*>& inputs) {
+        return inputs[0]->channel() == inputs[1]->channel() && inputs[1]->channel() == common->group();
+    }
+    static bool _fuseOnCPU(const Convolution2DCommon* common, const std::vector<Tensor*>& inputs,
+                           const Context& context) {
+        return context.forwardType() == MNN_FORWARD_CPU && 1 == common->group() && !_isDepthWise(common, inputs);
+    }
 };
 
 static void _create() {
@@ -35,6 +35,16 @@ public:
         const int inputDepth = input->length(2), inputHeight = input->length(3), inputWidth = input->length(4);
         const int inputChannel = input->length(1), batch = input->length(0), outputChannel = output->length(1);
 
+        if (_fuseOnCPU(inputs, outputs, context)) {
+            // CPU packs im2col tile by tile, use one command instead of materializing the full im2col tensor
+            Command cmd;
+            cmd.op      = op;
+            cmd.inputs  = {input};
+            cmd.outputs = {output};
+            res.command.emplace_back(std::move(cmd));
+            return true;
+        }
+
         auto weightTensor = context.allocConst(op, {static_cast<int>(weightData->size())}, halide_type_of<float>());
         ::memcpy(weightTensor.get()->host<float>(), weightData->data(), weightData->size()*sizeof(float));
         auto weight = weightTensor.get();
@@ -135,8 +145,17 @@ public:
     }
 
     virtual std::vector<bool> onGetOutputVirtual(const Op* op, const std::vector<Tensor*>& inputs,
-                                                 const std::vector<Tensor*>& outputs) const override {
-        return {true};
+                                                 const std::vector<Tensor*>& outputs,
+                                                 const Context& context) const override {
+        return {!_fuseOnCPU(inputs, outputs, context)};
+    }
+
+private:
+    static bool _fuseOnCPU(const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs,
+                           const Context& context) {
+        return context.forwardType() == MNN_FORWARD_CPU &&
+               TensorUtils::getDescribe(inputs[0])->dimensionFormat == MNN_DATA_FORMAT_NC4HW4 &&
+               TensorUtils::getDescribe(outputs[0])->dimensionFormat == MNN_DATA_FORMAT_NC4HW4;
     }
 };
 
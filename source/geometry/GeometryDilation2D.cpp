@@ -138,7 +138,8 @@ public:
     }
 
     virtual std::vector<bool> onGetOutputVirtual(const Op* op, const std::vector<Tensor*>& inputs,
-                                                 const std::vector<Tensor*>& outputs) const override {
+                                                 const std::vector<Tensor*>& outputs,
+                                                 const Context& context) const override {
         return {true};
     }
 };
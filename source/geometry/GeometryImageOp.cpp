@@ -181,7 +181,8 @@ public:
         return true;
     }
     virtual std::vector<bool> onGetOutputVirtual(const Op* op, const std::vector<Tensor*>& inputs,
-                                                 const std::vector<Tensor*>& outputs) const override {
+                                                 const std::vector<Tensor*>& outputs,
+                                                 const Context& context) const override {
         std::vector<bool> res(outputs.size(), false);
         auto outputDes = TensorUtils::getDescribe(outputs[0]);
         if (MNN_DATA_FORMAT_NC4HW4 != outputDes->dimensionFormat) {
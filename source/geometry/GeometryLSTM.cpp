@@ -32,6 +32,16 @@ public:
         0.
          */
         MNN_ASSERT(inputs.size() >= 4);
+        if (context.forwardType() == MNN_FORWARD_CPU) {
+            // CPU has a fused LSTM, use one command instead of the commands for each timestep
+            std::unique_ptr<OpT> lstmOp(new OpT);
+            lstmOp->type                       = OpType_LSTM;
+            lstmOp->main.type                  = OpParameter_LSTM;
+            lstmOp->main.value                 = new LSTMT;
+            lstmOp->main.AsLSTM()->outputCount = outputs[0]->length(3);
+            res.command.emplace_back(GeometryComputerUtils::makeCommand(lstmOp.get(), inputs, outputs));
+            return;
+        }
         auto X_Input      = inputs[0];
         auto W            = inputs[1];
         auto R            = inputs[2];
@@ -296,6 +306,13 @@ public:
             encode(XReverse.get(), 1);
         }
     }
+    virtual std::vector<bool> onGetOutputVirtual(const Op* op, const std::vector<Tensor*>& inputs,
+                                                 const std::vector<Tensor*>& outputs,
+                                                 const Context& context) const override {
+        // The fused LSTM of CPU computes the outputs of Onnx's LSTM directly
+        bool fused = 2 < inputs.size() && context.forwardType() == MNN_FORWARD_CPU;
+        return std::vector<bool>(outputs.size(), !fused);
+    }
     virtual bool onCompute(const Op* op, const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs,
                            Context& context, CommandBuffer& res) const override {
         if (2 < inputs.size()) {
@@ -0,0 +1,51 @@
+//
+//  ShapeAttention.cpp
+//  MNN
+//
+//  Created by MNN on 2020/11/02.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#include "shape/SizeComputer.hpp"
+#include "core/Macro.h"
+#include "core/TensorUtils.hpp"
+
+namespace MNN {
+// Q: [..., lq, d], K: [..., lk, d], V: [..., lk, dv] -> O: [..., lq, dv]
+class AttentionSizeComputer : public SizeComputer {
+    virtual bool onComputeSize(const MNN::Op* op, const std::vector<Tensor*>& inputs,
+                               const std::vector<Tensor*>& outputs) const override {
+        MNN_ASSERT(inputs.size() >= 3);
+        auto query = inputs[0];
+        auto key   = inputs[1];
+        auto value = inputs[2];
+        auto dims  = query->dimensions();
+        if (dims < 2 || key->dimensions() < 2 || value->dimensions() < 2) {
+            return false;
+        }
+        if (query->length(dims - 1) != key->length(key->dimensions() - 1)) {
+            return false;
+        }
+        if (key->length(key->dimensions() - 2) != value->length(value->dimensions() - 2)) {
+            return false;
+        }
+        auto output = outputs[0];
+        TensorUtils::copyShape(query, output, true);
+        output->setLength(dims - 1, value->length(value->dimensions() - 1));
+        output->buffer().type = query->getType();
+        return true;
+    }
+    virtual float onComputeFlops(const MNN::Op* op, const std::vector<Tensor*>& inputs,
+                                 const std::vector<Tensor*>& outputs) const override {
+        auto key   = inputs[1];
+        auto value = inputs[2];
+        auto lk    = key->length(key->dimensions() - 2);
+        auto d     = key->length(key->dimensions() - 1);
+        auto dv    = value->length(value->dimensions() - 1);
+        auto rows  = outputs[0]->elementSize() / dv;
+        return (float)rows * (float)lk * (float)(d + dv) / FLOPS_M;
+    }
+};
+
+REGISTER_SHAPE(AttentionSizeComputer, OpType_Attention);
+} // namespace MNN
@@ -0,0 +1,74 @@
+//
+//  ShapeBatchNormTrain.cpp
+//  MNN
+//
+//  Created by MNN on 2020/12/01.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#include "shape/SizeComputer.hpp"
+#include "core/Macro.h"
+#include "core/TensorUtils.hpp"
+
+namespace MNN {
+static bool _checkChannel(const Tensor* x, const Tensor* scale) {
+    if (x->dimensions() < 2 || TensorUtils::getDescribe(x)->dimensionFormat == MNN_DATA_FORMAT_NHWC) {
+        return false;
+    }
+    return scale->elementSize() == x->length(1);
+}
+
+// x: [n, c, ...], scale, bias: c elements -> y: the same as x, mean, invStd: the same as scale
+class BatchNormTrainSizeComputer : public SizeComputer {
+    virtual bool onComputeSize(const MNN::Op* op, const std::vector<Tensor*>& inputs,
+                               const std::vector<Tensor*>& outputs) const override {
+        MNN_ASSERT(inputs.size() == 3 && outputs.size() == 3);
+        auto x     = inputs[0];
+        auto scale = inputs[1];
+        if (!_checkChannel(x, scale) || inputs[2]->elementSize() != scale->elementSize()) {
+            return false;
+        }
+        TensorUtils::copyShape(x, outputs[0], true);
+        outputs[0]->buffer().type = x->getType();
+        for (int i = 1; i < 3; ++i) {
+            TensorUtils::copyShape(scale, outputs[i], true);
+            outputs[i]->buffer().type = scale->getType();
+        }
+        return true;
+    }
+    virtual float onComputeFlops(const MNN::Op* op, const std::vector<Tensor*>& inputs,
+                                 const std::vector<Tensor*>& outputs) const override {
+        return (float)inputs[0]->elementSize() * 5.0f / FLOPS_M;
+    }
+};
+
+// x, dy, scale, mean, invStd -> dx: the same as x, dScale, dBias: the same as scale
+class BatchNormGradSizeComputer : public SizeComputer {
+    virtual bool onComputeSize(const MNN::Op* op, const std::vector<Tensor*>& inputs,
+                               const std::vector<Tensor*>& outputs) const override {
+        MNN_ASSERT(inputs.size() == 5 && outputs.size() == 3);
+        auto x     = inputs[0];
+        auto scale = inputs[2];
+        if (!_checkChannel(x, scale) || inputs[1]->elementSize() != x->elementSize()) {
+            return false;
+        }
+        if (TensorUtils::getDescribe(inputs[1])->dimensionFormat != TensorUtils::getDescribe(x)->dimensionFormat) {
+            return false;
+        }
+        TensorUtils::copyShape(x, outputs[0], true);
+        outputs[0]->buffer().type = x->getType();
+        for (int i = 1; i < 3; ++i) {
+            TensorUtils::copyShape(scale, outputs[i], true);
+            outputs[i]->buffer().type = scale->getType();
+        }
+        return true;
+    }
+    virtual float onComputeFlops(const MNN::Op* op, const std::vector<Tensor*>& inputs,
+                                 const std::vector<Tensor*>& outputs) const override {
+        return (float)inputs[0]->elementSize() * 7.0f / FLOPS_M;
+    }
+};
+
+REGISTER_SHAPE(BatchNormTrainSizeComputer, OpType_BatchNormTrain);
+REGISTER_SHAPE(BatchNormGradSizeComputer, OpType_BatchNormGrad);
+} // namespace MNN
@@ -86,6 +86,9 @@ extern void ___SpaceToBatchNDSizeComputer__OpType_SpaceToBatchND__();
 extern void ___PackComputer__OpType_Pack__();
 extern void ___DeconvolutionSizeComputer__OpType_Deconvolution__();
 extern void ___DeconvolutionSizeComputer__OpType_DeconvolutionDepthwise__();
+extern void ___AttentionSizeComputer__OpType_Attention__();
+extern void ___BatchNormTrainSizeComputer__OpType_BatchNormTrain__();
+extern void ___BatchNormGradSizeComputer__OpType_BatchNormGrad__();
 
 void registerShapeOps() {
 ___ShapeSizeComputer__OpType_Shape__();
@@ -174,5 +177,8 @@ ___SpaceToBatchNDSizeComputer__OpType_SpaceToBatchND__();
 ___PackComputer__OpType_Pack__();
 ___DeconvolutionSizeComputer__OpType_Deconvolution__();
 ___DeconvolutionSizeComputer__OpType_DeconvolutionDepthwise__();
+___AttentionSizeComputer__OpType_Attention__();
+___BatchNormTrainSizeComputer__OpType_BatchNormTrain__();
+___BatchNormGradSizeComputer__OpType_BatchNormGrad__();
 }
 }
@@ -0,0 +1,137 @@
+//
+//  IncrementalResizeTest.cpp
+//  MNNTests
+//
+//  Created by MNN on 2020/11/05.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#include <math.h>
+#include <MNN/Interpreter.hpp>
+#include <MNN/expr/ExprCreator.hpp>
+#include "MNNTestSuite.h"
+#include "MNN_generated.h"
+using namespace MNN::Express;
+using namespace MNN;
+
+static void _fillInput(Interpreter* interp, Session* session, const char* name, int seed) {
+    auto input = interp->getSessionInput(session, name);
+    std::shared_ptr<Tensor> inputHost(new Tensor(input, Tensor::CAFFE));
+    for (int i = 0; i < inputHost->elementSize(); ++i) {
+        inputHost->host<float>()[i] = (float)((i + seed) % 13) / 13.0f - 0.5f;
+    }
+    input->copyFromHostTensor(inputHost.get());
+}
+
+static bool _compareOutput(Interpreter* interp, Session* session, Interpreter* expectInterp, Session* expectSession,
+                           const char* name, int index) {
+    auto output = interp->getSessionOutput(session, name);
+    auto expect = expectInterp->getSessionOutput(expectSession, name);
+    std::shared_ptr<Tensor> outputHost(new Tensor(output, Tensor::CAFFE));
+    std::shared_ptr<Tensor> expectHost(new Tensor(expect, Tensor::CAFFE));
+    output->copyToHostTensor(outputHost.get());
+    expect->copyToHostTensor(expectHost.get());
+    if (outputHost->elementSize() != expectHost->elementSize()) {
+        MNN_ERROR("Resize %d, %s size %d - %d\n", index, name, outputHost->elementSize(), expectHost->elementSize());
+        return false;
+    }
+    for (int i = 0; i < outputHost->elementSize(); ++i) {
+        auto v = outputHost->host<float>()[i];
+        auto e = expectHost->host<float>()[i];
+        if (fabsf(v - e) > 1e-4f * (1.0f + fabsf(e))) {
+            MNN_ERROR("Resize %d, %s %d: %f - %f\n", index, name, i, v, e);
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Resize a session many times while x changes its shape and y, z mostly keep theirs. Under
+   Session_Resize_Incremental the ops of y and z keep their executions and memory, and the results are the same as the
+   session resizing all ops. The first convolution reads a tensor made by the geometry, which is new in every resize,
+   so it's resized with the kept memory while the second one skips the resize */
+class IncrementalResizeTest : public MNNTestCase {
+public:
+    virtual bool run() {
+        const int ic = 8, oc = 16, kernel = 3, l = 32, n = 24;
+        auto x = _Input({1, 4, 8, 8}, NCHW, halide_type_of<float>());
+        x->setName("x");
+        auto y = _Input({1, ic, 12, 12}, NCHW, halide_type_of<float>());
+        y->setName("y");
+        auto z = _Input({16, l}, NCHW, halide_type_of<float>());
+        z->setName("z");
+        std::vector<float> weight(oc * ic * kernel * kernel), bias(oc), weight2(oc * oc), matrix(l * n);
+        for (int i = 0; i < weight.size(); ++i) {
+            weight[i] = (float)(i % 11) / 11.0f - 0.5f;
+        }
+        for (int i = 0; i < weight2.size(); ++i) {
+            weight2[i] = (float)(i % 5) / 5.0f - 0.5f;
+        }
+        for (int i = 0; i < oc; ++i) {
+            bias[i] = (float)i * 0.01f;
+        }
+        auto bias2 = bias;
+        for (int i = 0; i < matrix.size(); ++i) {
+            matrix[i] = (float)(i % 7) / 7.0f - 0.5f;
+        }
+        auto xOut = _Exp(_Abs(x));
+        xOut->setName("xOut");
+        auto yOut = _Conv(std::move(weight), std::move(bias), _Convert(y, NC4HW4), {ic, oc}, {kernel, kernel}, SAME);
+        yOut      = _Conv(std::move(weight2), std::move(bias2), _Relu(yOut), {oc, oc}, {1, 1});
+        yOut      = _Convert(yOut, NCHW);
+        yOut->setName("yOut");
+        auto zOut = _MatMul(z, _Const(matrix.data(), {l, n}, NCHW));
+        zOut->setName("zOut");
+        std::unique_ptr<MNN::NetT> net(new NetT);
+        Variable::save({xOut, yOut, zOut}, net.get());
+        flatbuffers::FlatBufferBuilder builderOutput(1024);
+        auto len = MNN::Net::Pack(builderOutput, net.get());
+        builderOutput.Finish(len);
+        std::shared_ptr<Interpreter> interp(
+            Interpreter::createFromBuffer(builderOutput.GetBufferPointer(), builderOutput.GetSize()));
+        std::shared_ptr<Interpreter> expectInterp(
+            Interpreter::createFromBuffer(builderOutput.GetBufferPointer(), builderOutput.GetSize()));
+        interp->setSessionMode(Interpreter::Session_Resize_Incremental);
+        ScheduleConfig config;
+        auto session       = interp->createSession(config);
+        auto expectSession = expectInterp->createSession(config);
+        // Shapes of x and y, y changes in the 5th resize. x gets its first shape back, then its memory is kept again
+        const int shapes[][4] = {{8, 8, 12, 12}, {9, 10, 12, 12}, {10, 12, 12, 12}, {8, 8, 12, 12},
+                                 {11, 7, 12, 12}, {11, 7, 10, 14}, {8, 8, 10, 14}};
+        for (int i = 0; i < sizeof(shapes) / sizeof(shapes[0]); ++i) {
+            auto s = shapes[i];
+            interp->resizeTensor(interp->getSessionInput(session, "x"), {1, 4, s[0], s[1]});
+            interp->resizeTensor(interp->getSessionInput(session, "y"), {1, ic, s[2], s[3]});
+            interp->resizeSession(session);
+            expectInterp->resizeTensor(expectInterp->getSessionInput(expectSession, "x"), {1, 4, s[0], s[1]});
+            expectInterp->resizeTensor(expectInterp->getSessionInput(expectSession, "y"), {1, ic, s[2], s[3]});
+            expectInterp->resizeSession(expectSession);
+            for (auto name : {"x", "y", "z"}) {
+                _fillInput(interp.get(), session, name, i);
+                _fillInput(expectInterp.get(), expectSession, name, i);
+            }
+            interp->runSession(session);
+            expectInterp->runSession(expectSession);
+            for (auto name : {"xOut", "yOut", "zOut"}) {
+                if (!_compareOutput(interp.get(), session, expectInterp.get(), expectSession, name, i)) {
+                    return false;
+                }
+            }
+            // The ReLU, the second convolution and the matmul skip the resize while only x changes
+            int skipped = 0;
+            interp->getSessionInfo(session, Interpreter::RESIZE_SKIPPED, &skipped);
+            if (i >= 1 && i <= 4 && skipped < 3) {
+                MNN_ERROR("Resize %d, %d ops skip the resize, the ops of y and z should\n", i, skipped);
+                return false;
+            }
+            int expectSkipped = 0;
+            expectInterp->getSessionInfo(expectSession, Interpreter::RESIZE_SKIPPED, &expectSkipped);
+            if (0 != expectSkipped) {
+                MNN_ERROR("Resize %d, %d ops skip the resize of Session_Resize_Full\n", i, expectSkipped);
+                return false;
+            }
+        }
+        return true;
+    }
+};
+MNNTestSuiteRegister(IncrementalResizeTest, "core/incremental_resize");
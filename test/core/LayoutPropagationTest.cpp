@@ -0,0 +1,79 @@
+//
+//  LayoutPropagationTest.cpp
+//  MNNTests
+//
+//  Created by MNN on 2020/11/10.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#include <math.h>
+#include <MNN/Interpreter.hpp>
+#include <MNN/expr/ExprCreator.hpp>
+#include "MNNTestSuite.h"
+#include "MNN_generated.h"
+using namespace MNN::Express;
+using namespace MNN;
+
+static VARP _scaleConv(VARP x, int channel, float scale) {
+    std::vector<float> weight(channel * channel, 0.0f);
+    std::vector<float> bias(channel, 0.0f);
+    for (int i = 0; i < channel; ++i) {
+        weight[i * channel + i] = scale;
+    }
+    return _Conv(std::move(weight), std::move(bias), x, {channel, channel}, {1, 1});
+}
+
+// The elementwise ops between two convolutions can run on NC4HW4 directly, with Session_Layout_Propagate
+// the NC4HW4 -> NCHW -> NC4HW4 conversions around them should be removed
+class LayoutPropagationTest : public MNNTestCase {
+public:
+    virtual bool run() {
+        const int channel = 8;
+        auto x = _Input({1, channel, 5, 7}, NCHW, halide_type_of<float>());
+        x->setName("x");
+        auto y = _Convert(_scaleConv(_Convert(x, NC4HW4), channel, 0.5f), NCHW);
+        auto z = _Multiply(_Sigmoid(y), _Relu6(y));
+        z->setName("z");
+        auto output = _Convert(_scaleConv(_Convert(z, NC4HW4), channel, 2.0f), NCHW);
+        output->setName("output");
+        std::unique_ptr<MNN::NetT> net(new NetT);
+        Variable::save({output}, net.get());
+        flatbuffers::FlatBufferBuilder builderOutput(1024);
+        auto len = MNN::Net::Pack(builderOutput, net.get());
+        builderOutput.Finish(len);
+        for (auto mode : {Interpreter::Session_Layout_Keep, Interpreter::Session_Layout_Propagate}) {
+            std::shared_ptr<Interpreter> interp(
+                Interpreter::createFromBuffer(builderOutput.GetBufferPointer(), builderOutput.GetSize()));
+            interp->setSessionMode(mode);
+            ScheduleConfig config;
+            auto session = interp->createSession(config);
+            auto input   = interp->getSessionInput(session, "x");
+            std::shared_ptr<Tensor> inputHost(new Tensor(input, Tensor::CAFFE));
+            for (int i = 0; i < inputHost->elementSize(); ++i) {
+                inputHost->host<float>()[i] = (float)(i % 17) - 8.0f;
+            }
+            input->copyFromHostTensor(inputHost.get());
+            interp->runSession(session);
+            auto outputTensor = interp->getSessionOutput(session, "output");
+            std::shared_ptr<Tensor> outputHost(new Tensor(outputTensor, Tensor::CAFFE));
+            outputTensor->copyToHostTensor(outputHost.get());
+            for (int i = 0; i < outputHost->elementSize(); ++i) {
+                auto v        = 0.5f * inputHost->host<float>()[i];
+                auto expected = 2.0f * fminf(fmaxf(v, 0.0f), 6.0f) / (1.0f + expf(-v));
+                if (fabsf(outputHost->host<float>()[i] - expected) > 1e-4f) {
+                    MNN_ERROR("Mode %d, %d: %f - %f\n", (int)mode, i, outputHost->host<float>()[i], expected);
+                    return false;
+                }
+            }
+            // Layout propagation is only done when it's asked for
+            float saved = 0.0f;
+            interp->getSessionInfo(session, Interpreter::LAYOUT_CONVERT_SAVED, &saved);
+            if ((mode == Interpreter::Session_Layout_Propagate) != (saved > 0.0f)) {
+                MNN_ERROR("Mode %d, %f MB layout conversion is removed\n", (int)mode, saved);
+                return false;
+            }
+        }
+        return true;
+    }
+};
+MNNTestSuiteRegister(LayoutPropagationTest, "core/layout_propagation");
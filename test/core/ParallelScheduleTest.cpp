@@ -0,0 +1,87 @@
+//
+//  ParallelScheduleTest.cpp
+//  MNNTests
+//
+//  Created by MNN on 2020/11/04.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#include <math.h>
+#include <MNN/Interpreter.hpp>
+#include <MNN/expr/ExprCreator.hpp>
+#include "MNNTestSuite.h"
+#include "MNN_generated.h"
+using namespace MNN::Express;
+using namespace MNN;
+
+static std::vector<float> _runNet(const void* buffer, size_t size, Interpreter::SessionMode mode) {
+    std::shared_ptr<Interpreter> interp(Interpreter::createFromBuffer(buffer, size));
+    interp->setSessionMode(mode);
+    ScheduleConfig config;
+    config.numThread = 4;
+    auto session     = interp->createSession(config);
+    auto input       = interp->getSessionInput(session, nullptr);
+    std::shared_ptr<Tensor> inputHost(new Tensor(input, Tensor::CAFFE));
+    for (int i = 0; i < inputHost->elementSize(); ++i) {
+        inputHost->host<float>()[i] = (float)(i % 17) / 17.0f - 0.5f;
+    }
+    input->copyFromHostTensor(inputHost.get());
+    interp->runSession(session);
+    auto output = interp->getSessionOutput(session, nullptr);
+    std::shared_ptr<Tensor> outputHost(new Tensor(output, Tensor::CAFFE));
+    output->copyToHostTensor(outputHost.get());
+    return std::vector<float>(outputHost->host<float>(), outputHost->host<float>() + outputHost->elementSize());
+}
+
+static bool _compareSchedule(VARP y, const char* name) {
+    std::unique_ptr<MNN::NetT> net(new NetT);
+    Variable::save({y}, net.get());
+    flatbuffers::FlatBufferBuilder builderOutput(1024);
+    auto len = MNN::Net::Pack(builderOutput, net.get());
+    builderOutput.Finish(len);
+    auto serial   = _runNet(builderOutput.GetBufferPointer(), builderOutput.GetSize(),
+                            Interpreter::Session_Schedule_Serial);
+    auto parallel = _runNet(builderOutput.GetBufferPointer(), builderOutput.GetSize(),
+                            Interpreter::Session_Schedule_Parallel);
+    if (serial.size() != parallel.size() || serial.empty()) {
+        MNN_ERROR("ParallelSchedule %s size error\n", name);
+        return false;
+    }
+    for (int i = 0; i < serial.size(); ++i) {
+        if (fabsf(serial[i] - parallel[i]) > 1e-5f * (1.0f + fabsf(serial[i]))) {
+            MNN_ERROR("ParallelSchedule %s %d: %f - %f\n", name, i, serial[i], parallel[i]);
+            return false;
+        }
+    }
+    return true;
+}
+
+class ParallelScheduleTest : public MNNTestCase {
+public:
+    virtual bool run() {
+        // Several independent branches merged at the end
+        auto x = _Input({1, 8, 16, 16}, NCHW, halide_type_of<float>());
+        std::vector<VARP> branches;
+        branches.emplace_back(_Exp(_Abs(x)));
+        branches.emplace_back(_Square(_Sin(x)));
+        branches.emplace_back(_Cos(_Negative(x)));
+        branches.emplace_back(_Tanh(_Square(x)));
+        branches.emplace_back(_Sigmoid(_Abs(x)));
+        auto y = _Concat(branches, 1);
+        y      = _Relu(y);
+        if (!_compareSchedule(y, "small")) {
+            return false;
+        }
+        // Two large matmuls, each of them computes with 2 of the 4 threads
+        const int l = 64, h = 48;
+        std::vector<float> w0(l * h), w1(l * h);
+        for (int i = 0; i < l * h; ++i) {
+            w0[i] = (float)(i % 7) / 7.0f - 0.5f;
+            w1[i] = (float)(i % 5) / 5.0f - 0.5f;
+        }
+        auto z = _Reshape(_Input({1, 8, 16, 16}, NCHW, halide_type_of<float>()), {32, l});
+        y      = _MatMul(z, _Const(w0.data(), {l, h}, NCHW)) + _MatMul(z, _Const(w1.data(), {l, h}, NCHW));
+        return _compareSchedule(y, "large");
+    }
+};
+MNNTestSuiteRegister(ParallelScheduleTest, "core/parallel_schedule");
@@ -0,0 +1,100 @@
+//
+//  SessionStateTest.cpp
+//  MNNTests
+//
+//  Created by MNN on 2020/11/26.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#include <math.h>
+#include <MNN/Interpreter.hpp>
+#include <MNN/expr/ExprCreator.hpp>
+#include "MNNTestSuite.h"
+#include "MNN_generated.h"
+using namespace MNN::Express;
+using namespace MNN;
+
+static float _frame(int t) {
+    if (t < 0) {
+        return 0.0f;
+    }
+    return (float)(t % 7) * 0.25f - 0.5f;
+}
+
+// Slice [begin, end) of the last axis, negative index counts from the end
+static VARP _slice(VARP x, int begin, int end, int endMask) {
+    int beginValue[]  = {0, 0, begin};
+    int endValue[]    = {0, 0, end};
+    int strideValue[] = {1, 1, 1};
+    return _StridedSlice(x, _Const(beginValue, {3}, NCHW, halide_type_of<int>()),
+                         _Const(endValue, {3}, NCHW, halide_type_of<int>()),
+                         _Const(strideValue, {3}, NCHW, halide_type_of<int>()), 3, 3 | endMask, 0, 0, 0);
+}
+
+// Stream frames of different chunk length through a temporal convolution of kernel 3, the last two frames of each
+// chunk are carried to the next one as a state
+class SessionStateTest : public MNNTestCase {
+public:
+    virtual bool run() {
+        auto x = _Input({1, 1, 4}, NCHW, halide_type_of<float>());
+        x->setName("x");
+        auto context = _Input({1, 1, 2}, NCHW, halide_type_of<float>());
+        context->setName("context");
+        auto full = _Concat({context, x}, 2);
+        auto y    = _slice(full, 0, -2, 0) + _slice(full, 1, -1, 0) + _slice(full, 2, 0, 4);
+        y->setName("y");
+        auto contextOutput = _slice(full, -2, 0, 4);
+        contextOutput->setName("contextOutput");
+        std::unique_ptr<MNN::NetT> net(new NetT);
+        Variable::save({y, contextOutput}, net.get());
+        flatbuffers::FlatBufferBuilder builderOutput(1024);
+        auto len = MNN::Net::Pack(builderOutput, net.get());
+        builderOutput.Finish(len);
+        std::shared_ptr<Interpreter> interp(
+            Interpreter::createFromBuffer(builderOutput.GetBufferPointer(), builderOutput.GetSize()));
+        ScheduleConfig config;
+        auto session = interp->createSession(config);
+        if (!interp->setSessionStates(session, {{"context", "contextOutput"}})) {
+            MNN_ERROR("Set session states failed\n");
+            return false;
+        }
+        if (interp->setSessionStates(session, {{"x", "z"}})) {
+            MNN_ERROR("Set session states should fail for unknown output\n");
+            return false;
+        }
+        interp->setSessionStates(session, {{"context", "contextOutput"}});
+        auto input = interp->getSessionInput(session, "x");
+        for (int pass = 0; pass < 2; ++pass) {
+            int offset = 0;
+            for (auto chunk : {4, 4, 3, 5, 1}) {
+                interp->resizeTensor(input, {1, 1, chunk});
+                interp->resizeSession(session);
+                std::shared_ptr<Tensor> inputHost(new Tensor(input, Tensor::CAFFE));
+                for (int i = 0; i < chunk; ++i) {
+                    inputHost->host<float>()[i] = _frame(offset + i);
+                }
+                input->copyFromHostTensor(inputHost.get());
+                if (NO_ERROR != interp->runSession(session)) {
+                    MNN_ERROR("Run stateful session failed\n");
+                    return false;
+                }
+                auto output = interp->getSessionOutput(session, "y");
+                std::shared_ptr<Tensor> outputHost(new Tensor(output, Tensor::CAFFE));
+                output->copyToHostTensor(outputHost.get());
+                for (int i = 0; i < chunk; ++i) {
+                    auto t        = offset + i;
+                    auto expected = _frame(t - 2) + _frame(t - 1) + _frame(t);
+                    if (fabsf(outputHost->host<float>()[i] - expected) > 1e-5f) {
+                        MNN_ERROR("pass %d, frame %d: %f - %f\n", pass, t, outputHost->host<float>()[i], expected);
+                        return false;
+                    }
+                }
+                offset += chunk;
+            }
+            // Begin a new sequence
+            interp->resetSessionStates(session);
+        }
+        return true;
+    }
+};
+MNNTestSuiteRegister(SessionStateTest, "core/session_state");
@@ -0,0 +1,160 @@
+//
+//  ThreadAffinityTest.cpp
+//  MNNTests
+//
+//  Created by MNN on 2020/11/30.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#include <math.h>
+#include <MNN/Interpreter.hpp>
+#include <MNN/expr/ExprCreator.hpp>
+#include <MNN/expr/Executor.hpp>
+#include "MNNTestSuite.h"
+#include "MNN_generated.h"
+#if defined(MNN_USE_THREAD_POOL) && defined(__linux__) && !defined(__ANDROID__)
+#include <sched.h>
+#include "backend/cpu/ThreadPool.hpp"
+#define MNN_TEST_THREAD_PLACEMENT
+#endif
+using namespace MNN::Express;
+using namespace MNN;
+
+static std::vector<float> _runNet(const void* buffer, size_t size, int numThread, BackendConfig::AffinityMode mode) {
+    std::shared_ptr<Interpreter> interp(Interpreter::createFromBuffer(buffer, size));
+    ScheduleConfig config;
+    BackendConfig backendConfig;
+    backendConfig.affinity = mode;
+    config.numThread       = numThread;
+    config.backendConfig   = &backendConfig;
+    auto session           = interp->createSession(config);
+    auto input             = interp->getSessionInput(session, nullptr);
+    std::shared_ptr<Tensor> inputHost(new Tensor(input, Tensor::CAFFE));
+    for (int i = 0; i < inputHost->elementSize(); ++i) {
+        inputHost->host<float>()[i] = (float)(i % 13) / 13.0f - 0.5f;
+    }
+    // Run twice, the threads are pinned from the first task
+    for (int i = 0; i < 2; ++i) {
+        input->copyFromHostTensor(inputHost.get());
+        interp->runSession(session);
+    }
+    auto output = interp->getSessionOutput(session, nullptr);
+    std::shared_ptr<Tensor> outputHost(new Tensor(output, Tensor::CAFFE));
+    output->copyToHostTensor(outputHost.get());
+    return std::vector<float>(outputHost->host<float>(), outputHost->host<float>() + outputHost->elementSize());
+}
+
+// The result of every placement of the threads is the same as the single thread one
+class ThreadAffinityTest : public MNNTestCase {
+public:
+    virtual bool run() {
+        const int ic = 16, oc = 32, kernel = 3;
+        auto x = _Input({1, ic, 24, 24}, NCHW, halide_type_of<float>());
+        std::vector<float> weight(oc * ic * kernel * kernel), bias(oc);
+        for (int i = 0; i < weight.size(); ++i) {
+            weight[i] = (float)(i % 11) / 11.0f - 0.5f;
+        }
+        for (int i = 0; i < oc; ++i) {
+            bias[i] = (float)i * 0.01f;
+        }
+        auto y = _Conv(std::move(weight), std::move(bias), _Convert(x, NC4HW4), {ic, oc}, {kernel, kernel}, SAME);
+        y      = _Convert(_Relu(y), NCHW);
+        std::unique_ptr<MNN::NetT> net(new NetT);
+        Variable::save({y}, net.get());
+        flatbuffers::FlatBufferBuilder builderOutput(1024);
+        auto len = MNN::Net::Pack(builderOutput, net.get());
+        builderOutput.Finish(len);
+        auto buffer   = builderOutput.GetBufferPointer();
+        auto size     = builderOutput.GetSize();
+        auto expected = _runNet(buffer, size, 1, BackendConfig::Affinity_None);
+        if (expected.empty()) {
+            MNN_ERROR("ThreadAffinity compute error\n");
+            return false;
+        }
+        // Affinity_Reset removes the pinning of the shared thread pool for the tests after this one
+        bool res = true;
+        for (auto mode : {BackendConfig::Affinity_Compact, BackendConfig::Affinity_Scatter,
+                          BackendConfig::Affinity_Node, BackendConfig::Affinity_None,
+                          BackendConfig::Affinity_Reset}) {
+            auto result = _runNet(buffer, size, 4, mode);
+            if (result.size() != expected.size()) {
+                MNN_ERROR("ThreadAffinity mode %d size error\n", (int)mode);
+                res = false;
+                continue;
+            }
+            for (int i = 0; i < expected.size(); ++i) {
+                if (fabsf(result[i] - expected[i]) > 1e-4f * (1.0f + fabsf(expected[i]))) {
+                    MNN_ERROR("ThreadAffinity mode %d, %d: %f - %f\n", (int)mode, i, result[i], expected[i]);
+                    res = false;
+                    break;
+                }
+            }
+        }
+        return res;
+    }
+};
+MNNTestSuiteRegister(ThreadAffinityTest, "core/thread_affinity");
+
+#ifdef MNN_TEST_THREAD_PLACEMENT
+// Number of cpus each thread of the shared pool can run on, the first one is the calling thread
+static std::vector<int> _poolCPUCount(int index, int number) {
+    std::vector<int> result(number, 0);
+    ThreadPool::active(index);
+    ThreadPool::enqueue(std::make_pair(
+                            [&result](int tId) {
+                                cpu_set_t mask;
+                                CPU_ZERO(&mask);
+                                if (0 == sched_getaffinity(0, sizeof(mask), &mask)) {
+                                    result[tId] = CPU_COUNT(&mask);
+                                }
+                            },
+                            number),
+                        index);
+    ThreadPool::deactive(index);
+    return result;
+}
+
+// A runtime made with the default BackendConfig keeps the placement of the shared pool, Affinity_Reset removes it
+class ThreadPlacementTest : public MNNTestCase {
+public:
+    virtual bool run() {
+        int number = ThreadPool::init(4);
+        cpu_set_t mask;
+        CPU_ZERO(&mask);
+        if (number < 2 || 0 != sched_getaffinity(0, sizeof(mask), &mask)) {
+            return true;
+        }
+        int total = CPU_COUNT(&mask);
+        auto index = ThreadPool::acquireWorkIndex();
+        if (index < 0) {
+            MNN_ERROR("ThreadPlacement no work index of the shared pool\n");
+            return false;
+        }
+        bool res = true;
+        ThreadPool::setAffinity(BackendConfig::Affinity_Compact);
+        {
+            BackendConfig config;
+            auto executor = Executor::newExecutor(MNN_FORWARD_CPU, config, 4);
+        }
+        auto count = _poolCPUCount(index, number);
+        for (int i = 1; i < number; ++i) {
+            if (1 != count[i]) {
+                MNN_ERROR("ThreadPlacement thread %d is not pinned after a runtime of default config: %d\n", i,
+                          count[i]);
+                res = false;
+            }
+        }
+        ThreadPool::setAffinity(BackendConfig::Affinity_Reset);
+        count = _poolCPUCount(index, number);
+        for (int i = 1; i < number; ++i) {
+            if (total != count[i]) {
+                MNN_ERROR("ThreadPlacement thread %d is not reset: %d - %d\n", i, count[i], total);
+                res = false;
+            }
+        }
+        ThreadPool::releaseWorkIndex(index);
+        return res;
+    }
+};
+MNNTestSuiteRegister(ThreadPlacementTest, "core/thread_placement");
+#endif
@@ -0,0 +1,262 @@
+//
+//  WeightCacheTest.cpp
+//  MNNTests
+//
+//  Created by MNN on 2020/11/17.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <MNN/Interpreter.hpp>
+#include <MNN/expr/ExprCreator.hpp>
+#include "MNNTestSuite.h"
+#include "MNN_generated.h"
+using namespace MNN::Express;
+using namespace MNN;
+
+static VARP _testConv(VARP x, int inputChannel, int outputChannel, int kernel, int seed) {
+    std::vector<float> weight(outputChannel * inputChannel * kernel * kernel);
+    std::vector<float> bias(outputChannel);
+    for (int i = 0; i < weight.size(); ++i) {
+        weight[i] = (float)((i * 13 + seed) % 19) / 19.0f - 0.5f;
+    }
+    for (int i = 0; i < bias.size(); ++i) {
+        bias[i] = (float)(i % 5) * 0.1f;
+    }
+    return _Conv(std::move(weight), std::move(bias), x, {inputChannel, outputChannel}, {kernel, kernel}, SAME);
+}
+
+static std::vector<uint8_t> _buildModel(int seed) {
+    auto x = _Input({1, 6, 14, 14}, NC4HW4, halide_type_of<float>());
+    x->setName("x");
+    auto y      = _testConv(_testConv(x, 6, 16, 1, seed), 16, 8, 3, seed + 2);
+    auto output = _Convert(_testConv(y, 8, 4, 5, seed + 6), NCHW);
+    output->setName("output");
+    std::unique_ptr<MNN::NetT> net(new NetT);
+    Variable::save({output}, net.get());
+    flatbuffers::FlatBufferBuilder builderOutput(1024);
+    auto len = MNN::Net::Pack(builderOutput, net.get());
+    builderOutput.Finish(len);
+    return std::vector<uint8_t>(builderOutput.GetBufferPointer(),
+                                builderOutput.GetBufferPointer() + builderOutput.GetSize());
+}
+
+static std::vector<float> _runModel(const std::vector<uint8_t>& model, const char* cacheFile, size_t keySize) {
+    std::shared_ptr<Interpreter> interp(Interpreter::createFromBuffer(model.data(), model.size()));
+    if (nullptr != cacheFile) {
+        interp->setCacheFile(cacheFile, keySize);
+    }
+    ScheduleConfig config;
+    auto session = interp->createSession(config);
+    auto input   = interp->getSessionInput(session, "x");
+    std::shared_ptr<Tensor> inputHost(new Tensor(input, Tensor::CAFFE));
+    for (int j = 0; j < inputHost->elementSize(); ++j) {
+        inputHost->host<float>()[j] = (float)(j % 23) / 23.0f - 0.5f;
+    }
+    input->copyFromHostTensor(inputHost.get());
+    interp->runSession(session);
+    auto outputTensor = interp->getSessionOutput(session, "output");
+    std::shared_ptr<Tensor> outputHost(new Tensor(outputTensor, Tensor::CAFFE));
+    outputTensor->copyToHostTensor(outputHost.get());
+    return std::vector<float>(outputHost->host<float>(), outputHost->host<float>() + outputHost->elementSize());
+}
+
+static bool _sameResult(const std::vector<float>& result, const std::vector<float>& expected) {
+    if (result.empty() || result.size() != expected.size()) {
+        return false;
+    }
+    for (int i = 0; i < result.size(); ++i) {
+        if (fabsf(result[i] - expected[i]) > 1e-5f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool _readFile(const char* fileName, std::vector<uint8_t>& content) {
+    FILE* f = fopen(fileName, "rb");
+    if (nullptr == f) {
+        return false;
+    }
+    fseek(f, 0, SEEK_END);
+    content.resize(ftell(f));
+    fseek(f, 0, SEEK_SET);
+    auto size = fread(content.data(), 1, content.size(), f);
+    fclose(f);
+    return size == content.size();
+}
+
+static bool _writeFile(const char* fileName, const std::vector<uint8_t>& content) {
+    FILE* f = fopen(fileName, "wb");
+    if (nullptr == f) {
+        return false;
+    }
+    auto size = fwrite(content.data(), 1, content.size(), f);
+    fclose(f);
+    return size == content.size();
+}
+
+// Zero the packed weights in the cache, see CPURuntime::onSetCache for the layout
+static bool _clearPackedWeights(std::vector<uint8_t>& cache, size_t offset) {
+    auto ptr = cache.data() + offset;
+    auto end = cache.data() + cache.size();
+    if (ptr + sizeof(uint32_t) > end) {
+        return false;
+    }
+    uint32_t number = *(const uint32_t*)ptr;
+    ptr += sizeof(uint32_t);
+    for (uint32_t i = 0; i < number; ++i) {
+        uint32_t keySize = 0;
+        uint64_t dataSize = 0;
+        ::memcpy(&keySize, ptr, sizeof(uint32_t));
+        ptr += sizeof(uint32_t) + keySize;
+        ::memcpy(&dataSize, ptr, sizeof(uint64_t));
+        ptr += sizeof(uint64_t);
+        if (ptr + dataSize > end) {
+            return false;
+        }
+        ::memset(ptr, 0, dataSize);
+        ptr += dataSize;
+    }
+    return number > 0;
+}
+
+/* The packed weights are saved to the cache file by the first interpreter and loaded by the next ones.
+   The key size is zero so that the cache file of one model is also accepted by the model with other weights,
+   which must not use the stale packed weights */
+class WeightCacheTest : public MNNTestCase {
+public:
+    virtual bool run() {
+        const char* cacheFile = "weight_cache_test.cache";
+        auto model            = _buildModel(1);
+        auto otherModel       = _buildModel(4);
+        auto expected         = _runModel(model, nullptr, 0);
+        auto otherExpected    = _runModel(otherModel, nullptr, 0);
+        ::remove(cacheFile);
+        auto recorded = _runModel(model, cacheFile, 0);
+        std::vector<uint8_t> cache;
+        if (!_readFile(cacheFile, cache)) {
+            MNN_ERROR("The cache file is not written\n");
+            return false;
+        }
+        bool res = true;
+        if (!_sameResult(recorded, expected) || !_sameResult(_runModel(model, cacheFile, 0), expected)) {
+            MNN_ERROR("Weight cache result error\n");
+            res = false;
+        }
+        if (res && !_sameResult(_runModel(otherModel, cacheFile, 0), otherExpected)) {
+            MNN_ERROR("Weight cache of other weights is used\n");
+            res = false;
+        }
+        // The result must change with the packed weights in the cache, which shows that the cache is used
+        if (res && (!_clearPackedWeights(cache, 0) || !_writeFile(cacheFile, cache) ||
+                    _sameResult(_runModel(model, cacheFile, 0), expected))) {
+            MNN_ERROR("Weight cache is not used\n");
+            res = false;
+        }
+        ::remove(cacheFile);
+        return res;
+    }
+};
+MNNTestSuiteRegister(WeightCacheTest, "core/weight_cache");
+
+// The sessions of one interpreter share the packed weights, which must stay valid while any of them is alive
+class WeightShareTest : public MNNTestCase {
+public:
+    virtual bool run() {
+        auto x = _Input({1, 6, 14, 14}, NC4HW4, halide_type_of<float>());
+        x->setName("x");
+        auto y      = _testConv(_testConv(x, 6, 16, 1, 1), 16, 8, 3, 3);
+        auto output = _Convert(_testConv(y, 8, 4, 5, 7), NCHW);
+        output->setName("output");
+        std::unique_ptr<MNN::NetT> net(new NetT);
+        Variable::save({output}, net.get());
+        flatbuffers::FlatBufferBuilder builderOutput(1024);
+        auto len = MNN::Net::Pack(builderOutput, net.get());
+        builderOutput.Finish(len);
+        std::shared_ptr<Interpreter> interp(
+            Interpreter::createFromBuffer(builderOutput.GetBufferPointer(), builderOutput.GetSize()));
+        auto runSession = [&](Session* session, std::vector<float>& result) {
+            auto input = interp->getSessionInput(session, "x");
+            std::shared_ptr<Tensor> inputHost(new Tensor(input, Tensor::CAFFE));
+            for (int j = 0; j < inputHost->elementSize(); ++j) {
+                inputHost->host<float>()[j] = (float)(j % 23) / 23.0f - 0.5f;
+            }
+            input->copyFromHostTensor(inputHost.get());
+            interp->runSession(session);
+            auto outputTensor = interp->getSessionOutput(session, "output");
+            std::shared_ptr<Tensor> outputHost(new Tensor(outputTensor, Tensor::CAFFE));
+            outputTensor->copyToHostTensor(outputHost.get());
+            result.assign(outputHost->host<float>(), outputHost->host<float>() + outputHost->elementSize());
+        };
+        ScheduleConfig config;
+        std::vector<Session*> sessions;
+        for (int i = 0; i < 3; ++i) {
+            sessions.emplace_back(interp->createSession(config));
+        }
+        std::vector<float> expected;
+        runSession(sessions[0], expected);
+        // Release the session that packed the weights first
+        interp->releaseSession(sessions[0]);
+        sessions.emplace_back(interp->createSession(config));
+        for (int i = 1; i < sessions.size(); ++i) {
+            std::vector<float> result;
+            runSession(sessions[i], result);
+            if (result.size() != expected.size()) {
+                MNN_ERROR("Weight share output size error\n");
+                return false;
+            }
+            for (int j = 0; j < expected.size(); ++j) {
+                if (fabsf(result[j] - expected[j]) > 1e-5f) {
+                    MNN_ERROR("Weight share session %d, %d: %f - %f\n", i, j, result[j], expected[j]);
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+};
+MNNTestSuiteRegister(WeightShareTest, "core/weight_share");
+
+// The interpreters sharing a RuntimeInfo keep their own packed weights, the models have the same structure so the
+// ops are at the same offsets of the buffers
+class WeightShareRuntimeTest : public MNNTestCase {
+public:
+    virtual bool run() {
+        std::vector<std::vector<uint8_t>> models = {_buildModel(1), _buildModel(4)};
+        ScheduleConfig config;
+        auto runtime = Interpreter::createRuntime({config});
+        for (int i = 0; i < models.size(); ++i) {
+            auto expected = _runModel(models[i], nullptr, 0);
+            std::vector<std::shared_ptr<Interpreter>> interps;
+            std::vector<Session*> sessions;
+            // The first interpreter packs the other model
+            for (int j = 0; j < models.size(); ++j) {
+                auto& model = models[(i + 1 + j) % models.size()];
+                interps.emplace_back(Interpreter::createFromBuffer(model.data(), model.size()));
+                sessions.emplace_back(interps[j]->createSession(config, runtime));
+            }
+            auto interp = interps[models.size() - 1];
+            auto input  = interp->getSessionInput(sessions[models.size() - 1], "x");
+            std::shared_ptr<Tensor> inputHost(new Tensor(input, Tensor::CAFFE));
+            for (int j = 0; j < inputHost->elementSize(); ++j) {
+                inputHost->host<float>()[j] = (float)(j % 23) / 23.0f - 0.5f;
+            }
+            input->copyFromHostTensor(inputHost.get());
+            interp->runSession(sessions[models.size() - 1]);
+            auto outputTensor = interp->getSessionOutput(sessions[models.size() - 1], "output");
+            std::shared_ptr<Tensor> outputHost(new Tensor(outputTensor, Tensor::CAFFE));
+            outputTensor->copyToHostTensor(outputHost.get());
+            std::vector<float> result(outputHost->host<float>(),
+                                      outputHost->host<float>() + outputHost->elementSize());
+            if (!_sameResult(result, expected)) {
+                MNN_ERROR("Weight share of model %d uses the weights of another interpreter\n", i);
+                return false;
+            }
+        }
+        return true;
+    }
+};
+MNNTestSuiteRegister(WeightShareRuntimeTest, "core/weight_share_runtime");
@@ -0,0 +1,85 @@
+//
+//  AttentionTest.cpp
+//  MNNTests
+//
+//  Created by MNN on 2020/11/02.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#include <math.h>
+#include <MNN/expr/ExprCreator.hpp>
+#include "MNNTestSuite.h"
+using namespace MNN::Express;
+
+static void referenceAttention(const float* q, const float* k, const float* v, float* o, int batch, int lq, int lk,
+                               int d, int dv, bool causal) {
+    std::vector<float> scores(lk);
+    float scale = 1.0f / sqrtf((float)d);
+    for (int b = 0; b < batch; ++b) {
+        for (int y = 0; y < lq; ++y) {
+            auto qY   = q + (b * lq + y) * d;
+            int kEnd  = causal ? std::min(lk, y + 1 + lk - lq) : lk;
+            float maxValue = -1000000.0f;
+            for (int x = 0; x < kEnd; ++x) {
+                float sum = 0.0f;
+                for (int z = 0; z < d; ++z) {
+                    sum += qY[z] * k[(b * lk + x) * d + z];
+                }
+                scores[x] = sum * scale;
+                maxValue  = std::max(maxValue, scores[x]);
+            }
+            float sumValue = 0.0f;
+            for (int x = 0; x < kEnd; ++x) {
+                scores[x] = expf(scores[x] - maxValue);
+                sumValue += scores[x];
+            }
+            for (int z = 0; z < dv; ++z) {
+                float sum = 0.0f;
+                for (int x = 0; x < kEnd; ++x) {
+                    sum += scores[x] * v[(b * lk + x) * dv + z];
+                }
+                o[(b * lq + y) * dv + z] = sum / sumValue;
+            }
+        }
+    }
+}
+
+class AttentionTest : public MNNTestCase {
+public:
+    virtual bool run() {
+        const int batch = 3, lq = 7, lk = 150, d = 12, dv = 9;
+        auto query = _Input({batch, lq, d}, NHWC);
+        auto key   = _Input({batch, lk, d}, NHWC);
+        auto value = _Input({batch, lk, dv}, NHWC);
+        auto fill  = [](VARP x, float offset) {
+            auto size = x->getInfo()->size;
+            auto ptr  = x->writeMap<float>();
+            for (int i = 0; i < size; ++i) {
+                ptr[i] = (float)((i * 7 + 3) % 23) / 23.0f - 0.5f + offset;
+            }
+        };
+        fill(query, 0.0f);
+        fill(key, 0.1f);
+        fill(value, -0.2f);
+        std::vector<float> expected(batch * lq * dv);
+        for (int c = 0; c < 2; ++c) {
+            bool causal = c > 0;
+            referenceAttention(query->readMap<float>(), key->readMap<float>(), value->readMap<float>(),
+                               expected.data(), batch, lq, lk, d, dv, causal);
+            auto output = _ScaledDotProductAttention(query, key, value, nullptr, 0.0f, causal);
+            auto ptr    = output->readMap<float>();
+            if (nullptr == ptr || output->getInfo()->size != expected.size()) {
+                MNN_ERROR("Attention compute error\n");
+                return false;
+            }
+            for (int i = 0; i < expected.size(); ++i) {
+                if (fabsf(ptr[i] - expected[i]) > 0.001f) {
+                    MNN_ERROR("Attention causal=%d, %d: %f - %f\n", causal, i, ptr[i], expected[i]);
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+};
+MNNTestSuiteRegister(AttentionTest, "expr/Attention");
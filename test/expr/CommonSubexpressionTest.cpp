@@ -0,0 +1,70 @@
+//
+//  CommonSubexpressionTest.cpp
+//  MNNTests
+//
+//  Created by MNN on 2020/11/18.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#include <math.h>
+#include <MNN/expr/Executor.hpp>
+#include <MNN/expr/ExprCreator.hpp>
+#include "MNNTestSuite.h"
+using namespace MNN::Express;
+
+// The same transpose and multiply are built twice, only one of them should be computed
+class CommonSubexpressionTest : public MNNTestCase {
+public:
+    virtual bool run() {
+        auto executor = Executor::getGlobalExecutor();
+        auto before   = executor->getEliminatedInfo();
+        const int h = 3, w = 5;
+        auto x    = _Input({h, w}, NCHW);
+        auto xPtr = x->writeMap<float>();
+        for (int i = 0; i < h * w; ++i) {
+            xPtr[i] = (float)i - 7.0f;
+        }
+        auto a      = _Transpose(x, {1, 0}) * _Scalar<float>(2.0f);
+        auto b      = _Transpose(x, {1, 0}) * _Scalar<float>(2.0f);
+        auto output = a + b;
+        auto outPtr = output->readMap<float>();
+        if (nullptr == outPtr) {
+            MNN_ERROR("CSE compute error\n");
+            return false;
+        }
+        for (int y = 0; y < w; ++y) {
+            for (int x = 0; x < h; ++x) {
+                auto expected = 4.0f * xPtr[x * w + y];
+                if (fabsf(outPtr[y * h + x] - expected) > 1e-5f) {
+                    MNN_ERROR("CSE error at %d, %d: %f - %f\n", y, x, outPtr[y * h + x], expected);
+                    return false;
+                }
+            }
+        }
+        auto after = executor->getEliminatedInfo();
+        if (after.first - before.first < 2 || after.second - before.second < 2 * h * w * sizeof(float)) {
+            MNN_ERROR("CSE removed %d exprs, %d bytes, expect at least 2 exprs\n", after.first - before.first,
+                      (int)(after.second - before.second));
+            return false;
+        }
+        // The replaced multiply no longer outputs to the add
+        for (auto& to : b->expr().first->outputs()) {
+            if (to.lock() == output->expr().first) {
+                MNN_ERROR("CSE keeps the link from the replaced expr\n");
+                return false;
+            }
+        }
+        // The inputs are still linked to the kept exprs
+        xPtr = x->writeMap<float>();
+        for (int i = 0; i < h * w; ++i) {
+            xPtr[i] = 1.0f;
+        }
+        outPtr = output->readMap<float>();
+        if (nullptr == outPtr || fabsf(outPtr[0] - 4.0f) > 1e-5f) {
+            MNN_ERROR("CSE result is not updated after the input changed\n");
+            return false;
+        }
+        return true;
+    }
+};
+MNNTestSuiteRegister(CommonSubexpressionTest, "expr/CommonSubexpression");
@@ -0,0 +1,90 @@
+//
+//  ElementwiseFusionTest.cpp
+//  MNNTests
+//
+//  Created by MNN on 2020/11/13.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#include <math.h>
+#include <algorithm>
+#include <MNN/expr/ExprCreator.hpp>
+#include "MNNTestSuite.h"
+#include "geometry/GeometryComputerUtils.hpp"
+using namespace MNN::Express;
+using namespace MNN;
+
+// Chains of elementwise ops are fused by the executor, the result must be the same as unfused ops
+class ElementwiseFusionTest : public MNNTestCase {
+public:
+    virtual bool run() {
+        const int size = 2000;
+        std::vector<float> data(size);
+        for (int i = 0; i < size; ++i) {
+            data[i] = (float)(i % 23) * 0.5f - 5.0f;
+        }
+        auto x = _Input({2, size / 2}, NCHW);
+        ::memcpy(x->writeMap<float>(), data.data(), size * sizeof(float));
+        x->unMap();
+        // y is read both by the fused chain and by the reduce
+        auto y = x * _Scalar<float>(0.5f) + _Scalar<float>(1.0f);
+        auto z = _Relu6(_Sigmoid(y) * y) - _Square(y);
+        auto output = z + _ReduceSum(y);
+        auto outPtr = output->readMap<float>();
+        if (nullptr == outPtr) {
+            MNN_ERROR("ElementwiseFusion compute error\n");
+            return false;
+        }
+        float sum = 0.0f;
+        for (int i = 0; i < size; ++i) {
+            sum += data[i] * 0.5f + 1.0f;
+        }
+        for (int i = 0; i < size; ++i) {
+            float yv       = data[i] * 0.5f + 1.0f;
+            float expected = std::min(std::max(yv / (1.0f + expf(-yv)), 0.0f), 6.0f) - yv * yv + sum;
+            if (fabsf(outPtr[i] - expected) > 1e-3f * std::max(1.0f, fabsf(expected))) {
+                MNN_ERROR("ElementwiseFusion %d: %f - %f\n", i, outPtr[i], expected);
+                return false;
+            }
+        }
+        return true;
+    }
+};
+MNNTestSuiteRegister(ElementwiseFusionTest, "expr/ElementwiseFusion");
+
+// The same chain as commands: the elementwise ones become one command, y is still written for the reduce
+class ElementwiseFusionCommandTest : public MNNTestCase {
+public:
+    virtual bool run() {
+        std::vector<std::shared_ptr<Tensor>> tensors;
+        auto create = [&tensors](std::vector<int> shape) {
+            tensors.emplace_back(Tensor::createDevice<float>(shape));
+            return tensors.back().get();
+        };
+        auto x = create({2, 1000}), half = create({}), one = create({});
+        auto t0 = create({2, 1000}), y = create({2, 1000}), t1 = create({2, 1000}), t2 = create({2, 1000});
+        auto t3 = create({2, 1000}), z = create({2, 1000}), r = create({});
+        CommandBuffer buffer;
+        buffer.command.emplace_back(GeometryComputerUtils::makeBinary(BinaryOpOperation_MUL, x, half, t0));
+        buffer.command.emplace_back(GeometryComputerUtils::makeBinary(BinaryOpOperation_ADD, t0, one, y));
+        buffer.command.emplace_back(GeometryComputerUtils::makeUnary(UnaryOpOperation_SIGMOID, y, t1));
+        buffer.command.emplace_back(GeometryComputerUtils::makeBinary(BinaryOpOperation_MUL, t1, y, t2));
+        buffer.command.emplace_back(GeometryComputerUtils::makeUnary(UnaryOpOperation_SQUARE, y, t3));
+        buffer.command.emplace_back(GeometryComputerUtils::makeBinary(BinaryOpOperation_SUB, t2, t3, z));
+        buffer.command.emplace_back(GeometryComputerUtils::makeReduce(ReductionType_SUM, y, r));
+        auto removed = GeometryComputerUtils::fuseElementwise(buffer);
+        if (removed != 5 || buffer.command.size() != 2) {
+            MNN_ERROR("ElementwiseFusion removed %d commands, %d left, expect 5 and 2\n", (int)removed,
+                      (int)buffer.command.size());
+            return false;
+        }
+        auto& fused = buffer.command[0];
+        if (fused.op->type() != OpType_Extra || fused.inputs != std::vector<Tensor*>({x, half, one}) ||
+            fused.outputs != std::vector<Tensor*>({y, z})) {
+            MNN_ERROR("ElementwiseFusion makes a wrong fused command\n");
+            return false;
+        }
+        return buffer.command[1].op->type() == OpType_Reduction && buffer.command[1].inputs[0] == y;
+    }
+};
+MNNTestSuiteRegister(ElementwiseFusionCommandTest, "expr/ElementwiseFusionCommand");
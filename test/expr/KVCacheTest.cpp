@@ -0,0 +1,139 @@
+//
+//  KVCacheTest.cpp
+//  MNNTests
+//
+//  Created by MNN on 2020/11/27.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#include <math.h>
+#include <MNN/expr/ExprCreator.hpp>
+#include <MNN/expr/KVCache.hpp>
+#include "MNNTestSuite.h"
+using namespace MNN::Express;
+
+static float _value(int index, float offset) {
+    return (float)((index * 7 + 3) % 23) / 23.0f - 0.5f + offset;
+}
+
+// Causal attention of the last lq keys over all lk keys, K / V: [batch, lk, d]
+static void _referenceAttention(const std::vector<float>& q, const std::vector<float>& k, const std::vector<float>& v,
+                                std::vector<float>& o, int batch, int lq, int lk, int d) {
+    std::vector<float> scores(lk);
+    float scale = 1.0f / sqrtf((float)d);
+    o.resize(batch * lq * d);
+    for (int b = 0; b < batch; ++b) {
+        for (int y = 0; y < lq; ++y) {
+            int kEnd       = y + 1 + lk - lq;
+            float maxValue = -1000000.0f;
+            for (int x = 0; x < kEnd; ++x) {
+                float sum = 0.0f;
+                for (int z = 0; z < d; ++z) {
+                    sum += q[(b * lq + y) * d + z] * k[(b * lk + x) * d + z];
+                }
+                scores[x] = sum * scale;
+                maxValue  = std::max(maxValue, scores[x]);
+            }
+            float sumValue = 0.0f;
+            for (int x = 0; x < kEnd; ++x) {
+                scores[x] = expf(scores[x] - maxValue);
+                sumValue += scores[x];
+            }
+            for (int z = 0; z < d; ++z) {
+                float sum = 0.0f;
+                for (int x = 0; x < kEnd; ++x) {
+                    sum += scores[x] * v[(b * lk + x) * d + z];
+                }
+                o[(b * lq + y) * d + z] = sum / sumValue;
+            }
+        }
+    }
+}
+
+// Prefill some tokens and decode one token per step, the attention reads the key / value caches which grow past
+// their initial capacity
+class KVCacheTest : public MNNTestCase {
+public:
+    virtual bool run() {
+        const int batch = 2, d = 8, prefill = 5, steps = 12;
+        KVCache key({batch, 4, d});
+        KVCache value({batch, 4, d});
+        // All keys / values so far, [batch, lk, d]
+        std::vector<float> keys, values;
+        int step = 0;
+        auto feed = [&](int number) {
+            auto k = _Input({batch, number, d}, NCHW);
+            auto v = _Input({batch, number, d}, NCHW);
+            auto kPtr = k->writeMap<float>();
+            auto vPtr = v->writeMap<float>();
+            std::vector<float> newKeys(batch * (key.size() + number) * d), newValues(newKeys.size());
+            for (int b = 0; b < batch; ++b) {
+                for (int x = 0; x < key.size() + number; ++x) {
+                    for (int z = 0; z < d; ++z) {
+                        auto dst = (b * (key.size() + number) + x) * d + z;
+                        if (x < key.size()) {
+                            newKeys[dst]   = keys[(b * key.size() + x) * d + z];
+                            newValues[dst] = values[(b * key.size() + x) * d + z];
+                            continue;
+                        }
+                        auto src       = (b * number + x - key.size()) * d + z;
+                        kPtr[src]      = _value(src + step * 5, 0.1f);
+                        vPtr[src]      = _value(src + step * 11, -0.2f);
+                        newKeys[dst]   = kPtr[src];
+                        newValues[dst] = vPtr[src];
+                    }
+                }
+            }
+            keys.swap(newKeys);
+            values.swap(newValues);
+            return key.append(k) && value.append(v);
+        };
+        auto check = [&](VARP query, VARP output, int lq) {
+            std::vector<float> q(query->readMap<float>(), query->readMap<float>() + batch * lq * d);
+            std::vector<float> expected;
+            _referenceAttention(q, keys, values, expected, batch, lq, key.size(), d);
+            auto ptr = output->readMap<float>();
+            if (nullptr == ptr || output->getInfo()->size != expected.size()) {
+                MNN_ERROR("Cached attention compute error at step %d\n", step);
+                return false;
+            }
+            for (int i = 0; i < expected.size(); ++i) {
+                if (fabsf(ptr[i] - expected[i]) > 0.001f) {
+                    MNN_ERROR("Cached attention step %d, %d: %f - %f\n", step, i, ptr[i], expected[i]);
+                    return false;
+                }
+            }
+            return true;
+        };
+        auto fillQuery = [&](VARP query) {
+            auto size = query->getInfo()->size;
+            auto ptr  = query->writeMap<float>();
+            for (int i = 0; i < size; ++i) {
+                ptr[i] = _value(i + step * 3, 0.0f);
+            }
+        };
+
+        auto prefillQuery  = _Input({batch, prefill, d}, NCHW);
+        auto prefillOutput = _ScaledDotProductAttention(prefillQuery, key.cache(), value.cache(), nullptr, 0.0f, true,
+                                                        key.length());
+        fillQuery(prefillQuery);
+        if (!feed(prefill) || !check(prefillQuery, prefillOutput, prefill)) {
+            return false;
+        }
+        // The graph is built once and recomputed for each token
+        auto query  = _Input({batch, 1, d}, NCHW);
+        auto output = _ScaledDotProductAttention(query, key.cache(), value.cache(), nullptr, 0.0f, true, key.length());
+        for (step = 1; step <= steps; ++step) {
+            fillQuery(query);
+            if (!feed(1) || !check(query, output, 1)) {
+                return false;
+            }
+        }
+        if (key.size() != prefill + steps || key.capacity() != 32) {
+            MNN_ERROR("KVCache size %d, capacity %d\n", key.size(), key.capacity());
+            return false;
+        }
+        return true;
+    }
+};
+MNNTestSuiteRegister(KVCacheTest, "expr/KVCache");
@@ -230,6 +230,30 @@ public:
             }
         }
 
+        {
+            // Broadcast MatMul: [2, 1, h, l] x [3, l, e] -> [2, 3, h, e]
+            auto x0 = _Input({2, 1, h, l}, NHWC, halide_type_of<float>());
+            auto x1 = _Input({3, l, e}, NHWC, halide_type_of<float>());
+            auto x0Ptr = x0->writeMap<float>();
+            auto x1Ptr = x1->writeMap<float>();
+            for (int b = 0; b < 2; ++b) {
+                fillFloat(x0Ptr + b * h * l, h, l, (float)b * 10);
+            }
+            for (int b = 0; b < 3; ++b) {
+                fillFloat(x1Ptr + b * e * l, l, e, (float)b * 5);
+            }
+            auto y    = _MatMul(x0, x1);
+            auto yPtr = y->readMap<float>();
+            for (int b0 = 0; b0 < 2; ++b0) {
+                for (int b1 = 0; b1 < 3; ++b1) {
+                    auto res = checkMatMul(yPtr + (b0 * 3 + b1) * e * h, x0Ptr + b0 * h * l, x1Ptr + b1 * e * l, e, l, h);
+                    if (!res) {
+                        FUNC_PRINT(1);
+                        return false;
+                    }
+                }
+            }
+        }
         return true;
     }
 };
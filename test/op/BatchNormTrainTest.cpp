@@ -0,0 +1,126 @@
+//
+//  BatchNormTrainTest.cpp
+//  MNNTests
+//
+//  Created by MNN on 2020/12/01.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#include <math.h>
+#include <MNN/expr/ExprCreator.hpp>
+#include "MNNTestSuite.h"
+#include "MNN_generated.h"
+using namespace MNN::Express;
+using namespace MNN;
+
+static EXPRP _batchNormOp(OpType type, std::vector<VARP> inputs, int channels, float eps) {
+    std::unique_ptr<OpT> op(new OpT);
+    op->type                         = type;
+    op->main.type                    = OpParameter_BatchNorm;
+    op->main.value                   = new BatchNormT;
+    op->main.AsBatchNorm()->channels = channels;
+    op->main.AsBatchNorm()->epsilon  = eps;
+    return Expr::create(std::move(op), inputs, 3);
+}
+
+static bool _check(VARP var, const std::vector<double>& expected, const char* name, Dimensionformat order) {
+    var      = _Convert(var, NCHW);
+    auto ptr = var->readMap<float>();
+    if (nullptr == ptr || var->getInfo()->size != expected.size()) {
+        MNN_ERROR("BatchNormTrain %s compute error, format %d\n", name, (int)order);
+        return false;
+    }
+    for (int i = 0; i < expected.size(); ++i) {
+        if (fabs(ptr[i] - expected[i]) > 1e-4 * (1.0 + fabs(expected[i]))) {
+            MNN_ERROR("BatchNormTrain %s, format %d, %d: %f - %f\n", name, (int)order, i, ptr[i], expected[i]);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Compare the fused BatchNorm of training and its gradient with a double reference
+class BatchNormTrainTest : public MNNTestCase {
+public:
+    virtual bool run() {
+        for (auto order : {NCHW, NC4HW4}) {
+            if (!_test({2, 6, 3, 5}, order)) {
+                return false;
+            }
+        }
+        return _test({7, 5}, NCHW);
+    }
+
+private:
+    static bool _test(const std::vector<int>& shape, Dimensionformat order) {
+        const float eps = 1e-5f;
+        const int batch = shape[0], channel = shape[1];
+        int plane       = 1;
+        for (int i = 2; i < shape.size(); ++i) {
+            plane *= shape[i];
+        }
+        const int size = batch * channel * plane;
+        std::vector<float> x(size), dy(size), scale(channel), bias(channel);
+        for (int i = 0; i < size; ++i) {
+            // Large offset to check the precision of variance
+            x[i]  = (float)((i * 37 + 11) % 29) / 29.0f + 20.0f;
+            dy[i] = (float)((i * 13 + 5) % 17) / 17.0f - 0.5f;
+        }
+        for (int c = 0; c < channel; ++c) {
+            scale[c] = 0.5f + 0.25f * c;
+            bias[c]  = 0.1f * c - 0.2f;
+        }
+        std::vector<double> mean(channel, 0.0), invStd(channel, 0.0), y(size), dScale(channel, 0.0),
+            dBias(channel, 0.0), dx(size);
+        const double m = batch * plane;
+        auto index     = [&](int b, int c, int p) { return (b * channel + c) * plane + p; };
+        for (int c = 0; c < channel; ++c) {
+            double var = 0.0;
+            for (int b = 0; b < batch; ++b) {
+                for (int p = 0; p < plane; ++p) {
+                    mean[c] += x[index(b, c, p)];
+                }
+            }
+            mean[c] /= m;
+            for (int b = 0; b < batch; ++b) {
+                for (int p = 0; p < plane; ++p) {
+                    var += (x[index(b, c, p)] - mean[c]) * (x[index(b, c, p)] - mean[c]);
+                }
+            }
+            invStd[c] = 1.0 / sqrt(var / m + eps);
+            for (int b = 0; b < batch; ++b) {
+                for (int p = 0; p < plane; ++p) {
+                    auto i    = index(b, c, p);
+                    auto xhat = (x[i] - mean[c]) * invStd[c];
+                    y[i]      = xhat * scale[c] + bias[c];
+                    dBias[c] += dy[i];
+                    dScale[c] += dy[i] * xhat;
+                }
+            }
+            for (int b = 0; b < batch; ++b) {
+                for (int p = 0; p < plane; ++p) {
+                    auto i    = index(b, c, p);
+                    auto xhat = (x[i] - mean[c]) * invStd[c];
+                    dx[i]     = scale[c] * invStd[c] * (dy[i] - dBias[c] / m - xhat * dScale[c] / m);
+                }
+            }
+        }
+
+        auto xVar     = _Const(x.data(), shape, NCHW);
+        auto dyVar    = _Const(dy.data(), shape, NCHW);
+        auto scaleVar = _Const(scale.data(), {channel}, NCHW);
+        auto biasVar  = _Const(bias.data(), {channel}, NCHW);
+        auto forward  = _batchNormOp(OpType_BatchNormTrain, {_Convert(xVar, order), scaleVar, biasVar}, channel, eps);
+        auto backward = _batchNormOp(OpType_BatchNormGrad,
+                                     {_Convert(xVar, order), _Convert(dyVar, order), scaleVar,
+                                      Variable::create(forward, 1), Variable::create(forward, 2)},
+                                     channel, eps);
+        return _check(Variable::create(forward, 0), y, "y", order) &&
+               _check(Variable::create(forward, 1), mean, "mean", order) &&
+               _check(Variable::create(forward, 2), invStd, "invStd", order) &&
+               _check(Variable::create(backward, 0), dx, "dx", order) &&
+               _check(Variable::create(backward, 1), dScale, "dScale", order) &&
+               _check(Variable::create(backward, 2), dBias, "dBias", order);
+    }
+};
+MNNTestSuiteRegister(BatchNormTrainTest, "op/batchnorm_train");
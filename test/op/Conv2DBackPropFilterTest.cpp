@@ -156,3 +156,69 @@ public:
 };
 
 MNNTestSuiteRegister(Conv2DDWBackPropFilterTest, "op/Conv2DBackPropFilterDW");
+
+// More output positions than one tile of the CPU execution, batch > 1, dilation and NCHW inputs
+class Conv2DBackPropFilterTiledTest : public MNNTestCase {
+public:
+    virtual ~Conv2DBackPropFilterTiledTest() = default;
+    static bool test(int batch, int ic, int oc, int ih, int iw, int kernel, int stride, int dilate, int pad,
+                     bool packed) {
+        const int oh = (ih + 2 * pad - (kernel - 1) * dilate - 1) / stride + 1;
+        const int ow = (iw + 2 * pad - (kernel - 1) * dilate - 1) / stride + 1;
+        std::vector<float> inputData(batch * ic * ih * iw), gradData(batch * oc * oh * ow);
+        for (auto& v : inputData) {
+            v = (rand() % 255) / 255.0f - 0.5f;
+        }
+        for (auto& v : gradData) {
+            v = (rand() % 255) / 255.0f - 0.5f;
+        }
+        std::vector<float> expected(oc * ic * kernel * kernel, 0.0f);
+        for (int o = 0; o < oc; ++o) {
+            for (int c = 0; c < ic; ++c) {
+                for (int ky = 0; ky < kernel; ++ky) {
+                    for (int kx = 0; kx < kernel; ++kx) {
+                        float sum = 0.0f;
+                        for (int b = 0; b < batch; ++b) {
+                            for (int y = 0; y < oh; ++y) {
+                                for (int x = 0; x < ow; ++x) {
+                                    int sy = y * stride - pad + ky * dilate, sx = x * stride - pad + kx * dilate;
+                                    if (sy < 0 || sy >= ih || sx < 0 || sx >= iw) {
+                                        continue;
+                                    }
+                                    sum += gradData[((b * oc + o) * oh + y) * ow + x] *
+                                           inputData[((b * ic + c) * ih + sy) * iw + sx];
+                                }
+                            }
+                        }
+                        expected[((o * ic + c) * kernel + ky) * kernel + kx] = sum;
+                    }
+                }
+            }
+        }
+        auto input = _Input({batch, ic, ih, iw}, NCHW, halide_type_of<float>());
+        auto grad  = _Input({batch, oc, oh, ow}, NCHW, halide_type_of<float>());
+        auto x = input, dy = grad;
+        if (packed) {
+            x  = _Convert(input, NC4HW4);
+            dy = _Convert(grad, NC4HW4);
+        }
+        auto output = _Conv2DBackPropFilter(x, dy, {kernel, kernel}, CAFFE, {stride, stride}, {dilate, dilate}, 1,
+                                            {pad, pad});
+        output = _Convert(output, NCHW);
+        ::memcpy(input->writeMap<float>(), inputData.data(), inputData.size() * sizeof(float));
+        ::memcpy(grad->writeMap<float>(), gradData.data(), gradData.size() * sizeof(float));
+        if (!checkVectorByRelativeError<float>(output->readMap<float>(), expected.data(), expected.size(), 0.005)) {
+            MNN_ERROR("Conv2DBackPropFilter tiled test failed: b%d ic%d oc%d %dx%d k%d s%d d%d p%d\n", batch, ic, oc,
+                      ih, iw, kernel, stride, dilate, pad);
+            return false;
+        }
+        return true;
+    }
+    virtual bool run() {
+        srand(20);
+        return test(2, 5, 6, 17, 15, 3, 1, 1, 1, true) && test(2, 3, 7, 19, 13, 3, 2, 1, 1, false) &&
+               test(1, 8, 4, 16, 16, 3, 1, 2, 2, true) && test(1, 20, 13, 10, 9, 3, 1, 1, 1, true);
+    }
+};
+
+MNNTestSuiteRegister(Conv2DBackPropFilterTiledTest, "op/Conv2DBackPropFilterTiled");
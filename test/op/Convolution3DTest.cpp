@@ -187,7 +187,16 @@ protected:
                 }
             }
         }
-        return true;
+        // stride, dilation, same padding, and a 3x3x3 kernel big enough for winograd
+        bool succ = Convolution3DCommonTest::test(type, device_name, "Conv3D", 2, 5, 7, {5, 9, 9}, PadMode_CAFFE,
+                                                  {1, 1, 1}, {3, 3, 3}, {2, 2, 2}, {1, 1, 1}, 1) &&
+                    Convolution3DCommonTest::test(type, device_name, "Conv3D", 1, 6, 3, {6, 10, 10}, PadMode_CAFFE,
+                                                  {2, 2, 2}, {3, 3, 3}, {1, 1, 1}, {2, 2, 2}, 1) &&
+                    Convolution3DCommonTest::test(type, device_name, "Conv3D", 1, 4, 9, {4, 11, 7}, PadMode_SAME,
+                                                  {}, {3, 3, 2}, {1, 2, 2}, {1, 1, 1}, 1) &&
+                    Convolution3DCommonTest::test(type, device_name, "Conv3D", 1, 16, 32, {3, 24, 24}, PadMode_CAFFE,
+                                                  {1, 1, 1}, {3, 3, 3}, {1, 1, 1}, {1, 1, 1}, 1);
+        return succ;
     }
 };
 
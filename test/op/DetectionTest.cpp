@@ -0,0 +1,243 @@
+//
+//  DetectionTest.cpp
+//  MNNTests
+//
+//  Created by MNN on 2020/11/10.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <MNN/expr/ExprCreator.hpp>
+#include "MNNTestSuite.h"
+using namespace MNN::Express;
+
+// The scores of all boxes and classes are distinct, so the orders of the reference and MNN are the same
+static float _score(int box, int cls) {
+    return (float)((box * 31 + cls * 17 + 1) % 997) / 997.0f;
+}
+
+// Corners of a, b are [x0, y0, x1, y1] or [y0, x0, y1, x1], min <= max
+static float _iou(const float* a, const float* b) {
+    float h     = std::max(std::min(a[2], b[2]) - std::max(a[0], b[0]), 0.0f);
+    float w     = std::max(std::min(a[3], b[3]) - std::max(a[1], b[1]), 0.0f);
+    float inter = h * w;
+    if (inter <= 0.0f) {
+        return 0.0f;
+    }
+    return inter / ((a[2] - a[0]) * (a[3] - a[1]) + (b[2] - b[0]) * (b[3] - b[1]) - inter);
+}
+
+// Greedy NMS over the boxes whose score is above scoreThreshold
+static std::vector<int> _referenceNMS(const std::vector<float>& boxes, const std::vector<float>& scores,
+                                      int maxDetections, float iouThreshold, float scoreThreshold) {
+    std::vector<int> order;
+    for (int i = 0; i < scores.size(); ++i) {
+        if (scores[i] > scoreThreshold) {
+            order.emplace_back(i);
+        }
+    }
+    std::sort(order.begin(), order.end(), [&](int a, int b) { return scores[a] > scores[b]; });
+    std::vector<int> selected;
+    for (int i = 0; i < order.size() && selected.size() < maxDetections; ++i) {
+        bool keep = true;
+        for (auto s : selected) {
+            if (_iou(boxes.data() + 4 * order[i], boxes.data() + 4 * s) > iouThreshold) {
+                keep = false;
+                break;
+            }
+        }
+        if (keep) {
+            selected.emplace_back(order[i]);
+        }
+    }
+    return selected;
+}
+
+struct Detection {
+    int box;
+    int cls;
+    float score;
+};
+
+static bool _checkDetections(const std::vector<Detection>& expected, const std::vector<float>& boxes,
+                             const float* outputBoxes, const float* outputClasses, const float* outputScores,
+                             const char* name) {
+    for (int i = 0; i < expected.size(); ++i) {
+        auto& e = expected[i];
+        if ((int)outputClasses[i] != e.cls || fabsf(outputScores[i] - e.score) > 1e-6f) {
+            MNN_ERROR("%s %d: class %d - %d, score %f - %f\n", name, i, (int)outputClasses[i], e.cls,
+                      outputScores[i], e.score);
+            return false;
+        }
+        for (int j = 0; j < 4; ++j) {
+            if (fabsf(outputBoxes[4 * i + j] - boxes[4 * e.box + j]) > 1e-4f) {
+                MNN_ERROR("%s %d, box %d: %f - %f\n", name, i, j, outputBoxes[4 * i + j], boxes[4 * e.box + j]);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Compare the regular (NMS per class) and the fast (NMS of the max scores) post process with the reference
+class DetectionPostProcessTest : public MNNTestCase {
+public:
+    virtual bool run() {
+        const int number = 45, classes = 3, maxDetections = 10, detectionsPerClass = 6;
+        const float iouThreshold = 0.4f, scoreThreshold = 0.2f;
+        const std::vector<float> scale = {10.0f, 10.0f, 5.0f, 5.0f};
+        // Anchors: [y, x, h, w], encodings: [y, x, h, w] relative to the anchors, scores with background first
+        std::vector<float> anchors(number * 4), encodings(number * 4), predictions(number * (classes + 1));
+        std::vector<float> boxes(number * 4);
+        for (int i = 0; i < number; ++i) {
+            auto anchor   = anchors.data() + 4 * i;
+            auto encoding = encodings.data() + 4 * i;
+            anchor[0]     = (float)(i % 5) * 0.2f + 0.1f;
+            anchor[1]     = (float)((i / 5) % 3) * 0.3f + 0.15f;
+            anchor[2]     = 0.2f + (float)(i % 4) * 0.1f;
+            anchor[3]     = 0.3f + (float)(i % 3) * 0.1f;
+            for (int j = 0; j < 4; ++j) {
+                encoding[j] = (float)((i * 7 + j * 3) % 5 - 2) * 0.2f;
+            }
+            float y = encoding[0] / scale[0] * anchor[2] + anchor[0];
+            float x = encoding[1] / scale[1] * anchor[3] + anchor[1];
+            float h = 0.5f * expf(encoding[2] / scale[2]) * anchor[2];
+            float w = 0.5f * expf(encoding[3] / scale[3]) * anchor[3];
+            float box[4] = {y - h, x - w, y + h, x + w};
+            ::memcpy(boxes.data() + 4 * i, box, sizeof(box));
+            predictions[i * (classes + 1)] = 0.0f;
+            for (int c = 0; c < classes; ++c) {
+                predictions[i * (classes + 1) + c + 1] = _score(i, c);
+            }
+        }
+        for (bool regular : {true, false}) {
+            std::vector<Detection> expected;
+            if (regular) {
+                for (int c = 0; c < classes; ++c) {
+                    std::vector<float> scores(number);
+                    for (int i = 0; i < number; ++i) {
+                        scores[i] = _score(i, c);
+                    }
+                    for (auto i : _referenceNMS(boxes, scores, detectionsPerClass, iouThreshold, scoreThreshold)) {
+                        expected.emplace_back(Detection({i, c, scores[i]}));
+                    }
+                }
+                std::sort(expected.begin(), expected.end(),
+                          [](const Detection& a, const Detection& b) { return a.score > b.score; });
+                expected.resize(std::min((int)expected.size(), maxDetections));
+            } else {
+                std::vector<float> scores(number);
+                std::vector<int> maxClass(number);
+                for (int i = 0; i < number; ++i) {
+                    for (int c = 0; c < classes; ++c) {
+                        if (c == 0 || _score(i, c) > scores[i]) {
+                            scores[i]   = _score(i, c);
+                            maxClass[i] = c;
+                        }
+                    }
+                }
+                for (auto i : _referenceNMS(boxes, scores, maxDetections, iouThreshold, scoreThreshold)) {
+                    expected.emplace_back(Detection({i, maxClass[i], scores[i]}));
+                }
+            }
+            auto outputs = _DetectionPostProcess(_Const(encodings.data(), {1, number, 4}, NHWC),
+                                                 _Const(predictions.data(), {1, number, classes + 1}, NHWC),
+                                                 _Const(anchors.data(), {number, 4}, NHWC), classes, maxDetections, 1,
+                                                 detectionsPerClass, scoreThreshold, iouThreshold, regular, scale);
+            auto outputBoxes   = outputs[0]->readMap<float>();
+            auto outputClasses = outputs[1]->readMap<float>();
+            auto outputScores  = outputs[2]->readMap<float>();
+            auto outputNumber  = outputs[3]->readMap<float>();
+            if (nullptr == outputBoxes || nullptr == outputClasses || nullptr == outputScores ||
+                nullptr == outputNumber || (int)outputNumber[0] != expected.size()) {
+                MNN_ERROR("DetectionPostProcess compute error, regular: %d\n", regular);
+                return false;
+            }
+            if (!_checkDetections(expected, boxes, outputBoxes, outputClasses, outputScores,
+                                  regular ? "DetectionPostProcess regular" : "DetectionPostProcess fast")) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+MNNTestSuiteRegister(DetectionPostProcessTest, "op/detection_post_process");
+
+// Compare the NMS per class of DetectionOutput with the reference
+class DetectionOutputTest : public MNNTestCase {
+public:
+    virtual bool run() {
+        const int number = 40, classes = 4, keepTopK = 12;
+        const float nmsThreshold = 0.45f, confidenceThreshold = 0.1f;
+        // Prior boxes: [xmin, ymin, xmax, ymax], then the variances
+        std::vector<float> location(number * 4), confidence(number * classes), priorbox(2 * number * 4);
+        std::vector<float> boxes(number * 4);
+        for (int i = 0; i < number; ++i) {
+            auto pb  = priorbox.data() + 4 * i;
+            auto var = priorbox.data() + 4 * number + 4 * i;
+            auto loc = location.data() + 4 * i;
+            float cx = (float)(i % 5) * 0.2f + 0.1f, cy = (float)((i / 5) % 4) * 0.25f + 0.1f;
+            float w = 0.2f + (float)(i % 3) * 0.1f, h = 0.25f + (float)(i % 4) * 0.1f;
+            pb[0] = cx - 0.5f * w;
+            pb[1] = cy - 0.5f * h;
+            pb[2] = cx + 0.5f * w;
+            pb[3] = cy + 0.5f * h;
+            var[0] = var[1] = 0.1f;
+            var[2] = var[3] = 0.2f;
+            for (int j = 0; j < 4; ++j) {
+                loc[j] = (float)((i * 5 + j * 3) % 7 - 3) * 0.3f;
+            }
+            float pbW = pb[2] - pb[0], pbH = pb[3] - pb[1];
+            float pbCX = (pb[0] + pb[2]) * 0.5f, pbCY = (pb[1] + pb[3]) * 0.5f;
+            float boxCX = var[0] * loc[0] * pbW + pbCX, boxCY = var[1] * loc[1] * pbH + pbCY;
+            float boxW = expf(var[2] * loc[2]) * pbW, boxH = expf(var[3] * loc[3]) * pbH;
+            float box[4] = {boxCX - boxW * 0.5f, boxCY - boxH * 0.5f, boxCX + boxW * 0.5f, boxCY + boxH * 0.5f};
+            ::memcpy(boxes.data() + 4 * i, box, sizeof(box));
+            for (int c = 0; c < classes; ++c) {
+                confidence[i * classes + c] = _score(i, c);
+            }
+        }
+        // Class 0 is the background
+        std::vector<Detection> expected;
+        for (int c = 1; c < classes; ++c) {
+            std::vector<float> scores(number);
+            for (int i = 0; i < number; ++i) {
+                scores[i] = _score(i, c);
+            }
+            for (auto i : _referenceNMS(boxes, scores, keepTopK, nmsThreshold, confidenceThreshold)) {
+                expected.emplace_back(Detection({i, c, scores[i]}));
+            }
+        }
+        std::sort(expected.begin(), expected.end(),
+                  [](const Detection& a, const Detection& b) { return a.score > b.score; });
+        if (expected.size() < keepTopK) {
+            MNN_ERROR("DetectionOutput test data error\n");
+            return false;
+        }
+        expected.resize(keepTopK);
+
+        auto locationVar   = _Convert(_Const(location.data(), {1, number * 4, 1, 1}, NCHW), NC4HW4);
+        auto confidenceVar = _Convert(_Const(confidence.data(), {1, number * classes, 1, 1}, NCHW), NC4HW4);
+        auto priorboxVar   = _Convert(_Const(priorbox.data(), {1, 2, number * 4, 1}, NCHW), NC4HW4);
+        auto output = _DetectionOutput(locationVar, confidenceVar, priorboxVar, classes, true, 0, nmsThreshold,
+                                       number, 1, false, keepTopK, confidenceThreshold, 0.0f);
+        output   = _Convert(output, NCHW);
+        auto ptr = output->readMap<float>();
+        if (nullptr == ptr || output->getInfo()->size != keepTopK * 6) {
+            MNN_ERROR("DetectionOutput compute error\n");
+            return false;
+        }
+        // Each row: label, score, xmin, ymin, xmax, ymax
+        std::vector<float> outputBoxes(keepTopK * 4), outputClasses(keepTopK), outputScores(keepTopK);
+        for (int i = 0; i < keepTopK; ++i) {
+            outputClasses[i] = ptr[6 * i];
+            outputScores[i]  = ptr[6 * i + 1];
+            ::memcpy(outputBoxes.data() + 4 * i, ptr + 6 * i + 2, 4 * sizeof(float));
+        }
+        return _checkDetections(expected, boxes, outputBoxes.data(), outputClasses.data(), outputScores.data(),
+                                "DetectionOutput");
+    }
+};
+MNNTestSuiteRegister(DetectionOutputTest, "op/detection_output");
@@ -0,0 +1,116 @@
+//
+//  Int8ChainTest.cpp
+//  MNNTests
+//
+//  Created by MNN on 2020/11/16.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#include <math.h>
+#include <algorithm>
+#include <MNN/expr/ExecutorScope.hpp>
+#include <MNN/expr/Expr.hpp>
+#include <MNN/expr/ExprCreator.hpp>
+#include "MNNTestSuite.h"
+#include "MNN_generated.h"
+
+using namespace MNN::Express;
+
+// FloatToInt8 -> ReLU -> Concat -> PoolInt8 -> Int8ToFloat, the activations stay int8 with one scale
+class Int8ChainTest : public MNNTestCase {
+public:
+    virtual ~Int8ChainTest() = default;
+    virtual bool run() {
+        const int c0 = 5, c1 = 3, h = 4, w = 4;
+        const float scale = 0.05f;
+        std::vector<float> data0(c0 * h * w), data1(c1 * h * w);
+        for (int i = 0; i < data0.size(); ++i) {
+            data0[i] = (float)(i % 11 - 5) * scale;
+        }
+        for (int i = 0; i < data1.size(); ++i) {
+            data1[i] = (float)(i % 7 - 3) * scale;
+        }
+        auto x0 = _Input({1, c0, h, w}, NCHW);
+        auto x1 = _Input({1, c1, h, w}, NCHW);
+        ::memcpy(x0->writeMap<float>(), data0.data(), data0.size() * sizeof(float));
+        ::memcpy(x1->writeMap<float>(), data1.data(), data1.size() * sizeof(float));
+        auto q0 = _FloatToInt8(_Convert(x0, NC4HW4), _Const(1.0f / scale, {c0}, NCHW), -127, 127);
+        auto q1 = _FloatToInt8(_Convert(x1, NC4HW4), _Const(1.0f / scale, {c1}, NCHW), -127, 127);
+        auto concat = _Concat({_Relu(q0), q1}, 1);
+
+        std::unique_ptr<MNN::OpT> pool(new MNN::OpT);
+        pool->type       = MNN::OpType_PoolInt8;
+        pool->main.type  = MNN::OpParameter_Pool;
+        pool->main.value = new MNN::PoolT;
+        auto poolParam   = pool->main.AsPool();
+        poolParam->type    = MNN::PoolType_MAXPOOL;
+        poolParam->kernelX = 2;
+        poolParam->kernelY = 2;
+        poolParam->strideX = 2;
+        poolParam->strideY = 2;
+        poolParam->padType = MNN::PoolPadType_VALID;
+        auto pooled = Variable::create(Expr::create(pool.get(), {concat}));
+        auto output = _Convert(_Int8ToFloat(pooled, _Const(scale, {c0 + c1}, NCHW)), NCHW);
+        auto outPtr = output->readMap<float>();
+        if (nullptr == outPtr) {
+            MNN_ERROR("Int8 chain compute error\n");
+            return false;
+        }
+        for (int c = 0; c < c0 + c1; ++c) {
+            for (int y = 0; y < h / 2; ++y) {
+                for (int x = 0; x < w / 2; ++x) {
+                    float expected = -1000.0f;
+                    for (int ky = 0; ky < 2; ++ky) {
+                        for (int kx = 0; kx < 2; ++kx) {
+                            int offset = (2 * y + ky) * w + 2 * x + kx;
+                            float v    = c < c0 ? std::max(data0[c * h * w + offset], 0.0f)
+                                             : data1[(c - c0) * h * w + offset];
+                            expected   = std::max(expected, v);
+                        }
+                    }
+                    float result = outPtr[(c * (h / 2) + y) * (w / 2) + x];
+                    if (fabsf(result - expected) > 1e-4f) {
+                        MNN_ERROR("Int8 chain error at %d, %d, %d: %f - %f\n", c, y, x, result, expected);
+                        return false;
+                    }
+                }
+            }
+        }
+        return true;
+    }
+};
+MNNTestSuiteRegister(Int8ChainTest, "op/Int8Chain");
+
+// Int8 ReLU of 100 bytes on 4 threads, the size is not a multiple of the 16 bytes each thread takes
+class Int8ReluTest : public MNNTestCase {
+public:
+    virtual ~Int8ReluTest() = default;
+    virtual bool run() {
+        MNN::BackendConfig config;
+        auto executor = Executor::newExecutor(MNN_FORWARD_CPU, config, 4);
+        ExecutorScope scope(executor);
+        const int c = 4, h = 5, w = 5;
+        const float scale = 0.1f;
+        std::vector<float> data(c * h * w);
+        for (int i = 0; i < data.size(); ++i) {
+            data[i] = (float)(i % 9 - 4) * scale;
+        }
+        auto x = _Input({1, c, h, w}, NCHW);
+        ::memcpy(x->writeMap<float>(), data.data(), data.size() * sizeof(float));
+        auto q      = _FloatToInt8(_Convert(x, NC4HW4), _Const(1.0f / scale, {c}, NCHW), -127, 127);
+        auto output = _Convert(_Int8ToFloat(_Relu(q), _Const(scale, {c}, NCHW)), NCHW);
+        auto outPtr = output->readMap<float>();
+        if (nullptr == outPtr) {
+            MNN_ERROR("Int8 relu compute error\n");
+            return false;
+        }
+        for (int i = 0; i < data.size(); ++i) {
+            if (fabsf(outPtr[i] - std::max(data[i], 0.0f)) > 1e-4f) {
+                MNN_ERROR("Int8 relu error at %d: %f - %f\n", i, outPtr[i], std::max(data[i], 0.0f));
+                return false;
+            }
+        }
+        return true;
+    }
+};
+MNNTestSuiteRegister(Int8ReluTest, "op/Int8Relu");
@@ -0,0 +1,139 @@
+//
+//  LSTMTest.cpp
+//  MNNTests
+//
+//  Created by MNN on 2020/11/09.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#include <math.h>
+#include <MNN/expr/Expr.hpp>
+#include <MNN/expr/ExprCreator.hpp>
+#include "MNNTestSuite.h"
+#include "MNN_generated.h"
+
+using namespace MNN::Express;
+
+static float sigmoidRef(float x) {
+    return 1.0f / (1.0f + expf(-x));
+}
+
+// Gate order: IOFC, Y: [seqLength, direction, batch, hidden]
+static void referenceLSTM(const float* x, const float* w, const float* r, const float* b, const float* h0,
+                          const float* c0, float* y, float* yh, float* yc, int seqLength, int batch, int inputSize,
+                          int hidden, int direction) {
+    std::vector<float> gate(4 * hidden);
+    std::vector<float> h(hidden), c(hidden);
+    for (int d = 0; d < direction; ++d) {
+        auto wD = w + d * 4 * hidden * inputSize;
+        auto rD = r + d * 4 * hidden * hidden;
+        auto bD = b + d * 4 * hidden;
+        for (int n = 0; n < batch; ++n) {
+            auto offset = (d * batch + n) * hidden;
+            for (int i = 0; i < hidden; ++i) {
+                h[i] = nullptr == h0 ? 0.0f : h0[offset + i];
+                c[i] = nullptr == c0 ? 0.0f : c0[offset + i];
+            }
+            for (int step = 0; step < seqLength; ++step) {
+                int t   = d > 0 ? seqLength - 1 - step : step;
+                auto xT = x + (t * batch + n) * inputSize;
+                for (int j = 0; j < 4 * hidden; ++j) {
+                    float sum = bD[j];
+                    for (int k = 0; k < inputSize; ++k) {
+                        sum += wD[j * inputSize + k] * xT[k];
+                    }
+                    for (int k = 0; k < hidden; ++k) {
+                        sum += rD[j * hidden + k] * h[k];
+                    }
+                    gate[j] = sum;
+                }
+                for (int i = 0; i < hidden; ++i) {
+                    float iG = sigmoidRef(gate[i]);
+                    float oG = sigmoidRef(gate[hidden + i]);
+                    float fG = sigmoidRef(gate[2 * hidden + i]);
+                    float cG = tanhf(gate[3 * hidden + i]);
+                    c[i]     = fG * c[i] + iG * cG;
+                    h[i]     = oG * tanhf(c[i]);
+                    y[((t * direction + d) * batch + n) * hidden + i] = h[i];
+                }
+            }
+            for (int i = 0; i < hidden; ++i) {
+                yh[offset + i] = h[i];
+                yc[offset + i] = c[i];
+            }
+        }
+    }
+}
+
+class LSTMTest : public MNNTestCase {
+public:
+    virtual ~LSTMTest() = default;
+    virtual bool run() {
+        const int seqLength = 6, batch = 2, inputSize = 5, hidden = 7;
+        for (int direction = 1; direction <= 2; ++direction) {
+            for (int withInit = 0; withInit < 2; ++withInit) {
+                if (!_run(seqLength, batch, inputSize, hidden, direction, withInit > 0)) {
+                    MNN_ERROR("LSTM test failed for direction = %d, withInit = %d\n", direction, withInit);
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+private:
+    static void _fill(std::vector<float>& data, int seed, float scale) {
+        for (int i = 0; i < data.size(); ++i) {
+            data[i] = ((float)((i * 17 + seed) % 31) / 31.0f - 0.5f) * scale;
+        }
+    }
+    bool _run(int seqLength, int batch, int inputSize, int hidden, int direction, bool withInit) {
+        std::vector<float> xData(seqLength * batch * inputSize), wData(direction * 4 * hidden * inputSize),
+            rData(direction * 4 * hidden * hidden), bData(direction * 4 * hidden), h0Data(direction * batch * hidden),
+            c0Data(direction * batch * hidden);
+        _fill(xData, 1, 2.0f);
+        _fill(wData, 3, 1.0f);
+        _fill(rData, 5, 1.0f);
+        _fill(bData, 7, 0.5f);
+        _fill(h0Data, 11, 1.0f);
+        _fill(c0Data, 13, 1.0f);
+        auto x = _Input({seqLength, batch, inputSize}, NCHW);
+        ::memcpy(x->writeMap<float>(), xData.data(), xData.size() * sizeof(float));
+        std::vector<VARP> inputs = {x, _Const(wData.data(), {direction, 4 * hidden, inputSize}, NCHW),
+                                    _Const(rData.data(), {direction, 4 * hidden, hidden}, NCHW),
+                                    _Const(bData.data(), {direction, 4 * hidden}, NCHW)};
+        if (withInit) {
+            inputs.emplace_back(_Const(h0Data.data(), {direction, batch, hidden}, NCHW));
+            inputs.emplace_back(_Const(c0Data.data(), {direction, batch, hidden}, NCHW));
+        }
+        std::unique_ptr<MNN::OpT> lstm(new MNN::OpT);
+        lstm->type                       = MNN::OpType_LSTM;
+        lstm->main.type                  = MNN::OpParameter_LSTM;
+        lstm->main.value                 = new MNN::LSTMT;
+        lstm->main.AsLSTM()->outputCount = hidden;
+        auto expr = Expr::create(lstm.get(), inputs, 3);
+        std::vector<float> y(seqLength * direction * batch * hidden), yh(direction * batch * hidden),
+            yc(direction * batch * hidden);
+        referenceLSTM(xData.data(), wData.data(), rData.data(), bData.data(), withInit ? h0Data.data() : nullptr,
+                      withInit ? c0Data.data() : nullptr, y.data(), yh.data(), yc.data(), seqLength, batch, inputSize,
+                      hidden, direction);
+        std::vector<float>* expected[] = {&y, &yh, &yc};
+        for (int i = 0; i < 3; ++i) {
+            auto output = Variable::create(expr, i);
+            auto info   = output->getInfo();
+            auto ptr    = output->readMap<float>();
+            if (nullptr == info || nullptr == ptr || info->size != expected[i]->size()) {
+                MNN_ERROR("LSTM output %d compute error\n", i);
+                return false;
+            }
+            for (int j = 0; j < info->size; ++j) {
+                if (fabsf(ptr[j] - (*expected[i])[j]) > 0.002f) {
+                    MNN_ERROR("LSTM output %d, %d: %f - %f\n", i, j, ptr[j], (*expected[i])[j]);
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+};
+MNNTestSuiteRegister(LSTMTest, "op/LSTM");
@@ -0,0 +1,88 @@
+//
+//  LayerNormTest.cpp
+//  MNNTests
+//
+//  Created by MNN on 2020/12/02.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#include <math.h>
+#include <MNN/expr/ExprCreator.hpp>
+#include "MNNTestSuite.h"
+#include "MNN_generated.h"
+using namespace MNN::Express;
+using namespace MNN;
+
+static VARP _layerNorm(VARP x, int axisNumber, float eps, const std::vector<float>& gamma,
+                       const std::vector<float>& beta) {
+    std::unique_ptr<OpT> op(new OpT);
+    op->type       = OpType_LayerNorm;
+    op->main.type  = OpParameter_LayerNorm;
+    op->main.value = new LayerNormT;
+    auto param     = op->main.AsLayerNorm();
+    for (int i = 0; i < axisNumber; ++i) {
+        param->axis.emplace_back(-1 - i);
+    }
+    param->epsilon = eps;
+    param->gamma   = gamma;
+    param->beta    = beta;
+    return Variable::create(Expr::create(std::move(op), {x}));
+}
+
+// The rows are normalized by a single-pass Welford kernel, check it with a double two-pass reference for sizes of
+// every remainder of the vector width and values with a large offset
+class LayerNormTest : public MNNTestCase {
+public:
+    virtual bool run() {
+        for (int inner : {1, 3, 4, 7, 8, 13, 16, 33, 64, 257}) {
+            for (float offset : {0.0f, 1000.0f}) {
+                if (!_test(5, inner, offset)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+private:
+    static bool _test(int outer, int inner, float offset) {
+        const float eps = 1e-5f;
+        std::vector<float> x(outer * inner), gamma(inner), beta(inner);
+        for (int i = 0; i < x.size(); ++i) {
+            x[i] = (float)((i * 37 + 11) % 29) / 29.0f - 0.5f + offset;
+        }
+        for (int i = 0; i < inner; ++i) {
+            gamma[i] = 0.5f + 0.01f * i;
+            beta[i]  = 0.1f - 0.002f * i;
+        }
+        auto input  = _Const(x.data(), {outer, 1, inner}, NCHW);
+        auto output = _layerNorm(input, 1, eps, gamma, beta);
+        auto ptr    = output->readMap<float>();
+        if (nullptr == ptr || output->getInfo()->size != x.size()) {
+            MNN_ERROR("LayerNorm compute error for inner %d\n", inner);
+            return false;
+        }
+        for (int o = 0; o < outer; ++o) {
+            auto src    = x.data() + o * inner;
+            double mean = 0.0, var = 0.0;
+            for (int i = 0; i < inner; ++i) {
+                mean += src[i];
+            }
+            mean /= inner;
+            for (int i = 0; i < inner; ++i) {
+                var += (src[i] - mean) * (src[i] - mean);
+            }
+            var /= inner;
+            for (int i = 0; i < inner; ++i) {
+                double expected = (src[i] - mean) / sqrt(var + eps) * gamma[i] + beta[i];
+                if (fabs(ptr[o * inner + i] - expected) > 2e-3) {
+                    MNN_ERROR("LayerNorm inner %d, offset %f, %d, %d: %f - %f\n", inner, offset, o, i,
+                              ptr[o * inner + i], expected);
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+};
+MNNTestSuiteRegister(LayerNormTest, "op/layernorm");
@@ -6,6 +6,9 @@
 //  Copyright © 2018, Alibaba Group Holding Limited
 //
 
+#include <math.h>
+#include <MNN/expr/Executor.hpp>
+#include <MNN/expr/ExecutorScope.hpp>
 #include <MNN/expr/Expr.hpp>
 #include <MNN/expr/ExprCreator.hpp>
 #include <MNN/expr/Optimizer.hpp>
@@ -54,6 +57,7 @@ static int randomCreate(int i) {
     i = (i * 43) % 255;
     return i;
 }
+using namespace MNN;
 using namespace MNN::Express;
 class MatMulCommonTest : public MNNTestCase {
 public:
@@ -134,3 +138,90 @@ public:
 };
 
 MNNTestSuiteRegister(MatMulTestOnCPU, "op/matmul");
+
+// A batched matmul with a constant B keeps the packed B as bf16 under Precision_Low and Memory_Low, check it with a
+// double reference and a tolerance of the bf16 rounding (2^-9 relative), the inputs are positive so the relative error
+// of C is the same. Precision_Low alone keeps B in fp32
+class BatchMatMulLowPrecisionTest : public MNNTestCase {
+public:
+    virtual bool run() {
+        // e, l, h around the pack sizes, B broadcast or not
+        return _test(2, 37, 19, 13, false, false, false) && _test(3, 5, 33, 29, true, false, true) &&
+               _test(2, 25, 8, 17, false, true, false) && _test(4, 1, 70, 3, true, true, true);
+    }
+
+private:
+    static std::vector<float> _compute(BackendConfig::PrecisionMode precision, BackendConfig::MemoryMode memory,
+                                       const std::vector<float>& a, const std::vector<float>& b, int batch, int e,
+                                       int l, int h, bool broadcast, bool transposeA, bool transposeB) {
+        BackendConfig config;
+        config.precision = precision;
+        config.memory    = memory;
+        auto executor    = Executor::newExecutor(MNN_FORWARD_CPU, config, 1);
+        ExecutorScope scope(executor);
+        auto inputA = _Input(transposeA ? std::vector<int>{batch, l, e} : std::vector<int>{batch, e, l}, NCHW);
+        ::memcpy(inputA->writeMap<float>(), a.data(), a.size() * sizeof(float));
+        std::vector<int> bShape = transposeB ? std::vector<int>{h, l} : std::vector<int>{l, h};
+        if (!broadcast) {
+            bShape.insert(bShape.begin(), batch);
+        }
+        auto output = _MatMul(inputA, _Const(b.data(), bShape, NCHW), transposeA, transposeB);
+        auto ptr    = output->readMap<float>();
+        if (nullptr == ptr || output->getInfo()->size != batch * e * h) {
+            return {};
+        }
+        return std::vector<float>(ptr, ptr + batch * e * h);
+    }
+    static bool _test(int batch, int e, int l, int h, bool broadcast, bool transposeA, bool transposeB) {
+        const int bBatch = broadcast ? 1 : batch;
+        std::vector<float> a(batch * e * l), b(bBatch * l * h);
+        for (int i = 0; i < a.size(); ++i) {
+            a[i] = (float)randomCreate(i) / 255.f;
+        }
+        for (int i = 0; i < b.size(); ++i) {
+            b[i] = (float)randomCreate(10 - i) / 255.f + 0.01f;
+        }
+        auto low      = _compute(BackendConfig::Precision_Low, BackendConfig::Memory_Low, a, b, batch, e, l, h,
+                                 broadcast, transposeA, transposeB);
+        auto lowFloat = _compute(BackendConfig::Precision_Low, BackendConfig::Memory_Normal, a, b, batch, e, l, h,
+                                 broadcast, transposeA, transposeB);
+        auto normal   = _compute(BackendConfig::Precision_Normal, BackendConfig::Memory_Normal, a, b, batch, e, l, h,
+                               broadcast, transposeA, transposeB);
+        if (low.empty() || lowFloat.empty() || normal.empty()) {
+            MNN_ERROR("BatchMatMul low precision compute error\n");
+            return false;
+        }
+        if (lowFloat != normal) {
+            MNN_ERROR("BatchMatMul low precision %d x %d x %d: Precision_Low alone changes the result\n", e, l, h);
+            return false;
+        }
+        float maxDiff = 0.0f;
+        for (int n = 0; n < batch; ++n) {
+            for (int y = 0; y < e; ++y) {
+                for (int x = 0; x < h; ++x) {
+                    double expected = 0.0;
+                    for (int k = 0; k < l; ++k) {
+                        auto aV = transposeA ? a[(n * l + k) * e + y] : a[(n * e + y) * l + k];
+                        auto bI = broadcast ? 0 : n;
+                        auto bV = transposeB ? b[(bI * h + x) * l + k] : b[(bI * l + k) * h + x];
+                        expected += (double)aV * bV;
+                    }
+                    auto index = (n * e + y) * h + x;
+                    if (fabs(low[index] - expected) > 4e-3 * expected + 1e-6) {
+                        MNN_ERROR("BatchMatMul low precision %d x %d x %d, %d, %d, %d: %f - %f\n", e, l, h, n, y, x,
+                                  low[index], expected);
+                        return false;
+                    }
+                    maxDiff = fmaxf(maxDiff, fabsf(low[index] - normal[index]) / (float)expected);
+                }
+            }
+        }
+        // B of every case has values that are not exact in bf16
+        if (maxDiff < 1e-5f) {
+            MNN_ERROR("BatchMatMul low precision %d x %d x %d: the constant B is not stored as bf16\n", e, l, h);
+            return false;
+        }
+        return true;
+    }
+};
+MNNTestSuiteRegister(BatchMatMulLowPrecisionTest, "op/matmul_low_precision");
@@ -174,6 +174,71 @@ protected:
                 return false;
             }
         }
+        // MultiInput Deconv with batch and dilation
+        {
+            const int batch = 2, inputChannel = 5, outputChannel = 6, inputHeight = 7, inputWidth = 6;
+            const int kernelSize = 3, stride = 2, dilate = 2, pad = 1;
+            const int height = (inputHeight - 1) * stride + (kernelSize - 1) * dilate + 1 - 2 * pad;
+            const int width  = (inputWidth - 1) * stride + (kernelSize - 1) * dilate + 1 - 2 * pad;
+            std::vector<float> inputData(batch * inputChannel * inputHeight * inputWidth);
+            std::vector<float> filterData(inputChannel * outputChannel * kernelSize * kernelSize);
+            std::vector<float> biasData(outputChannel);
+            for (auto& v : inputData) {
+                v = (rand() % 255) / 255.0f - 0.5f;
+            }
+            for (auto& v : filterData) {
+                v = (rand() % 255) / 255.0f - 0.5f;
+            }
+            for (auto& v : biasData) {
+                v = (rand() % 255) / 255.0f - 0.5f;
+            }
+            std::vector<float> outputData(batch * outputChannel * height * width);
+            for (int b = 0; b < batch; ++b) {
+                for (int o = 0; o < outputChannel; ++o) {
+                    auto dst = outputData.data() + (b * outputChannel + o) * height * width;
+                    for (int i = 0; i < height * width; ++i) {
+                        dst[i] = biasData[o];
+                    }
+                    for (int c = 0; c < inputChannel; ++c) {
+                        for (int y = 0; y < inputHeight; ++y) {
+                            for (int x = 0; x < inputWidth; ++x) {
+                                auto value = inputData[((b * inputChannel + c) * inputHeight + y) * inputWidth + x];
+                                for (int ky = 0; ky < kernelSize; ++ky) {
+                                    for (int kx = 0; kx < kernelSize; ++kx) {
+                                        int dy = y * stride - pad + ky * dilate, dx = x * stride - pad + kx * dilate;
+                                        if (dy < 0 || dy >= height || dx < 0 || dx >= width) {
+                                            continue;
+                                        }
+                                        dst[dy * width + dx] +=
+                                            value *
+                                            filterData[((c * outputChannel + o) * kernelSize + ky) * kernelSize + kx];
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+            auto input  = _Input({batch, inputChannel, inputHeight, inputWidth}, NCHW, halide_type_of<float>());
+            auto filter = _Input({inputChannel, outputChannel, kernelSize, kernelSize}, NCHW, halide_type_of<float>());
+            auto bias   = _Input({outputChannel}, NCHW, halide_type_of<float>());
+            auto output = _Deconv(filter, bias, _Convert(input, NC4HW4), CAFFE, {stride, stride}, {dilate, dilate}, 1,
+                                  {pad, pad});
+            output = _Convert(output, NCHW);
+            const std::vector<int> outDim = {batch, outputChannel, height, width};
+            if (!checkVector<int>(output->getInfo()->dim.data(), outDim.data(), 4, 0)) {
+                MNN_ERROR("Batch MultiDeconvolution(%s) shape test failed!\n", deviceName.c_str());
+                return false;
+            }
+            ::memcpy(input->writeMap<float>(), inputData.data(), inputData.size() * sizeof(float));
+            ::memcpy(filter->writeMap<float>(), filterData.data(), filterData.size() * sizeof(float));
+            ::memcpy(bias->writeMap<float>(), biasData.data(), biasData.size() * sizeof(float));
+            if (!checkVectorByRelativeError<float>(output->readMap<float>(), outputData.data(), outputData.size(),
+                                                   0.005)) {
+                MNN_ERROR("Batch MultiDeconvolution(%s) test failed!\n", deviceName.c_str());
+                return false;
+            }
+        }
         return true;
     }
 };
@@ -0,0 +1,116 @@
+//
+//  NonMaxSuppressionTest.cpp
+//  MNNTests
+//
+//  Created by MNN on 2020/11/10.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#include <math.h>
+#include <algorithm>
+#include <MNN/expr/ExprCreator.hpp>
+#include "MNNTestSuite.h"
+#include "MNN_generated.h"
+using namespace MNN::Express;
+using namespace MNN;
+
+// [ymin, xmin, ymax, xmax] of boxes, some of the corners are swapped
+static std::vector<float> _makeBoxes(int number) {
+    std::vector<float> boxes(number * 4);
+    for (int i = 0; i < number; ++i) {
+        float y = (float)((i * 37 + 5) % 41) / 41.0f;
+        float x = (float)((i * 53 + 7) % 43) / 43.0f;
+        float h = 0.1f + (float)((i * 11) % 7) * 0.05f;
+        float w = 0.1f + (float)((i * 13) % 5) * 0.06f;
+        auto box = boxes.data() + 4 * i;
+        box[0]   = y;
+        box[1]   = x;
+        box[2]   = y + h;
+        box[3]   = x + w;
+        if (i % 5 == 0) {
+            std::swap(box[0], box[2]);
+        }
+    }
+    return boxes;
+}
+
+static float _iou(const float* a, const float* b) {
+    float ayMin = std::min(a[0], a[2]), axMin = std::min(a[1], a[3]);
+    float ayMax = std::max(a[0], a[2]), axMax = std::max(a[1], a[3]);
+    float byMin = std::min(b[0], b[2]), bxMin = std::min(b[1], b[3]);
+    float byMax = std::max(b[0], b[2]), bxMax = std::max(b[1], b[3]);
+    float h     = std::max(std::min(ayMax, byMax) - std::max(ayMin, byMin), 0.0f);
+    float w     = std::max(std::min(axMax, bxMax) - std::max(axMin, bxMin), 0.0f);
+    float inter = h * w;
+    if (inter <= 0.0f) {
+        return 0.0f;
+    }
+    return inter / ((ayMax - ayMin) * (axMax - axMin) + (byMax - byMin) * (bxMax - bxMin) - inter);
+}
+
+// Greedy NMS of tensorflow, the scores are distinct
+static std::vector<int> _referenceNMS(const std::vector<float>& boxes, const std::vector<float>& scores,
+                                      int maxDetections, float iouThreshold) {
+    std::vector<int> order(scores.size());
+    for (int i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&](int a, int b) { return scores[a] > scores[b]; });
+    std::vector<int> selected;
+    for (int i = 0; i < order.size() && selected.size() < maxDetections; ++i) {
+        bool keep = true;
+        for (auto s : selected) {
+            if (_iou(boxes.data() + 4 * order[i], boxes.data() + 4 * s) > iouThreshold) {
+                keep = false;
+                break;
+            }
+        }
+        if (keep) {
+            selected.emplace_back(order[i]);
+        }
+    }
+    return selected;
+}
+
+static VARP _NonMaxSuppression(VARP boxes, VARP scores, int maxDetections, float iouThreshold) {
+    std::unique_ptr<OpT> op(new OpT);
+    op->type = OpType_NonMaxSuppressionV2;
+    return Variable::create(
+        Expr::create(std::move(op), {boxes, scores, _Scalar<int>(maxDetections), _Scalar<float>(iouThreshold)}));
+}
+
+// Compare with the greedy NMS for numbers of selected boxes around the vector width
+class NonMaxSuppressionTest : public MNNTestCase {
+public:
+    virtual bool run() {
+        const int number = 67;
+        auto boxes       = _makeBoxes(number);
+        std::vector<float> scores(number);
+        for (int i = 0; i < number; ++i) {
+            scores[i] = (float)((i * 29 + 3) % number) / number;
+        }
+        for (float iouThreshold : {0.0f, 0.2f, 0.5f, 0.9f}) {
+            auto all = _referenceNMS(boxes, scores, number, iouThreshold);
+            for (int maxDetections : {1, 3, 4, 5, 9, number}) {
+                maxDetections = std::min(maxDetections, (int)all.size());
+                std::vector<int> expected(all.begin(), all.begin() + maxDetections);
+                auto output = _NonMaxSuppression(_Const(boxes.data(), {number, 4}, NHWC),
+                                                 _Const(scores.data(), {number}, NHWC), maxDetections, iouThreshold);
+                auto ptr    = output->readMap<int>();
+                if (nullptr == ptr || output->getInfo()->size != expected.size()) {
+                    MNN_ERROR("NonMaxSuppression compute error, iou %f, max %d\n", iouThreshold, maxDetections);
+                    return false;
+                }
+                for (int i = 0; i < expected.size(); ++i) {
+                    if (ptr[i] != expected[i]) {
+                        MNN_ERROR("NonMaxSuppression iou %f, max %d, %d: %d - %d\n", iouThreshold, maxDetections, i,
+                                  ptr[i], expected[i]);
+                        return false;
+                    }
+                }
+            }
+        }
+        return true;
+    }
+};
+MNNTestSuiteRegister(NonMaxSuppressionTest, "op/non_max_suppression");
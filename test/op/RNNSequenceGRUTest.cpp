@@ -0,0 +1,138 @@
+//
+//  RNNSequenceGRUTest.cpp
+//  MNNTests
+//
+//  Created by MNN on 2020/11/09.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#include <math.h>
+#include <MNN/expr/Expr.hpp>
+#include <MNN/expr/ExprCreator.hpp>
+#include "MNNTestSuite.h"
+#include "MNN_generated.h"
+
+using namespace MNN::Express;
+
+struct GRUWeight {
+    std::vector<float> gateWeight;
+    std::vector<float> gateBias;
+    std::vector<float> candidateWeight;
+    std::vector<float> candidateBias;
+};
+
+static void _fill(std::vector<float>& data, int size, int seed, float scale) {
+    data.resize(size);
+    for (int i = 0; i < size; ++i) {
+        data[i] = ((float)((i * 13 + seed) % 29) / 29.0f - 0.5f) * scale;
+    }
+}
+
+static std::unique_ptr<MNN::BlobT> _makeBlob(const std::vector<float>& data, std::vector<int> dims) {
+    std::unique_ptr<MNN::BlobT> blob(new MNN::BlobT);
+    blob->dims     = dims;
+    blob->dataType = MNN::DataType_DT_FLOAT;
+    blob->float32s = data;
+    return blob;
+}
+
+// Output is stored in the order of computing, input: [batch, seqLength, inputSize]
+static void referenceGRU(const float* x, const GRUWeight& weight, std::vector<float>& output, int batch, int seqLength,
+                         int inputSize, int numUnits, bool reverse, bool keepAllOutputs) {
+    output.resize(keepAllOutputs ? batch * seqLength * numUnits : batch * numUnits);
+    std::vector<float> inputAndState(inputSize + numUnits), gate(2 * numUnits), h(numUnits);
+    for (int b = 0; b < batch; ++b) {
+        std::fill(h.begin(), h.end(), 0.0f);
+        for (int step = 0; step < seqLength; ++step) {
+            int t = reverse ? seqLength - 1 - step : step;
+            ::memcpy(inputAndState.data(), x + (b * seqLength + t) * inputSize, inputSize * sizeof(float));
+            ::memcpy(inputAndState.data() + inputSize, h.data(), numUnits * sizeof(float));
+            for (int j = 0; j < 2 * numUnits; ++j) {
+                float sum = weight.gateBias[j];
+                for (int k = 0; k < inputSize + numUnits; ++k) {
+                    sum += inputAndState[k] * weight.gateWeight[k * 2 * numUnits + j];
+                }
+                gate[j] = 1.0f / (1.0f + expf(-sum));
+            }
+            for (int k = 0; k < numUnits; ++k) {
+                inputAndState[inputSize + k] = gate[k] * h[k];
+            }
+            for (int j = 0; j < numUnits; ++j) {
+                float sum = weight.candidateBias[j];
+                for (int k = 0; k < inputSize + numUnits; ++k) {
+                    sum += inputAndState[k] * weight.candidateWeight[k * numUnits + j];
+                }
+                float z = gate[numUnits + j];
+                h[j]    = z * h[j] + (1.0f - z) * tanhf(sum);
+            }
+            if (keepAllOutputs) {
+                ::memcpy(output.data() + (b * seqLength + step) * numUnits, h.data(), numUnits * sizeof(float));
+            }
+        }
+        if (!keepAllOutputs) {
+            ::memcpy(output.data() + b * numUnits, h.data(), numUnits * sizeof(float));
+        }
+    }
+}
+
+class RNNSequenceGRUTest : public MNNTestCase {
+public:
+    virtual ~RNNSequenceGRUTest() = default;
+    virtual bool run() {
+        const int batch = 2, seqLength = 5, inputSize = 6, numUnits = 5;
+        GRUWeight fw, bw;
+        _fill(fw.gateWeight, (inputSize + numUnits) * 2 * numUnits, 1, 1.0f);
+        _fill(fw.gateBias, 2 * numUnits, 3, 0.5f);
+        _fill(fw.candidateWeight, (inputSize + numUnits) * numUnits, 5, 1.0f);
+        _fill(fw.candidateBias, numUnits, 7, 0.5f);
+        _fill(bw.gateWeight, (inputSize + numUnits) * 2 * numUnits, 11, 1.0f);
+        _fill(bw.gateBias, 2 * numUnits, 13, 0.5f);
+        _fill(bw.candidateWeight, (inputSize + numUnits) * numUnits, 17, 1.0f);
+        _fill(bw.candidateBias, numUnits, 19, 0.5f);
+        std::vector<float> xData;
+        _fill(xData, batch * seqLength * inputSize, 23, 2.0f);
+        for (int keep = 0; keep < 2; ++keep) {
+            bool keepAllOutputs = keep > 0;
+            std::unique_ptr<MNN::OpT> gru(new MNN::OpT);
+            gru->type       = MNN::OpType_RNNSequenceGRU;
+            gru->main.type  = MNN::OpParameter_RNNParam;
+            gru->main.value = new MNN::RNNParamT;
+            auto param                = gru->main.AsRNNParam();
+            param->numUnits           = numUnits;
+            param->isBidirectionalRNN = true;
+            param->keepAllOutputs     = keepAllOutputs;
+            param->fwGateWeight       = _makeBlob(fw.gateWeight, {inputSize + numUnits, 2 * numUnits});
+            param->fwGateBias         = _makeBlob(fw.gateBias, {2 * numUnits});
+            param->fwCandidateWeight  = _makeBlob(fw.candidateWeight, {inputSize + numUnits, numUnits});
+            param->fwCandidateBias    = _makeBlob(fw.candidateBias, {numUnits});
+            param->bwGateWeight       = _makeBlob(bw.gateWeight, {inputSize + numUnits, 2 * numUnits});
+            param->bwGateBias         = _makeBlob(bw.gateBias, {2 * numUnits});
+            param->bwCandidateWeight  = _makeBlob(bw.candidateWeight, {inputSize + numUnits, numUnits});
+            param->bwCandidateBias    = _makeBlob(bw.candidateBias, {numUnits});
+            auto x = _Input({batch, seqLength, inputSize}, NCHW);
+            ::memcpy(x->writeMap<float>(), xData.data(), xData.size() * sizeof(float));
+            auto expr = Expr::create(gru.get(), {x}, 2);
+            for (int d = 0; d < 2; ++d) {
+                std::vector<float> expected;
+                referenceGRU(xData.data(), d == 0 ? fw : bw, expected, batch, seqLength, inputSize, numUnits, d > 0,
+                             keepAllOutputs);
+                auto output = Variable::create(expr, d);
+                auto info   = output->getInfo();
+                auto ptr    = output->readMap<float>();
+                if (nullptr == info || nullptr == ptr || info->size != expected.size()) {
+                    MNN_ERROR("RNNSequenceGRU output %d compute error\n", d);
+                    return false;
+                }
+                for (int i = 0; i < expected.size(); ++i) {
+                    if (fabsf(ptr[i] - expected[i]) > 0.002f) {
+                        MNN_ERROR("RNNSequenceGRU keepAllOutputs=%d, output %d, %d: %f - %f\n", keepAllOutputs, d, i,
+                                  ptr[i], expected[i]);
+                        return false;
+                    }
+                }
+            }
+        }
+        return true;
+    }
+};
+MNNTestSuiteRegister(RNNSequenceGRUTest, "op/RNNSequenceGRU");
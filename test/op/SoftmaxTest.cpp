@@ -6,6 +6,8 @@
 //  Copyright © 2018, Alibaba Group Holding Limited
 //
 
+#include <math.h>
+#include <algorithm>
 #include <MNN/expr/Expr.hpp>
 #include <MNN/expr/ExprCreator.hpp>
 #include "MNNTestSuite.h"
@@ -86,6 +88,38 @@ public:
                 return false;
             }
         }
+        // testcase 4, large axis split into several blocks
+        {
+            const int channel = 20003;
+            auto input        = _Input({2, channel}, NCHW);
+            auto inputPtr     = input->writeMap<float>();
+            for (int i = 0; i < 2 * channel; ++i) {
+                inputPtr[i] = (float)(i % 97) * 0.25f - (float)(i / channel) * 30.0f;
+            }
+            input->unMap();
+            std::vector<float> expectedOutput(2 * channel);
+            for (int y = 0; y < 2; ++y) {
+                float maxValue = -1000.0f;
+                for (int x = 0; x < channel; ++x) {
+                    maxValue = std::max(maxValue, inputPtr[y * channel + x]);
+                }
+                double sum = 0.0;
+                for (int x = 0; x < channel; ++x) {
+                    sum += exp(inputPtr[y * channel + x] - maxValue);
+                }
+                for (int x = 0; x < channel; ++x) {
+                    expectedOutput[y * channel + x] = exp(inputPtr[y * channel + x] - maxValue) / sum;
+                }
+            }
+            auto output    = _Softmax(input);
+            auto gotOutput = output->readMap<float>();
+            for (int i = 0; i < 2 * channel; ++i) {
+                if (fabsf(gotOutput[i] - expectedOutput[i]) > 1e-6f + 0.001f * expectedOutput[i]) {
+                    MNN_ERROR("SoftmaxTest4 test failed at %d: %e - %e\n", i, gotOutput[i], expectedOutput[i]);
+                    return false;
+                }
+            }
+        }
         return true;
     }
 };
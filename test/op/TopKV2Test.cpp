@@ -0,0 +1,61 @@
+//
+//  TopKV2Test.cpp
+//  MNNTests
+//
+//  Created by MNN on 2020/11/12.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#include <algorithm>
+#include <MNN/expr/Expr.hpp>
+#include <MNN/expr/ExprCreator.hpp>
+#include "MNNTestSuite.h"
+#include "MNN_generated.h"
+
+using namespace MNN::Express;
+
+class TopKV2Test : public MNNTestCase {
+public:
+    virtual ~TopKV2Test() = default;
+    virtual bool run() {
+        // small k uses the heap, large k uses partial selection
+        return _run(7, 100, 3) && _run(7, 100, 60) && _run(3, 17, 17) && _run(1, 1000, 1);
+    }
+
+private:
+    bool _run(int numRows, int rowSize, int k) {
+        std::vector<float> data(numRows * rowSize);
+        for (int i = 0; i < data.size(); ++i) {
+            // repeated values check that the smaller index comes first
+            data[i] = (float)((i * 37) % 53);
+        }
+        auto input = _Input({numRows, rowSize}, NCHW);
+        ::memcpy(input->writeMap<float>(), data.data(), data.size() * sizeof(float));
+        std::unique_ptr<MNN::OpT> topk(new MNN::OpT);
+        topk->type = MNN::OpType_TopKV2;
+        auto expr  = Expr::create(topk.get(), {input, _Scalar<int>(k)}, 2);
+        auto values  = Variable::create(expr, 0)->readMap<float>();
+        auto indices = Variable::create(expr, 1)->readMap<int>();
+        if (nullptr == values || nullptr == indices) {
+            MNN_ERROR("TopKV2 compute error\n");
+            return false;
+        }
+        std::vector<int> order(rowSize);
+        for (int y = 0; y < numRows; ++y) {
+            auto row = data.data() + y * rowSize;
+            for (int x = 0; x < rowSize; ++x) {
+                order[x] = x;
+            }
+            std::stable_sort(order.begin(), order.end(), [row](int a, int b) { return row[a] > row[b]; });
+            for (int x = 0; x < k; ++x) {
+                if (indices[y * k + x] != order[x] || values[y * k + x] != row[order[x]]) {
+                    MNN_ERROR("TopKV2 (%d, %d, %d) error at %d, %d: %d - %d\n", numRows, rowSize, k, y, x,
+                              indices[y * k + x], order[x]);
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+};
+MNNTestSuiteRegister(TopKV2Test, "op/TopKV2");
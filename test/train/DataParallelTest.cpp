@@ -0,0 +1,62 @@
+//
+//  DataParallelTest.cpp
+//  MNNTests
+//
+//  Created by MNN on 2020/12/04.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#include <math.h>
+#include <MNN/expr/ExprCreator.hpp>
+#include <MNN/expr/NN.hpp>
+#include "DataParallel.hpp"
+#include "Loss.hpp"
+#include "MNNTestSuite.h"
+#include "SGD.hpp"
+#include "TrainTestUtils.h"
+using namespace MNN::Express;
+using namespace MNN::Train;
+
+// The replicas run on their own threads and executors, the update must be the one of the whole batch on a single
+// model, including the batches that are not divisible by the number of replicas
+class DataParallelTest : public MNNTestCase {
+public:
+    virtual bool run() {
+        const int batch = 10, steps = 3;
+        const float learningRate = 0.1f;
+        for (int replicas : {1, 3, 4}) {
+            LinearReference reference;
+            auto model = reference.createModule();
+            std::shared_ptr<SGD> sgd(new SGD(model));
+            sgd->setLearningRate(learningRate);
+            DataParallel parallel(
+                model, sgd, []() { return NN::Linear(LinearReference::INPUT, LinearReference::OUTPUT); }, replicas);
+            if (parallel.replicas() != replicas) {
+                MNN_ERROR("DataParallel creates %d replicas, expect %d\n", parallel.replicas(), replicas);
+                return false;
+            }
+            auto lossFunction = [](std::shared_ptr<Module> module, const std::vector<VARP>& inputs) {
+                return _MSE(module->forward(inputs[0]), inputs[1]);
+            };
+            for (int s = 0; s < steps; ++s) {
+                std::vector<float> x, target;
+                LinearReference::makeBatch(batch, s, x, target);
+                auto xVar      = _Const(x.data(), {batch, LinearReference::INPUT}, NCHW);
+                auto targetVar = _Const(target.data(), {batch, LinearReference::OUTPUT}, NCHW);
+                auto loss      = parallel.step({xVar, targetVar}, lossFunction);
+                auto expected  = reference.loss(x, target, 0, batch);
+                if (fabs(loss - expected) > 1e-4) {
+                    MNN_ERROR("DataParallel %d replicas, step %d: loss %f - %f\n", replicas, s, loss, expected);
+                    return false;
+                }
+                reference.step(x, target, batch, learningRate);
+                if (!reference.check(model, 1e-4, "DataParallel")) {
+                    MNN_ERROR("DataParallel %d replicas, step %d error\n", replicas, s);
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+};
+MNNTestSuiteRegister(DataParallelTest, "train/data_parallel");
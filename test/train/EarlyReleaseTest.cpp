@@ -0,0 +1,170 @@
+//
+//  EarlyReleaseTest.cpp
+//  MNNTests
+//
+//  Created by MNN on 2020/12/04.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#include <math.h>
+#include <MNN/expr/ExecutorScope.hpp>
+#include <MNN/expr/ExprCreator.hpp>
+#include "MNNTestSuite.h"
+#include "OpGrad.hpp"
+#include "core/Backend.hpp"
+using namespace MNN::Express;
+using namespace MNN;
+
+static bool _checkGrad(VARP grad, const std::vector<double>& expected, const char* name, int layer) {
+    auto ptr = grad->readMap<float>();
+    if (nullptr == ptr || grad->getInfo()->size != expected.size()) {
+        MNN_ERROR("EarlyRelease compute %s %d error\n", name, layer);
+        return false;
+    }
+    for (int i = 0; i < expected.size(); ++i) {
+        if (fabs(ptr[i] - expected[i]) > 1e-3 * (1.0 + fabs(expected[i]))) {
+            MNN_ERROR("EarlyRelease %s %d, %d: %f - %f\n", name, layer, i, ptr[i], expected[i]);
+            return false;
+        }
+    }
+    return true;
+}
+
+/* p = sum_k reduce(u_k) and q_k = reduce(2 * u_k) with u_k = exp(k * x) in one cache. Visiting p first, every u_k is
+   made before any q_k and kept until it, the executor runs q_k as soon as u_k is ready so about two of them are alive
+   at the same time. Return the memory planned for the cache, -1 if the result is wrong */
+static float _computeBranches(int size, int branches) {
+    BackendConfig config;
+    auto executor = Executor::newExecutor(MNN_FORWARD_CPU, config, 1);
+    ExecutorScope scope(executor);
+    std::vector<float> x(size);
+    for (int i = 0; i < size; ++i) {
+        x[i] = (float)(i % 17) / 17.0f - 0.5f;
+    }
+    auto input = _Const(x.data(), {size}, NCHW);
+    VARP p;
+    std::vector<VARP> outputs(1);
+    for (int k = 0; k < branches; ++k) {
+        auto u = _Exp(input * _Scalar<float>(0.1f * (k + 1)));
+        auto r = _ReduceSum(u, {});
+        p      = nullptr == p ? r : p + r;
+        outputs.emplace_back(_ReduceSum(u * _Scalar<float>(2.0f), {}));
+    }
+    outputs[0] = p;
+    Variable::prepareCompute(outputs);
+    double expectP = 0.0;
+    for (int k = 0; k < branches; ++k) {
+        double sum = 0.0;
+        for (int i = 0; i < size; ++i) {
+            sum += exp(0.1 * (k + 1) * x[i]);
+        }
+        expectP += sum;
+        if (!_checkGrad(outputs[k + 1], {2.0 * sum}, "branch", k)) {
+            return -1.0f;
+        }
+    }
+    if (!_checkGrad(p, {expectP}, "sum", 0)) {
+        return -1.0f;
+    }
+    auto runtime = Executor::getRuntime().first[MNN_FORWARD_CPU];
+    return runtime->onGetMemoryInMB() * 1024.0f * 1024.0f;
+}
+
+/* The gradients of x and the weights of h_(i+1) = relu(z_i), z_i = h_i * W_i^T are computed in one cache. The
+   tensors are released after their last consumer, so the planned memory must be below the sum of the tensors. The
+   backward needs the activations of all layers, so the order of the units only saves a few dz_i here (about 6%), the
+   branches below are where the order matters */
+class EarlyReleaseTest : public MNNTestCase {
+public:
+    virtual bool run() {
+        const int batch = 256, width = 16, layers = 6;
+        const int size = batch * width;
+        BackendConfig config;
+        auto executor = Executor::newExecutor(MNN_FORWARD_CPU, config, 1);
+        ExecutorScope scope(executor);
+        std::vector<float> x(size);
+        for (int i = 0; i < size; ++i) {
+            x[i] = (float)((i * 7 + 1) % 13) / 13.0f - 0.45f;
+        }
+        std::vector<std::vector<float>> weights(layers, std::vector<float>(width * width));
+        std::vector<VARP> weightVars(layers);
+        auto input = _TrainableParam(x.data(), {batch, width}, NCHW);
+        auto h     = input;
+        for (int l = 0; l < layers; ++l) {
+            for (int i = 0; i < width * width; ++i) {
+                weights[l][i] = (float)((i * 5 + l * 3) % 11) / 11.0f * 0.6f - 0.27f;
+            }
+            weightVars[l] = _TrainableParam(weights[l].data(), {width, width}, NCHW);
+            h             = _Relu(_MatMul(h, weightVars[l], false, true));
+        }
+        auto loss = _ReduceSum(h, {});
+        std::set<VARP> parameters(weightVars.begin(), weightVars.end());
+        parameters.insert(input);
+        auto grads = OpGrad::grad(loss, parameters);
+        std::vector<VARP> outputs = {grads[input]};
+        for (auto w : weightVars) {
+            outputs.emplace_back(grads[w]);
+        }
+        Variable::prepareCompute(outputs);
+
+        // Reference in double
+        std::vector<std::vector<double>> hs(layers + 1, std::vector<double>(size)), zs(layers, std::vector<double>(size));
+        hs[0].assign(x.begin(), x.end());
+        for (int l = 0; l < layers; ++l) {
+            for (int b = 0; b < batch; ++b) {
+                for (int o = 0; o < width; ++o) {
+                    double sum = 0.0;
+                    for (int i = 0; i < width; ++i) {
+                        sum += hs[l][b * width + i] * weights[l][o * width + i];
+                    }
+                    zs[l][b * width + o]     = sum;
+                    hs[l + 1][b * width + o] = sum > 0.0 ? sum : 0.0;
+                }
+            }
+        }
+        std::vector<double> dh(size, 1.0);
+        for (int l = layers - 1; l >= 0; --l) {
+            std::vector<double> dz(size), dw(width * width, 0.0), dhNext(size, 0.0);
+            for (int i = 0; i < size; ++i) {
+                dz[i] = zs[l][i] > 0.0 ? dh[i] : 0.0;
+            }
+            for (int b = 0; b < batch; ++b) {
+                for (int o = 0; o < width; ++o) {
+                    for (int i = 0; i < width; ++i) {
+                        dw[o * width + i] += dz[b * width + o] * hs[l][b * width + i];
+                        dhNext[b * width + i] += dz[b * width + o] * weights[l][o * width + i];
+                    }
+                }
+            }
+            if (!_checkGrad(outputs[l + 1], dw, "weight", l)) {
+                return false;
+            }
+            dh = std::move(dhNext);
+        }
+        if (!_checkGrad(outputs[0], dh, "input", 0)) {
+            return false;
+        }
+
+        // The memory planned for the cache is in the allocators of the runtime of the executor. The cache makes at
+        // least z_i, h_(i+1), dz_i and dh_i for each layer, without the early release they would all be alive
+        auto runtime = Executor::getRuntime().first[MNN_FORWARD_CPU];
+        auto memory  = runtime->onGetMemoryInMB() * 1024.0f * 1024.0f;
+        auto total   = 4.0f * layers * size * sizeof(float);
+        if (memory <= 0.0f || memory > 0.75f * total) {
+            MNN_ERROR("EarlyRelease plans %f bytes, the tensors of the cache take at least %f bytes\n", memory, total);
+            return false;
+        }
+
+        // In the order of the visit the u_k of 8 branches would all be alive
+        const int branchSize = 64 * 1024, branches = 8;
+        auto branchMemory    = _computeBranches(branchSize, branches);
+        auto branchTotal     = (float)branches * branchSize * sizeof(float);
+        if (branchMemory <= 0.0f || branchMemory > 0.5f * branchTotal) {
+            MNN_ERROR("EarlyRelease plans %f bytes for the branches, all u_k take %f bytes\n", branchMemory,
+                      branchTotal);
+            return false;
+        }
+        return true;
+    }
+};
+MNNTestSuiteRegister(EarlyReleaseTest, "train/early_release");
@@ -0,0 +1,80 @@
+//
+//  GradientAccumulationTest.cpp
+//  MNNTests
+//
+//  Created by MNN on 2020/12/04.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#include <math.h>
+#include <MNN/expr/ExprCreator.hpp>
+#include "GradientAccumulation.hpp"
+#include "Loss.hpp"
+#include "MNNTestSuite.h"
+#include "SGD.hpp"
+#include "TrainTestUtils.h"
+using namespace MNN::Express;
+using namespace MNN::Train;
+
+// K micro-batches must give the update of the whole batch in one step. With releaseActivations the loss of a
+// micro-batch is fixed to a constant after its gradients are read, so it no longer holds the graph
+class GradientAccumulationTest : public MNNTestCase {
+public:
+    virtual bool run() {
+        const int batch = 8, steps = 2;
+        const float learningRate = 0.1f;
+        for (bool release : {false, true}) {
+            for (int microBatches : {1, 2, 4}) {
+                LinearReference reference;
+                auto model = reference.createModule();
+                std::shared_ptr<SGD> sgd(new SGD(model));
+                sgd->setLearningRate(learningRate);
+                GradientAccumulation accumulation(model, sgd, microBatches, release);
+                const int microBatch = batch / microBatches;
+                for (int s = 0; s < steps; ++s) {
+                    std::vector<float> x, target;
+                    LinearReference::makeBatch(batch, s, x, target);
+                    for (int m = 0; m < microBatches; ++m) {
+                        auto xVar = _Const(x.data() + m * microBatch * LinearReference::INPUT,
+                                           {microBatch, LinearReference::INPUT}, NCHW);
+                        auto targetVar = _Const(target.data() + m * microBatch * LinearReference::OUTPUT,
+                                                {microBatch, LinearReference::OUTPUT}, NCHW);
+                        auto loss    = _MSE(model->forward(xVar), targetVar);
+                        auto updated = accumulation.step(loss);
+                        if (updated != (m == microBatches - 1)) {
+                            MNN_ERROR("GradientAccumulation %d micro-batches updates at %d\n", microBatches, m);
+                            return false;
+                        }
+                        if (release != (nullptr == loss->expr().first->get())) {
+                            MNN_ERROR("GradientAccumulation releaseActivations %d, the loss keeps its graph: %d\n",
+                                      release, nullptr != loss->expr().first->get());
+                            return false;
+                        }
+                        if (!release) {
+                            continue;
+                        }
+                        // The fixed loss keeps the value of its micro-batch after the parameters are updated
+                        auto lossPtr  = loss->readMap<float>();
+                        auto expected = reference.loss(x, target, m * microBatch, microBatch);
+                        if (nullptr == lossPtr || fabs(lossPtr[0] - expected) > 1e-4) {
+                            MNN_ERROR("GradientAccumulation %d micro-batches, loss of %d error\n", microBatches, m);
+                            return false;
+                        }
+                    }
+                    reference.step(x, target, batch, learningRate);
+                    if (!reference.check(model, 1e-4, "GradientAccumulation")) {
+                        MNN_ERROR("GradientAccumulation %d micro-batches, release %d, step %d error\n", microBatches,
+                                  release, s);
+                        return false;
+                    }
+                }
+                if (accumulation.accumulated() != 0 || accumulation.flush()) {
+                    MNN_ERROR("GradientAccumulation keeps micro-batches after the update\n");
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+};
+MNNTestSuiteRegister(GradientAccumulationTest, "train/gradient_accumulation");
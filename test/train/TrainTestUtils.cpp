@@ -0,0 +1,107 @@
+//
+//  TrainTestUtils.cpp
+//  MNNTests
+//
+//  Created by MNN on 2020/12/04.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#include "TrainTestUtils.h"
+#include <math.h>
+#include <MNN/expr/ExprCreator.hpp>
+#include <MNN/expr/NN.hpp>
+using namespace MNN::Express;
+
+LinearReference::LinearReference() {
+    mWeight.resize(OUTPUT * INPUT);
+    mBias.resize(OUTPUT);
+    for (int i = 0; i < mWeight.size(); ++i) {
+        mWeight[i] = (double)((i * 7 + 3) % 11) / 11.0 - 0.5;
+    }
+    for (int i = 0; i < mBias.size(); ++i) {
+        mBias[i] = 0.1 * i;
+    }
+}
+
+std::shared_ptr<Module> LinearReference::createModule() const {
+    std::shared_ptr<Module> module(NN::Linear(INPUT, OUTPUT));
+    std::vector<float> weight(mWeight.begin(), mWeight.end());
+    std::vector<float> bias(mBias.begin(), mBias.end());
+    module->loadParameters(
+        {_TrainableParam(weight.data(), {OUTPUT, INPUT}, NCHW), _TrainableParam(bias.data(), {1, OUTPUT}, NCHW)});
+    return module;
+}
+
+void LinearReference::makeBatch(int batch, int step, std::vector<float>& x, std::vector<float>& target) {
+    x.resize(batch * INPUT);
+    target.resize(batch * OUTPUT);
+    for (int i = 0; i < x.size(); ++i) {
+        x[i] = (float)((i * 13 + step * 5) % 17) / 17.0f - 0.5f;
+    }
+    for (int i = 0; i < target.size(); ++i) {
+        target[i] = (float)((i * 3 + step) % 7) / 7.0f;
+    }
+}
+
+double LinearReference::loss(const std::vector<float>& x, const std::vector<float>& target, int start,
+                             int batch) const {
+    double sum = 0.0;
+    for (int b = start; b < start + batch; ++b) {
+        for (int o = 0; o < OUTPUT; ++o) {
+            double y = mBias[o];
+            for (int i = 0; i < INPUT; ++i) {
+                y += x[b * INPUT + i] * mWeight[o * INPUT + i];
+            }
+            sum += (y - target[b * OUTPUT + o]) * (y - target[b * OUTPUT + o]);
+        }
+    }
+    return sum / batch;
+}
+
+void LinearReference::step(const std::vector<float>& x, const std::vector<float>& target, int batch,
+                           float learningRate) {
+    std::vector<double> weightGrad(mWeight.size(), 0.0), biasGrad(mBias.size(), 0.0);
+    for (int b = 0; b < batch; ++b) {
+        for (int o = 0; o < OUTPUT; ++o) {
+            double y = mBias[o];
+            for (int i = 0; i < INPUT; ++i) {
+                y += x[b * INPUT + i] * mWeight[o * INPUT + i];
+            }
+            // d(mean over batch of the sum over outputs) / dy
+            double dy = 2.0 * (y - target[b * OUTPUT + o]) / batch;
+            for (int i = 0; i < INPUT; ++i) {
+                weightGrad[o * INPUT + i] += dy * x[b * INPUT + i];
+            }
+            biasGrad[o] += dy;
+        }
+    }
+    for (int i = 0; i < mWeight.size(); ++i) {
+        mWeight[i] -= learningRate * weightGrad[i];
+    }
+    for (int i = 0; i < mBias.size(); ++i) {
+        mBias[i] -= learningRate * biasGrad[i];
+    }
+}
+
+bool LinearReference::check(std::shared_ptr<Module> module, double threshold, const char* name) const {
+    auto parameters = module->parameters();
+    if (parameters.size() != 2) {
+        MNN_ERROR("%s: the linear model has %d parameters\n", name, (int)parameters.size());
+        return false;
+    }
+    const std::vector<double>* expected[] = {&mWeight, &mBias};
+    for (int p = 0; p < 2; ++p) {
+        auto ptr = parameters[p]->readMap<float>();
+        if (nullptr == ptr || parameters[p]->getInfo()->size != expected[p]->size()) {
+            MNN_ERROR("%s: read parameter %d error\n", name, p);
+            return false;
+        }
+        for (int i = 0; i < expected[p]->size(); ++i) {
+            if (fabs(ptr[i] - (*expected[p])[i]) > threshold) {
+                MNN_ERROR("%s: parameter %d, %d: %f - %f\n", name, p, i, ptr[i], (*expected[p])[i]);
+                return false;
+            }
+        }
+    }
+    return true;
+}
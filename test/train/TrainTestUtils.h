@@ -0,0 +1,40 @@
+//
+//  TrainTestUtils.h
+//  MNNTests
+//
+//  Created by MNN on 2020/12/04.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#ifndef TrainTestUtils_h
+#define TrainTestUtils_h
+
+#include <MNN/expr/Module.hpp>
+#include <memory>
+#include <vector>
+
+/* A linear model y = x * weight^T + bias with the MSE loss, its SGD steps are also computed in double as the
+   reference of the training tests */
+class LinearReference {
+public:
+    static const int INPUT  = 8;
+    static const int OUTPUT = 3;
+
+    LinearReference();
+    // NN::Linear with the parameters of the reference
+    std::shared_ptr<MNN::Express::Module> createModule() const;
+    // Inputs and targets of the batch for the step
+    static void makeBatch(int batch, int step, std::vector<float>& x, std::vector<float>& target);
+    // The MSE loss of the rows [start, start + batch)
+    double loss(const std::vector<float>& x, const std::vector<float>& target, int start, int batch) const;
+    // One SGD step without momentum and weight decay over the whole batch
+    void step(const std::vector<float>& x, const std::vector<float>& target, int batch, float learningRate);
+    // Compare the parameters of the module with the reference
+    bool check(std::shared_ptr<MNN::Express::Module> module, double threshold, const char* name) const;
+
+private:
+    std::vector<double> mWeight;
+    std::vector<double> mBias;
+};
+
+#endif /* TrainTestUtils_h */
@@ -7,8 +7,10 @@
 //
 
 #include "calibration.hpp"
+#include <algorithm>
 #include <cmath>
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <set>
 #include <MNN/ImageProcess.hpp>
@@ -357,9 +359,104 @@ void Calibration::_computeFeatureScaleADMM() {
     MNN_PRINT("\n");
 }
 
+void Calibration::_markInt8Ops() {
+    _int8Ops.clear();
+    // ReLU, Pooling and Concat don't change the value range, so they can run on int8 when all their inputs are
+    // produced by quantized ops. Their inputs and outputs then must use the same scale, use union-find to collect
+    // the tensors that share one scale
+    std::map<const MNN::Tensor*, const MNN::Tensor*> parent;
+    std::function<const MNN::Tensor*(const MNN::Tensor*)> findRoot = [&](const MNN::Tensor* t) {
+        auto iter = parent.find(t);
+        if (iter == parent.end() || iter->second == t) {
+            return t;
+        }
+        auto root = findRoot(iter->second);
+        parent[t] = root;
+        return root;
+    };
+    std::set<int> int8Tensors;
+    for (const auto& op : _originaleModel->oplists) {
+        const auto opType = op->type;
+        bool quantized    = false;
+        bool keepScale    = false;
+        if (opType == MNN::OpType_Convolution || opType == MNN::OpType_ConvolutionDepthwise) {
+            quantized = true;
+        } else if (opType == MNN::OpType_Eltwise) {
+            quantized = op->main.AsEltwise()->type == MNN::EltwiseType_SUM;
+        } else if (opType == MNN::OpType_ReLU || opType == MNN::OpType_Pooling || opType == MNN::OpType_Concat) {
+            keepScale = true;
+            if (opType == MNN::OpType_ReLU && nullptr != op->main.AsRelu() && op->main.AsRelu()->slope != 0.0f) {
+                keepScale = false;
+            }
+            if (opType == MNN::OpType_Pooling && op->main.AsPool()->type != MNN::PoolType_MAXPOOL &&
+                op->main.AsPool()->type != MNN::PoolType_AVEPOOL) {
+                keepScale = false;
+            }
+            auto tensorsPair = _opInfo.find(op->name);
+            if (tensorsPair == _opInfo.end() || op->outputIndexes.size() != 1) {
+                keepScale = false;
+            }
+            for (auto index : op->inputIndexes) {
+                if (int8Tensors.find(index) == int8Tensors.end()) {
+                    keepScale = false;
+                }
+            }
+            if (keepScale) {
+                for (auto t : tensorsPair->second.first) {
+                    keepScale = keepScale && _scales.find(t) != _scales.end();
+                }
+                for (auto t : tensorsPair->second.second) {
+                    keepScale = keepScale && _scales.find(t) != _scales.end();
+                }
+            }
+            quantized = keepScale;
+        }
+        if (!quantized) {
+            continue;
+        }
+        for (auto index : op->outputIndexes) {
+            int8Tensors.insert(index);
+        }
+        if (!keepScale) {
+            continue;
+        }
+        _int8Ops.insert(op->name);
+        const auto& tensorsPair = _opInfo[op->name];
+        auto outputRoot         = findRoot(tensorsPair.second[0]);
+        for (auto t : tensorsPair.first) {
+            auto root = findRoot(t);
+            if (root != outputRoot) {
+                parent[root] = outputRoot;
+            }
+        }
+    }
+
+    // Use the max scale of each group, so that no value of the group is clipped
+    std::map<const MNN::Tensor*, float> groupScale;
+    for (const auto& iter : parent) {
+        for (auto t : {iter.first, iter.second}) {
+            auto& scale = groupScale[findRoot(t)];
+            for (auto v : _scales[t]) {
+                scale = std::max(scale, v);
+            }
+        }
+    }
+    for (const auto& iter : parent) {
+        for (auto t : {iter.first, iter.second}) {
+            auto& scale = _scales[t];
+            std::fill(scale.begin(), scale.end(), groupScale[findRoot(t)]);
+        }
+    }
+}
+
 void Calibration::_updateScale() {
     for (const auto& op : _originaleModel->oplists) {
         const auto opType = op->type;
+        if (opType == MNN::OpType_Pooling && _int8Ops.find(op->name) != _int8Ops.end()) {
+            // PoolInt8 use the same parameter as Pooling
+            op->type = MNN::OpType_PoolInt8;
+            continue;
+        }
         if (opType != MNN::OpType_Convolution && opType != MNN::OpType_ConvolutionDepthwise &&
             opType != MNN::OpType_Eltwise) {
             continue;
@@ -439,8 +536,11 @@ void Calibration::_insertDequantize() {
     // Search All Int Tensors
     std::set<int> int8Tensors;
     std::set<int> int8Outputs;
+    auto isInt8Op = [this](const MNN::OpT* op) {
+        return Helper::INT8SUPPORTED_OPS.count(op->type) > 0 || _int8Ops.count(op->name) > 0;
+    };
     for (auto& op : _originaleModel->oplists) {
-        if (Helper::INT8SUPPORTED_OPS.count(op->type) > 0) {
+        if (isInt8Op(op.get())) {
             for (auto index : op->inputIndexes) {
                 int8Tensors.insert(index);
             }
@@ -461,12 +561,11 @@ void Calibration::_insertDequantize() {
 
     // Insert Convert For Not Support Int8 Ops
     for (auto iter = _originaleModel->oplists.begin(); iter != _originaleModel->oplists.end();) {
-        auto op           = iter->get();
-        const auto opType = op->type;
-        const auto name   = op->name;
+        auto op         = iter->get();
+        const auto name = op->name;
         // check whether is output op
         // if Yes, insert dequantization op after this op
-        if (Helper::INT8SUPPORTED_OPS.find(opType) != Helper::INT8SUPPORTED_OPS.end()) {
+        if (isInt8Op(op)) {
             // this is quantized op
             iter++;
             continue;
@@ -566,6 +665,7 @@ void Calibration::runQuantizeModel() {
     } else if (_featureQuantizeMethod == "ADMM") {
         _computeFeatureScaleADMM();
     }
+    _markInt8Ops();
     _updateScale();
     _insertDequantize();
 }
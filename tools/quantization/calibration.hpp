@@ -10,6 +10,7 @@
 #define CALIBRATION_HPP
 
 #include <map>
+#include <set>
 
 #include <MNN/ImageProcess.hpp>
 #include <MNN/Interpreter.hpp>
@@ -49,6 +50,9 @@ private:
     // The scale results
     std::map<const MNN::Tensor*, std::vector<float>> _scales;
 
+    // The ops that run on int8 without changing their type
+    std::set<std::string> _int8Ops;
+
     std::shared_ptr<MNN::Interpreter> _interpreter;
     // keep mnn forward information
     MNN::Session* _session;
@@ -65,6 +69,9 @@ private:
     void _collectFeatureMapsDistribution();
     void _computeFeatureScaleKL();
     void _computeFeatureScaleADMM();
+    // find the ops between quantized ops that can keep int8 (ReLU, Pooling, Concat), and share one scale between
+    // their inputs and outputs, so that the activations don't go back to float
+    void _markInt8Ops();
     void _updateScale();
 
     // insert the dequantization op before the not supported op(int8), and insert dequantization op
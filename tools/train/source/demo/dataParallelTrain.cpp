@@ -0,0 +1,68 @@
+//
+//  dataParallelTrain.cpp
+//  MNN
+//
+//  Created by MNN on 2020/11/20.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#include <MNN/AutoTime.hpp>
+#include <MNN/expr/ExprCreator.hpp>
+#include <stdlib.h>
+#include "DataParallel.hpp"
+#include "DemoUnit.hpp"
+#include "Lenet.hpp"
+#include "Loss.hpp"
+#include "SGD.hpp"
+using namespace MNN::Express;
+using namespace MNN::Train;
+
+// Train Lenet on random data with several replicas and print the time of each step
+class DataParallelTrain : public DemoUnit {
+public:
+    virtual int run(int argc, const char* argv[]) override {
+        int replicas = 4;
+        int batch    = 64;
+        int steps    = 10;
+        if (argc > 1) {
+            replicas = ::atoi(argv[1]);
+        }
+        if (argc > 2) {
+            batch = ::atoi(argv[2]);
+        }
+        if (argc > 3) {
+            steps = ::atoi(argv[3]);
+        }
+        MNN_PRINT("Usage: ./runTrainDemo.out DataParallelTrain [replicas] [batch] [steps], use %d, %d, %d\n", replicas,
+                  batch, steps);
+        std::shared_ptr<Module> model(new Model::Lenet);
+        std::shared_ptr<SGD> sgd(new SGD(model));
+        sgd->setLearningRate(0.01f);
+        sgd->setMomentum(0.9f);
+        DataParallel parallel(model, sgd, []() { return new Model::Lenet; }, replicas);
+
+        auto image = _Input({batch, 1, 28, 28}, NCHW);
+        auto label = _Input({batch}, NCHW, halide_type_of<int32_t>());
+        auto imagePtr = image->writeMap<float>();
+        auto labelPtr = label->writeMap<int32_t>();
+        for (int i = 0; i < batch * 28 * 28; ++i) {
+            imagePtr[i] = (rand() % 256) / 255.0f;
+        }
+        for (int i = 0; i < batch; ++i) {
+            labelPtr[i] = rand() % 10;
+        }
+        auto lossFunction = [](std::shared_ptr<Module> module, const std::vector<VARP>& inputs) {
+            auto predict = module->forward(_Convert(inputs[0], NC4HW4));
+            auto target  = _OneHot(inputs[1], _Scalar<int>(10), _Scalar<float>(1.0f), _Scalar<float>(0.0f));
+            return _CrossEntropy(predict, target);
+        };
+        for (int i = 0; i < steps; ++i) {
+            MNN::Timer timer;
+            auto loss = parallel.step({image, label}, lossFunction);
+            MNN_PRINT("step %d, loss = %f, %f ms\n", i, loss, timer.durationInUs() / 1000.0f);
+        }
+        return 0;
+    }
+};
+
+DemoUnitSetRegister(DataParallelTrain, "DataParallelTrain");
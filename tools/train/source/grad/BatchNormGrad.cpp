@@ -0,0 +1,51 @@
+//
+//  BatchNormGrad.cpp
+//  MNN
+//
+//  Created by MNN on 2020/12/01.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#include "BatchNormGrad.hpp"
+#include "core/Macro.h"
+using namespace std;
+using namespace MNN;
+using namespace MNN::Express;
+
+class BatchNormTrainGrad : public OpGrad {
+public:
+    BatchNormTrainGrad() {
+        mType = NO_LINEAR;
+    }
+
+    // Only the diff of y is used, the mean and invStd outputs are for the running statistics
+    virtual std::vector<Express::VARP> onGrad(Express::EXPRP expr,
+                                              const std::vector<Express::VARP>& backwardOutput) override {
+        std::vector<Express::VARP> result(3, nullptr);
+        auto outputDiff = backwardOutput[0];
+        if (nullptr == outputDiff) {
+            return result;
+        }
+        auto inputs = expr->inputs();
+        auto x      = inputs[0];
+        outputDiff  = _Convert(outputDiff, x->getInfo()->order);
+        std::unique_ptr<OpT> forwardOp(expr->get()->UnPack());
+        unique_ptr<OpT> newOp(new OpT);
+        newOp->type       = OpType_BatchNormGrad;
+        newOp->main.type  = OpParameter_BatchNorm;
+        newOp->main.value = new BatchNormT(*forwardOp->main.AsBatchNorm());
+
+        auto gradExpr = Expr::create(std::move(newOp), {x, outputDiff, inputs[1], Variable::create(expr, 1),
+                                                        Variable::create(expr, 2)}, 3);
+        for (int i = 0; i < 3; ++i) {
+            result[i] = Variable::create(gradExpr, i);
+        }
+        return result;
+    }
+};
+
+static const auto gRegister = []() {
+    static BatchNormTrainGrad _c;
+    OpGrad::insert(OpType_BatchNormTrain, &_c);
+    return true;
+}();
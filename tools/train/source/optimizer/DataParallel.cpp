@@ -0,0 +1,258 @@
+//
+//  DataParallel.cpp
+//  MNN
+//
+//  Created by MNN on 2020/11/20.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#include "DataParallel.hpp"
+#include <MNN/expr/ExecutorScope.hpp>
+#include <MNN/expr/ExprCreator.hpp>
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <string.h>
+#include <thread>
+#include "OpGrad.hpp"
+using namespace MNN::Express;
+
+namespace MNN {
+namespace Train {
+namespace {
+class Barrier {
+public:
+    Barrier(int number) : mNumber(number) {
+        // Do nothing
+    }
+    void wait() {
+        std::unique_lock<std::mutex> lock(mMutex);
+        auto generation = mGeneration;
+        if (++mArrived == mNumber) {
+            mArrived = 0;
+            mGeneration++;
+            mCondition.notify_all();
+            return;
+        }
+        mCondition.wait(lock, [this, generation]() { return generation != mGeneration; });
+    }
+
+private:
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    int mNumber;
+    int mArrived    = 0;
+    int mGeneration = 0;
+};
+
+bool isInput(VARP p) {
+    return nullptr != p.get() && nullptr == p->expr().first->get();
+}
+} // namespace
+
+DataParallel::DataParallel(std::shared_ptr<Module> module, std::shared_ptr<ParameterOptimizer> optimizer,
+                           std::function<Module*()> creator, int replicas, int threadPerReplica) {
+    mModule    = module;
+    mOptimizer = optimizer;
+    Replica origin;
+    origin.module     = module;
+    origin.parameters = module->parameters();
+    auto& trainable   = optimizer->trainable();
+    for (int i = 0; i < origin.parameters.size(); ++i) {
+        if (trainable.find(origin.parameters[i]) != trainable.end()) {
+            mTrainableIndex.emplace_back(i);
+        }
+    }
+    mReplicas.emplace_back(std::move(origin));
+    BackendConfig config;
+    for (int r = 1; r < replicas; ++r) {
+        Replica replica;
+        replica.module.reset(creator());
+        if (nullptr == replica.module.get()) {
+            MNN_ERROR("DataParallel: create replica %d failed\n", r);
+            break;
+        }
+        replica.parameters = replica.module->parameters();
+        if (replica.parameters.size() != mReplicas[0].parameters.size()) {
+            MNN_ERROR("DataParallel: replica %d has %d parameters, but the module has %d\n", r,
+                      (int)replica.parameters.size(), (int)mReplicas[0].parameters.size());
+            break;
+        }
+        replica.module->setIsTraining(module->getIsTraining());
+        replica.executor = Executor::newExecutor(MNN_FORWARD_CPU, config, threadPerReplica);
+        mReplicas.emplace_back(std::move(replica));
+    }
+}
+
+float DataParallel::step(const std::vector<VARP>& inputs, LossFunction loss) {
+    if (inputs.empty()) {
+        return -1.0f;
+    }
+    // Split the batch, the first batch % number replicas get one more
+    std::vector<const uint8_t*> inputPtrs(inputs.size());
+    std::vector<size_t> rowBytes(inputs.size());
+    const int batch = inputs[0]->getInfo()->dim[0];
+    for (int k = 0; k < inputs.size(); ++k) {
+        auto info = inputs[k]->getInfo();
+        if (nullptr == info || info->dim.empty() || info->dim[0] != batch) {
+            MNN_ERROR("DataParallel: inputs must have the same batch\n");
+            return -1.0f;
+        }
+        inputPtrs[k] = inputs[k]->readMap<uint8_t>();
+        if (nullptr == inputPtrs[k]) {
+            return -1.0f;
+        }
+        rowBytes[k] = info->size / batch * info->type.bytes();
+    }
+    const int number = std::min((int)mReplicas.size(), batch);
+    std::vector<int> microBatch(number), microOffset(number);
+    for (int r = 0, offset = 0; r < number; ++r) {
+        microBatch[r]  = batch / number + (r < batch % number ? 1 : 0);
+        microOffset[r] = offset;
+        offset += microBatch[r];
+    }
+
+    // The values of replica 0 are copied to the others
+    auto& parameters = mReplicas[0].parameters;
+    std::vector<const void*> parameterPtrs(parameters.size(), nullptr);
+    std::vector<size_t> parameterBytes(parameters.size(), 0);
+    for (int i = 0; i < parameters.size(); ++i) {
+        if (number > 1 && isInput(parameters[i])) {
+            auto info         = parameters[i]->getInfo();
+            parameterPtrs[i]  = parameters[i]->readMap<void>();
+            parameterBytes[i] = info->size * info->type.bytes();
+        }
+    }
+    // Reduced gradients
+    const int trainableNumber = (int)mTrainableIndex.size();
+    std::vector<VARP> reduced(trainableNumber);
+    std::vector<float*> reducedPtrs(trainableNumber);
+    std::vector<int> reducedSize(trainableNumber);
+    for (int j = 0; j < trainableNumber; ++j) {
+        auto info      = parameters[mTrainableIndex[j]]->getInfo();
+        reduced[j]     = _Input(info->dim, info->order, halide_type_of<float>());
+        reducedPtrs[j] = reduced[j]->writeMap<float>();
+        reducedSize[j] = info->size;
+    }
+
+    std::vector<std::vector<const float*>> gradPtrs(number, std::vector<const float*>(trainableNumber, nullptr));
+    std::vector<float> losses(number, 0.0f);
+    std::vector<int> success(number, 0);
+    Barrier barrier(number);
+    auto work = [&](int r) {
+        auto& replica = mReplicas[r];
+        std::shared_ptr<ExecutorScope> scope;
+        if (nullptr != replica.executor.get()) {
+            scope.reset(new ExecutorScope(replica.executor));
+        }
+        if (r > 0) {
+            for (int i = 0; i < parameters.size(); ++i) {
+                if (nullptr == parameterPtrs[i] || !isInput(replica.parameters[i]) ||
+                    replica.parameters[i]->getInfo()->size != parameters[i]->getInfo()->size) {
+                    continue;
+                }
+                ::memcpy(replica.parameters[i]->writeMap<void>(), parameterPtrs[i], parameterBytes[i]);
+            }
+        }
+        std::vector<VARP> microInputs(inputs.size());
+        for (int k = 0; k < inputs.size(); ++k) {
+            auto info = inputs[k]->getInfo();
+            auto dims = info->dim;
+            dims[0]   = microBatch[r];
+            microInputs[k] = _Input(dims, info->order, info->type);
+            ::memcpy(microInputs[k]->writeMap<void>(), inputPtrs[k] + microOffset[r] * rowBytes[k],
+                     microBatch[r] * rowBytes[k]);
+        }
+        std::map<VARP, VARP> grads;
+        std::vector<VARP> computed;
+        auto lossVar = loss(replica.module, microInputs);
+        if (nullptr != lossVar.get()) {
+            std::set<VARP> trainable;
+            for (auto index : mTrainableIndex) {
+                trainable.insert(replica.parameters[index]);
+            }
+            grads = OpGrad::grad(lossVar, trainable);
+            // Compute the gradients, the loss and the running statistics of BatchNorm in one cache
+            std::vector<VARP> prepareCompute{lossVar};
+            for (auto& iter : grads) {
+                prepareCompute.emplace_back(iter.second);
+            }
+            for (auto p : replica.parameters) {
+                if (nullptr != p.get() && nullptr != p->expr().first->get()) {
+                    computed.emplace_back(p);
+                    prepareCompute.emplace_back(p);
+                }
+            }
+            Variable::prepareCompute(prepareCompute);
+            success[r] = 1;
+            for (int j = 0; j < trainableNumber; ++j) {
+                auto iter = grads.find(replica.parameters[mTrainableIndex[j]]);
+                if (iter == grads.end()) {
+                    continue;
+                }
+                gradPtrs[r][j] = iter->second->readMap<float>();
+                if (nullptr == gradPtrs[r][j]) {
+                    success[r] = 0;
+                }
+            }
+            auto lossPtr = lossVar->readMap<float>();
+            if (nullptr == lossPtr) {
+                success[r] = 0;
+            } else {
+                losses[r] = lossPtr[0];
+            }
+            // Otherwise they refer to the graph of this step
+            for (auto p : computed) {
+                p.fix(VARP::CONSTANT);
+            }
+        }
+        barrier.wait();
+        // Each replica reduces its own slice of every gradient, weighted by the micro-batch
+        for (int j = 0; j < trainableNumber; ++j) {
+            auto dst   = reducedPtrs[j];
+            int start  = (int)((int64_t)reducedSize[j] * r / number);
+            int finish = (int)((int64_t)reducedSize[j] * (r + 1) / number);
+            ::memset(dst + start, 0, (finish - start) * sizeof(float));
+            for (int s = 0; s < number; ++s) {
+                auto src = gradPtrs[s][j];
+                if (nullptr == src) {
+                    continue;
+                }
+                float weight = (float)microBatch[s] / (float)batch;
+                for (int v = start; v < finish; ++v) {
+                    dst[v] += weight * src[v];
+                }
+            }
+        }
+        // Keep the gradients until all slices are reduced
+        barrier.wait();
+    };
+    std::vector<std::thread> threads;
+    for (int r = 1; r < number; ++r) {
+        threads.emplace_back(std::thread(work, r));
+    }
+    work(0);
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    float totalLoss = 0.0f;
+    for (int r = 0; r < number; ++r) {
+        if (!success[r]) {
+            MNN_ERROR("DataParallel: compute replica %d failed\n", r);
+            return -1.0f;
+        }
+        totalLoss += losses[r] * microBatch[r] / batch;
+    }
+    std::map<VARP, VARP> grad;
+    for (int j = 0; j < trainableNumber; ++j) {
+        if (nullptr != gradPtrs[0][j]) {
+            grad[parameters[mTrainableIndex[j]]] = reduced[j];
+        }
+    }
+    mOptimizer->step(grad);
+    return totalLoss;
+}
+
+} // namespace Train
+} // namespace MNN
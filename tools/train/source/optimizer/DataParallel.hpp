@@ -0,0 +1,62 @@
+//
+//  DataParallel.hpp
+//  MNN
+//
+//  Created by MNN on 2020/11/20.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#ifndef DataParallel_hpp
+#define DataParallel_hpp
+
+#include <MNN/expr/Executor.hpp>
+#include <MNN/expr/Module.hpp>
+#include <functional>
+#include <vector>
+#include "ParameterOptimizer.hpp"
+
+namespace MNN {
+namespace Train {
+
+/* Data parallel training on CPU. The batch is split along dim 0 into micro-batches, each replica of the model runs
+   forward and backward for its micro-batch on its own thread and executor, then the gradients are all-reduced and
+   the optimizer updates the parameters once.
+   Replica 0 is the optimizer's module and runs on the calling thread with the current executor, the other replicas
+   are built by the creator and get the parameters of replica 0 before each step.
+ */
+class MNN_PUBLIC DataParallel {
+public:
+    // Returns the loss of the micro-batch, it should be the mean over the micro-batch like the loss of a full batch
+    typedef std::function<Express::VARP(std::shared_ptr<Express::Module>, const std::vector<Express::VARP>&)>
+        LossFunction;
+
+    DataParallel(std::shared_ptr<Express::Module> module, std::shared_ptr<ParameterOptimizer> optimizer,
+                 std::function<Express::Module*()> creator, int replicas, int threadPerReplica = 1);
+    DataParallel(const DataParallel&) = delete;
+    DataParallel& operator=(const DataParallel&) = delete;
+    ~DataParallel() = default;
+
+    // Returns the loss of the whole batch, or a negative value on error
+    float step(const std::vector<Express::VARP>& inputs, LossFunction loss);
+
+    int replicas() const {
+        return (int)mReplicas.size();
+    }
+
+private:
+    struct Replica {
+        std::shared_ptr<Express::Module> module;
+        std::shared_ptr<Express::Executor> executor;
+        std::vector<Express::VARP> parameters;
+    };
+    std::shared_ptr<Express::Module> mModule;
+    std::shared_ptr<ParameterOptimizer> mOptimizer;
+    std::vector<Replica> mReplicas;
+    // Index in Module::parameters() of the trainable parameters
+    std::vector<int> mTrainableIndex;
+};
+
+} // namespace Train
+} // namespace MNN
+
+#endif // DataParallel_hpp
@@ -0,0 +1,119 @@
+//
+//  GradientAccumulation.cpp
+//  MNN
+//
+//  Created by MNN on 2020/11/23.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#include "GradientAccumulation.hpp"
+#include <MNN/expr/ExprCreator.hpp>
+#include <string.h>
+#include "OpGrad.hpp"
+using namespace MNN::Express;
+
+namespace MNN {
+namespace Train {
+
+GradientAccumulation::GradientAccumulation(std::shared_ptr<Module> module,
+                                           std::shared_ptr<ParameterOptimizer> optimizer, int microBatches,
+                                           bool releaseActivations) {
+    mModule             = module;
+    mOptimizer          = optimizer;
+    mMicroBatches       = microBatches;
+    mReleaseActivations = releaseActivations;
+    auto& trainable     = optimizer->trainable();
+    for (auto p : module->parameters()) {
+        if (trainable.find(p) == trainable.end()) {
+            continue;
+        }
+        auto info = p->getInfo();
+        auto grad = _Input(info->dim, info->order, halide_type_of<float>());
+        ::memset(grad->writeMap<float>(), 0, info->size * sizeof(float));
+        mTrainable.emplace_back(p);
+        mGrad.emplace_back(grad);
+    }
+    mHasGrad.resize(mGrad.size(), false);
+}
+
+bool GradientAccumulation::step(VARP loss) {
+    std::set<VARP> trainable(mTrainable.begin(), mTrainable.end());
+    auto grads = OpGrad::grad(loss, trainable);
+    std::vector<VARP> computed;
+    std::vector<VARP> prepareCompute;
+    for (auto& iter : grads) {
+        prepareCompute.emplace_back(iter.second);
+    }
+    if (mReleaseActivations) {
+        // The running statistics of BatchNorm and so on refer to the activations of this micro-batch
+        for (auto p : mModule->parameters()) {
+            if (nullptr != p.get() && nullptr != p->expr().first->get()) {
+                computed.emplace_back(p);
+                prepareCompute.emplace_back(p);
+            }
+        }
+        prepareCompute.emplace_back(loss);
+    }
+    Variable::prepareCompute(prepareCompute);
+    for (int i = 0; i < mTrainable.size(); ++i) {
+        auto iter = grads.find(mTrainable[i]);
+        if (iter == grads.end()) {
+            continue;
+        }
+        auto src = iter->second->readMap<float>();
+        if (nullptr == src) {
+            MNN_ERROR("Compute gradient error in GradientAccumulation\n");
+            return false;
+        }
+        auto dst  = mGrad[i]->writeMap<float>();
+        auto size = mGrad[i]->getInfo()->size;
+        for (int v = 0; v < size; ++v) {
+            dst[v] += src[v];
+        }
+        mHasGrad[i] = true;
+    }
+    grads.clear();
+    if (mReleaseActivations) {
+        loss.fix(VARP::CONSTANT);
+        for (auto p : computed) {
+            p.fix(VARP::CONSTANT);
+        }
+    }
+    mAccumulated++;
+    if (mAccumulated < mMicroBatches) {
+        return false;
+    }
+    return flush();
+}
+
+bool GradientAccumulation::flush() {
+    if (0 == mAccumulated) {
+        return false;
+    }
+    // Mean of the micro-batches
+    float scale = 1.0f / (float)mAccumulated;
+    std::map<VARP, VARP> grad;
+    for (int i = 0; i < mGrad.size(); ++i) {
+        if (!mHasGrad[i]) {
+            continue;
+        }
+        auto ptr  = mGrad[i]->writeMap<float>();
+        auto size = mGrad[i]->getInfo()->size;
+        for (int v = 0; v < size; ++v) {
+            ptr[v] *= scale;
+        }
+        grad[mTrainable[i]] = mGrad[i];
+    }
+    auto res = mOptimizer->step(grad);
+    for (int i = 0; i < mGrad.size(); ++i) {
+        if (mHasGrad[i]) {
+            ::memset(mGrad[i]->writeMap<float>(), 0, mGrad[i]->getInfo()->size * sizeof(float));
+            mHasGrad[i] = false;
+        }
+    }
+    mAccumulated = 0;
+    return res;
+}
+
+} // namespace Train
+} // namespace MNN
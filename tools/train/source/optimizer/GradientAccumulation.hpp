@@ -0,0 +1,57 @@
+//
+//  GradientAccumulation.hpp
+//  MNN
+//
+//  Created by MNN on 2020/11/23.
+//  Copyright © 2018, Alibaba Group Holding Limited
+//
+
+#ifndef GradientAccumulation_hpp
+#define GradientAccumulation_hpp
+
+#include <MNN/expr/Module.hpp>
+#include <vector>
+#include "ParameterOptimizer.hpp"
+
+namespace MNN {
+namespace Train {
+
+/* Splits a logical batch into microBatches steps. The gradients of each micro-batch are added in place into
+   preallocated buffers, the optimizer updates the parameters with their mean after the last micro-batch.
+   With releaseActivations, the loss and the computed parameters (such as the running mean of BatchNorm) are fixed
+   to constants after each micro-batch, so its activations are freed before the next forward and the activation
+   memory scales with the micro-batch instead of the batch.
+ */
+class MNN_PUBLIC GradientAccumulation {
+public:
+    GradientAccumulation(std::shared_ptr<Express::Module> module, std::shared_ptr<ParameterOptimizer> optimizer,
+                         int microBatches, bool releaseActivations = true);
+    GradientAccumulation(const GradientAccumulation&) = delete;
+    GradientAccumulation& operator=(const GradientAccumulation&) = delete;
+    ~GradientAccumulation() = default;
+
+    // Accumulate the gradients of the loss of a micro-batch, returns true if the parameters are updated by this call
+    bool step(Express::VARP loss);
+    // Update with the micro-batches accumulated so far, returns false if there is none
+    bool flush();
+
+    int accumulated() const {
+        return mAccumulated;
+    }
+
+private:
+    std::shared_ptr<Express::Module> mModule;
+    std::shared_ptr<ParameterOptimizer> mOptimizer;
+    int mMicroBatches;
+    bool mReleaseActivations;
+    int mAccumulated = 0;
+    std::vector<Express::VARP> mTrainable;
+    std::vector<Express::VARP> mGrad;
+    // Whether mGrad[i] has been accumulated since the last update
+    std::vector<bool> mHasGrad;
+};
+
+} // namespace Train
+} // namespace MNN
+
+#endif // GradientAccumulation_hpp
@@ -55,6 +55,16 @@ bool ParameterOptimizer::step(Express::VARP loss) {
     MNN_PRINT("call %s in %s in line %d\n", __FUNCTION__, __FILE__, __LINE__);
     mStep++;
     auto res = this->onGetNextParameter(loss);
+    return _update(res);
+}
+
+bool ParameterOptimizer::step(const std::map<Express::VARP, Express::VARP>& grad) {
+    mStep++;
+    auto res = this->onApplyGradient(grad);
+    return _update(res);
+}
+
+bool ParameterOptimizer::_update(const std::map<Express::VARP, Express::VARP>& res) {
     for (auto iter : res) {
         iter.second.fix(Express::VARP::TRAINABLE);
 //        iter.first->input(iter.second);
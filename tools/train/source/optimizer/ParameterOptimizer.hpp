@@ -24,10 +24,13 @@ public:
     ParameterOptimizer(std::shared_ptr<Express::Module> module);
     virtual ~ParameterOptimizer() = default;
     bool step(Express::VARP loss);
+    // Update with gradients computed outside the optimizer, such as the ones reduced across DataParallel replicas
+    bool step(const std::map<Express::VARP, Express::VARP>& grad);
     int currentStep();
     void setCurrentStep(int step);
 
     virtual std::map<Express::VARP, Express::VARP> onGetNextParameter(Express::VARP loss) = 0;
+    virtual std::map<Express::VARP, Express::VARP> onApplyGradient(std::map<Express::VARP, Express::VARP> grad) = 0;
 
     static ParameterOptimizer* createSGD(std::shared_ptr<Express::Module> module, float lr, float momentum, float weightDecay, RegularizationMethod method);
     static ParameterOptimizer* createADAM(std::shared_ptr<Express::Module> module, float lr, float momentum, float momentum2, float weightDecay, float eps, RegularizationMethod method);
@@ -42,6 +45,7 @@ protected:
         return mModule;
     }
 private:
+    bool _update(const std::map<Express::VARP, Express::VARP>& res);
     int mStep = 0;
     std::shared_ptr<Express::Module> mModule;
     std::set<Express::VARP> mTrainable;
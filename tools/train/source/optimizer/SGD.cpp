@@ -358,6 +358,12 @@ std::map<Express::VARP, Express::VARP> SGD::onGetNextParameter(Express::VARP los
         Variable::replace(prepareCompute[i], replaceOp[i]);
     }
     printf("finish replace & start apply grad to params\n");
+    grad = onApplyGradient(std::move(grad));
+    printf("finish the function %s\n", __FUNCTION__);
+    return grad;
+}
+
+std::map<Express::VARP, Express::VARP> SGD::onApplyGradient(std::map<Express::VARP, Express::VARP> grad) {
     for (auto &iter : grad) {
         // apply regularization
         auto addWeightDecayGrad = regularizeParameters(iter.first, iter.second);
@@ -368,7 +374,6 @@ std::map<Express::VARP, Express::VARP> SGD::onGetNextParameter(Express::VARP los
         auto newParameter = iter.first - updateValue;
         iter.second = newParameter;
     }
-    printf("finish the function %s\n", __FUNCTION__);
     return grad;
 }
 
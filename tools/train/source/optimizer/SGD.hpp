@@ -23,6 +23,7 @@ public:
     SGD(std::shared_ptr<Express::Module> module);
     virtual ~ SGD() = default;
     virtual std::map<Express::VARP, Express::VARP> onGetNextParameter(Express::VARP loss) override;
+    virtual std::map<Express::VARP, Express::VARP> onApplyGradient(std::map<Express::VARP, Express::VARP> grad) override;
 
     Express::VARP regularizeParameters(Express::VARP param, Express::VARP grad);
 